@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* AEF benchmark. It encrypts and decrypts bursts of AVTPDUs which
+ * encapsulate 1400-byte AVTPDUs, in place, and reports the throughput of a
+ * single core in Gbit/s of encapsulated data, for both the AES-NI/PCLMULQDQ
+ * and the portable implementations.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp.h"
+#include "avtp_aef.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define INNER_LEN		1400
+#define BUF_LEN			(INNER_LEN + AVTP_AEF_OVERHEAD)
+#define BURST			32
+#define BYTES			(1ULL << 30)
+
+static const struct {
+	const char *name;
+	size_t key_len;
+	uint32_t flags;
+} cases[] = {
+	{ "AES-128", 16, 0 },
+	{ "AES-256", 32, 0 },
+	{ "AES-128 portable", 16, AVTP_AEF_PORTABLE },
+	{ "AES-256 portable", 32, AVTP_AEF_PORTABLE },
+};
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int run(unsigned int n, uint8_t *bufs)
+{
+	struct avtp_aef_buf burst[BURST];
+	struct avtp_aef *tx, *rx;
+	uint64_t start, enc, dec, rounds, i;
+	uint8_t key[32];
+	unsigned int j;
+	int res;
+
+	for (j = 0; j < sizeof(key); j++)
+		key[j] = rand();
+
+	res = avtp_aef_create(&tx, key, cases[n].key_len, 1, 2,
+							cases[n].flags);
+	if (res < 0)
+		return res;
+
+	res = avtp_aef_create(&rx, key, cases[n].key_len, 1, 2,
+							cases[n].flags);
+	if (res < 0)
+		return res;
+
+	/* Portable runs are much slower, so they process less data. */
+	rounds = BYTES / (INNER_LEN * BURST);
+	if (!avtp_aef_is_accelerated(tx))
+		rounds /= 8;
+
+	for (j = 0; j < BURST; j++) {
+		burst[j].pdu = (struct avtp_stream_pdu *) (bufs + j * BUF_LEN);
+		avtp_aef_pdu_init(burst[j].pdu);
+	}
+
+	enc = dec = 0;
+	for (i = 0; i < rounds; i++) {
+		for (j = 0; j < BURST; j++)
+			burst[j].len = INNER_LEN;
+
+		start = get_time_ns();
+		res = avtp_aef_encrypt_batch(tx, burst, BURST);
+		enc += get_time_ns() - start;
+		if (res < 0)
+			return res;
+
+		for (j = 0; j < BURST; j++)
+			burst[j].len = burst[j].out_len;
+
+		start = get_time_ns();
+		res = avtp_aef_decrypt_batch(rx, burst, BURST);
+		dec += get_time_ns() - start;
+		if (res != BURST)
+			return -1;
+	}
+
+	printf("%-18s %8s %10.2f %10.2f\n", cases[n].name,
+			avtp_aef_is_accelerated(tx) ? "yes" : "no",
+			rounds * BURST * INNER_LEN * 8.0 / enc,
+			rounds * BURST * INNER_LEN * 8.0 / dec);
+
+	avtp_aef_destroy(tx);
+	avtp_aef_destroy(rx);
+
+	return 0;
+}
+
+int main(void)
+{
+	uint8_t *bufs;
+	unsigned int i;
+
+	bufs = malloc(BURST * BUF_LEN);
+	if (!bufs) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < BURST * BUF_LEN; i++)
+		bufs[i] = rand();
+
+	printf("%-18s %8s %10s %10s\n", "cipher", "AES-NI", "enc Gb/s",
+								"dec Gb/s");
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		if (run(i, bufs) < 0) {
+			fprintf(stderr, "%s failed\n", cases[i].name);
+			return 1;
+		}
+	}
+
+	free(bufs);
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* ASRC benchmark. It converts one second of audio for each combination of
+ * channel count and rate conversion below and reports the realtime factor,
+ * i.e. how many such streams a single core could sustain, together with the
+ * resulting channels per core.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "avtp.h"
+#include "avtp_aaf.h"
+#include "avtp_asrc.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define CHUNK_FRAMES		48
+#define ITERATIONS		5
+
+struct conversion {
+	const char *name;
+	uint8_t in_nsr;
+	uint8_t out_nsr;
+	uint32_t in_rate;
+};
+
+static const struct conversion conversions[] = {
+	{ "48k->48k", AVTP_AAF_PCM_NSR_48KHZ, AVTP_AAF_PCM_NSR_48KHZ, 48000 },
+	{ "48k->44.1k", AVTP_AAF_PCM_NSR_48KHZ, AVTP_AAF_PCM_NSR_44_1KHZ,
+									48000 },
+	{ "44.1k->48k", AVTP_AAF_PCM_NSR_44_1KHZ, AVTP_AAF_PCM_NSR_48KHZ,
+									44100 },
+	{ "96k->48k", AVTP_AAF_PCM_NSR_96KHZ, AVTP_AAF_PCM_NSR_48KHZ, 96000 },
+	{ "48k->96k", AVTP_AAF_PCM_NSR_48KHZ, AVTP_AAF_PCM_NSR_96KHZ, 48000 },
+	{ "192k->48k", AVTP_AAF_PCM_NSR_192KHZ, AVTP_AAF_PCM_NSR_48KHZ,
+									192000 },
+};
+
+static const uint16_t channels[] = { 2, 8, 32 };
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Convert one second of audio in chunks of CHUNK_FRAMES, as a listener
+ * would do per AAF PDU. Returns the elapsed time in nanoseconds, or 0 on
+ * error.
+ */
+static uint64_t run(const struct conversion *conv, uint16_t chans)
+{
+	size_t in_frames = conv->in_rate * CHUNK_FRAMES / 48000;
+	size_t out_frames = in_frames * 4 + 64;
+	uint64_t start, best = UINT64_MAX;
+	struct avtp_asrc *asrc;
+	int16_t *in, *out;
+	int i, res;
+
+	in = calloc(in_frames * chans, sizeof(*in));
+	out = calloc(out_frames * chans, sizeof(*out));
+	if (!in || !out)
+		goto err;
+
+	for (i = 0; i < (int)(in_frames * chans); i++)
+		in[i] = rand();
+
+	res = avtp_asrc_create(&asrc, conv->in_nsr, conv->out_nsr,
+				AVTP_AAF_FORMAT_INT_16BIT, chans,
+				AVTP_ASRC_IN_BIG_ENDIAN);
+	if (res < 0)
+		goto err;
+
+	/* Exercise the non-nominal path, as with a recovered media clock. */
+	avtp_asrc_set_ratio(asrc, 12345);
+
+	for (i = 0; i < ITERATIONS; i++) {
+		uint64_t elapsed;
+		size_t produced;
+		uint32_t n;
+
+		start = get_time_ns();
+
+		for (n = 0; n < conv->in_rate; n += in_frames) {
+			res = avtp_asrc_process(asrc, in, in_frames, out,
+						out_frames, &produced);
+			if (res < 0) {
+				avtp_asrc_destroy(asrc);
+				goto err;
+			}
+		}
+
+		elapsed = get_time_ns() - start;
+		if (elapsed < best)
+			best = elapsed;
+	}
+
+	avtp_asrc_destroy(asrc);
+	free(in);
+	free(out);
+	return best;
+
+err:
+	free(in);
+	free(out);
+	return 0;
+}
+
+int main(void)
+{
+	int i, j;
+
+	printf("%-12s %8s %12s %14s %14s\n", "conversion", "channels",
+		"ns/second", "realtime x", "channels/core");
+
+	for (i = 0; i < (int)(sizeof(conversions) / sizeof(conversions[0]));
+									i++) {
+		for (j = 0; j < (int)(sizeof(channels) / sizeof(channels[0]));
+									j++) {
+			uint64_t elapsed = run(&conversions[i], channels[j]);
+			double factor;
+
+			if (!elapsed) {
+				fprintf(stderr, "Failed to run %s\n",
+							conversions[i].name);
+				return 1;
+			}
+
+			factor = (double)NSEC_PER_SEC / elapsed;
+			printf("%-12s %8u %12llu %14.1f %14.0f\n",
+				conversions[i].name, channels[j],
+				(unsigned long long)elapsed, factor,
+				factor * channels[j]);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Coalescing presentation sink benchmark. It plays a class A like stream,
+ * 8000 payloads of 192 bytes per second, each received TRANSIT_NS before
+ * its presentation time, into a pipe drained by another process. For
+ * several coalescing windows it reports the writev() calls per 1000
+ * payloads, the CPU time spent per payload, and the timing error measured
+ * by the sink: how early and how late payloads actually reached the pipe.
+ *
+ * Window 0 writes payloads one by one, like present_data().
+ *
+ * Usage: bench-batch
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "avtp_batch.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define NSEC_PER_USEC		1000ULL
+#define PERIOD_NS		125000
+#define TRANSIT_NS		2000000
+#define PAYLOAD_LEN		192
+#define PAYLOADS		4000
+
+static const uint64_t windows[] = {
+	0, 250 * NSEC_PER_USEC, 1000 * NSEC_PER_USEC, 2000 * NSEC_PER_USEC,
+};
+
+static uint64_t get_cpu_time_ns(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * NSEC_PER_SEC +
+		(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ULL;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t time)
+{
+	struct timespec ts = {
+		.tv_sec = time / NSEC_PER_SEC,
+		.tv_nsec = time % NSEC_PER_SEC,
+	};
+
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static pid_t spawn_drain(int fds[2])
+{
+	static uint8_t buf[64 * 1024];
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		close(fds[1]);
+		while (read(fds[0], buf, sizeof(buf)) > 0)
+			;
+		_exit(0);
+	}
+
+	close(fds[0]);
+	return pid;
+}
+
+/* Payload i arrives at 'start + i * PERIOD_NS' and is due TRANSIT_NS
+ * later. The loop sleeps until whichever comes first: the next arrival or
+ * the sink deadline.
+ */
+static int run(uint64_t window, struct avtp_batch_sink_stats *stats,
+							uint64_t *cpu_ns)
+{
+	uint8_t payload[PAYLOAD_LEN] = { 0 };
+	struct avtp_batch_sink *sink;
+	uint64_t start, deadline;
+	int fds[2], i = 0, res;
+	pid_t pid;
+
+	if (pipe(fds) < 0)
+		return -1;
+
+	pid = spawn_drain(fds);
+	if (pid < 0)
+		return -1;
+
+	res = avtp_batch_sink_create(&sink, fds[1], window, 1024,
+						1024 * PAYLOAD_LEN);
+	if (res < 0)
+		return -1;
+
+	*cpu_ns = get_cpu_time_ns();
+	start = now_ns() + PERIOD_NS;
+
+	while (1) {
+		uint64_t arrival = start + (uint64_t) i * PERIOD_NS;
+		int pending;
+
+		pending = avtp_batch_sink_get_deadline(sink, &deadline);
+		if (!pending && i == PAYLOADS)
+			break;
+
+		if (pending && (i == PAYLOADS || deadline <= arrival)) {
+			sleep_until(deadline);
+			res = avtp_batch_sink_flush(sink, now_ns());
+			if (res < 0)
+				return -1;
+			continue;
+		}
+
+		sleep_until(arrival);
+		res = avtp_batch_sink_queue(sink, payload, PAYLOAD_LEN,
+							arrival + TRANSIT_NS);
+		if (res < 0)
+			return -1;
+		i++;
+	}
+
+	*cpu_ns = get_cpu_time_ns() - *cpu_ns;
+	avtp_batch_sink_get_stats(sink, stats);
+	avtp_batch_sink_destroy(sink);
+
+	close(fds[1]);
+	waitpid(pid, NULL, 0);
+	return 0;
+}
+
+int main(void)
+{
+	unsigned int i;
+
+	printf("%10s %14s %10s %12s %12s\n", "window us", "writes/1000",
+				"cpu ns", "max early us", "max late us");
+
+	for (i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+		struct avtp_batch_sink_stats stats;
+		uint64_t cpu_ns;
+
+		if (run(windows[i], &stats, &cpu_ns) < 0) {
+			perror("Run failed");
+			return 1;
+		}
+
+		printf("%10.0f %14.1f %10.0f %12.1f %12.1f\n",
+			(double) windows[i] / NSEC_PER_USEC,
+			1000.0 * stats.writes / stats.payloads,
+			(double) cpu_ns / stats.payloads,
+			(double) stats.max_early / NSEC_PER_USEC,
+			(double) stats.max_late / NSEC_PER_USEC);
+	}
+
+	return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* IEC 61883 CIP header benchmark. It writes the per-packet CIP fields ('dbc',
+ * FDF and 'syt') of a burst of 2-channel, 48 kHz AM824 PDUs and reports the
+ * sustained packet rate of a single core for:
+ *  - pdu_set: one avtp_ieciidc_pdu_set() call per field, as an application
+ *    setting up its own PDUs would;
+ *  - cip_write: one avtp_ieciidc_cip_write() call per PDU from a template, as
+ *    the packers do;
+ *  - cip_write_batch: one avtp_ieciidc_cip_write_batch() call per burst.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp.h"
+#include "avtp_ieciidc.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define CHANNELS		2
+#define SYT_INTERVAL		8
+#define PDU_SIZE		(sizeof(struct avtp_stream_pdu) + \
+				AVTP_IECIIDC_CIP_HEADER_LEN + \
+				SYT_INTERVAL * CHANNELS * sizeof(uint32_t))
+#define BURST			64
+#define ROUNDS			100000
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t elapsed)
+{
+	printf("%-16s %12.0f %10.2f\n", name,
+		(double) BURST * ROUNDS * NSEC_PER_SEC / elapsed,
+		(double) elapsed / ((double) BURST * ROUNDS));
+}
+
+int main(void)
+{
+	struct avtp_stream_pdu *pdus[BURST];
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_ieciidc_cip cip;
+	uint16_t syt[BURST];
+	uint8_t *buf, *ref;
+	uint64_t start;
+	unsigned int i, j;
+	uint8_t dbc;
+	int res;
+
+	buf = malloc(BURST * PDU_SIZE);
+	ref = malloc(BURST * PDU_SIZE);
+	if (!buf || !ref) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	res = avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, CHANNELS,
+								16, 1, 0);
+	if (res < 0)
+		return 1;
+
+	for (i = 0; i < BURST; i++) {
+		pdus[i] = (struct avtp_stream_pdu *) (buf + i * PDU_SIZE);
+		avtp_ieciidc_am824_pdu_init(&am824, pdus[i]);
+		syt[i] = rand();
+	}
+
+	res = avtp_ieciidc_cip_init(&cip, pdus[0]);
+	if (res < 0)
+		return 1;
+
+	printf("%-16s %12s %10s\n", "path", "PDU/s", "ns/PDU");
+
+	start = get_time_ns();
+	for (j = 0; j < ROUNDS; j++) {
+		dbc = j * BURST * SYT_INTERVAL;
+		for (i = 0; i < BURST; i++) {
+			avtp_ieciidc_pdu_set(pdus[i], AVTP_IECIIDC_FIELD_CIP_DBC,
+									dbc);
+			avtp_ieciidc_pdu_set(pdus[i], AVTP_IECIIDC_FIELD_CIP_SFC,
+						AVTP_IECIIDC_SFC_48KHZ);
+			avtp_ieciidc_pdu_set(pdus[i], AVTP_IECIIDC_FIELD_CIP_SYT,
+								syt[i]);
+			dbc += SYT_INTERVAL;
+		}
+	}
+	report("pdu_set", get_time_ns() - start);
+
+	/* All paths must produce the same headers. */
+	memcpy(ref, buf, BURST * PDU_SIZE);
+
+	start = get_time_ns();
+	for (j = 0; j < ROUNDS; j++) {
+		dbc = j * BURST * SYT_INTERVAL;
+		for (i = 0; i < BURST; i++) {
+			avtp_ieciidc_cip_write(&cip, pdus[i], dbc,
+					AVTP_IECIIDC_SFC_48KHZ, syt[i]);
+			dbc += SYT_INTERVAL;
+		}
+	}
+	report("cip_write", get_time_ns() - start);
+
+	if (memcmp(ref, buf, BURST * PDU_SIZE)) {
+		fprintf(stderr, "cip_write mismatch\n");
+		return 1;
+	}
+
+	start = get_time_ns();
+	for (j = 0; j < ROUNDS; j++)
+		avtp_ieciidc_cip_write_batch(&cip, pdus, BURST,
+					j * BURST * SYT_INTERVAL, SYT_INTERVAL,
+					AVTP_IECIIDC_SFC_48KHZ, syt);
+	report("cip_write_batch", get_time_ns() - start);
+
+	if (memcmp(ref, buf, BURST * PDU_SIZE)) {
+		fprintf(stderr, "cip_write_batch mismatch\n");
+		return 1;
+	}
+
+	free(buf);
+	free(ref);
+
+	return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* avtp.hpp benchmark. It parses and updates the AAF header of a batch of
+ * PDUs with hand-written shifts and masks, with avtp.hpp and with the C API,
+ * reporting the time per PDU of each. avtp.hpp is expected to match the
+ * hand-written code.
+ */
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#include "avtp.h"
+#include "avtp.hpp"
+#include "avtp_aaf.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define PDU_SIZE		64
+#define PDUS			4096
+#define ROUNDS			2000
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static uint32_t load32(const uint8_t *p)
+{
+	uint32_t w;
+
+	memcpy(&w, p, sizeof(w));
+
+	return ntohl(w);
+}
+
+static void store32(uint8_t *p, uint32_t w)
+{
+	w = htonl(w);
+	memcpy(p, &w, sizeof(w));
+}
+
+struct hand {
+	static uint64_t parse(const uint8_t *pdu)
+	{
+		uint32_t fs = load32(pdu + 16);
+
+		return ((load32(pdu) >> 8) & 0xff) + (load32(pdu + 20) >> 16) +
+			(fs >> 24) + ((fs >> 20) & 0xf) + ((fs >> 8) & 0x3ff) +
+			(fs & 0xff);
+	}
+
+	static void update(uint8_t *pdu, uint8_t seq, uint32_t time,
+							uint16_t data_len)
+	{
+		store32(pdu, (load32(pdu) & ~0xff00u) | (seq << 8));
+		store32(pdu + 12, time);
+		store32(pdu + 20, (load32(pdu + 20) & 0xffff) |
+						((uint32_t) data_len << 16));
+	}
+};
+
+struct hpp {
+	static uint64_t parse(const uint8_t *pdu)
+	{
+		using namespace avtp::aaf;
+
+		return avtp::get<seq_num>(pdu) +
+			avtp::get<stream_data_len>(pdu) +
+			avtp::get<format>(pdu) + avtp::get<nsr>(pdu) +
+			avtp::get<chan_per_frame>(pdu) +
+			avtp::get<bit_depth>(pdu);
+	}
+
+	static void update(uint8_t *pdu, uint8_t seq, uint32_t time,
+							uint16_t data_len)
+	{
+		using namespace avtp::aaf;
+
+		avtp::set<seq_num>(pdu, seq);
+		avtp::set<timestamp>(pdu, time);
+		avtp::set<stream_data_len>(pdu, data_len);
+	}
+};
+
+struct c_api {
+	static uint64_t parse(const uint8_t *pdu)
+	{
+		const struct avtp_stream_pdu *p =
+				(const struct avtp_stream_pdu *) pdu;
+		const enum avtp_aaf_field fields[] = {
+			AVTP_AAF_FIELD_SEQ_NUM, AVTP_AAF_FIELD_STREAM_DATA_LEN,
+			AVTP_AAF_FIELD_FORMAT, AVTP_AAF_FIELD_NSR,
+			AVTP_AAF_FIELD_CHAN_PER_FRAME, AVTP_AAF_FIELD_BIT_DEPTH,
+		};
+		uint64_t sum = 0, val;
+
+		for (enum avtp_aaf_field f : fields) {
+			avtp_aaf_pdu_get(p, f, &val);
+			sum += val;
+		}
+
+		return sum;
+	}
+
+	static void update(uint8_t *pdu, uint8_t seq, uint32_t time,
+							uint16_t data_len)
+	{
+		struct avtp_stream_pdu *p = (struct avtp_stream_pdu *) pdu;
+
+		avtp_aaf_pdu_set(p, AVTP_AAF_FIELD_SEQ_NUM, seq);
+		avtp_aaf_pdu_set(p, AVTP_AAF_FIELD_TIMESTAMP, time);
+		avtp_aaf_pdu_set(p, AVTP_AAF_FIELD_STREAM_DATA_LEN, data_len);
+	}
+};
+
+template <class Impl>
+static void run(const char *name, std::vector<uint8_t> &pdus)
+{
+	uint64_t start, parse, update, sum = 0;
+	unsigned int i, j;
+
+	start = get_time_ns();
+	for (i = 0; i < ROUNDS; i++) {
+		for (j = 0; j < PDUS; j++)
+			sum += Impl::parse(&pdus[j * PDU_SIZE]);
+	}
+	parse = get_time_ns() - start;
+
+	start = get_time_ns();
+	for (i = 0; i < ROUNDS; i++) {
+		for (j = 0; j < PDUS; j++)
+			Impl::update(&pdus[j * PDU_SIZE], i + j, i * j, j);
+	}
+	update = get_time_ns() - start;
+
+	/* Keep the parse loop from being optimized away. */
+	if (sum == 0)
+		printf("unexpected sum\n");
+
+	printf("%-12s %12.2f %12.2f\n", name,
+			(double) parse / ((double) PDUS * ROUNDS),
+			(double) update / ((double) PDUS * ROUNDS));
+}
+
+int main(void)
+{
+	std::vector<uint8_t> pdus((size_t) PDUS * PDU_SIZE);
+	unsigned int i;
+
+	for (i = 0; i < PDUS; i++) {
+		struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *)
+							&pdus[i * PDU_SIZE];
+
+		avtp_aaf_pdu_init(pdu);
+		avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_FORMAT,
+						AVTP_AAF_FORMAT_INT_16BIT);
+		avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_NSR,
+						AVTP_AAF_PCM_NSR_48KHZ);
+		avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_CHAN_PER_FRAME, 2);
+		avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_BIT_DEPTH, 16);
+	}
+
+	printf("%-12s %12s %12s\n", "access", "parse ns/PDU",
+						"update ns/PDU");
+
+	run<hand>("hand-written", pdus);
+	run<hpp>("avtp.hpp", pdus);
+	run<c_api>("C API", pdus);
+
+	return 0;
+}
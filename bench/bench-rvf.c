@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* RVF benchmark. It packetizes and depacketizes 1080p frames into 1500 byte
+ * PDUs and reports the sustained frame rate of a single core for each
+ * supported pixel format. Packing converts planar frames into wire pgroups
+ * and unpacking converts them back.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp.h"
+#include "avtp_rvf.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define WIDTH			1920
+#define HEIGHT			1080
+#define STRIDE			(WIDTH * 2)
+#define MAX_PDU_SIZE		1500
+#define FRAMES			100
+
+static const struct {
+	const char *name;
+	uint8_t format;
+	uint8_t depth;
+} formats[] = {
+	{ "4:2:2 8-bit", AVTP_RVF_PIXEL_FORMAT_422, AVTP_RVF_PIXEL_DEPTH_8BIT },
+	{ "4:2:2 10-bit", AVTP_RVF_PIXEL_FORMAT_422,
+						AVTP_RVF_PIXEL_DEPTH_10BIT },
+	{ "RGB 8-bit", AVTP_RVF_PIXEL_FORMAT_444, AVTP_RVF_PIXEL_DEPTH_8BIT },
+};
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void init_frame(struct avtp_rvf_frame *frame, uint8_t *buf)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		frame->planes[i] = buf + (size_t) i * STRIDE * HEIGHT;
+		frame->strides[i] = STRIDE;
+	}
+}
+
+static int run(unsigned int n, uint8_t *src_buf, uint8_t *dst_buf,
+						uint8_t *pdus, size_t *lens)
+{
+	struct avtp_rvf_frame src, dst;
+	struct avtp_rvf_video tx, rx;
+	unsigned int i, j, count = 0;
+	uint64_t start, pack, unpack;
+	int eof, res;
+
+	init_frame(&src, src_buf);
+	init_frame(&dst, dst_buf);
+
+	res = avtp_rvf_video_init(&tx, WIDTH, HEIGHT, formats[n].format,
+					formats[n].depth, MAX_PDU_SIZE);
+	if (res < 0)
+		return res;
+
+	rx = tx;
+
+	/* Prepare one frame worth of PDUs for the depacketizer. */
+	do {
+		struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *)
+					(pdus + count * MAX_PDU_SIZE);
+
+		avtp_rvf_video_pdu_init(&tx, pdu);
+		avtp_rvf_video_pack(&tx, pdu, &src, &lens[count], &eof);
+		count++;
+	} while (!eof);
+
+	start = get_time_ns();
+	for (i = 0; i < FRAMES; i++) {
+		for (j = 0; j < count; j++)
+			avtp_rvf_video_pack(&tx, (struct avtp_stream_pdu *)
+						(pdus + j * MAX_PDU_SIZE),
+						&src, &lens[j], &eof);
+	}
+	pack = get_time_ns() - start;
+
+	start = get_time_ns();
+	for (i = 0; i < FRAMES; i++) {
+		for (j = 0; j < count; j++) {
+			res = avtp_rvf_video_unpack(&rx,
+					(struct avtp_stream_pdu *)
+					(pdus + j * MAX_PDU_SIZE),
+					lens[j], &dst);
+			if (res < 0)
+				return res;
+		}
+	}
+	unpack = get_time_ns() - start;
+
+	if (memcmp(src_buf + STRIDE, dst_buf + STRIDE, WIDTH)) {
+		fprintf(stderr, "Frame mismatch\n");
+		return -1;
+	}
+
+	printf("%-14s %10.1f %10.1f %10u\n", formats[n].name,
+				FRAMES * (double) NSEC_PER_SEC / pack,
+				FRAMES * (double) NSEC_PER_SEC / unpack, count);
+
+	return 0;
+}
+
+int main(void)
+{
+	size_t frame_len = (size_t) 3 * STRIDE * HEIGHT;
+	uint8_t *src_buf, *dst_buf, *pdus;
+	size_t *lens;
+	unsigned int i;
+
+	src_buf = malloc(frame_len);
+	dst_buf = malloc(frame_len);
+	pdus = malloc((size_t) HEIGHT * 4 * MAX_PDU_SIZE);
+	lens = malloc(HEIGHT * 4 * sizeof(*lens));
+	if (!src_buf || !dst_buf || !pdus || !lens) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	/* Random 10-bit samples are valid 8-bit samples too. */
+	for (i = 0; i < frame_len / 2; i++)
+		((uint16_t *) src_buf)[i] = rand() & 0x3FF;
+
+	printf("%-14s %10s %10s %10s\n", "format", "pack fps", "unpack fps",
+								"PDUs/frame");
+
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		if (run(i, src_buf, dst_buf, pdus, lens) < 0) {
+			fprintf(stderr, "%s failed\n", formats[i].name);
+			return 1;
+		}
+	}
+
+	free(src_buf);
+	free(dst_buf);
+	free(pdus);
+	free(lens);
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Presentation scheduler benchmark. Payloads of several streams, each
+ * 125 us apart plus up to 50 us of jitter, are scheduled while the due
+ * ones are popped, keeping about 2 ms worth of payloads queued. It compares
+ * the heap scheduler against keeping a list sorted by insertion, the
+ * simplest way to extend the FIFO queue of the listener examples to
+ * several streams and reordering, and reports the cost per payload.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/queue.h>
+#include <time.h>
+
+#include "avtp_sched.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define PERIOD			125000
+#define JITTER			50000
+#define DEPTH			2000000
+#define PAYLOADS		(1 << 20)
+
+struct list_entry {
+	TAILQ_ENTRY(list_entry) entries;
+	uint64_t time;
+};
+
+TAILQ_HEAD(list_queue, list_entry);
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Presentation time of payload 'i' out of 'streams' interleaved ones. */
+static uint64_t payload_time(unsigned int i, unsigned int streams)
+{
+	return (uint64_t) (i / streams) * PERIOD + rand() % JITTER;
+}
+
+static double run_heap(unsigned int streams, struct list_entry *entries)
+{
+	struct avtp_sched *sched;
+	uint64_t start, now, time;
+	unsigned int i;
+	void *data;
+	int res;
+
+	res = avtp_sched_create(&sched, PAYLOADS);
+	if (res < 0) {
+		fprintf(stderr, "Failed to create scheduler: %d\n", res);
+		exit(EXIT_FAILURE);
+	}
+
+	srand(1);
+	start = get_time_ns();
+
+	for (i = 0; i < PAYLOADS; i++) {
+		time = payload_time(i, streams);
+		avtp_sched_push(sched, time, &entries[i]);
+
+		now = time > DEPTH ? time - DEPTH : 0;
+		while (avtp_sched_pop(sched, now, NULL, &data) == 1)
+			;
+	}
+
+	while (avtp_sched_pop(sched, UINT64_MAX, NULL, &data) == 1)
+		;
+
+	time = get_time_ns() - start;
+	avtp_sched_destroy(sched);
+
+	return (double) time / PAYLOADS;
+}
+
+static double run_list(unsigned int streams, struct list_entry *entries)
+{
+	struct list_queue queue = TAILQ_HEAD_INITIALIZER(queue);
+	struct list_entry *entry, *pos;
+	uint64_t start, now, time;
+	unsigned int i;
+
+	srand(1);
+	start = get_time_ns();
+
+	for (i = 0; i < PAYLOADS; i++) {
+		entry = &entries[i];
+		entry->time = payload_time(i, streams);
+
+		/* Payloads mostly arrive in order, so search from the tail. */
+		TAILQ_FOREACH_REVERSE(pos, &queue, list_queue, entries)
+			if (pos->time <= entry->time)
+				break;
+
+		if (pos)
+			TAILQ_INSERT_AFTER(&queue, pos, entry, entries);
+		else
+			TAILQ_INSERT_HEAD(&queue, entry, entries);
+
+		now = entry->time > DEPTH ? entry->time - DEPTH : 0;
+		while ((pos = TAILQ_FIRST(&queue)) && pos->time <= now)
+			TAILQ_REMOVE(&queue, pos, entries);
+	}
+
+	time = get_time_ns() - start;
+
+	return (double) time / PAYLOADS;
+}
+
+int main(void)
+{
+	static const unsigned int streams[] = { 1, 8, 64 };
+	struct list_entry *entries;
+	unsigned int i;
+
+	entries = calloc(PAYLOADS, sizeof(*entries));
+	if (!entries) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	printf("%-8s %8s %12s %12s\n", "streams", "queued", "heap ns/pl",
+							"list ns/pl");
+
+	for (i = 0; i < sizeof(streams) / sizeof(streams[0]); i++)
+		printf("%-8u %8u %12.1f %12.1f\n", streams[i],
+				DEPTH / PERIOD * streams[i],
+				run_heap(streams[i], entries),
+				run_list(streams[i], entries));
+
+	free(entries);
+	return 0;
+}
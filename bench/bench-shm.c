@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Presentation sink benchmark. A producer hands PDU payloads to a consumer
+ * process, either with one write() per payload to a pipe, like
+ * present_data() does with stdout, or through the shared memory ring. It
+ * reports the CPU time spent per payload on each side and, for the ring,
+ * the share of payloads the consumer lost because it was overrun.
+ *
+ * Like a listener, the producer is paced: it hands payloads over in bursts
+ * of BURST, one burst every BURST_PERIOD_NS. Both sides pay for the pacing
+ * sleeps.
+ *
+ * Usage: bench-shm
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "avtp_shm.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define PAYLOADS		200000
+#define BURST			32
+#define BURST_PERIOD_NS		100000
+#define RING_SIZE		(1 << 20)
+#define MAX_PAYLOAD		1400
+
+static const size_t payload_sizes[] = { 4, 192, 1400 };
+
+struct result {
+	uint64_t received;
+	uint64_t cpu_ns;
+};
+
+static uint64_t get_cpu_time_ns(int who)
+{
+	struct rusage ru;
+
+	getrusage(who, &ru);
+
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * NSEC_PER_SEC +
+		(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ULL;
+}
+
+/* Sleep until the next burst is due. */
+static void pace(struct timespec *next)
+{
+	next->tv_nsec += BURST_PERIOD_NS;
+	if (next->tv_nsec >= (long) NSEC_PER_SEC) {
+		next->tv_nsec -= NSEC_PER_SEC;
+		next->tv_sec++;
+	}
+
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL);
+}
+
+static void consume_pipe(int fd, size_t len, struct result *res)
+{
+	uint8_t buf[MAX_PAYLOAD];
+
+	while (1) {
+		ssize_t n = read(fd, buf, len);
+
+		if (n <= 0)
+			break;
+
+		res->received++;
+	}
+
+	res->cpu_ns = get_cpu_time_ns(RUSAGE_SELF);
+}
+
+/* The consumer leaves once the ring stays idle for a while. */
+static void consume_shm(int sock, struct result *res)
+{
+	struct avtp_shm_reader *reader;
+	struct avtp_shm_rec rec;
+	volatile uint8_t sink = 0;
+	int mem_fd, bell_fd, n;
+
+	if (avtp_shm_recv_fds(sock, &mem_fd, &bell_fd) < 0 ||
+		avtp_shm_reader_create(&reader, mem_fd, bell_fd) < 0)
+		return;
+
+	/* Tell the producer we're ready. */
+	if (write(sock, "", 1) != 1)
+		return;
+
+	while (1) {
+		n = avtp_shm_reader_next(reader, &rec);
+		if (n == 1) {
+			sink += ((const uint8_t *) rec.data)[rec.len - 1];
+			if (avtp_shm_reader_release(reader) == 0)
+				res->received++;
+			continue;
+		}
+
+		if (n == 0 && avtp_shm_reader_wait(reader, 200) == -ETIMEDOUT)
+			break;
+	}
+
+	res->cpu_ns = get_cpu_time_ns(RUSAGE_SELF);
+	avtp_shm_reader_destroy(reader);
+}
+
+static int run_pipe(const uint8_t *payload, size_t len, uint64_t *cpu_ns,
+							struct result *res)
+{
+	struct timespec next;
+	int fds[2], i;
+	pid_t pid;
+
+	if (pipe(fds) < 0)
+		return -1;
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+
+	if (pid == 0) {
+		close(fds[1]);
+		consume_pipe(fds[0], len, res);
+		_exit(0);
+	}
+
+	close(fds[0]);
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	*cpu_ns = get_cpu_time_ns(RUSAGE_SELF);
+	for (i = 0; i < PAYLOADS; i++) {
+		if (write(fds[1], payload, len) != (ssize_t) len)
+			return -1;
+		if (i % BURST == BURST - 1)
+			pace(&next);
+	}
+	*cpu_ns = get_cpu_time_ns(RUSAGE_SELF) - *cpu_ns;
+
+	close(fds[1]);
+	waitpid(pid, NULL, 0);
+	return 0;
+}
+
+static int run_shm(const uint8_t *payload, size_t len, uint64_t *cpu_ns,
+							struct result *res)
+{
+	struct avtp_shm_sink *sink;
+	struct timespec next;
+	int sock[2], i;
+	char ready;
+	pid_t pid;
+
+	if (avtp_shm_sink_create(&sink, "bench-shm", RING_SIZE) < 0)
+		return -1;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sock) < 0)
+		return -1;
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+
+	if (pid == 0) {
+		close(sock[0]);
+		consume_shm(sock[1], res);
+		_exit(0);
+	}
+
+	close(sock[1]);
+	if (avtp_shm_send_fds(sink, sock[0]) < 0 ||
+				read(sock[0], &ready, 1) != 1)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	*cpu_ns = get_cpu_time_ns(RUSAGE_SELF);
+	for (i = 0; i < PAYLOADS; i++) {
+		avtp_shm_sink_write(sink, payload, len, i);
+		if (i % BURST == BURST - 1) {
+			avtp_shm_sink_flush(sink);
+			pace(&next);
+		}
+	}
+	*cpu_ns = get_cpu_time_ns(RUSAGE_SELF) - *cpu_ns;
+
+	waitpid(pid, NULL, 0);
+	close(sock[0]);
+	avtp_shm_sink_destroy(sink);
+	return 0;
+}
+
+int main(void)
+{
+	uint8_t payload[MAX_PAYLOAD];
+	struct result *res;
+	unsigned int i;
+
+	/* Consumers report back through shared memory. */
+	res = mmap(NULL, sizeof(*res), PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (res == MAP_FAILED) {
+		perror("Failed to map results");
+		return 1;
+	}
+
+	memset(payload, 0x5A, sizeof(payload));
+
+	printf("%8s %8s %14s %14s %8s\n", "payload", "sink", "producer ns",
+					"consumer ns", "lost");
+
+	for (i = 0; i < sizeof(payload_sizes) / sizeof(payload_sizes[0]);
+									i++) {
+		size_t len = payload_sizes[i];
+		uint64_t cpu_ns;
+
+		memset(res, 0, sizeof(*res));
+		if (run_pipe(payload, len, &cpu_ns, res) < 0) {
+			perror("Pipe run failed");
+			return 1;
+		}
+
+		printf("%8zu %8s %14.1f %14.1f %7.2f%%\n", len, "pipe",
+			(double) cpu_ns / PAYLOADS,
+			(double) res->cpu_ns / PAYLOADS,
+			100.0 * (PAYLOADS - res->received) / PAYLOADS);
+
+		memset(res, 0, sizeof(*res));
+		if (run_shm(payload, len, &cpu_ns, res) < 0) {
+			perror("Ring run failed");
+			return 1;
+		}
+
+		printf("%8zu %8s %14.1f %14.1f %7.2f%%\n", len, "shm",
+			(double) cpu_ns / PAYLOADS,
+			(double) res->cpu_ns / PAYLOADS,
+			100.0 * (PAYLOADS - res->received) / PAYLOADS);
+	}
+
+	return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* TSCF benchmark. It batches CAN and CAN FD frames into 1500 byte PDUs and
+ * iterates over them on the receive side, reporting the sustained message
+ * rate of a single core. Frames are 10 us apart and windows 1 ms long, so
+ * PDUs are filled up to the MTU.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp.h"
+#include "avtp_tscf.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define NSEC_PER_USEC		1000ULL
+#define MAX_PDU_SIZE		1500
+#define WINDOW			1000000
+#define MSGS			4096
+#define ROUNDS			500
+
+static const struct {
+	const char *name;
+	uint8_t type;
+	uint8_t len;
+	uint8_t flags;
+} cases[] = {
+	{ "CAN 8", AVTP_ACF_TYPE_CAN, 8, 0 },
+	{ "CAN Brief 8", AVTP_ACF_TYPE_CAN_BRIEF, 8, 0 },
+	{ "CAN FD 64", AVTP_ACF_TYPE_CAN, 64, AVTP_ACF_CAN_FLAG_FDF },
+};
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static int run(unsigned int n, struct avtp_acf_can *msgs, uint8_t *pdus,
+								size_t *lens)
+{
+	struct avtp_tscf_pktzr pktzr;
+	unsigned int i, j, count = 0;
+	uint64_t start, pack, unpack, sum = 0;
+	int res;
+
+	for (i = 0; i < MSGS; i++) {
+		msgs[i].len = cases[n].len;
+		msgs[i].flags = cases[n].flags;
+	}
+
+	res = avtp_tscf_pktzr_init(&pktzr, MAX_PDU_SIZE, WINDOW);
+	if (res < 0)
+		return res;
+
+	start = get_time_ns();
+	for (i = 0; i < ROUNDS; i++) {
+		unsigned int done = 0;
+
+		count = 0;
+		while (done < MSGS) {
+			struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *)
+						(pdus + count * MAX_PDU_SIZE);
+
+			if (i == 0)
+				avtp_tscf_pdu_init(pdu);
+
+			res = avtp_tscf_pktzr_pack_can(&pktzr, pdu,
+						cases[n].type, msgs + done,
+						MSGS - done);
+			if (res < 0)
+				return res;
+
+			done += res;
+			avtp_tscf_pktzr_flush(&pktzr, pdu, &lens[count++]);
+		}
+	}
+	pack = get_time_ns() - start;
+
+	start = get_time_ns();
+	for (i = 0; i < ROUNDS; i++) {
+		for (j = 0; j < count; j++) {
+			struct avtp_tscf_iter iter;
+			struct avtp_acf_msg msg;
+			struct avtp_acf_can can;
+			uint64_t time;
+
+			res = avtp_tscf_iter_init(&iter,
+					(struct avtp_stream_pdu *)
+					(pdus + j * MAX_PDU_SIZE),
+					lens[j], msgs[0].timestamp);
+			if (res < 0)
+				return res;
+
+			while (avtp_tscf_iter_next(&iter, &msg, &time) > 0) {
+				res = avtp_acf_can_read(&msg, &can);
+				if (res < 0)
+					return res;
+
+				sum += can.id + time;
+			}
+		}
+	}
+	unpack = get_time_ns() - start;
+
+	/* Keep the receive loop from being optimized away. */
+	if (sum == 0)
+		return -1;
+
+	printf("%-12s %12.0f %12.0f %10.1f\n", cases[n].name,
+			(double) MSGS * ROUNDS * NSEC_PER_SEC / pack,
+			(double) MSGS * ROUNDS * NSEC_PER_SEC / unpack,
+			(double) MSGS / count);
+
+	return 0;
+}
+
+int main(void)
+{
+	uint8_t data[AVTP_ACF_CAN_MAX_DATA_LEN];
+	struct avtp_acf_can *msgs;
+	uint8_t *pdus;
+	size_t *lens;
+	unsigned int i;
+
+	msgs = calloc(MSGS, sizeof(*msgs));
+	pdus = malloc((size_t) MSGS * MAX_PDU_SIZE);
+	lens = malloc(MSGS * sizeof(*lens));
+	if (!msgs || !pdus || !lens) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = rand();
+
+	for (i = 0; i < MSGS; i++) {
+		msgs[i].timestamp = NSEC_PER_SEC + i * 10 * NSEC_PER_USEC;
+		msgs[i].id = i & 0x7FF;
+		msgs[i].data = data;
+	}
+
+	printf("%-12s %12s %12s %10s\n", "message", "pack msg/s",
+						"iter msg/s", "msgs/PDU");
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		if (run(i, msgs, pdus, lens) < 0) {
+			fprintf(stderr, "%s failed\n", cases[i].name);
+			return 1;
+		}
+	}
+
+	free(msgs);
+	free(pdus);
+	free(lens);
+
+	return 0;
+}
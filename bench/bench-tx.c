@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Transmit benchmark. It sends PDUs made of a 24 byte header and a payload
+ * taken in place from a frame buffer, with and without zero-copy, and
+ * reports the CPU time spent per Gbit of payload for several PDU sizes.
+ *
+ * Usage: bench-tx [IPV4-ADDR PORT]
+ *
+ * By default PDUs are sent via UDP to the loopback interface, where the
+ * kernel always copies zero-copy payloads, so only the per-send overhead of
+ * zero-copy is measured. Pass the address of a remote host (any port, PDUs
+ * are discarded) to measure transmission through a real NIC.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "avtp_tx.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define HEADER_LEN		24
+#define FRAME_LEN		(16 * 1024 * 1024)
+#define TOTAL_BYTES		(2ULL * 1024 * 1024 * 1024)
+#define DEFAULT_PORT		17220
+
+static const size_t payload_sizes[] = { 1400, 8000, 32000, 60000 };
+
+static uint64_t get_cpu_time_ns(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * NSEC_PER_SEC +
+		(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ULL;
+}
+
+static int create_socket(const struct sockaddr_in *addr)
+{
+	int fd, sndbuf = 4 * 1024 * 1024;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		perror("Failed to open socket");
+		return -1;
+	}
+
+	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+	if (connect(fd, (struct sockaddr *) addr, sizeof(*addr)) < 0) {
+		perror("Failed to connect socket");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Wait until the kernel releases zero-copy send 'id'. */
+static int wait_released(struct avtp_tx_zc *zc, int fd, uint32_t id)
+{
+	struct pollfd pfd = { .fd = fd, .events = 0 };
+	int res;
+
+	while (1) {
+		res = avtp_tx_zc_reap(zc);
+		if (res < 0)
+			return res;
+
+		res = avtp_tx_zc_is_released(zc, id);
+		if (res != 0)
+			return res;
+
+		poll(&pfd, 1, 100);
+	}
+}
+
+/* Send TOTAL_BYTES of payload, in 'payload_len' PDUs, and return the CPU
+ * time spent, in ns. Each PDU payload is the next slice of the frame buffer.
+ * With zero-copy, a slice is only reused once the kernel has released it.
+ */
+static int64_t run(const struct sockaddr_in *addr, uint8_t *frame,
+				size_t payload_len, int zerocopy,
+				struct avtp_tx_zc_stats *stats)
+{
+	uint8_t header[HEADER_LEN] = { 0 };
+	unsigned int slices = FRAME_LEN / payload_len;
+	uint32_t *ids = calloc(slices, sizeof(*ids));
+	struct avtp_tx_zc zc;
+	uint64_t sent = 0, start;
+	unsigned int slice = 0;
+	int fd, res;
+
+	fd = create_socket(addr);
+	if (fd < 0 || !ids)
+		goto err;
+
+	if (zerocopy) {
+		res = avtp_tx_zc_init(&zc, fd);
+		if (res < 0) {
+			fprintf(stderr, "Zero-copy not supported: %s\n",
+							strerror(-res));
+			goto err;
+		}
+	}
+
+	start = get_cpu_time_ns();
+	while (sent < TOTAL_BYTES) {
+		struct iovec iov = {
+			frame + slice * payload_len, payload_len
+		};
+		ssize_t n;
+
+		if (zerocopy) {
+			if (sent >= (uint64_t) slices * payload_len) {
+				res = wait_released(&zc, fd, ids[slice]);
+				if (res < 0)
+					goto err;
+			}
+
+			n = avtp_tx_zc_send(&zc, header, HEADER_LEN, &iov, 1,
+							0, &ids[slice]);
+			if (n == -ENOBUFS) {
+				avtp_tx_zc_reap(&zc);
+				continue;
+			}
+		} else {
+			n = avtp_tx_send(fd, NULL, header, HEADER_LEN, &iov, 1,
+									0);
+		}
+
+		/* Nobody listens on the loopback port. */
+		if (n == -ECONNREFUSED)
+			continue;
+		if (n < 0) {
+			fprintf(stderr, "Failed to send: %s\n", strerror(-n));
+			goto err;
+		}
+
+		sent += payload_len;
+		slice = (slice + 1) % slices;
+	}
+
+	if (zerocopy) {
+		uint32_t pending;
+
+		do {
+			avtp_tx_zc_reap(&zc);
+			avtp_tx_zc_get_pending(&zc, &pending);
+		} while (pending);
+
+		avtp_tx_zc_get_stats(&zc, stats);
+	}
+
+	start = get_cpu_time_ns() - start;
+
+	close(fd);
+	free(ids);
+	return start;
+
+err:
+	if (fd >= 0)
+		close(fd);
+	free(ids);
+	return -1;
+}
+
+int main(int argc, char *argv[])
+{
+	struct sockaddr_in addr = { 0 };
+	uint8_t *frame;
+	unsigned int i;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(argc > 2 ? atoi(argv[2]) : DEFAULT_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (argc > 1 && inet_pton(AF_INET, argv[1], &addr.sin_addr) != 1) {
+		fprintf(stderr, "Invalid address %s\n", argv[1]);
+		return 1;
+	}
+
+	frame = malloc(FRAME_LEN);
+	if (!frame) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+	memset(frame, 0x5A, FRAME_LEN);
+
+	printf("%8s %14s %14s %10s\n", "payload", "copy ms/Gbit",
+					"zc ms/Gbit", "zc copied");
+
+	for (i = 0; i < sizeof(payload_sizes) / sizeof(payload_sizes[0]);
+									i++) {
+		struct avtp_tx_zc_stats stats = { 0 };
+		double gbit = TOTAL_BYTES * 8 / 1e9;
+		int64_t copy, zc;
+
+		copy = run(&addr, frame, payload_sizes[i], 0, NULL);
+		zc = run(&addr, frame, payload_sizes[i], 1, &stats);
+		if (copy < 0 || zc < 0)
+			return 1;
+
+		printf("%8zu %14.2f %14.2f %9.0f%%\n", payload_sizes[i],
+			copy / 1e6 / gbit, zc / 1e6 / gbit,
+			stats.completions ?
+			100.0 * stats.copied / stats.completions : 0.0);
+	}
+
+	free(frame);
+
+	return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* IEC 61883-8 video benchmark. It packetizes and depacketizes 1080p frames
+ * (8-bit 4:2:2, 3840 bytes per line) into 1500 byte PDUs and reports the
+ * sustained frame rate of a single core for:
+ *  - pack: building the gather lists, which is all a zero-copy transmit
+ *    path needs;
+ *  - pack+gather: building the gather lists and copying them into a
+ *    transmit buffer, as a copying transmit path would;
+ *  - unpack: writing received PDUs into the frame buffer.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "avtp.h"
+#include "avtp_ieciidc.h"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define WIDTH			1920
+#define HEIGHT			1080
+#define LINE_LEN		(WIDTH * 2)
+#define STRIDE			4096
+#define DBS			60
+#define MAX_PDU_SIZE		1500
+#define MAX_IOV			4
+#define FRAMES			200
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void report(const char *name, uint64_t elapsed, unsigned int pdus)
+{
+	printf("%-12s %10.1f fps %10.2f Gbit/s %8u PDUs/frame\n", name,
+		FRAMES * (double)NSEC_PER_SEC / elapsed,
+		FRAMES * (double)LINE_LEN * HEIGHT * 8 / elapsed, pdus);
+}
+
+int main(void)
+{
+	struct avtp_ieciidc_video tx, rx;
+	struct avtp_ieciidc_video_frame src, dst;
+	struct avtp_stream_pdu *hdr;
+	struct iovec iov[MAX_IOV];
+	uint8_t *pdus, *slot;
+	size_t *lens;
+	unsigned int i, n, count = 0;
+	uint64_t start;
+	int eof, res;
+
+	src.data = malloc(STRIDE * HEIGHT);
+	src.stride = STRIDE;
+	dst.data = malloc(STRIDE * HEIGHT);
+	dst.stride = STRIDE;
+	hdr = malloc(MAX_PDU_SIZE);
+	slot = malloc(MAX_PDU_SIZE);
+	pdus = malloc((size_t)HEIGHT * 4 * MAX_PDU_SIZE);
+	lens = malloc(HEIGHT * 4 * sizeof(*lens));
+	if (!src.data || !dst.data || !hdr || !slot || !pdus || !lens) {
+		fprintf(stderr, "Failed to allocate memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < STRIDE * HEIGHT; i++)
+		src.data[i] = rand();
+
+	res = avtp_ieciidc_video_init(&tx, DBS, LINE_LEN, HEIGHT,
+								MAX_PDU_SIZE);
+	if (res < 0)
+		return 1;
+
+	rx = tx;
+	avtp_ieciidc_video_pdu_init(&tx, hdr);
+
+	/* Keep one frame worth of PDUs for the depacketizer. */
+	do {
+		n = avtp_ieciidc_video_pack(&tx, hdr, &src, iov, MAX_IOV,
+									&eof);
+		lens[count] = 0;
+		for (i = 0; i < n; i++) {
+			memcpy(pdus + count * MAX_PDU_SIZE + lens[count],
+					iov[i].iov_base, iov[i].iov_len);
+			lens[count] += iov[i].iov_len;
+		}
+		count++;
+	} while (!eof);
+
+	start = get_time_ns();
+	for (i = 0; i < FRAMES; i++) {
+		do {
+			avtp_ieciidc_video_pack(&tx, hdr, &src, iov, MAX_IOV,
+									&eof);
+		} while (!eof);
+	}
+	report("pack", get_time_ns() - start, count);
+
+	start = get_time_ns();
+	for (i = 0; i < FRAMES; i++) {
+		do {
+			unsigned int j;
+			size_t len = 0;
+
+			n = avtp_ieciidc_video_pack(&tx, hdr, &src, iov,
+							MAX_IOV, &eof);
+			for (j = 0; j < n; j++) {
+				memcpy(slot + len, iov[j].iov_base,
+							iov[j].iov_len);
+				len += iov[j].iov_len;
+			}
+		} while (!eof);
+	}
+	report("pack+gather", get_time_ns() - start, count);
+
+	start = get_time_ns();
+	for (i = 0; i < FRAMES; i++) {
+		for (n = 0; n < count; n++) {
+			res = avtp_ieciidc_video_unpack(&rx,
+				(struct avtp_stream_pdu *)
+					(pdus + n * MAX_PDU_SIZE),
+				lens[n], &dst);
+			if (res < 0) {
+				fprintf(stderr, "Failed to unpack PDU\n");
+				return 1;
+			}
+		}
+	}
+	report("unpack", get_time_ns() - start, count);
+
+	if (memcmp(src.data, dst.data, LINE_LEN)) {
+		fprintf(stderr, "Frame mismatch\n");
+		return 1;
+	}
+
+	free(src.data);
+	free(dst.data);
+	free(hdr);
+	free(slot);
+	free(pdus);
+	free(lens);
+
+	return 0;
+}
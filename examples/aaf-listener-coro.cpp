@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* AAF Listener example, coroutine version.
+ *
+ * This example does the same as aaf-listener but, instead of a poll() loop
+ * over the socket and a timerfd, it runs the stream as a C++20 coroutine on
+ * top of avtp_coro.hpp: PDUs are received in batches with co_await and each
+ * PCM payload is written to stdout after co_await-ing its presentation time.
+ * The same reactor could run as many stream coroutines as needed.
+ *
+ * It accepts the same AAF streams as aaf-listener (16-bit, 48 kHz, stereo)
+ * and it's used the same way:
+ *
+ * $ aaf-listener-coro <args> | aplay -f dat -t raw -D <playback-device>
+ */
+
+#include <argp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <linux/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <unistd.h>
+
+#include "avtp_coro.hpp"
+#include "avtp_view.hpp"
+#include "examples/common.h"
+
+#define STREAM_ID		0xAABBCCDDEEFF0001
+#define NUM_CHANNELS		2
+#define DATA_LEN		(2 * NUM_CHANNELS)
+#define MAX_PDU_SIZE		1500
+#define BATCH			32
+#define NSEC_PER_SEC		1000000000ULL
+
+static char ifname[IFNAMSIZ];
+static uint8_t macaddr[ETH_ALEN];
+static int max_transit_time;
+static struct avtp_policy *policy;
+
+static struct argp_option options[] = {
+	{"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
+	{"ifname", 'i', "IFNAME", 0, "Network Interface" },
+	{"max-transit-time", 'm', "MSEC", 0, "Maximum Transit Time in ms" },
+	{ 0 }
+};
+
+static error_t parser(int key, char *arg, struct argp_state *state)
+{
+	int res;
+
+	switch (key) {
+	case 'd':
+		res = sscanf(arg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+					&macaddr[0], &macaddr[1], &macaddr[2],
+					&macaddr[3], &macaddr[4], &macaddr[5]);
+		if (res != 6) {
+			fprintf(stderr, "Invalid address\n");
+			exit(EXIT_FAILURE);
+		}
+
+		break;
+	case 'i':
+		strncpy(ifname, arg, sizeof(ifname) - 1);
+		break;
+	case 'm':
+		max_transit_time = atoi(arg);
+		break;
+	}
+
+	return 0;
+}
+
+static struct argp argp = { options, parser };
+
+static bool is_valid_packet(const avtp::ConstAafView &view)
+{
+	using namespace avtp::aaf;
+
+	return view.get<version>() == 0 && view.get<tv>() == 1 &&
+		view.get<sp>() == AVTP_AAF_PCM_SP_NORMAL &&
+		view.get<stream_id>() == STREAM_ID &&
+		view.get<format>() == AVTP_AAF_FORMAT_INT_16BIT &&
+		view.get<nsr>() == AVTP_AAF_PCM_NSR_48KHZ &&
+		view.get<chan_per_frame>() == NUM_CHANNELS &&
+		view.get<bit_depth>() == 16 &&
+		view.payload().size() == DATA_LEN;
+}
+
+static avtp::task run_stream(avtp::reactor &r, avtp::receiver &rx,
+							avtp::timer &tm)
+{
+	uint8_t expected_seq = 0;
+
+	while (true) {
+		int n = co_await rx.recv();
+
+		if (n < 0) {
+			fprintf(stderr, "Failed to receive data: %d\n", n);
+			break;
+		}
+
+		for (int i = 0; i < n; i++) {
+			avtp::ConstAafView view;
+			struct timespec tspec;
+			enum avtp_policy_action action;
+			uint8_t data[DATA_LEN];
+
+			if (view.init(rx.packet(i)) < 0 ||
+						!is_valid_packet(view)) {
+				fprintf(stderr, "Dropping packet\n");
+				continue;
+			}
+
+			if (view.get<avtp::aaf::seq_num>() != expected_seq) {
+				fprintf(stderr, "Sequence number mismatch: expected %u, got %u\n",
+					expected_seq,
+					view.get<avtp::aaf::seq_num>());
+				expected_seq = view.get<avtp::aaf::seq_num>();
+			}
+			expected_seq++;
+
+			if (get_presentation_time(policy,
+					view.get<avtp::aaf::timestamp>(),
+					&tspec, &action) < 0)
+				goto out;
+
+			if (action == AVTP_POLICY_ACTION_DROP) {
+				fprintf(stderr, "Dropping late packet\n");
+				continue;
+			}
+
+			/* Later PDUs of the batch wait in the receiver
+			 * buffers until this one is presented.
+			 */
+			if (co_await tm.sleep_until(tspec.tv_sec * NSEC_PER_SEC +
+							tspec.tv_nsec) < 0)
+				goto out;
+
+			memcpy(data, view.payload().data(), DATA_LEN);
+			if (present_data(data, DATA_LEN) < 0)
+				goto out;
+		}
+	}
+
+out:
+	r.stop();
+}
+
+int main(int argc, char *argv[])
+{
+	avtp::reactor r;
+	avtp::receiver rx;
+	avtp::timer tm;
+	int fd, res;
+
+	argp_parse(&argp, argc, argv, 0, NULL, NULL);
+
+	if (create_policy(&policy, max_transit_time) < 0)
+		return 1;
+
+	fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
+	if (fd < 0) {
+		avtp_policy_destroy(policy);
+		return 1;
+	}
+
+	res = r.init();
+	if (res < 0)
+		goto err;
+
+	res = rx.init(r, fd, BATCH, MAX_PDU_SIZE);
+	if (res < 0)
+		goto err;
+
+	res = tm.init(r);
+	if (res < 0)
+		goto err;
+
+	run_stream(r, rx, tm);
+
+	res = r.run();
+
+err:
+	if (res < 0)
+		fprintf(stderr, "Listener failed: %s\n", strerror(-res));
+
+	avtp_policy_destroy(policy);
+	close(fd);
+	return 1;
+}
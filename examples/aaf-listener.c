@@ -52,9 +52,26 @@
  * stream, you should do something like this:
  *
  * $ aaf-listener <args> | aplay -f dat -t raw -D <playback-device>
+ *
+ * Alternatively, with '--shm PATH' samples are not written to stdout but
+ * published, along with their presentation time, into a shared memory ring
+ * (see avtp_shm.h). Consumers connect to the Unix socket at PATH to get the
+ * ring, e.g. 'shm-reader PATH'.
+ *
+ * With '--window USEC', samples due within USEC microseconds of each other
+ * are written to stdout together, with a single writev() (see avtp_batch.h).
+ * Samples may then be written up to USEC early.
+ *
+ * With '--stats PATH', stream statistics are exported to the file PATH, e.g.
+ * in /dev/shm, and can be watched live with 'avtp-stat PATH'.
+ *
+ * Samples are classified by their presentation time (see avtp_policy.h), so
+ * '--max-transit-time' should match the talker's. Samples too early, or
+ * from another timestamp wrap, are dropped. What happens to late samples is
+ * set with '--late': 'now' writes them right away, 'conceal' writes silence
+ * in their place and 'drop' drops them.
  */
 
-#include <assert.h>
 #include <argp.h>
 #include <arpa/inet.h>
 #include <linux/if.h>
@@ -64,13 +81,19 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/queue.h>
+#include <sys/socket.h>
 #include <sys/timerfd.h>
+#include <sys/un.h>
 #include <unistd.h>
 #include <inttypes.h>
 
 #include "avtp.h"
 #include "avtp_aaf.h"
+#include "avtp_batch.h"
+#include "avtp_policy.h"
+#include "avtp_sched.h"
+#include "avtp_shm.h"
+#include "avtp_stats.h"
 #include "examples/common.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
@@ -79,22 +102,40 @@
 #define DATA_LEN		(SAMPLE_SIZE * NUM_CHANNELS)
 #define PDU_SIZE		(sizeof(struct avtp_stream_pdu) + DATA_LEN)
 #define NSEC_PER_SEC		1000000000ULL
+#define SHM_RING_SIZE		(1 << 20)
+#define NSEC_PER_USEC		1000ULL
+#define BATCH_MAX_SAMPLES	4096
+#define MAX_SAMPLES		48000 /* 1 s of stream. */
 
 struct sample_entry {
-	STAILQ_ENTRY(sample_entry) entries;
-
-	struct timespec tspec;
 	uint8_t pcm_sample[DATA_LEN];
 };
 
-static STAILQ_HEAD(sample_queue, sample_entry) samples;
+static struct avtp_sched *sched;
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static uint8_t expected_seq;
+static char *shm_path;
+static struct avtp_shm_sink *shm_sink;
+static int window = -1;
+static struct avtp_batch_sink *batch_sink;
+static char *stats_path;
+static struct avtp_stats *stats;
+static struct avtp_stats_counters *counters;
+static int max_transit_time;
+static struct avtp_policy *policy;
+static enum avtp_policy_action late_action = AVTP_POLICY_ACTION_PRESENT_NOW;
 
 static struct argp_option options[] = {
 	{"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
 	{"ifname", 'i', "IFNAME", 0, "Network Interface" },
+	{"late", 'l', "ACTION", 0, "What to do with late samples: 'now' "
+				"(default), 'conceal' or 'drop'" },
+	{"max-transit-time", 'm', "MSEC", 0, "Maximum Transit Time in ms" },
+	{"shm", 's', "PATH", 0, "Publish samples to shared memory, serving "
+				"the ring on Unix socket PATH" },
+	{"stats", 'S', "PATH", 0, "Export stream statistics to PATH" },
+	{"window", 'w', "USEC", 0, "Write samples due within USEC together" },
 	{ 0 }
 };
 
@@ -116,6 +157,31 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 	case 'i':
 		strncpy(ifname, arg, sizeof(ifname) - 1);
 		break;
+	case 'l':
+		if (!strcmp(arg, "now")) {
+			late_action = AVTP_POLICY_ACTION_PRESENT_NOW;
+		} else if (!strcmp(arg, "conceal")) {
+			late_action = AVTP_POLICY_ACTION_CONCEAL;
+		} else if (!strcmp(arg, "drop")) {
+			late_action = AVTP_POLICY_ACTION_DROP;
+		} else {
+			fprintf(stderr, "Invalid late action\n");
+			exit(EXIT_FAILURE);
+		}
+
+		break;
+	case 'm':
+		max_transit_time = atoi(arg);
+		break;
+	case 's':
+		shm_path = arg;
+		break;
+	case 'S':
+		stats_path = arg;
+		break;
+	case 'w':
+		window = atoi(arg);
+		break;
 	}
 
 	return 0;
@@ -127,6 +193,7 @@ static struct argp argp = { options, parser };
 static int schedule_sample(int fd, struct timespec *tspec, uint8_t *pcm_sample)
 {
 	struct sample_entry *entry;
+	int res;
 
 	entry = malloc(sizeof(*entry));
 	if (!entry) {
@@ -134,22 +201,21 @@ static int schedule_sample(int fd, struct timespec *tspec, uint8_t *pcm_sample)
 		return -1;
 	}
 
-	entry->tspec.tv_sec = tspec->tv_sec;
-	entry->tspec.tv_nsec = tspec->tv_nsec;
 	memcpy(entry->pcm_sample, pcm_sample, DATA_LEN);
 
-	STAILQ_INSERT_TAIL(&samples, entry, entries);
-
-	/* If this was the first entry inserted onto the queue, we need to arm
-	 * the timer.
-	 */
-	if (STAILQ_FIRST(&samples) == entry) {
-		int res;
+	res = avtp_sched_push(sched, tspec->tv_sec * NSEC_PER_SEC +
+							tspec->tv_nsec, entry);
+	if (res < 0) {
+		fprintf(stderr, "Failed to schedule sample: %d\n", res);
+		free(entry);
+		return -1;
+	}
 
-		res = arm_timer(fd, tspec);
+	/* If this is the next sample due, the timer needs to be re-armed. */
+	if (res == 1) {
+		res = avtp_sched_arm_timer(sched, fd);
 		if (res < 0) {
-			STAILQ_REMOVE(&samples, entry, sample_entry, entries);
-			free(entry);
+			fprintf(stderr, "Failed to arm timer: %d\n", res);
 			return -1;
 		}
 	}
@@ -157,6 +223,71 @@ static int schedule_sample(int fd, struct timespec *tspec, uint8_t *pcm_sample)
 	return 0;
 }
 
+static int arm_batch_timer(int fd)
+{
+	struct timespec tspec;
+	uint64_t deadline;
+
+	if (avtp_batch_sink_get_deadline(batch_sink, &deadline) <= 0)
+		return 0;
+
+	tspec.tv_sec = deadline / NSEC_PER_SEC;
+	tspec.tv_nsec = deadline % NSEC_PER_SEC;
+
+	return arm_timer(fd, &tspec);
+}
+
+/* Queue 'pcm_sample' to the batch sink, arming the timer if the sink was
+ * idle.
+ */
+static int batch_sample(int fd, struct timespec *tspec, uint8_t *pcm_sample)
+{
+	uint64_t deadline;
+	int pending, res;
+
+	pending = avtp_batch_sink_get_deadline(batch_sink, &deadline);
+
+	res = avtp_batch_sink_queue(batch_sink, pcm_sample, DATA_LEN,
+				tspec->tv_sec * NSEC_PER_SEC + tspec->tv_nsec);
+	if (res < 0) {
+		fprintf(stderr, "Failed to queue sample: %d\n", res);
+		return -1;
+	}
+
+	return pending ? 0 : arm_batch_timer(fd);
+}
+
+static int batch_timeout(int fd)
+{
+	struct timespec now;
+	uint64_t expirations;
+	ssize_t n;
+	int res;
+
+	n = read(fd, &expirations, sizeof(uint64_t));
+	if (n < 0) {
+		perror("Failed to read timerfd");
+		return -1;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	res = avtp_batch_sink_flush(batch_sink,
+				now.tv_sec * NSEC_PER_SEC + now.tv_nsec);
+	if (res < 0) {
+		fprintf(stderr, "Failed to write samples: %d\n", res);
+		return -1;
+	}
+
+	return arm_batch_timer(fd);
+}
+
+static void count_invalid(enum avtp_stats_invalid field)
+{
+	if (counters)
+		counters->invalid[field]++;
+}
+
 static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 {
 	struct avtp_common_pdu *common = (struct avtp_common_pdu *) pdu;
@@ -172,6 +303,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val32 != AVTP_SUBTYPE_AAF) {
 		fprintf(stderr, "Subtype mismatch: expected %u, got %u\n",
 						AVTP_SUBTYPE_AAF, val32);
+		count_invalid(AVTP_STATS_INVALID_SUBTYPE);
 		return false;
 	}
 
@@ -183,6 +315,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val32 != 0) {
 		fprintf(stderr, "Version mismatch: expected %u, got %u\n",
 								0, val32);
+		count_invalid(AVTP_STATS_INVALID_VERSION);
 		return false;
 	}
 
@@ -194,6 +327,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != 1) {
 		fprintf(stderr, "tv mismatch: expected %u, got %" PRIu64 "\n",
 								1, val64);
+		count_invalid(AVTP_STATS_INVALID_TV);
 		return false;
 	}
 
@@ -205,6 +339,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != AVTP_AAF_PCM_SP_NORMAL) {
 		fprintf(stderr, "sp mismatch: expected %u, got %" PRIu64 "\n",
 						AVTP_AAF_PCM_SP_NORMAL, val64);
+		count_invalid(AVTP_STATS_INVALID_SP);
 		return false;
 	}
 
@@ -216,6 +351,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != STREAM_ID) {
 		fprintf(stderr, "Stream ID mismatch: expected %" PRIu64 ", got %" PRIu64 "\n",
 							STREAM_ID, val64);
+		count_invalid(AVTP_STATS_INVALID_STREAM_ID);
 		return false;
 	}
 
@@ -232,6 +368,8 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 		 */
 		fprintf(stderr, "Sequence number mismatch: expected %u, got %" PRIu64 "\n",
 							expected_seq, val64);
+		if (counters)
+			counters->seq_gaps += (uint8_t) (val64 - expected_seq);
 		expected_seq = val64;
 	}
 
@@ -245,6 +383,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != AVTP_AAF_FORMAT_INT_16BIT) {
 		fprintf(stderr, "Format mismatch: expected %u, got %" PRIu64 "\n",
 					AVTP_AAF_FORMAT_INT_16BIT, val64);
+		count_invalid(AVTP_STATS_INVALID_FORMAT);
 		return false;
 	}
 
@@ -256,6 +395,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != AVTP_AAF_PCM_NSR_48KHZ) {
 		fprintf(stderr, "Sample rate mismatch: expected %u, got %" PRIu64 "\n",
 						AVTP_AAF_PCM_NSR_48KHZ, val64);
+		count_invalid(AVTP_STATS_INVALID_RATE);
 		return false;
 	}
 
@@ -267,6 +407,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != NUM_CHANNELS) {
 		fprintf(stderr, "Channels mismatch: expected %u, got %" PRIu64 "\n",
 							NUM_CHANNELS, val64);
+		count_invalid(AVTP_STATS_INVALID_CHANNELS);
 		return false;
 	}
 
@@ -278,6 +419,7 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != 16) {
 		fprintf(stderr, "Depth mismatch: expected %u, got %" PRIu64 "\n",
 								16, val64);
+		count_invalid(AVTP_STATS_INVALID_DEPTH);
 		return false;
 	}
 
@@ -289,18 +431,42 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	if (val64 != DATA_LEN) {
 		fprintf(stderr, "Data len mismatch: expected %u, got %" PRIu64 "\n",
 							DATA_LEN, val64);
+		count_invalid(AVTP_STATS_INVALID_DATA_LEN);
 		return false;
 	}
 
 	return true;
 }
 
+static void count_drop(enum avtp_policy_class pdu_class)
+{
+	if (!counters)
+		return;
+
+	if (pdu_class == AVTP_POLICY_CLASS_EARLY)
+		counters->early_drops++;
+	else
+		counters->late_drops++;
+}
+
+static void record_margin(const struct timespec *tspec)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	avtp_stats_margin(counters,
+		(int64_t) (tspec->tv_sec - now.tv_sec) * (int64_t) NSEC_PER_SEC +
+				(tspec->tv_nsec - now.tv_nsec));
+}
+
 static int new_packet(int sk_fd, int timer_fd)
 {
 	int res;
 	ssize_t n;
 	uint64_t avtp_time;
 	struct timespec tspec;
+	enum avtp_policy_action action;
 	struct avtp_stream_pdu *pdu = alloca(PDU_SIZE);
 
 	memset(pdu, 0, PDU_SIZE);
@@ -311,6 +477,9 @@ static int new_packet(int sk_fd, int timer_fd)
 		return -1;
 	}
 
+	if (counters)
+		avtp_stats_packet(counters, n);
+
 	if (!is_valid_packet(pdu)) {
 		fprintf(stderr, "Dropping packet\n");
 		return 0;
@@ -322,10 +491,38 @@ static int new_packet(int sk_fd, int timer_fd)
 		return -1;
 	}
 
-	res = get_presentation_time(avtp_time, &tspec);
+	res = get_presentation_time(policy, avtp_time, &tspec, &action);
 	if (res < 0)
 		return -1;
 
+	if (action == AVTP_POLICY_ACTION_DROP) {
+		count_drop(res);
+		return 0;
+	}
+
+	/* Silence is all zeros in signed 16-bit PCM. */
+	if (action == AVTP_POLICY_ACTION_CONCEAL)
+		memset(pdu->avtp_payload, 0, DATA_LEN);
+
+	if (counters)
+		record_margin(&tspec);
+
+	/* Shared memory consumers schedule samples on their own. */
+	if (shm_sink) {
+		res = avtp_shm_sink_write(shm_sink, pdu->avtp_payload, DATA_LEN,
+				tspec.tv_sec * NSEC_PER_SEC + tspec.tv_nsec);
+		if (res < 0) {
+			fprintf(stderr, "Failed to publish sample: %d\n", res);
+			return -1;
+		}
+
+		avtp_shm_sink_flush(shm_sink);
+		return 0;
+	}
+
+	if (batch_sink)
+		return batch_sample(timer_fd, &tspec, pdu->avtp_payload);
+
 	res = schedule_sample(timer_fd, &tspec, pdu->avtp_payload);
 	if (res < 0)
 		return -1;
@@ -338,7 +535,9 @@ static int timeout(int fd)
 	int res;
 	ssize_t n;
 	uint64_t expirations;
+	struct timespec now;
 	struct sample_entry *entry;
+	void *data;
 
 	n = read(fd, &expirations, sizeof(uint64_t));
 	if (n < 0) {
@@ -346,38 +545,91 @@ static int timeout(int fd)
 		return -1;
 	}
 
-	assert(expirations == 1);
+	clock_gettime(CLOCK_REALTIME, &now);
 
-	entry = STAILQ_FIRST(&samples);
-	assert(entry != NULL);
+	while (avtp_sched_pop(sched, now.tv_sec * NSEC_PER_SEC + now.tv_nsec,
+							NULL, &data) == 1) {
+		entry = data;
 
-	res = present_data(entry->pcm_sample, DATA_LEN);
-	if (res < 0)
+		res = present_data(entry->pcm_sample, DATA_LEN);
+		free(entry);
+		if (res < 0)
+			return -1;
+	}
+
+	res = avtp_sched_arm_timer(sched, fd);
+	if (res < 0) {
+		fprintf(stderr, "Failed to arm timer: %d\n", res);
 		return -1;
+	}
 
-	STAILQ_REMOVE_HEAD(&samples, entries);
-	free(entry);
+	return 0;
+}
 
-	if (!STAILQ_EMPTY(&samples)) {
-		entry = STAILQ_FIRST(&samples);
+static int create_shm_socket(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd, res;
 
-		res = arm_timer(fd, &entry->tspec);
-		if (res < 0)
-			return -1;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path too long\n");
+		return -1;
+	}
+
+	strcpy(addr.sun_path, path);
+	unlink(path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		perror("Failed to open Unix socket");
+		return -1;
+	}
+
+	res = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+	if (res < 0) {
+		perror("Failed to bind() Unix socket");
+		goto err;
 	}
 
+	res = listen(fd, 8);
+	if (res < 0) {
+		perror("Failed to listen() on Unix socket");
+		goto err;
+	}
+
+	return fd;
+
+err:
+	close(fd);
+	return -1;
+}
+
+/* Hand the ring over to a new consumer. */
+static int new_consumer(int fd)
+{
+	int client, res;
+
+	client = accept(fd, NULL, NULL);
+	if (client < 0) {
+		perror("Failed to accept() consumer");
+		return -1;
+	}
+
+	res = avtp_shm_send_fds(shm_sink, client);
+	if (res < 0)
+		fprintf(stderr, "Failed to send ring to consumer: %d\n", res);
+
+	close(client);
 	return 0;
 }
 
 int main(int argc, char *argv[])
 {
-	int sk_fd, timer_fd, res;
-	struct pollfd fds[2];
+	int sk_fd, timer_fd, shm_fd = -1, res;
+	struct pollfd fds[3];
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
-	STAILQ_INIT(&samples);
-
 	sk_fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
 	if (sk_fd < 0)
 		return 1;
@@ -392,9 +644,63 @@ int main(int argc, char *argv[])
 	fds[0].events = POLLIN;
 	fds[1].fd = timer_fd;
 	fds[1].events = POLLIN;
+	fds[2].fd = -1;
+	fds[2].events = POLLIN;
+
+	res = create_policy(&policy, max_transit_time);
+	if (res < 0)
+		goto err;
+
+	res = avtp_sched_create(&sched, MAX_SAMPLES);
+	if (res < 0) {
+		fprintf(stderr, "Failed to create scheduler: %d\n", res);
+		goto err;
+	}
+
+	avtp_policy_set_action(policy, AVTP_POLICY_CLASS_LATE, late_action);
+
+	if (stats_path) {
+		unsigned int index;
+
+		res = avtp_stats_create(&stats, stats_path, 1, 1);
+		if (res < 0) {
+			fprintf(stderr, "Failed to create stats: %d\n", res);
+			goto err;
+		}
+
+		avtp_stats_add_stream(stats, STREAM_ID, "aaf-listener", &index);
+		counters = avtp_stats_get_counters(stats, 0, index);
+	}
+
+	if (window >= 0) {
+		res = avtp_batch_sink_create(&batch_sink, STDOUT_FILENO,
+					window * NSEC_PER_USEC,
+					BATCH_MAX_SAMPLES,
+					BATCH_MAX_SAMPLES * DATA_LEN);
+		if (res < 0) {
+			fprintf(stderr, "Failed to create batch sink: %d\n",
+									res);
+			goto err;
+		}
+	}
+
+	if (shm_path) {
+		res = avtp_shm_sink_create(&shm_sink, "aaf-listener",
+								SHM_RING_SIZE);
+		if (res < 0) {
+			fprintf(stderr, "Failed to create shm sink: %d\n", res);
+			goto err;
+		}
+
+		shm_fd = create_shm_socket(shm_path);
+		if (shm_fd < 0)
+			goto err;
+
+		fds[2].fd = shm_fd;
+	}
 
 	while (1) {
-		res = poll(fds, 2, -1);
+		res = poll(fds, 3, -1);
 		if (res < 0) {
 			perror("Failed to poll() fds");
 			goto err;
@@ -407,7 +713,14 @@ int main(int argc, char *argv[])
 		}
 
 		if (fds[1].revents & POLLIN) {
-			res = timeout(timer_fd);
+			res = batch_sink ? batch_timeout(timer_fd) :
+							timeout(timer_fd);
+			if (res < 0)
+				goto err;
+		}
+
+		if (fds[2].revents & POLLIN) {
+			res = new_consumer(shm_fd);
 			if (res < 0)
 				goto err;
 		}
@@ -416,6 +729,15 @@ int main(int argc, char *argv[])
 	return 0;
 
 err:
+	if (shm_fd >= 0) {
+		close(shm_fd);
+		unlink(shm_path);
+	}
+	avtp_shm_sink_destroy(shm_sink);
+	avtp_batch_sink_destroy(batch_sink);
+	avtp_stats_destroy(stats);
+	avtp_policy_destroy(policy);
+	avtp_sched_destroy(sched);
 	close(sk_fd);
 	close(timer_fd);
 	return 1;
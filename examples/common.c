@@ -63,7 +63,23 @@ int calculate_avtp_time(uint32_t *avtp_time, uint32_t max_transit_time)
 	return 0;
 }
 
-int get_presentation_time(uint64_t avtp_time, struct timespec *tspec)
+int create_policy(struct avtp_policy **policy, uint32_t max_transit_time)
+{
+	int res;
+
+	res = avtp_policy_create(policy, max_transit_time * NSEC_PER_MSEC,
+							NSEC_PER_MSEC);
+	if (res < 0) {
+		fprintf(stderr, "Failed to create policy: %d\n", res);
+		return -1;
+	}
+
+	return 0;
+}
+
+int get_presentation_time(struct avtp_policy *policy, uint64_t avtp_time,
+				struct timespec *tspec,
+				enum avtp_policy_action *action)
 {
 	int res;
 	uint64_t ptime, now;
@@ -78,21 +94,17 @@ int get_presentation_time(uint64_t avtp_time, struct timespec *tspec)
 
 	/* The avtp_timestamp within AAF packet is the lower part (32
 	 * less-significant bits) from presentation time calculated by the
-	 * talker.
-	 */
-	ptime = (now & 0xFFFFFFFF00000000ULL) | avtp_time;
-
-	/* If 'ptime' is less than the 'now', it means the higher part
-	 * from 'ptime' needs to be incremented by 1 in order to recover the
-	 * presentation time set by the talker.
+	 * talker. The policy recovers the higher part and tells late or
+	 * bogus timestamps apart from the ones to be scheduled.
 	 */
-	if (ptime < now)
-		ptime += (1ULL << 32);
+	res = avtp_policy_classify(policy, avtp_time, now, &ptime, action);
+	if (res < 0)
+		return -1;
 
 	tspec->tv_sec = ptime / NSEC_PER_SEC;
 	tspec->tv_nsec = ptime % NSEC_PER_SEC;
 
-	return 0;
+	return res;
 }
 
 int setup_socket_address(int fd, const char *ifname, uint8_t macaddr[],
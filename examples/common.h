@@ -27,6 +27,12 @@
 
 #include <stdint.h>
 
+#include "avtp_policy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* Calculate AVTP presentation time based on current time and informed
  * max_transit_time.
  * @avtp_time: Pointer to variable which the calculated time should be saved.
@@ -38,16 +44,33 @@
  */
 int calculate_avtp_time(uint32_t *avtp_time, uint32_t max_transit_time);
 
+/* Create late/early packet policy for a listener, accepting PDUs up to
+ * 1 ms around the window set by max_transit_time.
+ * @policy: Pointer to variable which the policy should be saved. It must be
+ *          destroyed with avtp_policy_destroy() when no longer needed.
+ * @max_transit_time: Max transit time for the network, in ms, as given to
+ *                    the talker.
+ *
+ * Returns:
+ *    0: Success.
+ *    -1: Could not create policy.
+ */
+int create_policy(struct avtp_policy **policy, uint32_t max_transit_time);
+
 /* Given an AVTP presentation time, retrieve correspondent time on
- * CLOCK_REALTIME.
+ * CLOCK_REALTIME and what to do with the PDU, according to 'policy'.
+ * @policy: Late/early packet policy.
  * @avtp_time: AVTP presentation time to be converted.
  * @ts: Pointer to struct timespec where obtained time should be saved.
+ * @action: Pointer to variable which the action to be taken should be saved.
  *
  * Returns:
- *    0: Success.
+ *    >= 0: Class of the PDU, an enum avtp_policy_class.
  *    -1: If could not get CLOCK_REALTIME.
  */
-int get_presentation_time(uint64_t avtp_time, struct timespec *tspec);
+int get_presentation_time(struct avtp_policy *policy, uint64_t avtp_time,
+				struct timespec *tspec,
+				enum avtp_policy_action *action);
 
 /* Create TSN socket to listen for incomimg packets.
  * @ifname: Network interface name where to create the socket.
@@ -103,3 +126,7 @@ int present_data(uint8_t *data, size_t len);
  *    -1: Could not arm timer.
  */
 int arm_timer(int fd, struct timespec *tspec);
+
+#ifdef __cplusplus
+}
+#endif
@@ -93,6 +93,7 @@
 #include <sys/param.h>
 #include <sys/queue.h>
 #include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
 #include <math.h>
 #include <inttypes.h>
@@ -123,6 +124,15 @@
 #define AAF_PERIOD		(NSEC_PER_SEC * AAF_NUM_SAMPLES / AAF_SAMPLE_RATE)
 #define MCLK_PERIOD		AAF_PERIOD
 #define MCLKLIST_TS_PER_CRF	(CRF_SAMPLE_RATE / CRF_TIMESTAMPS_PER_SEC)
+/* Maximum deviation allowed between CRF timestamps and their nominal position,
+ * a quarter of the sample period as in Equation 16 from spec 1722.
+ */
+#define CRF_TOLERANCE_NS	(NSEC_PER_SEC / CRF_SAMPLE_RATE / 4)
+/* Media clock servo parameters: 1 Hz loop bandwidth and holdover after 5 CRF
+ * PDUs are missed.
+ */
+#define CRF_SERVO_BANDWIDTH	1000
+#define CRF_SERVO_HOLDOVER	(100 * NSEC_PER_MSEC)
 
 #define NSEC_PER_SEC		1000000000ULL
 #define NSEC_PER_MSEC		1000000ULL
@@ -149,6 +159,9 @@ static uint8_t crf_seq_num;
 static uint8_t aaf_seq_num;
 static uint64_t prev_mclk_timestamp, rounded_mtt;
 static STAILQ_HEAD(timestamp_queue, media_clock_entry) mclk_timestamps;
+static struct avtp_crf_drift crf_drift;
+static struct avtp_crf_servo crf_servo;
+static uint8_t prev_servo_state = AVTP_CRF_SERVO_UNLOCKED;
 
 static struct argp_option options[] = {
 	{"crf-addr", 'c', "MACADDR", 0, "CRF Stream Destination MAC address" },
@@ -392,6 +405,13 @@ static bool is_valid_crf_pdu(struct avtp_crf_pdu *pdu)
 		return false;
 	}
 
+	res = avtp_crf_pdu_validate(pdu, CRF_PDU_SIZE, CRF_TOLERANCE_NS,
+								&crf_drift);
+	if (res < 0) {
+		fprintf(stderr, "CRF: Invalid timestamp list: %d\n", res);
+		return false;
+	}
+
 	return true;
 }
 
@@ -620,23 +640,77 @@ static int aaf_talker_tx_timeout(int fd_timer, int fd_sk,
 	return 0;
 }
 
+static int get_time_ns(uint64_t *now)
+{
+	int res;
+	struct timespec tspec;
+
+	res = clock_gettime(CLOCK_REALTIME, &tspec);
+	if (res < 0) {
+		perror("Failed to get time");
+		return -1;
+	}
+
+	*now = (tspec.tv_sec * NSEC_PER_SEC) + tspec.tv_nsec;
+
+	return 0;
+}
+
+static void report_servo_state(uint64_t now)
+{
+	struct avtp_crf_servo_status status;
+
+	avtp_crf_servo_get_status(&crf_servo, now, &status);
+	if (status.state == prev_servo_state)
+		return;
+
+	switch (status.state) {
+	case AVTP_CRF_SERVO_LOCKED:
+		printf("Media clock locked (%" PRId64 " ppb)\n", status.ppb);
+		break;
+	case AVTP_CRF_SERVO_HOLDOVER:
+		printf("Media clock in holdover\n");
+		break;
+	default:
+		printf("Media clock unlocked (phase error %" PRId64 " ns)\n",
+							status.phase_error);
+		break;
+	}
+
+	prev_servo_state = status.state;
+}
+
 /* This routine generates media clock timestamps using timestamps from CRF
  * stream.
  */
 static int recover_mclk(struct avtp_crf_pdu *pdu)
 {
 	int res, idx;
-	uint64_t ts_mclk, ts_crf;
+	uint64_t ts_mclk, now;
+
+	res = get_time_ns(&now);
+	if (res < 0)
+		return res;
 
-	/* To recover the media clock we consider only the first timestamp from
-	 * CRF PDU since the others timestamps are incremented monotonically
-	 * from the first timestamp (see Section 10.7 from IEEE 1722-2016
-	 * spec).
+	/* Every timestamp from the CRF PDU is fed to the media clock servo,
+	 * which filters out the network jitter. The media clock timestamps
+	 * are then taken from the servo, starting at the last CRF timestamp
+	 * tracked.
 	 */
-	ts_crf = be64toh(pdu->crf_data[0]);
+	for (idx = 0; idx < TIMESTAMPS_PER_PKT; idx++) {
+		res = avtp_crf_servo_update(&crf_servo,
+					be64toh(pdu->crf_data[idx]), now);
+		if (res < 0)
+			return res;
+	}
+
+	report_servo_state(now);
 
 	for (idx = 0; idx < MCLKLIST_TS_PER_CRF; idx++) {
-		ts_mclk = ts_crf + (idx * MCLK_PERIOD);
+		res = avtp_crf_servo_get_time(&crf_servo,
+					idx * AAF_NUM_SAMPLES, &ts_mclk);
+		if (res < 0)
+			return res;
 
 		if (mode == MODE_TALKER) {
 			/* If we are operating in talker mode, the max transit
@@ -960,11 +1034,22 @@ static int aaf_listener(int fd_rx)
 
 int main(int argc, char *argv[])
 {
-	int fd_rx;
+	int fd_rx, res;
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
 	STAILQ_INIT(&mclk_timestamps);
+	avtp_crf_drift_init(&crf_drift);
+	res = avtp_crf_servo_init(&crf_servo, AVTP_CRF_PULL_MULT_BY_1,
+				CRF_SAMPLE_RATE,
+				CRF_SAMPLE_RATE / CRF_TIMESTAMPS_PER_SEC,
+				CRF_SERVO_BANDWIDTH, CRF_TOLERANCE_NS,
+				CRF_SERVO_HOLDOVER);
+	if (res < 0) {
+		fprintf(stderr, "Failed to init CRF servo: %d\n", res);
+		return 1;
+	}
+
 	rounded_mtt = ceil((double)mtt / MCLK_PERIOD) * MCLK_PERIOD;
 
 	fd_rx = setup_rx_socket();
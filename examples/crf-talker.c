@@ -80,7 +80,6 @@
 #define DATA_LEN		(sizeof(uint64_t) * TIMESTAMPS_PER_PKT)
 #define PDU_SIZE		(sizeof(struct avtp_crf_pdu) + DATA_LEN)
 #define PDUS_PER_SEC		(TIMESTAMPS_PER_SEC / TIMESTAMPS_PER_PKT)
-#define CRF_PERIOD		(NSEC_PER_SEC / TIMESTAMPS_PER_SEC)
 #define NOMINAL_PERIOD		(1.0 / SAMPLE_RATE)
 #define TX_INTERVAL		(NSEC_PER_SEC / PDUS_PER_SEC)
 
@@ -149,11 +148,14 @@ static uint64_t calculate_crf_timestamp(struct timespec tspec, uint64_t rounded_
 	return crf_time;
 }
 
-static int init_pdu(struct avtp_crf_pdu *pdu)
+static int init_pdu(struct avtp_crf_gen *gen, struct avtp_crf_pdu *pdu)
 {
 	int res;
 
-	res = avtp_crf_pdu_init(pdu);
+	/* The generator sets 'type', 'pull', 'base_frequency' and
+	 * 'timestamp_interval' fields according to its configuration.
+	 */
+	res = avtp_crf_gen_pdu_init(gen, pdu);
 	if (res < 0)
 		return -1;
 
@@ -161,44 +163,20 @@ static int init_pdu(struct avtp_crf_pdu *pdu)
 	if (res < 0)
 		return -1;
 
-	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_TYPE,
-						AVTP_CRF_TYPE_AUDIO_SAMPLE);
-	if (res < 0)
-		return -1;
-
 	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_STREAM_ID, STREAM_ID);
 	if (res < 0)
 		return -1;
 
-	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_PULL,
-						AVTP_CRF_PULL_MULT_BY_1);
-	if (res < 0)
-		return -1;
-
-	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_BASE_FREQ,
-							SAMPLE_RATE);
-	if (res < 0)
-		return -1;
-
-	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_TIMESTAMP_INTERVAL,
-							TIMESTAMP_INTERVAL);
-	if (res < 0)
-		return -1;
-
-	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN, DATA_LEN);
-	if (res < 0)
-		return -1;
-
 	return 0;
 }
 
 int main(int argc, char *argv[])
 {
-	int sk_fd, res, idx;
-	uint8_t seq_num = 0;
+	int sk_fd, res;
 	uint64_t crf_time, rounded_mtt;
 	struct timespec clksrc_ts = {0};
 	struct sockaddr_ll sk_addr = {0};
+	struct avtp_crf_gen gen;
 	struct avtp_crf_pdu *pdu = alloca(PDU_SIZE);
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
@@ -212,10 +190,6 @@ int main(int argc, char *argv[])
 	if (res < 0)
 		goto err;
 
-	res = init_pdu(pdu);
-	if (res < 0)
-		goto err;
-
 	res = clock_gettime(CLOCK_REALTIME, &clksrc_ts);
 	if (res < 0) {
 		perror("Failed to get time");
@@ -223,15 +197,25 @@ int main(int argc, char *argv[])
 	}
 
 	rounded_mtt = ceil(mtt / NOMINAL_PERIOD) * NOMINAL_PERIOD;
+	crf_time = calculate_crf_timestamp(clksrc_ts, rounded_mtt);
+
+	/* From now on the generator keeps track of the CRF timestamps, so
+	 * the fractional part of the nominal period is never lost.
+	 */
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, SAMPLE_RATE,
+				TIMESTAMP_INTERVAL, crf_time);
+	if (res < 0)
+		goto err;
+
+	res = init_pdu(&gen, pdu);
+	if (res < 0)
+		goto err;
 
 	while (1) {
 		ssize_t n;
 
-		crf_time = calculate_crf_timestamp(clksrc_ts, rounded_mtt);
-		for (idx = 0; idx < TIMESTAMPS_PER_PKT; idx++)
-			pdu->crf_data[idx] = htobe64(crf_time + (CRF_PERIOD * idx));
-
-		res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_SEQ_NUM, seq_num++);
+		res = avtp_crf_gen_fill(&gen, pdu, TIMESTAMPS_PER_PKT);
 		if (res < 0)
 			goto err;
 
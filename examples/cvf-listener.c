@@ -54,7 +54,6 @@
  *  ! decodebin ! videoconvert ! autovideosink
  */
 
-#include <assert.h>
 #include <argp.h>
 #include <arpa/inet.h>
 #include <linux/if.h>
@@ -64,12 +63,12 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/queue.h>
 #include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "avtp.h"
 #include "avtp_cvf.h"
+#include "avtp_sched.h"
 #include "examples/common.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
@@ -77,23 +76,25 @@
 #define AVTP_H264_HEADER_LEN	(sizeof(uint32_t))
 #define AVTP_FULL_HEADER_LEN	(sizeof(struct avtp_stream_pdu) + AVTP_H264_HEADER_LEN)
 #define MAX_PDU_SIZE		(AVTP_FULL_HEADER_LEN + DATA_LEN)
+#define MAX_NALS		4096
+#define NSEC_PER_SEC		1000000000ULL
 
 struct nal_entry {
-	STAILQ_ENTRY(nal_entry) entries;
-
 	uint16_t len;
-	struct timespec tspec;
 	uint8_t nal[DATA_LEN];
 };
 
-static STAILQ_HEAD(nal_queue, nal_entry) nals;
+static struct avtp_sched *sched;
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static uint8_t expected_seq;
+static int max_transit_time;
+static struct avtp_policy *policy;
 
 static struct argp_option options[] = {
 	{"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
 	{"ifname", 'i', "IFNAME", 0, "Network Interface" },
+	{"max-transit-time", 'm', "MSEC", 0, "Maximum Transit Time in ms" },
 	{ 0 }
 };
 
@@ -115,6 +116,9 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 	case 'i':
 		strncpy(ifname, arg, sizeof(ifname) - 1);
 		break;
+	case 'm':
+		max_transit_time = atoi(arg);
+		break;
 	}
 
 	return 0;
@@ -126,6 +130,7 @@ static int schedule_nal(int fd, struct timespec *tspec, uint8_t *nal,
 								ssize_t len)
 {
 	struct nal_entry *entry;
+	int res;
 
 	entry = malloc(sizeof(*entry));
 	if (!entry) {
@@ -134,22 +139,21 @@ static int schedule_nal(int fd, struct timespec *tspec, uint8_t *nal,
 	}
 
 	entry->len = len;
-	entry->tspec.tv_sec = tspec->tv_sec;
-	entry->tspec.tv_nsec = tspec->tv_nsec;
 	memcpy(entry->nal, nal, entry->len);
 
-	STAILQ_INSERT_TAIL(&nals, entry, entries);
-
-	/* If this was the first entry inserted onto the queue, we need to arm
-	 * the timer.
-	 */
-	if (STAILQ_FIRST(&nals) == entry) {
-		int res;
+	res = avtp_sched_push(sched, tspec->tv_sec * NSEC_PER_SEC +
+							tspec->tv_nsec, entry);
+	if (res < 0) {
+		fprintf(stderr, "Failed to schedule NAL: %d\n", res);
+		free(entry);
+		return -1;
+	}
 
-		res = arm_timer(fd, tspec);
+	/* If this is the next NAL due, the timer needs to be re-armed. */
+	if (res == 1) {
+		res = avtp_sched_arm_timer(sched, fd);
 		if (res < 0) {
-			STAILQ_REMOVE(&nals, entry, nal_entry, entries);
-			free(entry);
+			fprintf(stderr, "Failed to arm timer: %d\n", res);
 			return -1;
 		}
 	}
@@ -276,6 +280,7 @@ static int new_packet(int sk_fd, int timer_fd)
 	uint16_t h264_data_len;
 	uint64_t avtp_time;
 	struct timespec tspec;
+	enum avtp_policy_action action;
 	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
 	struct avtp_cvf_h264_payload *h264_pay =
 			(struct avtp_cvf_h264_payload *)pdu->avtp_payload;
@@ -299,10 +304,15 @@ static int new_packet(int sk_fd, int timer_fd)
 		return -1;
 	}
 
-	res = get_presentation_time(avtp_time, &tspec);
+	res = get_presentation_time(policy, avtp_time, &tspec, &action);
 	if (res < 0)
 		return -1;
 
+	if (action == AVTP_POLICY_ACTION_DROP) {
+		fprintf(stderr, "Dropping NAL out of presentation window\n");
+		return 0;
+	}
+
 	res = get_h264_data_len(pdu, &h264_data_len);
 	if (res < 0)
 		return -1;
@@ -320,7 +330,9 @@ static int timeout(int fd)
 	int res;
 	ssize_t n;
 	uint64_t expirations;
+	struct timespec now;
 	struct nal_entry *entry;
+	void *data;
 
 	n = read(fd, &expirations, sizeof(uint64_t));
 	if (n < 0) {
@@ -328,26 +340,24 @@ static int timeout(int fd)
 		return -1;
 	}
 
-	assert(expirations == 1);
-
-	entry = STAILQ_FIRST(&nals);
-	assert(entry != NULL);
-
-	res = present_data(entry->nal, entry->len);
-	if (res < 0)
-		return -1;
+	clock_gettime(CLOCK_REALTIME, &now);
 
-	STAILQ_REMOVE_HEAD(&nals, entries);
-	free(entry);
+	while (avtp_sched_pop(sched, now.tv_sec * NSEC_PER_SEC + now.tv_nsec,
+							NULL, &data) == 1) {
+		entry = data;
 
-	if (!STAILQ_EMPTY(&nals)) {
-		entry = STAILQ_FIRST(&nals);
-
-		res = arm_timer(fd, &entry->tspec);
+		res = present_data(entry->nal, entry->len);
+		free(entry);
 		if (res < 0)
 			return -1;
 	}
 
+	res = avtp_sched_arm_timer(sched, fd);
+	if (res < 0) {
+		fprintf(stderr, "Failed to arm timer: %d\n", res);
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -358,8 +368,6 @@ int main(int argc, char *argv[])
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
-	STAILQ_INIT(&nals);
-
 	sk_fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
 	if (sk_fd < 0)
 		return 1;
@@ -375,6 +383,16 @@ int main(int argc, char *argv[])
 	fds[1].fd = timer_fd;
 	fds[1].events = POLLIN;
 
+	res = create_policy(&policy, max_transit_time);
+	if (res < 0)
+		goto err;
+
+	res = avtp_sched_create(&sched, MAX_NALS);
+	if (res < 0) {
+		fprintf(stderr, "Failed to create scheduler: %d\n", res);
+		goto err;
+	}
+
 	while (1) {
 		res = poll(fds, 2, -1);
 		if (res < 0) {
@@ -398,6 +416,8 @@ int main(int argc, char *argv[])
 	return 0;
 
 err:
+	avtp_policy_destroy(policy);
+	avtp_sched_destroy(sched);
 	close(sk_fd);
 	close(timer_fd);
 	return 1;
@@ -74,6 +74,7 @@
 
 #include "avtp.h"
 #include "avtp_cvf.h"
+#include "avtp_tx.h"
 #include "examples/common.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
@@ -202,13 +203,10 @@ static ssize_t start_code_position(size_t offset)
 	return -1;
 }
 
-static int prepare_packet(struct avtp_stream_pdu *pdu, char *nal_data,
-							size_t nal_data_len)
+static int prepare_packet(struct avtp_stream_pdu *pdu, size_t nal_data_len)
 {
 	int res;
 	uint32_t avtp_time;
-	struct avtp_cvf_h264_payload *h264_pay =
-			(struct avtp_cvf_h264_payload *) pdu->avtp_payload;
 
 	res = calculate_avtp_time(&avtp_time, max_transit_time);
 	if (res < 0) {
@@ -232,13 +230,11 @@ static int prepare_packet(struct avtp_stream_pdu *pdu, char *nal_data,
 	if (res < 0)
 		return -1;
 
-	memcpy(h264_pay->h264_data, nal_data, nal_data_len);
-
 	return 0;
 }
 
 static int process_nal(struct avtp_stream_pdu *pdu, bool process_last,
-							size_t *nal_len)
+					size_t *nal_start, size_t *nal_len)
 {
 	int res;
 	ssize_t start, end;
@@ -260,6 +256,7 @@ static int process_nal(struct avtp_stream_pdu *pdu, bool process_last,
 		}
 	}
 
+	*nal_start = start;
 	*nal_len = end - start;
 	if (*nal_len > DATA_LEN) {
 		fprintf(stderr, "NAL length bigger than expected. Expected %u, "
@@ -267,28 +264,34 @@ static int process_nal(struct avtp_stream_pdu *pdu, bool process_last,
 		goto err;
 	}
 
-	/* Sets AVTP packet headers and content - the NAL unit */
-	res = prepare_packet(pdu, &buffer[start], *nal_len);
+	/* Sets AVTP packet headers. The NAL unit itself is sent straight
+	 * from 'buffer'.
+	 */
+	res = prepare_packet(pdu, *nal_len);
 	if (res < 0) {
 		goto err;
 	}
 
-	/* Finally, let's offset any remaining data on the buffer to the
-	 * beginning. Not really efficient, but keep things simple */
-	memmove(buffer, buffer + end, buffer_level - end);
-	buffer_level -= end;
-
 	return PROCESS_OK;
 
 err:
 	return PROCESS_ERROR;
 }
 
+/* Drop 'len' bytes already sent from the beginning of the buffer. Not really
+ * efficient, but keep things simple.
+ */
+static void consume_buffer(size_t len)
+{
+	memmove(buffer, buffer + len, buffer_level - len);
+	buffer_level -= len;
+}
+
 int main(int argc, char *argv[])
 {
 	int fd, res;
 	struct sockaddr_ll sk_addr;
-	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
+	struct avtp_stream_pdu *pdu = alloca(AVTP_FULL_HEADER_LEN);
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
@@ -313,19 +316,28 @@ int main(int argc, char *argv[])
 			end = true;
 
 		while (buffer_level > 0) {
-			enum process_result pr =
-					process_nal(pdu, end, (size_t *)&n);
+			struct iovec iov;
+			size_t nal_start, nal_len;
+			enum process_result pr;
+
+			pr = process_nal(pdu, end, &nal_start, &nal_len);
 			if (pr == PROCESS_ERROR)
 				goto err;
 			if (pr == PROCESS_NONE)
 				break;
 
-			n = sendto(fd, pdu, AVTP_FULL_HEADER_LEN + n, 0,
-				(struct sockaddr *) &sk_addr, sizeof(sk_addr));
+			iov.iov_base = &buffer[nal_start];
+			iov.iov_len = nal_len;
+
+			n = avtp_tx_send(fd, &sk_addr, pdu,
+					AVTP_FULL_HEADER_LEN, &iov, 1, 0);
 			if (n < 0) {
-				perror("Failed to send data");
+				fprintf(stderr, "Failed to send data: %s\n",
+								strerror(-n));
 				goto err;
 			}
+
+			consume_buffer(nal_start + nal_len);
 		}
 
 		if (end)
@@ -31,8 +31,9 @@
  * which receives AVTP packets from the network, retrieves the MPEG-TS packets,
  * and writes them to stdout once the presentation time is reached.
  *
- * For simplicity, the example supports MPEG-TS streams, and expects that each
- * AVTP packet contains only one source packet.
+ * For simplicity, the example supports only MPEG-TS streams. AVTP packets may
+ * carry any number of source packets; they are queued on a ring buffer and
+ * TS packets which are due are written to stdout in batches.
  *
  * TSN stream parameters such as destination mac address are passed via
  * command-line arguments. Run 'ieciidc-listener --help' for more information.
@@ -65,8 +66,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <sys/queue.h>
 #include <sys/timerfd.h>
+#include <time.h>
 #include <unistd.h>
 #include <inttypes.h>
 
@@ -75,25 +76,17 @@
 #include "examples/common.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
-#define MPEG_TS_PACKET_LEN	188
+#define MAX_PDU_SIZE		1500
+#define RING_SIZE		1024
+#define NSEC_PER_SEC		1000000000ULL
 
-#define DATA_LEN		(MPEG_TS_PACKET_LEN + sizeof(uint32_t)) /* MPEG-TS size + SPH */
-#define CIP_HEADER_LEN		(sizeof(uint32_t) * 2)
-#define STREAM_DATA_LEN		DATA_LEN + CIP_HEADER_LEN
-#define PDU_SIZE		(sizeof(struct avtp_stream_pdu) + CIP_HEADER_LEN + DATA_LEN)
-
-struct packet_entry {
-	STAILQ_ENTRY(packet_entry) entries;
-
-	struct timespec tspec;
-	uint8_t mpegts_packet[MPEG_TS_PACKET_LEN];
-};
-
-static STAILQ_HEAD(packet_queue, packet_entry) packets;
+static struct avtp_ieciidc_ts_dpktzr dpktzr;
+static uint8_t ring_data[RING_SIZE * AVTP_IECIIDC_TS_PACKET_LEN];
+static uint64_t ring_times[RING_SIZE];
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static uint8_t expected_seq;
-static uint8_t expected_dbc;
+static uint64_t lost;
 
 static struct argp_option options[] = {
 	{"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
@@ -126,38 +119,30 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser };
 
-/* Schedule 'MPEG-TS packet' to be presented at time specified by 'tspec'. */
-static int schedule_packet(int fd, struct timespec *tspec, uint8_t *mpeg_tsp)
+static uint64_t get_time_ns(void)
 {
-	struct packet_entry *entry;
+	struct timespec tspec;
 
-	entry = malloc(sizeof(*entry));
-	if (!entry) {
-		fprintf(stderr, "Failed to allocate memory\n");
-		return -1;
-	}
+	clock_gettime(CLOCK_REALTIME, &tspec);
 
-	entry->tspec.tv_sec = tspec->tv_sec;
-	entry->tspec.tv_nsec = tspec->tv_nsec;
-	memcpy(entry->mpegts_packet, mpeg_tsp, MPEG_TS_PACKET_LEN);
+	return tspec.tv_sec * NSEC_PER_SEC + tspec.tv_nsec;
+}
 
-	STAILQ_INSERT_TAIL(&packets, entry, entries);
+/* Arm the timer for the oldest queued TS packet, if any. */
+static int arm_next_timer(int fd)
+{
+	struct timespec tspec;
+	uint64_t time;
+	int res;
 
-	/* If this was the first entry inserted onto the queue, we need to arm
-	 * the timer.
-	 */
-	if (STAILQ_FIRST(&packets) == entry) {
-		int res;
+	res = avtp_ieciidc_ts_dpktzr_front(&dpktzr, &time);
+	if (res < 0)
+		return 0;
 
-		res = arm_timer(fd, tspec);
-		if (res < 0) {
-			STAILQ_REMOVE(&packets, entry, packet_entry, entries);
-			free(entry);
-			return -1;
-		}
-	}
+	tspec.tv_sec = time / NSEC_PER_SEC;
+	tspec.tv_nsec = time % NSEC_PER_SEC;
 
-	return 0;
+	return arm_timer(fd, &tspec);
 }
 
 static bool is_valid_packet(struct avtp_stream_pdu *pdu)
@@ -167,14 +152,9 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 	uint32_t val32;
 	int res;
 
-	res = avtp_pdu_get(common, AVTP_FIELD_SUBTYPE, &val32);
-	assert(res == 0);
-	if (val32 != AVTP_SUBTYPE_61883_IIDC) {
-		fprintf(stderr, "Subtype mismatch: expected %u, got %u\n",
-						AVTP_SUBTYPE_61883_IIDC, val32);
-		return false;
-	}
-
+	/* Subtype, CIP format and payload layout are checked by the
+	 * depacketizer.
+	 */
 	res = avtp_pdu_get(common, AVTP_FIELD_VERSION, &val32);
 	assert(res == 0);
 	if (val32 != 0) {
@@ -214,15 +194,6 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 
 	expected_seq++;
 
-	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
-									&val64);
-	assert(res == 0);
-	if (val64 != STREAM_DATA_LEN) {
-		fprintf(stderr, "Data len mismatch: expected %lu, got %"
-					PRIu64 "\n", STREAM_DATA_LEN, val64);
-		return false;
-	}
-
 	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TAG, &val64);
 	assert(res == 0);
 	if (val64 != AVTP_IECIIDC_TAG_CIP) {
@@ -247,22 +218,6 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 		return false;
 	}
 
-	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBS, &val64);
-	assert(res == 0);
-	if (val64 != 6) {
-		fprintf(stderr, "dbs mismatch: expected %u, got %" PRIu64 "\n",
-								6, val64);
-		return false;
-	}
-
-	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_FN, &val64);
-	assert(res == 0);
-	if (val64 != 3) {
-		fprintf(stderr, "fn mismatch: expected %u, got %" PRIu64 "\n",
-								3, val64);
-		return false;
-	}
-
 	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_QPC, &val64);
 	assert(res == 0);
 	if (val64 != 0) {
@@ -271,22 +226,6 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 		return false;
 	}
 
-	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_SPH, &val64);
-	assert(res == 0);
-	if (val64 != 1) {
-		fprintf(stderr, "sph mismatch: expected %u, got %" PRIu64 "\n",
-								1, val64);
-		return false;
-	}
-
-	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_FMT, &val64);
-	assert(res == 0);
-	if (val64 != 32) {
-		fprintf(stderr, "fmt mismatch: expected %u, got %" PRIu64 "\n",
-								32, val64);
-		return false;
-	}
-
 	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_TSF, &val64);
 	assert(res == 0);
 	if (val64 != 0) {
@@ -295,16 +234,6 @@ static bool is_valid_packet(struct avtp_stream_pdu *pdu)
 		return false;
 	}
 
-	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val64);
-	assert(res == 0);
-	if (val64 != expected_dbc) {
-		/* As with sequence mismatch, we'll not discard this packet,
-		 * only log that the mismatch happened */
-		fprintf(stderr, "dbc mismatch: expected %u, got %" PRIu64 "\n",
-							expected_dbc, val64);
-	}
-	expected_dbc += 8;
-
 	return true;
 }
 
@@ -312,38 +241,50 @@ static int new_packet(int sk_fd, int timer_fd)
 {
 	int res;
 	ssize_t n;
-	uint32_t avtp_time;
-	struct timespec tspec;
-	struct avtp_stream_pdu *pdu = alloca(PDU_SIZE);
-	struct avtp_ieciidc_cip_payload *pay =
-			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
-	struct avtp_ieciidc_cip_source_packet *sp =
-		(struct avtp_ieciidc_cip_source_packet *) pay->cip_data_payload;
-
-	memset(pdu, 0, PDU_SIZE);
+	bool was_empty;
+	uint64_t time;
+	struct avtp_ieciidc_ts_dpktzr_stats stats;
+	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
 
-	n = recv(sk_fd, pdu, PDU_SIZE, 0);
-	if (n < 0 || n != PDU_SIZE) {
+	n = recv(sk_fd, pdu, MAX_PDU_SIZE, 0);
+	if (n < 0) {
 		perror("Failed to receive data");
 		return -1;
 	}
 
+	if (n < (ssize_t) (sizeof(*pdu) + AVTP_IECIIDC_CIP_HEADER_LEN)) {
+		fprintf(stderr, "Dropping short packet\n");
+		return 0;
+	}
+
 	if (!is_valid_packet(pdu)) {
 		fprintf(stderr, "Dropping packet\n");
 		return 0;
 	}
 
-	/* There are no helpers for payload fields, so one must remember
-	 * of byte ordering */
-	avtp_time = ntohl(sp->avtp_source_packet_header_timestamp);
+	was_empty = avtp_ieciidc_ts_dpktzr_front(&dpktzr, &time) < 0;
 
-	res = get_presentation_time(avtp_time, &tspec);
-	if (res < 0)
-		return -1;
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, n, get_time_ns());
+	if (res == -ENOSPC) {
+		fprintf(stderr, "Ring full, dropping packet\n");
+		return 0;
+	}
+	if (res < 0) {
+		fprintf(stderr, "Dropping malformed packet\n");
+		return 0;
+	}
 
-	res = schedule_packet(timer_fd, &tspec, sp->cip_with_sph_payload);
-	if (res < 0)
-		return -1;
+	/* As with sequence mismatch, packet loss is only logged. */
+	avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	if (stats.lost != lost) {
+		fprintf(stderr, "Lost %" PRIu64 " TS packets\n",
+							stats.lost - lost);
+		lost = stats.lost;
+	}
+
+	/* If these were the first packets queued, we need to arm the timer. */
+	if (was_empty)
+		return arm_next_timer(timer_fd);
 
 	return 0;
 }
@@ -353,7 +294,7 @@ static int timeout(int fd)
 	int res;
 	ssize_t n;
 	uint64_t expirations;
-	struct packet_entry *entry;
+	const void *data;
 
 	n = read(fd, &expirations, sizeof(uint64_t));
 	if (n < 0) {
@@ -363,25 +304,19 @@ static int timeout(int fd)
 
 	assert(expirations == 1);
 
-	entry = STAILQ_FIRST(&packets);
-	assert(entry != NULL);
-
-	res = present_data(entry->mpegts_packet, MPEG_TS_PACKET_LEN);
-	if (res < 0)
-		return -1;
-
-	STAILQ_REMOVE_HEAD(&packets, entries);
-	free(entry);
-
-	if (!STAILQ_EMPTY(&packets)) {
-		entry = STAILQ_FIRST(&packets);
-
-		res = arm_timer(fd, &entry->tspec);
+	/* Present every TS packet which is due, one contiguous run at a time.
+	 */
+	while ((n = avtp_ieciidc_ts_dpktzr_peek(&dpktzr, get_time_ns(),
+							&data)) > 0) {
+		res = present_data((uint8_t *) data,
+					n * AVTP_IECIIDC_TS_PACKET_LEN);
 		if (res < 0)
 			return -1;
+
+		avtp_ieciidc_ts_dpktzr_pop(&dpktzr, n);
 	}
 
-	return 0;
+	return arm_next_timer(fd);
 }
 
 int main(int argc, char *argv[])
@@ -391,7 +326,9 @@ int main(int argc, char *argv[])
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
-	STAILQ_INIT(&packets);
+	res = avtp_ieciidc_ts_dpktzr_init(&dpktzr, ring_data, ring_times,
+								RING_SIZE);
+	assert(res == 0);
 
 	sk_fd = create_listener_socket(ifname, macaddr, ETH_P_TSN);
 	if (sk_fd < 0)
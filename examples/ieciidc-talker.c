@@ -31,8 +31,10 @@
  * reads an MPEG-TS stream from stdin, creates AVTP IEC 61883/IIDC packets and
  * transmits them via the network.
  *
- * For simplicity, the example supports only MPEG-TS streams, and only one
- * source packet is packed into each AVTP packet sent.
+ * For simplicity, the example supports only MPEG-TS streams. As many source
+ * packets as fit in the network MTU are packed into each AVTP packet sent,
+ * and source packet timestamps are derived from the stream bitrate, which
+ * is informed via command-line. The stream is transmitted at that same rate.
  *
  * TSN stream parameters (e.g. destination mac address, traffic priority) are
  * passed via command-line arguments. Run 'ieciidc-talker --help' for more
@@ -75,19 +77,19 @@
 #include "examples/common.h"
 
 #define STREAM_ID		0xAABBCCDDEEFF0001
-#define MPEG_TS_PACKET_LEN	188
-
-#define DATA_LEN		(MPEG_TS_PACKET_LEN + sizeof(uint32_t)) /* MPEG-TS size + SPH */
-#define CIP_HEADER_LEN		(sizeof(uint32_t) * 2)
-#define STREAM_DATA_LEN		DATA_LEN + CIP_HEADER_LEN
-#define PDU_SIZE		(sizeof(struct avtp_stream_pdu) + CIP_HEADER_LEN + DATA_LEN)
+#define MAX_PDU_SIZE		1500
+#define DEFAULT_BITRATE		8000000
+#define NSEC_PER_SEC		1000000000ULL
+#define NSEC_PER_MSEC		1000000ULL
 
 static char ifname[IFNAMSIZ];
 static uint8_t macaddr[ETH_ALEN];
 static int priority = -1;
 static int max_transit_time;
+static uint64_t bitrate = DEFAULT_BITRATE;
 
 static struct argp_option options[] = {
+	{"bitrate", 'b', "BPS", 0, "MPEG-TS stream bitrate in bits/s" },
 	{"dst-addr", 'd', "MACADDR", 0, "Stream Destination MAC address" },
 	{"ifname", 'i', "IFNAME", 0, "Network Interface" },
 	{"max-transit-time", 'm', "MSEC", 0, "Maximum Transit Time in ms" },
@@ -100,6 +102,9 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 	int res;
 
 	switch (key) {
+	case 'b':
+		bitrate = strtoull(arg, NULL, 0);
+		break;
 	case 'd':
 		res = sscanf(arg, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
 					&macaddr[0], &macaddr[1], &macaddr[2],
@@ -126,11 +131,15 @@ static error_t parser(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = { options, parser };
 
-static void init_pdu(struct avtp_stream_pdu *pdu)
+static void init_pdu(struct avtp_ieciidc_ts_pktzr *pktzr,
+						struct avtp_stream_pdu *pdu)
 {
 	int res;
 
-	res = avtp_ieciidc_pdu_init(pdu, AVTP_IECIIDC_TAG_CIP);
+	/* The packetizer sets the CIP header for MPEG-TS, and keeps track
+	 * of 'dbc' and 'sequence_num' fields.
+	 */
+	res = avtp_ieciidc_ts_pktzr_pdu_init(pktzr, pdu);
 	assert(res == 0);
 
 	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TV, 0);
@@ -139,57 +148,39 @@ static void init_pdu(struct avtp_stream_pdu *pdu)
 	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_ID,
 								STREAM_ID);
 	assert(res == 0);
+}
 
-	res = avtp_ieciidc_pdu_set(pdu,
-			AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, STREAM_DATA_LEN);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_GV, 0);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_GATEWAY_INFO, 0);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CHANNEL, 31);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_QI_1, 0);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_SID, 63);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_DBS, 6);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_FN, 3);
-	assert(res == 0);
-
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_QPC, 0);
-	assert(res == 0);
+/* Read up to 'len' bytes from stdin, retrying on short reads so that PDUs
+ * are filled up to their capacity.
+ */
+static ssize_t read_packets(uint8_t *buf, size_t len)
+{
+	size_t total = 0;
 
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_SPH, 1);
-	assert(res == 0);
+	while (total < len) {
+		ssize_t n = read(STDIN_FILENO, buf + total, len - total);
 
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_QI_2, 2);
-	assert(res == 0);
+		if (n < 0)
+			return -1;
+		if (n == 0)
+			break;
 
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_FMT, 32);
-	assert(res == 0);
+		total += n;
+	}
 
-	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_TSF, 0);
-	assert(res == 0);
+	return total;
 }
 
 int main(int argc, char *argv[])
 {
 	int fd, res;
 	struct sockaddr_ll sk_addr;
-	struct avtp_stream_pdu *pdu = alloca(PDU_SIZE);
-	struct avtp_ieciidc_cip_payload *pay =
-			(struct avtp_ieciidc_cip_payload *)pdu->avtp_payload;
-	uint8_t seq_num = 0;
-	uint8_t dbc = 0;
+	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct timespec tspec;
+	uint8_t *buf;
+	size_t buf_len, pending = 0;
+	uint64_t now;
 
 	argp_parse(&argp, argc, argv, 0, NULL, NULL);
 
@@ -201,63 +192,75 @@ int main(int argc, char *argv[])
 	if (res < 0)
 		goto err;
 
-	init_pdu(pdu);
+	res = clock_gettime(CLOCK_REALTIME, &tspec);
+	if (res < 0) {
+		perror("Failed to get time");
+		goto err;
+	}
 
-	while (1) {
-		ssize_t n;
-		uint32_t avtp_time;
-		struct avtp_ieciidc_cip_source_packet *sp;
+	now = tspec.tv_sec * NSEC_PER_SEC + tspec.tv_nsec;
 
-		memset(pay->cip_data_payload, 0, DATA_LEN);
-		sp = (struct avtp_ieciidc_cip_source_packet *)
-							pay->cip_data_payload;
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, bitrate, MAX_PDU_SIZE,
+				now + max_transit_time * NSEC_PER_MSEC);
+	if (res < 0) {
+		fprintf(stderr, "Invalid bitrate\n");
+		goto err;
+	}
 
-		n = read(STDIN_FILENO, sp->cip_with_sph_payload,
-							MPEG_TS_PACKET_LEN);
-		if (n == 0)
-			break;
+	init_pdu(&pktzr, pdu);
 
-		if (n != MPEG_TS_PACKET_LEN) {
-			fprintf(stderr, "read %zd bytes, expected %d\n", n,
-							MPEG_TS_PACKET_LEN);
-		}
+	buf_len = MAX_PDU_SIZE / AVTP_IECIIDC_TS_SP_LEN *
+						AVTP_IECIIDC_TS_PACKET_LEN;
+	buf = alloca(buf_len);
+
+	while (1) {
+		ssize_t n;
+		size_t pdu_len, consumed;
+		uint64_t ptime;
 
-		res = calculate_avtp_time(&avtp_time, max_transit_time);
-		if (res < 0) {
-			fprintf(stderr, "Failed to calculate avtp time\n");
+		n = read_packets(buf + pending, buf_len - pending);
+		if (n < 0) {
+			perror("Failed to read data");
 			goto err;
 		}
 
-		/* There are no helpers for payload fields, so one must remember
-		 * of byte ordering
+		pending += n;
+		if (pending < AVTP_IECIIDC_TS_PACKET_LEN)
+			break;
+
+		/* Transmit the PDU max_transit_time before its first source
+		 * packet is due, so the stream goes out at its own bitrate.
 		 */
-		sp->avtp_source_packet_header_timestamp = htonl(avtp_time);
+		avtp_ieciidc_ts_pktzr_get_time(&pktzr, &ptime);
+		ptime -= max_transit_time * NSEC_PER_MSEC;
+		tspec.tv_sec = ptime / NSEC_PER_SEC;
+		tspec.tv_nsec = ptime % NSEC_PER_SEC;
+		clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &tspec, NULL);
 
-		res = avtp_ieciidc_pdu_set(pdu,
-					AVTP_IECIIDC_FIELD_SEQ_NUM, seq_num++);
-		assert(res == 0);
+		res = avtp_ieciidc_ts_pktzr_fill(&pktzr, pdu, buf, pending,
+								&pdu_len);
+		assert(res > 0);
 
-		res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_DBC,
-									dbc);
-		assert(res == 0);
-		/* We just send one MPEG-TS packet per AVTP packet, so we
-		 * increase dbc by the number of blocks on one MPEG-TS packet
-		 */
-		dbc += 8;
+		consumed = res * AVTP_IECIIDC_TS_PACKET_LEN;
+		pending -= consumed;
+		memmove(buf, buf + consumed, pending);
 
-		n = sendto(fd, pdu, PDU_SIZE, 0, (struct sockaddr *) &sk_addr,
+		n = sendto(fd, pdu, pdu_len, 0, (struct sockaddr *) &sk_addr,
 							sizeof(sk_addr));
 		if (n < 0) {
 			perror("Failed to send data");
 			goto err;
 		}
 
-		if (n != PDU_SIZE) {
-			fprintf(stderr, "wrote %zd bytes, expected %zd\n", n,
-								PDU_SIZE);
+		if (n != (ssize_t) pdu_len) {
+			fprintf(stderr, "wrote %zd bytes, expected %zu\n", n,
+								pdu_len);
 		}
 	}
 
+	if (pending)
+		fprintf(stderr, "dropped %zu trailing bytes\n", pending);
+
 	close(fd);
 	return 0;
 
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Shared memory reader example.
+ *
+ * This example implements a very simple consumer of the shared memory ring
+ * published by 'aaf-listener --shm PATH'. It connects to the Unix socket at
+ * PATH, maps the ring and writes the payload of every record to stdout,
+ * reporting on stderr the records it lost because it couldn't keep up.
+ *
+ * Records are consumed in place and written out in batches, with one write()
+ * per batch rather than per record. Presentation times are ignored, this
+ * example just drains the ring:
+ *
+ * $ shm-reader PATH | aplay -f dat -t raw -D <playback-device>
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "avtp_shm.h"
+
+#define BATCH_SIZE		4096
+
+static int connect_sink(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Socket path too long\n");
+		return -1;
+	}
+
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("Failed to open Unix socket");
+		return -1;
+	}
+
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("Failed to connect() to sink");
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static int flush(const uint8_t *buf, size_t len)
+{
+	while (len) {
+		ssize_t n = write(STDOUT_FILENO, buf, len);
+
+		if (n < 0) {
+			perror("Failed to write data");
+			return -1;
+		}
+
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct avtp_shm_reader *reader;
+	static uint8_t batch[BATCH_SIZE];
+	size_t pending = 0;
+	uint64_t expected_seq = 0;
+	bool first = true;
+	int sk_fd, mem_fd, bell_fd, res;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s PATH\n", argv[0]);
+		return 1;
+	}
+
+	sk_fd = connect_sink(argv[1]);
+	if (sk_fd < 0)
+		return 1;
+
+	res = avtp_shm_recv_fds(sk_fd, &mem_fd, &bell_fd);
+	close(sk_fd);
+	if (res < 0) {
+		fprintf(stderr, "Failed to receive ring: %d\n", res);
+		return 1;
+	}
+
+	res = avtp_shm_reader_create(&reader, mem_fd, bell_fd);
+	close(mem_fd);
+	close(bell_fd);
+	if (res < 0) {
+		fprintf(stderr, "Failed to map ring: %d\n", res);
+		return 1;
+	}
+
+	while (1) {
+		struct avtp_shm_rec rec;
+
+		res = avtp_shm_reader_next(reader, &rec);
+		if (res == -EOVERFLOW) {
+			fprintf(stderr, "Overrun by sink\n");
+			continue;
+		}
+
+		if (res == 0) {
+			/* Ring drained: write the batch out and sleep. */
+			if (flush(batch, pending) < 0)
+				goto err;
+
+			pending = 0;
+			res = avtp_shm_reader_wait(reader, -1);
+			if (res < 0 && res != -ETIMEDOUT) {
+				fprintf(stderr, "Failed to wait: %d\n", res);
+				goto err;
+			}
+
+			continue;
+		}
+
+		if (res < 0) {
+			fprintf(stderr, "Failed to read ring: %d\n", res);
+			goto err;
+		}
+
+		if (rec.len > sizeof(batch) - pending) {
+			if (flush(batch, pending) < 0)
+				goto err;
+
+			pending = 0;
+		}
+
+		if (rec.len <= sizeof(batch))
+			memcpy(batch + pending, rec.data, rec.len);
+
+		/* The sink may have overwritten the record meanwhile. */
+		if (avtp_shm_reader_release(reader) < 0) {
+			fprintf(stderr, "Record %llu overwritten\n",
+						(unsigned long long) rec.seq);
+			continue;
+		}
+
+		if (!first && rec.seq != expected_seq)
+			fprintf(stderr, "Lost %llu records\n",
+				(unsigned long long) (rec.seq - expected_seq));
+
+		first = false;
+		expected_seq = rec.seq + 1;
+
+		if (rec.len <= sizeof(batch))
+			pending += rec.len;
+	}
+
+	return 0;
+
+err:
+	avtp_shm_reader_destroy(reader);
+	return 1;
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Header-only C++17 field access.
+ *
+ * Every AVTPDU field is described at compile time by the type
+ * avtp::field<Offset, Bytes, Shift, Width>: the big-endian word holding the
+ * field starts 'Offset' bytes into the PDU and is 'Bytes' long (4 or 8), and
+ * the field is 'Width' bits wide starting at bit 'Shift' of that word. Fields
+ * are grouped per format (avtp::stream, avtp::aaf, avtp::cvf, avtp::crf,
+ * avtp::ieciidc) and named after the corresponding C enum entries, e.g.
+ * AVTP_AAF_FIELD_CHAN_PER_FRAME is avtp::aaf::chan_per_frame.
+ *
+ * avtp::get<F>() and avtp::set<F>() take a pointer to the first byte of the
+ * PDU, or any contiguous byte container such as std::array or std::span.
+ * There is no runtime dispatch and no argument checking: with optimization
+ * enabled each access is a single load (plus byte swap, shift and mask) and
+ * each update a single read-modify-write of the word, exactly like
+ * hand-written code. The buffer must be at least F::end bytes long.
+ *
+ * As with avtp_*_pdu_set(), values wider than the field are truncated.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace avtp {
+
+namespace detail {
+
+template <unsigned Width>
+using uint_for = std::conditional_t<Width <= 8, std::uint8_t,
+		 std::conditional_t<Width <= 16, std::uint16_t,
+		 std::conditional_t<Width <= 32, std::uint32_t,
+		 std::uint64_t>>>;
+
+template <class Byte>
+constexpr bool is_byte = sizeof(Byte) == 1 &&
+			(std::is_integral_v<Byte> || std::is_same_v<Byte, std::byte>);
+
+/* Byte-wise assembly keeps the accessors usable in constant expressions.
+ * The expressions are fully unrolled so compilers fold them into a single
+ * unaligned load or store and a byte swap.
+ */
+template <class Word, class Byte, std::size_t... I>
+constexpr Word load_be(const Byte *p, std::index_sequence<I...>)
+{
+	return ((static_cast<Word>(static_cast<std::uint8_t>(p[I])) <<
+					(8 * (sizeof(Word) - 1 - I))) | ...);
+}
+
+template <class Word, class Byte>
+constexpr Word load_be(const Byte *p)
+{
+	return load_be<Word>(p, std::make_index_sequence<sizeof(Word)>());
+}
+
+template <class Word, class Byte, std::size_t... I>
+constexpr void store_be(Byte *p, Word w, std::index_sequence<I...>)
+{
+	((p[I] = static_cast<Byte>(static_cast<std::uint8_t>(
+				w >> (8 * (sizeof(Word) - 1 - I))))), ...);
+}
+
+template <class Word, class Byte>
+constexpr void store_be(Byte *p, Word w)
+{
+	store_be<Word>(p, w, std::make_index_sequence<sizeof(Word)>());
+}
+
+} // namespace detail
+
+/* Compile-time descriptor of an AVTPDU field.
+ * @Offset: Offset of the word holding the field, in bytes from the start of
+ *          the PDU.
+ * @Bytes: Size of the word holding the field, either 4 or 8.
+ * @Shift: Position of the field least significant bit within the word.
+ * @Width: Width of the field in bits.
+ */
+template <std::size_t Offset, unsigned Bytes, unsigned Shift, unsigned Width>
+struct field {
+	static_assert(Bytes == 4 || Bytes == 8, "field word must be 4 or 8 bytes");
+	static_assert(Width > 0 && Shift + Width <= Bytes * 8,
+					"field does not fit in its word");
+
+	using word_type = std::conditional_t<Bytes == 8, std::uint64_t,
+							std::uint32_t>;
+	using value_type = detail::uint_for<Width>;
+
+	static constexpr std::size_t offset = Offset;
+	static constexpr std::size_t end = Offset + Bytes;
+	static constexpr unsigned shift = Shift;
+	static constexpr unsigned width = Width;
+	static constexpr word_type mask = (Width == Bytes * 8) ?
+				~word_type(0) :
+				((word_type(1) << Width) - 1) << Shift;
+};
+
+/* Get value from AVTPDU field.
+ * @F: Field descriptor.
+ * @pdu: Pointer to the first byte of the PDU.
+ *
+ * Returns:
+ *    Field value.
+ */
+template <class F, class Byte,
+	  std::enable_if_t<detail::is_byte<Byte>, int> = 0>
+constexpr typename F::value_type get(const Byte *pdu)
+{
+	using word_type = typename F::word_type;
+	word_type w = detail::load_be<word_type>(pdu + F::offset);
+
+	return static_cast<typename F::value_type>((w & F::mask) >> F::shift);
+}
+
+/* Set value to AVTPDU field.
+ * @F: Field descriptor.
+ * @pdu: Pointer to the first byte of the PDU.
+ * @val: Value to be set.
+ */
+template <class F, class Byte,
+	  std::enable_if_t<detail::is_byte<Byte> && !std::is_const_v<Byte>,
+									int> = 0>
+constexpr void set(Byte *pdu, typename F::value_type val)
+{
+	using word_type = typename F::word_type;
+	word_type v = static_cast<word_type>(val);
+
+	if constexpr (F::mask == ~word_type(0)) {
+		detail::store_be<word_type>(pdu + F::offset, v);
+	} else {
+		word_type w = detail::load_be<word_type>(pdu + F::offset);
+
+		w = (w & ~F::mask) | ((v << F::shift) & F::mask);
+		detail::store_be<word_type>(pdu + F::offset, w);
+	}
+}
+
+/* Overloads for contiguous byte containers with a data() member, such as
+ * std::array, std::vector or std::span. Plain arrays decay to pointers.
+ */
+template <class F, class Buf>
+constexpr auto get(const Buf &buf) -> decltype(get<F>(buf.data()))
+{
+	return get<F>(buf.data());
+}
+
+template <class F, class Buf>
+constexpr auto set(Buf &&buf, typename F::value_type val)
+				-> decltype(set<F>(buf.data(), val))
+{
+	set<F>(buf.data(), val);
+}
+
+/* Fields common to all AVTPDUs. */
+namespace common {
+using subtype = field<0, 4, 24, 8>;
+using version = field<0, 4, 20, 3>;
+} // namespace common
+
+/* Fields of the AVTP stream PDU header (struct avtp_stream_pdu). */
+namespace stream {
+using namespace common;
+using sv = field<0, 4, 23, 1>;
+using mr = field<0, 4, 19, 1>;
+using tv = field<0, 4, 16, 1>;
+using seq_num = field<0, 4, 8, 8>;
+using tu = field<0, 4, 0, 1>;
+using stream_id = field<4, 8, 0, 64>;
+using timestamp = field<12, 4, 0, 32>;
+using stream_data_len = field<20, 4, 16, 16>;
+} // namespace stream
+
+/* AAF fields (enum avtp_aaf_field). */
+namespace aaf {
+using namespace stream;
+using format = field<16, 4, 24, 8>;
+using nsr = field<16, 4, 20, 4>;
+using chan_per_frame = field<16, 4, 8, 10>;
+using bit_depth = field<16, 4, 0, 8>;
+using sp = field<20, 4, 12, 1>;
+using evt = field<20, 4, 8, 4>;
+} // namespace aaf
+
+/* CVF fields (enum avtp_cvf_field). 'h264_timestamp' lives in the H.264
+ * header, right after the stream PDU header.
+ */
+namespace cvf {
+using namespace stream;
+using format = field<16, 4, 24, 8>;
+using format_subtype = field<16, 4, 16, 8>;
+using h264_ptv = field<20, 4, 13, 1>;
+using m = field<20, 4, 12, 1>;
+using evt = field<20, 4, 8, 4>;
+using h264_timestamp = field<24, 4, 0, 32>;
+} // namespace cvf
+
+/* CRF fields (enum avtp_crf_field). CRF is not a stream PDU, its header is
+ * struct avtp_crf_pdu.
+ */
+namespace crf {
+using namespace common;
+using sv = field<0, 4, 23, 1>;
+using mr = field<0, 4, 19, 1>;
+using fs = field<0, 4, 17, 1>;
+using tu = field<0, 4, 16, 1>;
+using seq_num = field<0, 4, 8, 8>;
+using type = field<0, 4, 0, 8>;
+using stream_id = field<4, 8, 0, 64>;
+using pull = field<12, 8, 61, 3>;
+using base_freq = field<12, 8, 32, 29>;
+using crf_data_len = field<12, 8, 16, 16>;
+using timestamp_interval = field<12, 8, 0, 16>;
+} // namespace crf
+
+/* IEC 61883/IIDC fields (enum avtp_ieciidc_field). The 'cip_*' fields live in
+ * the CIP header, right after the stream PDU header.
+ */
+namespace ieciidc {
+using namespace stream;
+using gv = field<0, 4, 17, 1>;
+using gateway_info = field<16, 4, 0, 32>;
+using tag = field<20, 4, 14, 2>;
+using channel = field<20, 4, 8, 6>;
+using tcode = field<20, 4, 4, 4>;
+using sy = field<20, 4, 0, 4>;
+using cip_qi_1 = field<24, 4, 30, 2>;
+using cip_sid = field<24, 4, 24, 6>;
+using cip_dbs = field<24, 4, 16, 8>;
+using cip_fn = field<24, 4, 14, 2>;
+using cip_qpc = field<24, 4, 11, 3>;
+using cip_sph = field<24, 4, 10, 1>;
+using cip_dbc = field<24, 4, 0, 8>;
+using cip_qi_2 = field<28, 4, 30, 2>;
+using cip_fmt = field<28, 4, 24, 6>;
+using cip_tsf = field<28, 4, 23, 1>;
+using cip_nd = field<28, 4, 23, 1>;
+using cip_evt = field<28, 4, 20, 2>;
+using cip_n = field<28, 4, 19, 1>;
+using cip_sfc = field<28, 4, 16, 3>;
+using cip_no_data = field<28, 4, 16, 8>;
+using cip_syt = field<28, 4, 0, 16>;
+} // namespace ieciidc
+
+} // namespace avtp
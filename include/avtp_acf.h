@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ACF 'acf_msg_type' field values. */
+#define AVTP_ACF_TYPE_FLEXRAY			0x00
+#define AVTP_ACF_TYPE_CAN			0x01
+#define AVTP_ACF_TYPE_CAN_BRIEF			0x02
+#define AVTP_ACF_TYPE_LIN			0x03
+#define AVTP_ACF_TYPE_MOST			0x04
+#define AVTP_ACF_TYPE_GPC			0x05
+#define AVTP_ACF_TYPE_SERIAL			0x06
+#define AVTP_ACF_TYPE_PARALLEL			0x07
+#define AVTP_ACF_TYPE_SENSOR			0x08
+#define AVTP_ACF_TYPE_SENSOR_BRIEF		0x09
+#define AVTP_ACF_TYPE_AECP			0x0A
+#define AVTP_ACF_TYPE_ANCILLARY			0x0B
+#define AVTP_ACF_TYPE_USER0			0x78
+#define AVTP_ACF_TYPE_USER1			0x79
+#define AVTP_ACF_TYPE_USER2			0x7A
+#define AVTP_ACF_TYPE_USER3			0x7B
+#define AVTP_ACF_TYPE_USER4			0x7C
+#define AVTP_ACF_TYPE_USER5			0x7D
+#define AVTP_ACF_TYPE_USER6			0x7E
+#define AVTP_ACF_TYPE_USER7			0x7F
+
+/* ACF CAN message flags, i.e. the 'mtv', 'rtr', 'eff', 'brs', 'fdf' and
+ * 'esi' fields.
+ */
+#define AVTP_ACF_CAN_FLAG_MTV			(1 << 5)
+#define AVTP_ACF_CAN_FLAG_RTR			(1 << 4)
+#define AVTP_ACF_CAN_FLAG_EFF			(1 << 3)
+#define AVTP_ACF_CAN_FLAG_BRS			(1 << 2)
+#define AVTP_ACF_CAN_FLAG_FDF			(1 << 1)
+#define AVTP_ACF_CAN_FLAG_ESI			(1 << 0)
+
+/* Length of the ACF CAN and ACF CAN Brief message headers, in bytes. */
+#define AVTP_ACF_CAN_HEADER_LEN			16
+#define AVTP_ACF_CAN_BRIEF_HEADER_LEN		8
+
+/* Maximum CAN payload length (CAN FD), in bytes. */
+#define AVTP_ACF_CAN_MAX_DATA_LEN		64
+
+/* ACF message, as found by avtp_acf_iter_next(). Messages are not copied:
+ * 'data' points to the message header within the buffer being iterated.
+ */
+struct avtp_acf_msg {
+	const uint8_t *data;
+	/* Message length, in bytes, header included. */
+	uint16_t len;
+	uint8_t type;
+};
+
+/* ACF CAN message. When read with avtp_acf_can_read(), 'data' points to the
+ * payload within the message so no copy takes place.
+ */
+struct avtp_acf_can {
+	/* 'message_timestamp' field, in nanoseconds. Only meaningful if
+	 * AVTP_ACF_CAN_FLAG_MTV is set, and not present in ACF CAN Brief
+	 * messages.
+	 */
+	uint64_t timestamp;
+	/* 11-bit identifier, or 29-bit if AVTP_ACF_CAN_FLAG_EFF is set. */
+	uint32_t id;
+	const uint8_t *data;
+	/* Payload length, in bytes: up to 8, or one of the CAN FD lengths
+	 * up to 64 if AVTP_ACF_CAN_FLAG_FDF is set.
+	 */
+	uint8_t len;
+	/* Bitwise OR of AVTP_ACF_CAN_FLAG_* flags. */
+	uint8_t flags;
+	uint8_t bus_id;
+};
+
+/* ACF message iterator. Fields are private and should not be accessed
+ * directly, use the avtp_acf_iter_*() APIs instead.
+ */
+struct avtp_acf_iter {
+	const uint8_t *pos;
+	const uint8_t *end;
+};
+
+/* Initialize ACF message iterator over a sequence of ACF messages, e.g. the
+ * payload of a NTSCF or TSCF AVTPDU.
+ * @iter: Pointer to iterator struct.
+ * @data: ACF messages.
+ * @len: Length of 'data', in bytes.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_acf_iter_init(struct avtp_acf_iter *iter, const void *data,
+								size_t len);
+
+/* Get next ACF message.
+ * @iter: Pointer to iterator struct.
+ * @msg: Pointer to struct which the message should be saved.
+ *
+ * Returns:
+ *    1: A message was saved in 'msg'.
+ *    0: No messages left.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the message header is malformed. Iteration stops there.
+ */
+int avtp_acf_iter_next(struct avtp_acf_iter *iter, struct avtp_acf_msg *msg);
+
+/* Get the size of a CAN frame encoded as ACF message.
+ * @can: Pointer to CAN message.
+ * @type: AVTP_ACF_TYPE_CAN or AVTP_ACF_TYPE_CAN_BRIEF.
+ *
+ * Returns:
+ *    > 0: Message size in bytes, padding included.
+ *    -EINVAL: If any argument is invalid, e.g. the payload length is not a
+ *             valid CAN or CAN FD length.
+ */
+ssize_t avtp_acf_can_get_len(const struct avtp_acf_can *can, uint8_t type);
+
+/* Encode CAN frame as ACF message. The payload is zero-padded to a multiple
+ * of 4 bytes.
+ * @can: Pointer to CAN message.
+ * @type: AVTP_ACF_TYPE_CAN or AVTP_ACF_TYPE_CAN_BRIEF.
+ * @buf: Buffer which the message should be written to.
+ * @len: Length of 'buf', in bytes.
+ *
+ * Returns:
+ *    > 0: Number of bytes written.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOSPC: If the message doesn't fit in 'buf'. Nothing is written.
+ */
+ssize_t avtp_acf_can_write(const struct avtp_acf_can *can, uint8_t type,
+							void *buf, size_t len);
+
+/* Decode ACF CAN or ACF CAN Brief message.
+ * @msg: Pointer to message, as returned by avtp_acf_iter_next().
+ * @can: Pointer to struct which the CAN message should be saved. Its 'data'
+ *       field points into 'msg'.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid, or 'msg' is not a CAN message.
+ *    -EBADMSG: If the message is malformed.
+ */
+int avtp_acf_can_read(const struct avtp_acf_msg *msg,
+						struct avtp_acf_can *can);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* AEF continuous AVTPDU layout:
+ *
+ *   struct avtp_stream_pdu	Stream header, 'format_specific' holds the
+ *				key ID. Authenticated, not encrypted.
+ *   iv[AVTP_AEF_IV_LEN]	Explicit IV, combined with the 4-byte salt
+ *				into the 12-byte AES-GCM nonce.
+ *				Authenticated, not encrypted.
+ *   AVTPDU			Encapsulated AVTPDU (e.g. AAF or CVF),
+ *				encrypted in place.
+ *   icv[AVTP_AEF_ICV_LEN]	AES-GCM tag.
+ *
+ * 'stream_data_length' covers everything after the stream header.
+ */
+#define AVTP_AEF_IV_LEN				8
+#define AVTP_AEF_ICV_LEN			16
+
+/* Offset of the encapsulated AVTPDU, in bytes. */
+#define AVTP_AEF_HEADER_LEN			(sizeof(struct avtp_stream_pdu) + \
+							AVTP_AEF_IV_LEN)
+
+/* Bytes added by encapsulation. */
+#define AVTP_AEF_OVERHEAD			(AVTP_AEF_HEADER_LEN + \
+							AVTP_AEF_ICV_LEN)
+
+/* AEF flags. */
+/* Use the portable implementation, which is not constant time. */
+#define AVTP_AEF_PORTABLE			(1 << 0)
+
+enum avtp_aef_field {
+	AVTP_AEF_FIELD_SV,
+	AVTP_AEF_FIELD_MR,
+	AVTP_AEF_FIELD_TV,
+	AVTP_AEF_FIELD_SEQ_NUM,
+	AVTP_AEF_FIELD_TU,
+	AVTP_AEF_FIELD_STREAM_ID,
+	AVTP_AEF_FIELD_TIMESTAMP,
+	AVTP_AEF_FIELD_STREAM_DATA_LEN,
+	AVTP_AEF_FIELD_KEY_ID,
+	AVTP_AEF_FIELD_MAX,
+};
+
+/* Get value from AEF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be retrieved.
+ * @val: Pointer to variable which the retrieved value should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_aef_field field, uint64_t *val);
+
+/* Set value from AEF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be set.
+ * @val: Value to be set.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_aef_field field,
+								uint64_t val);
+
+/* Initialize AEF AVTPDU. All AVTPDU fields are initialized with zero except
+ * 'subtype' (which is set to AVTP_SUBTYPE_AEF_CONTINUOUS) and 'sv' (which is
+ * set to 1).
+ * @pdu: Pointer to PDU struct.
+ *
+ * Return values:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_pdu_init(struct avtp_stream_pdu *pdu);
+
+/* Opaque AEF AES-GCM context. */
+struct avtp_aef;
+
+/* Create AEF AES-GCM context for one stream direction. AES-NI and
+ * PCLMULQDQ are used if the CPU supports them, with a portable
+ * implementation as fallback. The portable implementation uses table-based
+ * AES and GHASH, whose memory accesses depend on the key and data, so it
+ * leaks timing through the cache to code sharing the CPU. The context keeps
+ * the explicit IV and 'sequence_num' counters, so a context must not be
+ * shared by talkers.
+ *
+ * The AES-GCM nonce is 'salt' followed by the explicit IV. The IV is a
+ * counter started at a random value, so two contexts encrypting with the
+ * same key and salt only repeat a nonce with negligible probability, but a
+ * repeated nonce breaks both confidentiality and authenticity. A (key, salt)
+ * pair should thus not be reused across encrypting contexts: give each
+ * talker, and each talker restart, a fresh salt or key.
+ * @aef: Pointer to variable which the context should be saved. It must be
+ *       destroyed with avtp_aef_destroy() when no longer needed.
+ * @key: AES key.
+ * @key_len: Key length, in bytes: 16 (AES-128) or 32 (AES-256).
+ * @key_id: Key ID carried in each AVTPDU.
+ * @salt: Implicit part of the nonce, shared by talker and listeners.
+ * @flags: Bitwise OR of AVTP_AEF_* flags.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOMEM: If memory could not be allocated.
+ *    < 0: Negative errno reported by getrandom().
+ */
+int avtp_aef_create(struct avtp_aef **aef, const void *key, size_t key_len,
+			uint32_t key_id, uint32_t salt, uint32_t flags);
+
+/* Destroy AEF AES-GCM context. Key material is wiped.
+ * @aef: Pointer to context.
+ */
+void avtp_aef_destroy(struct avtp_aef *aef);
+
+/* Check whether the context uses AES-NI and PCLMULQDQ.
+ * @aef: Pointer to context.
+ *
+ * Returns:
+ *    1: Accelerated.
+ *    0: Portable implementation.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_is_accelerated(const struct avtp_aef *aef);
+
+/* Encapsulate an AVTPDU in place. 'key_id', 'sequence_num',
+ * 'stream_data_length' and the explicit IV are set, then the AVTPDU is
+ * encrypted and the tag appended. Other header fields, such as 'stream_id'
+ * or 'avtp_timestamp', must be set beforehand since they are authenticated.
+ * @aef: Pointer to context.
+ * @pdu: Pointer to AEF PDU struct, initialized with avtp_aef_pdu_init(). The
+ *       AVTPDU to be encapsulated must be placed AVTP_AEF_HEADER_LEN bytes
+ *       into it, and AVTP_AEF_ICV_LEN bytes must be available after it.
+ * @len: Length of the encapsulated AVTPDU, in bytes.
+ * @pdu_len: Pointer to variable which the resulting AVTPDU size should be
+ *           saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_encrypt(struct avtp_aef *aef, struct avtp_stream_pdu *pdu,
+					size_t len, size_t *pdu_len);
+
+/* Authenticate and decapsulate an AVTPDU in place. On success the
+ * encapsulated AVTPDU is found AVTP_AEF_HEADER_LEN bytes into 'pdu'. On
+ * failure 'pdu' is left untouched.
+ * @aef: Pointer to context.
+ * @pdu: Pointer to received AEF PDU struct.
+ * @len: Length of received data, in bytes.
+ * @inner_len: Pointer to variable which the encapsulated AVTPDU size should
+ *             be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If 'pdu' is not an AEF AVTPDU, is truncated or fails
+ *              authentication.
+ *    -ENOKEY: If 'pdu' was encrypted with another key ID.
+ */
+int avtp_aef_decrypt(struct avtp_aef *aef, struct avtp_stream_pdu *pdu,
+					size_t len, size_t *inner_len);
+
+/* Burst entry for avtp_aef_encrypt_batch() and avtp_aef_decrypt_batch(). */
+struct avtp_aef_buf {
+	struct avtp_stream_pdu *pdu;
+	/* Input length: encapsulated AVTPDU length when encrypting, received
+	 * length when decrypting.
+	 */
+	size_t len;
+	/* Output length: resulting AVTPDU length when encrypting,
+	 * encapsulated AVTPDU length when decrypting.
+	 */
+	size_t out_len;
+	/* Result of decrypting this entry, as avtp_aef_decrypt(). */
+	int res;
+};
+
+/* Encapsulate a burst of AVTPDUs, as avtp_aef_encrypt(). All entries are
+ * validated before any is touched.
+ * @aef: Pointer to context.
+ * @bufs: Burst entries.
+ * @count: Number of entries in 'bufs'.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_encrypt_batch(struct avtp_aef *aef, struct avtp_aef_buf *bufs,
+							unsigned int count);
+
+/* Decapsulate a burst of AVTPDUs, as avtp_aef_decrypt(). The result of each
+ * entry is saved in its 'res' field.
+ * @aef: Pointer to context.
+ * @bufs: Burst entries.
+ * @count: Number of entries in 'bufs'.
+ *
+ * Returns:
+ *    >= 0: Number of entries successfully decapsulated.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_aef_decrypt_batch(struct avtp_aef *aef, struct avtp_aef_buf *bufs,
+							unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ASRC flags. By default samples are interleaved and in host byte order.
+ * Planar buffers hold one plane per channel, one after another, each plane
+ * being as long as the number of frames passed to avtp_asrc_process(). AAF
+ * payloads are interleaved and in network order, so they are handled with
+ * AVTP_ASRC_IN_BIG_ENDIAN.
+ */
+#define AVTP_ASRC_IN_PLANAR			(1 << 0)
+#define AVTP_ASRC_OUT_PLANAR			(1 << 1)
+#define AVTP_ASRC_IN_BIG_ENDIAN			(1 << 2)
+#define AVTP_ASRC_OUT_BIG_ENDIAN		(1 << 3)
+
+/* Opaque asynchronous sample rate converter. */
+struct avtp_asrc;
+
+/* Create asynchronous sample rate converter. It converts PCM samples between
+ * two AAF nominal sample rates with a polyphase windowed-sinc filter, and
+ * follows the rate ratio set with avtp_asrc_set_ratio().
+ * @asrc: Pointer to variable which the converter should be saved. It must be
+ *        destroyed with avtp_asrc_destroy() when no longer needed.
+ * @in_nsr: Input AAF 'nsr' field value (AVTP_AAF_PCM_NSR_*).
+ * @out_nsr: Output AAF 'nsr' field value (AVTP_AAF_PCM_NSR_*).
+ * @format: AAF 'format' field value for both input and output. Supported
+ *          values are AVTP_AAF_FORMAT_INT_16BIT, AVTP_AAF_FORMAT_INT_24BIT,
+ *          AVTP_AAF_FORMAT_INT_32BIT and AVTP_AAF_FORMAT_FLOAT_32BIT.
+ * @channels: Number of channels per frame.
+ * @flags: Bitwise OR of AVTP_ASRC_* flags.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOMEM: If memory could not be allocated.
+ */
+int avtp_asrc_create(struct avtp_asrc **asrc, uint8_t in_nsr,
+			uint8_t out_nsr, uint8_t format, uint16_t channels,
+			uint32_t flags);
+
+/* Destroy asynchronous sample rate converter.
+ * @asrc: Pointer to converter.
+ */
+void avtp_asrc_destroy(struct avtp_asrc *asrc);
+
+/* Set the rate ratio correction. This is the frequency offset of the input
+ * media clock from the local output clock, e.g. the 'ppb' value reported by
+ * avtp_crf_servo_get_status().
+ * @asrc: Pointer to converter.
+ * @ppb: Frequency offset, in parts per billion. Must be within +/-10%.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_asrc_set_ratio(struct avtp_asrc *asrc, int64_t ppb);
+
+/* Get the number of frames avtp_asrc_process() produces for an input.
+ * @asrc: Pointer to converter.
+ * @in_frames: Number of input frames.
+ * @out_frames: Pointer to variable which the number of output frames should
+ *              be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_asrc_get_output_frames(const struct avtp_asrc *asrc,
+				size_t in_frames, size_t *out_frames);
+
+/* Convert samples. All input frames are consumed. The converter keeps the
+ * filter history so a stream can be converted in chunks of any size.
+ * @asrc: Pointer to converter.
+ * @in: Input samples.
+ * @in_frames: Number of input frames.
+ * @out: Output buffer.
+ * @out_frames: Number of frames the output buffer can hold. Use
+ *              avtp_asrc_get_output_frames() to size it.
+ * @produced: Pointer to variable which the number of frames written to the
+ *            output buffer should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOSPC: If the output buffer is too small. Nothing is consumed.
+ */
+int avtp_asrc_process(struct avtp_asrc *asrc, const void *in,
+			size_t in_frames, void *out, size_t out_frames,
+			size_t *produced);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Coalescing presentation sink.
+ *
+ * Instead of one write() per payload at its presentation time, payloads are
+ * queued with their presentation time and written out in batches: when the
+ * first queued payload is due, it is written along with every payload due
+ * within the following 'window' ns, with a single writev() (one per
+ * AVTP_BATCH_MAX_IOV payloads).
+ *
+ * Timing error bound: a payload reaches the file descriptor at most 'window'
+ * ns before its presentation time. It is never written late by the sink
+ * itself, but by as much as the caller's timer is late to call
+ * avtp_batch_sink_flush(). Both are measured, see struct
+ * avtp_batch_sink_stats. With 'window' at 0 the sink behaves like
+ * one write() per payload, minus the payloads sharing a presentation time.
+ *
+ * Payloads are copied into the sink when queued, so the caller's buffers
+ * may be reused right away. They are written in the order they were queued,
+ * which is expected to be presentation time order.
+ */
+
+/* Maximum number of payloads written per writev() call. */
+#define AVTP_BATCH_MAX_IOV			1024
+
+/* Opaque coalescing presentation sink. */
+struct avtp_batch_sink;
+
+struct avtp_batch_sink_stats {
+	/* Number of payloads written. */
+	uint64_t payloads;
+	/* Number of writev() calls issued. */
+	uint64_t writes;
+	/* Largest time a payload was written before its presentation time,
+	 * in ns. Bounded by 'window'.
+	 */
+	uint64_t max_early;
+	/* Largest time a payload was written after its presentation time, in
+	 * ns, i.e. the flush latency.
+	 */
+	uint64_t max_late;
+};
+
+/* Create coalescing presentation sink.
+ * @sink: Pointer to variable which the sink should be saved. It must be
+ *        destroyed with avtp_batch_sink_destroy() when no longer needed.
+ * @fd: File descriptor payloads are written to, e.g. a pipe or a file. It
+ *      is expected to be in blocking mode.
+ * @window: Coalescing window, in nanoseconds.
+ * @max_payloads: Maximum number of payloads queued.
+ * @max_bytes: Maximum number of payload bytes queued.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOMEM: If memory could not be allocated.
+ */
+int avtp_batch_sink_create(struct avtp_batch_sink **sink, int fd,
+				uint64_t window, size_t max_payloads,
+				size_t max_bytes);
+
+/* Destroy coalescing presentation sink. Queued payloads are discarded.
+ * @sink: Pointer to sink.
+ */
+void avtp_batch_sink_destroy(struct avtp_batch_sink *sink);
+
+/* Queue a payload for presentation.
+ * @sink: Pointer to sink.
+ * @data: Payload, copied into the sink.
+ * @len: Payload length, in bytes.
+ * @time: Presentation time, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOSPC: If the sink is full. Payloads due must be flushed first.
+ */
+int avtp_batch_sink_queue(struct avtp_batch_sink *sink, const void *data,
+						size_t len, uint64_t time);
+
+/* Get the time the next batch is due, i.e. the presentation time of the
+ * first queued payload. avtp_batch_sink_flush() should be called then.
+ * @sink: Pointer to sink.
+ * @time: Pointer to variable which the time should be saved.
+ *
+ * Returns:
+ *    1: A batch is pending, 'time' is set.
+ *    0: No payload is queued.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_batch_sink_get_deadline(const struct avtp_batch_sink *sink,
+							uint64_t *time);
+
+/* Write out the payloads due by 'now' plus the coalescing window.
+ * @sink: Pointer to sink.
+ * @now: Current time, in nanoseconds, in the presentation time base.
+ *
+ * Returns:
+ *    >= 0: Number of payloads written.
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by writev(). Payloads not fully written
+ *         stay queued.
+ */
+int avtp_batch_sink_flush(struct avtp_batch_sink *sink, uint64_t now);
+
+/* Get sink statistics.
+ * @sink: Pointer to sink.
+ * @stats: Pointer to struct which the statistics should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_batch_sink_get_stats(const struct avtp_batch_sink *sink,
+				struct avtp_batch_sink_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,481 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* C++20 coroutine receive layer.
+ *
+ * avtp::reactor multiplexes any number of stream coroutines on one thread
+ * with epoll. Coroutines wait on two awaitables:
+ *
+ *    - avtp::receiver::recv() receives a batch of PDUs from a socket with a
+ *      single recvmmsg() into buffers allocated once by init().
+ *    - avtp::timer::sleep_until() waits for a CLOCK_REALTIME deadline, e.g.
+ *      the presentation time from get_presentation_time(), with a timerfd.
+ *
+ * Both try the operation first and only suspend when it would block, so a
+ * busy stream runs without going through epoll. Nothing is allocated per
+ * packet: the only allocations are the receiver buffers and the coroutine
+ * frames themselves.
+ *
+ * A typical listener coroutine:
+ *
+ *    avtp::task listen(avtp::receiver &rx, avtp::timer &tm)
+ *    {
+ *        while (true) {
+ *            int n = co_await rx.recv();
+ *
+ *            if (n < 0)
+ *                break;
+ *
+ *            for (int i = 0; i < n; i++) {
+ *                ... validate rx.packet(i), compute its presentation time ...
+ *                co_await tm.sleep_until(time);
+ *                ... present ...
+ *            }
+ *        }
+ *    }
+ *
+ * Receivers and timers are registered with epoll edge-triggered for their
+ * whole life, and must outlive any coroutine waiting on them. The reactor is
+ * not thread-safe.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace avtp {
+
+namespace detail {
+
+/* Epoll registration. 'on_event' is called by the reactor when the file
+ * descriptor is ready and a coroutine is waiting on it; it resumes the
+ * coroutine unless the wakeup turns out to be spurious.
+ */
+struct waiter {
+	std::coroutine_handle<> handle;
+	void (*on_event)(waiter *w);
+};
+
+} // namespace detail
+
+/* Detached coroutine. It starts running when called and its frame is freed
+ * when it returns.
+ */
+struct task {
+	struct promise_type {
+		task get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+class reactor {
+public:
+	reactor() = default;
+	reactor(const reactor &) = delete;
+	reactor &operator=(const reactor &) = delete;
+
+	~reactor()
+	{
+		if (epfd_ >= 0)
+			close(epfd_);
+	}
+
+	/* Initialize reactor.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    < 0: Negative errno reported by epoll_create1().
+	 */
+	int init() noexcept
+	{
+		epfd_ = epoll_create1(EPOLL_CLOEXEC);
+
+		return epfd_ < 0 ? -errno : 0;
+	}
+
+	/* Wait up to 'timeout_ms' for events and resume the coroutines they
+	 * complete.
+	 *
+	 * Returns:
+	 *    >= 0: Number of events handled.
+	 *    < 0: Negative errno reported by epoll_wait().
+	 */
+	int poll(int timeout_ms) noexcept
+	{
+		int n;
+
+		n = epoll_wait(epfd_, events_, MAX_EVENTS, timeout_ms);
+		if (n < 0)
+			return errno == EINTR ? 0 : -errno;
+
+		for (nevents_ = n, next_ = 0; next_ < nevents_;) {
+			auto *w = static_cast<detail::waiter *>(
+						events_[next_++].data.ptr);
+
+			if (w && w->handle)
+				w->on_event(w);
+		}
+
+		return n;
+	}
+
+	/* Run until stop() is called.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    < 0: Negative errno reported by epoll_wait().
+	 */
+	int run() noexcept
+	{
+		int res;
+
+		stopped_ = false;
+		while (!stopped_) {
+			res = poll(-1);
+			if (res < 0)
+				return res;
+		}
+
+		return 0;
+	}
+
+	/* Make run() return once the current events are handled. */
+	void stop() noexcept
+	{
+		stopped_ = true;
+	}
+
+	/* Register 'fd' for readiness events, used by receiver and timer. */
+	int add(int fd, detail::waiter *w) noexcept
+	{
+		struct epoll_event ev = {};
+
+		ev.events = EPOLLIN | EPOLLET;
+		ev.data.ptr = w;
+
+		return epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) < 0 ? -errno : 0;
+	}
+
+	/* Unregister 'fd'. Events for 'w' not handled yet by the current
+	 * poll() are dropped, so a coroutine may destroy its receivers and
+	 * timers as soon as it is resumed.
+	 */
+	void remove(int fd, detail::waiter *w) noexcept
+	{
+		int i;
+
+		epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+
+		for (i = next_; i < nevents_; i++) {
+			if (events_[i].data.ptr == w)
+				events_[i].data.ptr = nullptr;
+		}
+	}
+
+private:
+	static constexpr int MAX_EVENTS = 64;
+
+	int epfd_ = -1;
+	bool stopped_ = false;
+	struct epoll_event events_[MAX_EVENTS];
+	int nevents_ = 0;
+	int next_ = 0;
+};
+
+/* Batch receiver on a socket. The socket is owned by the caller. */
+class receiver : private detail::waiter {
+public:
+	receiver() = default;
+	receiver(const receiver &) = delete;
+	receiver &operator=(const receiver &) = delete;
+
+	~receiver()
+	{
+		if (r_)
+			r_->remove(fd_, this);
+	}
+
+	/* Initialize receiver.
+	 * @r: Reactor the receiver is registered with.
+	 * @fd: Socket file descriptor. O_NONBLOCK is not required.
+	 * @batch: Maximum number of PDUs returned by a recv().
+	 * @max_pdu_size: Size of each PDU buffer. Longer PDUs are truncated.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    -EINVAL: If any argument is invalid.
+	 *    -ENOMEM: If memory could not be allocated.
+	 *    < 0: Negative errno reported by epoll_ctl().
+	 */
+	int init(reactor &r, int fd, unsigned int batch,
+					std::size_t max_pdu_size) noexcept
+	{
+		unsigned int i;
+		int res;
+
+		if (r_ || fd < 0 || batch == 0 || max_pdu_size == 0)
+			return -EINVAL;
+
+		buf_.reset(new (std::nothrow) std::byte[batch * max_pdu_size]);
+		iov_.reset(new (std::nothrow) struct iovec[batch]);
+		msgs_.reset(new (std::nothrow) struct mmsghdr[batch]());
+		if (!buf_ || !iov_ || !msgs_)
+			return -ENOMEM;
+
+		for (i = 0; i < batch; i++) {
+			iov_[i].iov_base = &buf_[i * max_pdu_size];
+			iov_[i].iov_len = max_pdu_size;
+			msgs_[i].msg_hdr.msg_iov = &iov_[i];
+			msgs_[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		handle = nullptr;
+		on_event = event;
+		res = r.add(fd, this);
+		if (res < 0)
+			return res;
+
+		r_ = &r;
+		fd_ = fd;
+		batch_ = batch;
+		return 0;
+	}
+
+	struct recv_awaitable {
+		receiver &rx;
+
+		bool await_ready() noexcept
+		{
+			return rx.try_recv();
+		}
+
+		void await_suspend(std::coroutine_handle<> h) noexcept
+		{
+			rx.handle = h;
+		}
+
+		int await_resume() noexcept
+		{
+			return rx.result_;
+		}
+	};
+
+	/* Receive a batch of PDUs, suspending until at least one is available.
+	 * The co_await expression evaluates to the number of PDUs received, or
+	 * a negative errno reported by recvmmsg(). PDUs are valid until the
+	 * next recv().
+	 */
+	recv_awaitable recv() noexcept
+	{
+		return { *this };
+	}
+
+	/* PDU 'i' from the last batch. */
+	std::span<const std::byte> packet(unsigned int i) const noexcept
+	{
+		return { static_cast<const std::byte *>(iov_[i].iov_base),
+							msgs_[i].msg_len };
+	}
+
+	/* Whether PDU 'i' from the last batch was truncated. */
+	bool truncated(unsigned int i) const noexcept
+	{
+		return msgs_[i].msg_hdr.msg_flags & MSG_TRUNC;
+	}
+
+private:
+	bool try_recv() noexcept
+	{
+		int n;
+
+		n = recvmmsg(fd_, msgs_.get(), batch_, MSG_DONTWAIT, nullptr);
+		if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return false;
+			if (errno == EINTR)
+				return try_recv();
+			n = -errno;
+		}
+
+		result_ = n;
+		return true;
+	}
+
+	static void event(detail::waiter *w) noexcept
+	{
+		receiver *rx = static_cast<receiver *>(w);
+
+		if (rx->try_recv())
+			std::exchange(rx->handle, nullptr).resume();
+	}
+
+	reactor *r_ = nullptr;
+	int fd_ = -1;
+	unsigned int batch_ = 0;
+	int result_ = 0;
+	std::unique_ptr<std::byte[]> buf_;
+	std::unique_ptr<struct iovec[]> iov_;
+	std::unique_ptr<struct mmsghdr[]> msgs_;
+};
+
+/* Absolute CLOCK_REALTIME timer. */
+class timer : private detail::waiter {
+public:
+	timer() = default;
+	timer(const timer &) = delete;
+	timer &operator=(const timer &) = delete;
+
+	~timer()
+	{
+		if (fd_ < 0)
+			return;
+
+		if (r_)
+			r_->remove(fd_, this);
+		close(fd_);
+	}
+
+	/* Initialize timer.
+	 * @r: Reactor the timer is registered with.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    -EINVAL: If the timer is already initialized.
+	 *    < 0: Negative errno reported by timerfd_create() or epoll_ctl().
+	 */
+	int init(reactor &r) noexcept
+	{
+		int res;
+
+		if (fd_ >= 0)
+			return -EINVAL;
+
+		fd_ = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (fd_ < 0)
+			return -errno;
+
+		handle = nullptr;
+		on_event = event;
+		res = r.add(fd_, this);
+		if (res < 0)
+			return res;
+
+		r_ = &r;
+		return 0;
+	}
+
+	struct sleep_awaitable {
+		timer &tm;
+		uint64_t time;
+
+		bool await_ready() noexcept
+		{
+			return tm.arm(time);
+		}
+
+		void await_suspend(std::coroutine_handle<> h) noexcept
+		{
+			tm.handle = h;
+		}
+
+		int await_resume() noexcept
+		{
+			return tm.result_;
+		}
+	};
+
+	/* Suspend until CLOCK_REALTIME reaches 'time', in nanoseconds. The
+	 * co_await expression evaluates to 0, or a negative errno reported by
+	 * timerfd_settime(). Deadlines already in the past don't suspend.
+	 */
+	sleep_awaitable sleep_until(uint64_t time) noexcept
+	{
+		return { *this, time };
+	}
+
+private:
+	static constexpr uint64_t NSEC_PER_SEC = 1000000000ULL;
+
+	/* Returns true if the deadline is due or the timer failed. */
+	bool arm(uint64_t time) noexcept
+	{
+		struct itimerspec its = {};
+		struct timespec now;
+
+		result_ = 0;
+		clock_gettime(CLOCK_REALTIME, &now);
+		if ((uint64_t) now.tv_sec * NSEC_PER_SEC + now.tv_nsec >= time)
+			return true;
+
+		its.it_value.tv_sec = time / NSEC_PER_SEC;
+		its.it_value.tv_nsec = time % NSEC_PER_SEC;
+		if (timerfd_settime(fd_, TFD_TIMER_ABSTIME, &its, nullptr) < 0) {
+			result_ = -errno;
+			return true;
+		}
+
+		return false;
+	}
+
+	static void event(detail::waiter *w) noexcept
+	{
+		timer *tm = static_cast<timer *>(w);
+		uint64_t expirations;
+
+		/* Expirations left over from an earlier deadline were reset by
+		 * timerfd_settime(), so a failed read is a spurious wakeup.
+		 */
+		if (read(tm->fd_, &expirations, sizeof(expirations)) < 0)
+			return;
+
+		std::exchange(tm->handle, nullptr).resume();
+	}
+
+	reactor *r_ = nullptr;
+	int fd_ = -1;
+	int result_ = 0;
+};
+
+} // namespace avtp
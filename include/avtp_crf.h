@@ -28,6 +28,7 @@
 #pragma once
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -105,6 +106,225 @@ int avtp_crf_pdu_set(struct avtp_crf_pdu *pdu, enum avtp_crf_field field,
  */
 int avtp_crf_pdu_init(struct avtp_crf_pdu *pdu);
 
+/* CRF timestamp generator state. Fields are private and should not be
+ * accessed directly, use the avtp_crf_gen_*() APIs instead.
+ *
+ * The generator keeps the time of the next timestamp as an integer number of
+ * nanoseconds plus a remainder (rem / div) so the nominal period, which is
+ * rarely an integer number of nanoseconds, is accumulated without drifting.
+ * It holds no global state so any number of generators can be driven from
+ * the same thread.
+ */
+struct avtp_crf_gen {
+	uint64_t time;
+	uint64_t rem;
+	uint64_t period;
+	uint64_t period_rem;
+	uint64_t div;
+	uint32_t base_freq;
+	uint16_t timestamp_interval;
+	uint8_t type;
+	uint8_t pull;
+	uint8_t seq_num;
+};
+
+/* Initialize CRF timestamp generator.
+ * @gen: Pointer to generator struct.
+ * @type: CRF 'type' field value (AVTP_CRF_TYPE_*).
+ * @pull: CRF 'pull' field value (AVTP_CRF_PULL_*).
+ * @base_freq: CRF 'base_frequency' field value, in Hz.
+ * @timestamp_interval: Number of base frequency events between timestamps.
+ * @time: First CRF timestamp to be generated, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_gen_init(struct avtp_crf_gen *gen, uint8_t type, uint8_t pull,
+				uint32_t base_freq, uint16_t timestamp_interval,
+				uint64_t time);
+
+/* Initialize CRF AVTPDU with the 'type', 'pull', 'base_frequency' and
+ * 'timestamp_interval' fields the generator is configured with. All other
+ * fields are initialized as in avtp_crf_pdu_init().
+ * @gen: Pointer to generator struct.
+ * @pdu: Pointer to PDU struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_gen_pdu_init(const struct avtp_crf_gen *gen,
+						struct avtp_crf_pdu *pdu);
+
+/* Fill the CRF data of a PDU with the next 'count' timestamps from the
+ * generator. 'crf_data_length' and 'sequence_num' fields are set as well, the
+ * latter being incremented on every call.
+ * @gen: Pointer to generator struct.
+ * @pdu: Pointer to PDU struct. It must have room for 'count' timestamps.
+ * @count: Number of timestamps to be generated.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_gen_fill(struct avtp_crf_gen *gen, struct avtp_crf_pdu *pdu,
+							unsigned int count);
+
+/* CRF frequency offset estimator state, updated by avtp_crf_pdu_validate().
+ * The following fields may be read by the application:
+ * @ppb: Running estimate of the media clock frequency offset from the
+ *       nominal frequency, in parts per billion. Positive values mean the
+ *       media clock runs faster than nominal.
+ * @base_time: Time of the first timestamp from the last validated PDU, as
+ *             fitted by least squares over the whole timestamp list.
+ * @count: Number of PDUs folded into the estimate since the last reset.
+ * Other fields are private.
+ */
+struct avtp_crf_drift {
+	int64_t ppb;
+	uint64_t base_time;
+	uint32_t count;
+	uint8_t mr;
+};
+
+/* Initialize CRF frequency offset estimator.
+ * @drift: Pointer to estimator struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_drift_init(struct avtp_crf_drift *drift);
+
+/* Validate the CRF data from a received PDU. The PDU must be a CRF PDU whose
+ * 'crf_data_length' is a non-zero multiple of the timestamp size and fits in
+ * 'len'. Timestamps must be strictly increasing and the spacing between two
+ * consecutive timestamps must not deviate from the nominal period, derived
+ * from 'timestamp_interval', 'base_frequency' and 'pull' fields, by more than
+ * 'tolerance'.
+ *
+ * The 'fs' (frame sync) flag doesn't change the timestamp spacing so PDUs
+ * with it set are validated as any other. A toggle of the 'mr' (media clock
+ * restart) flag resets the estimator before the PDU is folded in.
+ *
+ * @pdu: Pointer to PDU struct.
+ * @len: Number of bytes available from 'pdu'.
+ * @tolerance: Maximum spacing deviation, in nanoseconds.
+ * @drift: Pointer to estimator updated when the PDU is valid. May be NULL.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the PDU doesn't pass validation.
+ */
+int avtp_crf_pdu_validate(const struct avtp_crf_pdu *pdu, size_t len,
+			uint32_t tolerance, struct avtp_crf_drift *drift);
+
+/* CRF media clock servo states. */
+#define AVTP_CRF_SERVO_UNLOCKED			0x00
+#define AVTP_CRF_SERVO_LOCKED			0x01
+#define AVTP_CRF_SERVO_HOLDOVER			0x02
+
+/* CRF media clock servo. It is a second order (PI) phase locked loop which
+ * tracks the CRF timestamps and provides a smoothed media clock. Phase is
+ * kept in nanoseconds plus a 16-bit binary fraction and the period between
+ * CRF timestamps in 48.16 fixed-point nanoseconds. Fields are private and
+ * should not be accessed directly, use the avtp_crf_servo_*() APIs instead.
+ */
+struct avtp_crf_servo {
+	uint64_t phase;
+	uint64_t phase_frac;
+	uint64_t period;
+	uint64_t nominal;
+	int64_t kp;
+	int64_t ki;
+	int64_t phase_error;
+	uint64_t last_update;
+	uint64_t holdover_timeout;
+	uint32_t lock_threshold;
+	uint16_t timestamp_interval;
+	uint16_t lock_count;
+	uint8_t state;
+	uint8_t started;
+};
+
+struct avtp_crf_servo_status {
+	/* One of AVTP_CRF_SERVO_* values. */
+	uint8_t state;
+	/* Phase error measured on the last update, in nanoseconds. */
+	int64_t phase_error;
+	/* Frequency offset of the recovered media clock from the nominal
+	 * frequency, in parts per billion. Positive values mean the media
+	 * clock runs faster than nominal.
+	 */
+	int64_t ppb;
+};
+
+/* Initialize CRF media clock servo.
+ * @servo: Pointer to servo struct.
+ * @pull: CRF 'pull' field value of the tracked stream.
+ * @base_freq: CRF 'base_frequency' field value of the tracked stream.
+ * @timestamp_interval: CRF 'timestamp_interval' field value of the tracked
+ *                      stream.
+ * @bandwidth: Loop bandwidth, in millihertz. It must be small compared to
+ *             the CRF timestamp rate.
+ * @lock_threshold: Maximum phase error, in nanoseconds, for an update to
+ *                  count towards lock.
+ * @holdover_timeout: Time without updates, in nanoseconds, after which a
+ *                    locked servo enters holdover.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_servo_init(struct avtp_crf_servo *servo, uint8_t pull,
+			uint32_t base_freq, uint16_t timestamp_interval,
+			uint32_t bandwidth, uint32_t lock_threshold,
+			uint64_t holdover_timeout);
+
+/* Feed a CRF timestamp to the servo. Every timestamp from the CRF stream
+ * should be fed, in order, since loop gains are computed for one update per
+ * CRF timestamp period. Timestamps which are not ahead of the last one are
+ * ignored. If the phase error is too large to be tracked (more than about a
+ * millisecond) the servo restarts acquisition from the timestamp.
+ * @servo: Pointer to servo struct.
+ * @timestamp: CRF timestamp, in nanoseconds.
+ * @now: Current local time, in nanoseconds, used for holdover detection.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_servo_update(struct avtp_crf_servo *servo, uint64_t timestamp,
+								uint64_t now);
+
+/* Get the time of a media clock event from the recovered media clock. While
+ * in holdover the servo freewheels using the last period estimate.
+ * @servo: Pointer to servo struct.
+ * @events: Number of base frequency events (e.g. audio samples) after the
+ *          last CRF timestamp tracked.
+ * @time: Pointer to variable which the event time should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid or no timestamp was fed yet.
+ */
+int avtp_crf_servo_get_time(const struct avtp_crf_servo *servo,
+					uint64_t events, uint64_t *time);
+
+/* Get servo status.
+ * @servo: Pointer to servo struct.
+ * @now: Current local time, in nanoseconds, used for holdover detection.
+ * @status: Pointer to struct which the status should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_crf_servo_get_status(const struct avtp_crf_servo *servo,
+			uint64_t now, struct avtp_crf_servo_status *status);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,7 +28,9 @@
 #pragma once
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +39,27 @@ extern "C" {
 #define AVTP_IECIIDC_TAG_NO_CIP		0x00
 #define AVTP_IECIIDC_TAG_CIP		0x01
 
+/* Size of the CIP header (cip_1 and cip_2 quadlets). */
+#define AVTP_IECIIDC_CIP_HEADER_LEN	8
+
+/* IEC 61883-4 MPEG-TS packet and source packet (SPH + TS packet) sizes. */
+#define AVTP_IECIIDC_TS_PACKET_LEN	188
+#define AVTP_IECIIDC_TS_SP_LEN		192
+
+/* IEC 61883-6 'sfc' (sampling frequency code) values. */
+#define AVTP_IECIIDC_SFC_32KHZ		0x00
+#define AVTP_IECIIDC_SFC_44_1KHZ	0x01
+#define AVTP_IECIIDC_SFC_48KHZ		0x02
+#define AVTP_IECIIDC_SFC_88_2KHZ	0x03
+#define AVTP_IECIIDC_SFC_96KHZ		0x04
+#define AVTP_IECIIDC_SFC_176_4KHZ	0x05
+#define AVTP_IECIIDC_SFC_192KHZ		0x06
+
+/* IEC 61883-6 AM824 multi-bit linear audio labels. */
+#define AVTP_IECIIDC_AM824_LABEL_MBLA_24BIT	0x40
+#define AVTP_IECIIDC_AM824_LABEL_MBLA_20BIT	0x41
+#define AVTP_IECIIDC_AM824_LABEL_MBLA_16BIT	0x42
+
 enum avtp_ieciidc_field {
 	AVTP_IECIIDC_FIELD_SV,
 	AVTP_IECIIDC_FIELD_MR,
@@ -108,6 +131,17 @@ struct avtp_ieciidc_cip_source_packet {
 	uint8_t cip_with_sph_payload[0];
 };
 
+/* CIP header template. Fields are private and should not be accessed
+ * directly, use the avtp_ieciidc_cip_*() APIs instead.
+ *
+ * Both CIP quadlets are kept in network order with the per-packet fields
+ * ('dbc', FDF and 'syt') cleared, so writing the CIP header of a packet
+ * takes a single 8-byte store.
+ */
+struct avtp_ieciidc_cip {
+	uint64_t header;
+};
+
 /* Get value from IEC 61883/IIDC AVTPDU field.
  * @pdu: Pointer to PDU struct.
  * @field: PDU field to be retrieved.
@@ -147,6 +181,499 @@ int avtp_ieciidc_pdu_set(struct avtp_stream_pdu *pdu,
  */
 int avtp_ieciidc_pdu_init(struct avtp_stream_pdu *pdu, uint8_t tag);
 
+/* IEC 61883-4 MPEG-TS packetizer state. Fields are private and should not be
+ * accessed directly, use the avtp_ieciidc_ts_pktzr_*() APIs instead.
+ *
+ * The packetizer packs as many source packets per AVTPDU as fit in the
+ * maximum PDU size. Source packet header timestamps are spaced by the
+ * transmission time of one TS packet at the stream bitrate, kept as an
+ * integer number of nanoseconds plus a remainder (rem / bitrate) so they
+ * don't drift. 'dbc' and 'sequence_num' are advanced on every PDU, and the
+ * CIP header is written from a template built by avtp_ieciidc_ts_pktzr_init().
+ */
+struct avtp_ieciidc_ts_pktzr {
+	uint64_t time;
+	uint64_t rem;
+	uint64_t period;
+	uint64_t period_rem;
+	uint64_t bitrate;
+	struct avtp_ieciidc_cip cip;
+	unsigned int max_packets;
+	uint8_t dbc;
+	uint8_t seq_num;
+};
+
+/* Initialize IEC 61883-4 MPEG-TS packetizer.
+ * @pktzr: Pointer to packetizer struct.
+ * @bitrate: MPEG-TS stream bitrate, in bits per second.
+ * @max_pdu_size: Maximum AVTPDU size, in bytes, usually the network MTU. It
+ *                must hold at least one source packet.
+ * @time: Presentation time of the first source packet, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_pktzr_init(struct avtp_ieciidc_ts_pktzr *pktzr,
+				uint64_t bitrate, size_t max_pdu_size,
+				uint64_t time);
+
+/* Initialize IEC 61883/IIDC AVTPDU for IEC 61883-4 MPEG-TS. The PDU is
+ * initialized as in avtp_ieciidc_pdu_init() with 'tag' set to
+ * AVTP_IECIIDC_TAG_CIP, and the CIP header is set for MPEG-TS: 'sid' 63,
+ * 'dbs' 6, 'fn' 3 (8 data blocks per source packet), 'qpc' 0, 'sph' 1,
+ * 'fmt' 0x20 and 'channel' 31. Stream ID and other stream fields are left
+ * to the caller.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_pktzr_pdu_init(const struct avtp_ieciidc_ts_pktzr *pktzr,
+						struct avtp_stream_pdu *pdu);
+
+/* Pack MPEG-TS packets into an AVTPDU. Up to the maximum number of source
+ * packets the PDU can hold are copied, each one prefixed by its source packet
+ * header timestamp. 'stream_data_length', 'dbc' and 'sequence_num' fields are
+ * set as well.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct, initialized with
+ *       avtp_ieciidc_ts_pktzr_pdu_init(). It must be 'max_pdu_size' long.
+ * @data: MPEG-TS packets.
+ * @len: Length of 'data', in bytes. Trailing bytes which don't make a whole
+ *       TS packet are ignored.
+ * @pdu_len: Pointer to variable which the resulting AVTPDU size should be
+ *           saved.
+ *
+ * Returns:
+ *    > 0: Number of TS packets packed.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_pktzr_fill(struct avtp_ieciidc_ts_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, const void *data,
+				size_t len, size_t *pdu_len);
+
+/* Get the presentation time of the next source packet to be packed.
+ * @pktzr: Pointer to packetizer struct.
+ * @time: Pointer to variable which the time, in nanoseconds, should be
+ *        saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_pktzr_get_time(const struct avtp_ieciidc_ts_pktzr *pktzr,
+							uint64_t *time);
+
+/* IEC 61883-4 MPEG-TS depacketizer state. Fields are private and should not
+ * be accessed directly, use the avtp_ieciidc_ts_dpktzr_*() APIs instead.
+ *
+ * The depacketizer splits AVTPDUs into TS packets and queues them on a ring
+ * of caller-provided memory, so no memory is allocated per packet. TS packets
+ * are stored contiguously, so runs of them can be presented with a single
+ * write. Each one is tagged with the 64-bit presentation time reconstructed
+ * from its source packet header timestamp.
+ */
+struct avtp_ieciidc_ts_dpktzr {
+	uint8_t *data;
+	uint64_t *times;
+	unsigned int capacity;
+	unsigned int head;
+	unsigned int tail;
+	uint64_t packets;
+	uint64_t lost;
+	uint64_t dropped;
+	uint8_t expected_dbc;
+	uint8_t seq_num;
+	uint8_t started;
+};
+
+/* IEC 61883-4 MPEG-TS depacketizer statistics. */
+struct avtp_ieciidc_ts_dpktzr_stats {
+	/* TS packets queued. */
+	uint64_t packets;
+	/* TS packets lost, according to 'dbc' discontinuities. */
+	uint64_t lost;
+	/* TS packets dropped because the ring was full. */
+	uint64_t dropped;
+};
+
+/* Initialize IEC 61883-4 MPEG-TS depacketizer.
+ * @dpktzr: Pointer to depacketizer struct.
+ * @data: Ring buffer for TS packets. It must hold 'capacity' TS packets, i.e.
+ *        capacity * AVTP_IECIIDC_TS_PACKET_LEN bytes.
+ * @times: Ring buffer for presentation times. It must hold 'capacity'
+ *         entries.
+ * @capacity: Ring size, in TS packets. Must be a power of 2.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_dpktzr_init(struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				void *data, uint64_t *times,
+				unsigned int capacity);
+
+/* Split an IEC 61883-4 MPEG-TS AVTPDU and queue its TS packets. Source packet
+ * header timestamps are expanded to the 64-bit time closest to 'now'. Packets
+ * are kept in timestamp order: a packet timestamped earlier than the one
+ * queued before it is presented at the time of the latter. A 'dbc' jump
+ * forward is accounted as lost packets, while a PDU whose 'dbc' is behind
+ * the expected one, i.e. a duplicate or a reordered PDU, is discarded.
+ * @dpktzr: Pointer to depacketizer struct.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of the PDU, in bytes.
+ * @now: Current time, in nanoseconds.
+ *
+ * Returns:
+ *    >= 0: Number of TS packets queued, 0 if the PDU was discarded.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the PDU isn't a well-formed IEC 61883-4 AVTPDU.
+ *    -ENOSPC: If the ring can't hold all TS packets in the PDU. None are
+ *             queued and they are accounted as dropped.
+ */
+int avtp_ieciidc_ts_dpktzr_push(struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				uint64_t now);
+
+/* Get the presentation time of the oldest queued TS packet.
+ * @dpktzr: Pointer to depacketizer struct.
+ * @time: Pointer to variable which the time, in nanoseconds, should be
+ *        saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If no TS packet is queued.
+ */
+int avtp_ieciidc_ts_dpktzr_front(const struct avtp_ieciidc_ts_dpktzr *dpktzr,
+							uint64_t *time);
+
+/* Get the oldest queued TS packets which are due for presentation. Packets are
+ * not dequeued, use avtp_ieciidc_ts_dpktzr_pop() once they are consumed.
+ * @dpktzr: Pointer to depacketizer struct.
+ * @now: Current time, in nanoseconds. Packets with presentation time up to
+ *       'now' are due.
+ * @data: Pointer to variable which the address of the first TS packet should
+ *        be saved. Packets are contiguous in memory.
+ *
+ * Returns:
+ *    >= 0: Number of TS packets at 'data'. It may be less than the number of
+ *          due packets when the ring wraps around.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_dpktzr_peek(const struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				uint64_t now, const void **data);
+
+/* Dequeue the oldest TS packets.
+ * @dpktzr: Pointer to depacketizer struct.
+ * @count: Number of TS packets to dequeue.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid or fewer packets are queued.
+ */
+int avtp_ieciidc_ts_dpktzr_pop(struct avtp_ieciidc_ts_dpktzr *dpktzr,
+							unsigned int count);
+
+/* Get depacketizer statistics.
+ * @dpktzr: Pointer to depacketizer struct.
+ * @stats: Pointer to struct which the statistics should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_ts_dpktzr_get_stats(
+				const struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				struct avtp_ieciidc_ts_dpktzr_stats *stats);
+
+/* IEC 61883-6 AM824 packer state. Fields are private and should not be
+ * accessed directly, use the avtp_ieciidc_am824_*() APIs instead.
+ *
+ * The packer converts interleaved PCM frames into AM824 data blocks, one
+ * quadlet per channel, and keeps track of 'dbc', 'syt' and 'sequence_num'.
+ * The time of the next data block is kept as an integer number of
+ * nanoseconds plus a remainder (rem / rate).
+ *
+ * In blocking mode every packet carries exactly SYT_INTERVAL data blocks (8,
+ * 16 or 32 depending on the sampling frequency), or none, in which case a
+ * NO-DATA packet is generated. In non-blocking mode packets carry any number
+ * of data blocks, and 'syt' is only valid when one of them starts a SYT
+ * interval.
+ */
+struct avtp_ieciidc_am824 {
+	uint64_t time;
+	uint64_t rem;
+	uint64_t period;
+	uint64_t period_rem;
+	struct avtp_ieciidc_cip cip;
+	uint32_t rate;
+	uint16_t channels;
+	uint8_t sfc;
+	uint8_t bits;
+	uint8_t syt_interval;
+	uint8_t blocking;
+	uint8_t dbc;
+	uint8_t seq_num;
+};
+
+/* Initialize IEC 61883-6 AM824 packer.
+ * @am824: Pointer to packer struct.
+ * @sfc: Sampling frequency code (AVTP_IECIIDC_SFC_*).
+ * @channels: Number of audio channels, which is also the data block size in
+ *            quadlets. Must be between 1 and 255.
+ * @bits: PCM sample size, 16 or 24. 16-bit samples are int16_t, 24-bit
+ *        samples are int32_t holding the sample in the lower 24 bits.
+ * @blocking: Non-zero for blocking transmission mode.
+ * @time: Presentation time of the first PCM frame, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_am824_init(struct avtp_ieciidc_am824 *am824, uint8_t sfc,
+				uint16_t channels, uint8_t bits, int blocking,
+				uint64_t time);
+
+/* Initialize IEC 61883/IIDC AVTPDU for IEC 61883-6 AM824. The PDU is
+ * initialized as in avtp_ieciidc_pdu_init() with 'tag' set to
+ * AVTP_IECIIDC_TAG_CIP, and the CIP header is set for AM824: 'sid' 63, 'dbs'
+ * set to the number of channels, 'fn' 0, 'qpc' 0, 'sph' 0, 'fmt' 0x10, 'evt'
+ * 0, 'sfc' and 'channel' 31. Stream ID is left to the caller.
+ * @am824: Pointer to packer struct.
+ * @pdu: Pointer to PDU struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_am824_pdu_init(const struct avtp_ieciidc_am824 *am824,
+						struct avtp_stream_pdu *pdu);
+
+/* Pack interleaved PCM frames into an AVTPDU as AM824 data blocks with MBLA
+ * labels. 'stream_data_length', 'sequence_num', 'dbc', 'syt' and FDF fields
+ * are set, as well as 'tv' and 'avtp_timestamp', which carry the presentation
+ * time of the data block 'syt' refers to. If 'frames' is zero, a NO-DATA
+ * packet is generated.
+ * @am824: Pointer to packer struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_ieciidc_am824_pdu_init().
+ *       It must have room for 'frames' data blocks.
+ * @pcm: Interleaved PCM frames.
+ * @frames: Number of PCM frames. In blocking mode it must be either zero or
+ *          the SYT interval.
+ * @pdu_len: Pointer to variable which the resulting AVTPDU size should be
+ *           saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_am824_pack(struct avtp_ieciidc_am824 *am824,
+				struct avtp_stream_pdu *pdu, const void *pcm,
+				unsigned int frames, size_t *pdu_len);
+
+/* Unpack AM824 data blocks from an IEC 61883-6 AVTPDU into interleaved PCM
+ * frames. Each data block yields one frame of 'channels' samples. Label
+ * bytes are discarded; 16-bit output keeps the 16 most significant bits of
+ * each sample.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of the PDU, in bytes.
+ * @bits: PCM sample size, 16 or 24, as in avtp_ieciidc_am824_init().
+ * @channels: Number of audio channels of the stream, between 1 and 255. PDUs
+ *            whose 'dbs' differs are rejected.
+ * @pcm: Buffer for interleaved PCM frames.
+ * @max_frames: Number of frames 'pcm' can hold.
+ *
+ * Returns:
+ *    >= 0: Number of frames unpacked. NO-DATA packets yield zero frames.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the PDU isn't a well-formed IEC 61883-6 AM824 AVTPDU.
+ *    -ENOSPC: If 'pcm' can't hold all frames.
+ */
+int avtp_ieciidc_am824_unpack(const struct avtp_stream_pdu *pdu, size_t len,
+				uint8_t bits, unsigned int channels, void *pcm,
+				unsigned int max_frames);
+
+/* Video frame buffer descriptor for IEC 61883-8. Lines are 'line_len' bytes
+ * long and start every 'stride' bytes from 'data'.
+ */
+struct avtp_ieciidc_video_frame {
+	uint8_t *data;
+	size_t stride;
+};
+
+/* IEC 61883-8 video packetizer/depacketizer state. Fields are private and
+ * should not be accessed directly, use the avtp_ieciidc_video_*() APIs
+ * instead.
+ *
+ * Video lines are mapped onto consecutive CIP data blocks, so a frame is a
+ * sequence of line_len * height / (dbs * 4) data blocks. The first packet of
+ * a frame has the 'sy' field set to 1, and the position of any other packet
+ * in the frame follows from its 'dbc'. Packets are never padded: every frame
+ * line length must be a multiple of the data block size.
+ */
+struct avtp_ieciidc_video {
+	size_t line_len;
+	size_t block_len;
+	uint64_t frame_blocks;
+	uint64_t block;
+	uint64_t lost;
+	struct avtp_ieciidc_cip cip;
+	unsigned int height;
+	unsigned int max_blocks;
+	uint8_t dbs;
+	uint8_t dbc;
+	uint8_t seq_num;
+	uint8_t synced;
+};
+
+/* Initialize IEC 61883-8 video packetizer or depacketizer.
+ * @video: Pointer to video struct.
+ * @dbs: Data block size, in quadlets.
+ * @line_len: Length of a video line, in bytes. Must be a multiple of the data
+ *            block size.
+ * @height: Number of lines per frame.
+ * @max_pdu_size: Maximum AVTPDU size, in bytes, usually the network MTU. It
+ *                must hold at least one data block. Packets carry at most 255
+ *                data blocks regardless, so 'dbc' tells the size of a lost one.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_video_init(struct avtp_ieciidc_video *video, uint8_t dbs,
+				size_t line_len, unsigned int height,
+				size_t max_pdu_size);
+
+/* Initialize IEC 61883/IIDC AVTPDU for IEC 61883-8 video. The PDU is
+ * initialized as in avtp_ieciidc_pdu_init() with 'tag' set to
+ * AVTP_IECIIDC_TAG_CIP, and the CIP header is set for video: 'sid' 63, 'dbs',
+ * 'fn' 0, 'qpc' 0, 'sph' 0, 'fmt' 0x01 and 'channel' 31. Stream ID is left to
+ * the caller.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct. Only the AVTPDU and CIP headers are used.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_video_pdu_init(const struct avtp_ieciidc_video *video,
+						struct avtp_stream_pdu *pdu);
+
+/* Packetize the next part of a video frame without copying it. The PDU
+ * headers are updated ('stream_data_length', 'sequence_num', 'sy', 'dbc')
+ * and 'iov' is filled with a gather list for sendmsg() or similar: the first
+ * entry covers the AVTPDU and CIP headers in 'pdu', the following ones point
+ * into the frame buffer, one per (part of a) line.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_ieciidc_video_pdu_init().
+ * @frame: Frame buffer descriptor.
+ * @iov: Gather list to be filled.
+ * @iovcnt: Number of entries in 'iov'. Packets span at most
+ *          max_pdu_size / line_len + 2 lines, so that many plus one entries
+ *          always suffice; fewer entries make for shorter packets.
+ * @end_of_frame: Pointer to variable which is set to 1 if this was the last
+ *                packet of the frame, 0 otherwise. The next call starts a new
+ *                frame.
+ *
+ * Returns:
+ *    > 0: Number of 'iov' entries used.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_video_pack(struct avtp_ieciidc_video *video,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_ieciidc_video_frame *frame,
+				struct iovec *iov, unsigned int iovcnt,
+				int *end_of_frame);
+
+/* Depacketize an IEC 61883-8 AVTPDU into a video frame buffer. Data blocks are
+ * copied straight to their line in the frame. Packets are dropped until the
+ * start of a frame is seen; afterwards 'dbc' discontinuities are accounted as
+ * lost data blocks, whose area of the frame is left untouched. If more
+ * packets were lost, according to 'sequence_num', than 'dbc' can account for,
+ * packets are dropped until the start of the next frame again.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of the PDU, in bytes.
+ * @frame: Frame buffer descriptor.
+ *
+ * Returns:
+ *    1: The last data block of the frame was received.
+ *    0: Success, the frame isn't complete yet, or the packet was dropped.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the PDU isn't a well-formed IEC 61883-8 AVTPDU.
+ */
+int avtp_ieciidc_video_unpack(struct avtp_ieciidc_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				const struct avtp_ieciidc_video_frame *frame);
+
+/* Get the number of data blocks lost, as seen by the depacketizer.
+ * @video: Pointer to video struct.
+ * @lost: Pointer to variable which the number of lost data blocks should be
+ *        saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_video_get_lost(const struct avtp_ieciidc_video *video,
+							uint64_t *lost);
+
+/* Initialize CIP header template from the CIP header of a PDU. The PDU
+ * should have been set up with the constant CIP fields of the stream (e.g.
+ * 'sid', 'dbs', 'fn', 'qpc', 'sph', 'fmt'); its 'dbc', FDF and 'syt' fields
+ * are ignored.
+ * @cip: Pointer to template struct.
+ * @pdu: Pointer to PDU struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid or the PDU 'tag' isn't
+ *             AVTP_IECIIDC_TAG_CIP.
+ */
+int avtp_ieciidc_cip_init(struct avtp_ieciidc_cip *cip,
+					const struct avtp_stream_pdu *pdu);
+
+/* Write the CIP header of a PDU from the template.
+ * @cip: Pointer to template struct.
+ * @pdu: Pointer to PDU struct.
+ * @dbc: 'dbc' field value.
+ * @fdf: FDF field value. For formats with a 3-octet FDF (FDF_3), this is the
+ *       most significant octet and 'syt' holds the other two.
+ * @syt: 'syt' field value.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_cip_write(const struct avtp_ieciidc_cip *cip,
+				struct avtp_stream_pdu *pdu, uint8_t dbc,
+				uint8_t fdf, uint16_t syt);
+
+/* Write the CIP header of a burst of PDUs from the template. PDU 'i' gets
+ * 'dbc' + i * 'dbc_step' as 'dbc' and 'syt[i]' as 'syt'.
+ * @cip: Pointer to template struct.
+ * @pdus: Array of pointers to PDU structs.
+ * @count: Number of PDUs.
+ * @dbc: 'dbc' field value of the first PDU.
+ * @dbc_step: Number of data blocks per PDU.
+ * @fdf: FDF field value, as in avtp_ieciidc_cip_write().
+ * @syt: Array of 'count' 'syt' field values. If NULL, 'syt' is set to 0xFFFF
+ *       (no information).
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ieciidc_cip_write_batch(const struct avtp_ieciidc_cip *cip,
+				struct avtp_stream_pdu *const pdus[],
+				unsigned int count, uint8_t dbc,
+				uint8_t dbc_step, uint8_t fdf,
+				const uint16_t *syt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avtp_acf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum 'ntscf_data_length' field value, in bytes. */
+#define AVTP_NTSCF_MAX_DATA_LEN			2047
+
+struct avtp_ntscf_pdu {
+	uint32_t subtype_data;
+	uint64_t stream_id;
+	uint8_t acf_msgs[0];
+} __attribute__ ((__packed__));
+
+enum avtp_ntscf_field {
+	AVTP_NTSCF_FIELD_SV,
+	AVTP_NTSCF_FIELD_DATA_LEN,
+	AVTP_NTSCF_FIELD_SEQ_NUM,
+	AVTP_NTSCF_FIELD_STREAM_ID,
+	AVTP_NTSCF_FIELD_MAX,
+};
+
+/* Get value from NTSCF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be retrieved.
+ * @val: Pointer to variable which the retrieved value should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ntscf_pdu_get(const struct avtp_ntscf_pdu *pdu,
+				enum avtp_ntscf_field field, uint64_t *val);
+
+/* Set value from NTSCF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be set.
+ * @val: Value to be set.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ntscf_pdu_set(struct avtp_ntscf_pdu *pdu,
+				enum avtp_ntscf_field field, uint64_t val);
+
+/* Initialize NTSCF AVTPDU. All AVTPDU fields are initialized with zero except
+ * 'subtype' (which is set to AVTP_SUBTYPE_NTSCF) and 'sv' (which is set to 1).
+ * @pdu: Pointer to PDU struct.
+ *
+ * Return values:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ntscf_pdu_init(struct avtp_ntscf_pdu *pdu);
+
+/* NTSCF packetizer state. Fields are private and should not be accessed
+ * directly, use the avtp_ntscf_pktzr_*() APIs instead.
+ *
+ * The packetizer appends ACF messages to the AVTPDU until it is full or the
+ * oldest message has waited for the latency budget, whichever comes first.
+ * The caller is told the deadline so it can sleep on it instead of polling.
+ */
+struct avtp_ntscf_pktzr {
+	uint64_t deadline;
+	uint64_t latency;
+	size_t max_data_len;
+	size_t data_len;
+	unsigned int count;
+	uint8_t seq_num;
+};
+
+/* Initialize NTSCF packetizer.
+ * @pktzr: Pointer to packetizer struct.
+ * @max_pdu_size: Maximum AVTPDU size, in bytes, usually the network MTU.
+ * @latency: Maximum time a message may wait in the AVTPDU, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_ntscf_pktzr_init(struct avtp_ntscf_pktzr *pktzr, size_t max_pdu_size,
+							uint64_t latency);
+
+/* Pack CAN frames into the AVTPDU. Frames are appended in order until one
+ * doesn't fit.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_ntscf_pdu_init(). It
+ *       must be 'max_pdu_size' long.
+ * @type: AVTP_ACF_TYPE_CAN or AVTP_ACF_TYPE_CAN_BRIEF.
+ * @msgs: CAN frames.
+ * @count: Number of entries in 'msgs'.
+ * @now: Current time, in nanoseconds. It starts the latency budget when the
+ *       AVTPDU was empty.
+ *
+ * Returns:
+ *    >= 0: Number of frames packed. Less than 'count' means the AVTPDU is
+ *          full and should be flushed with avtp_ntscf_pktzr_flush(), or
+ *          the next frame is invalid.
+ *    -EINVAL: If any argument is invalid, or the first frame is invalid.
+ */
+int avtp_ntscf_pktzr_pack_can(struct avtp_ntscf_pktzr *pktzr,
+				struct avtp_ntscf_pdu *pdu, uint8_t type,
+				const struct avtp_acf_can *msgs,
+				unsigned int count, uint64_t now);
+
+/* Get the time the AVTPDU should be flushed at, according to the latency
+ * budget.
+ * @pktzr: Pointer to packetizer struct.
+ * @deadline: Pointer to variable which the deadline, in nanoseconds, should
+ *            be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If the AVTPDU is empty.
+ */
+int avtp_ntscf_pktzr_get_deadline(const struct avtp_ntscf_pktzr *pktzr,
+							uint64_t *deadline);
+
+/* Finish the AVTPDU. 'ntscf_data_length' and 'sequence_num' fields are set,
+ * and the packetizer starts over so the same AVTPDU can be filled again once
+ * it has been transmitted.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct.
+ * @pdu_len: Pointer to variable which the resulting AVTPDU size should be
+ *           saved.
+ *
+ * Returns:
+ *    > 0: Number of ACF messages in the AVTPDU.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If the AVTPDU is empty.
+ */
+int avtp_ntscf_pktzr_flush(struct avtp_ntscf_pktzr *pktzr,
+				struct avtp_ntscf_pdu *pdu, size_t *pdu_len);
+
+/* Initialize ACF message iterator over a received NTSCF AVTPDU. Messages are
+ * not copied, see avtp_acf_iter_next().
+ * @iter: Pointer to iterator struct.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of received data, in bytes.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If 'pdu' is not a NTSCF AVTPDU or is truncated.
+ */
+int avtp_ntscf_iter_init(struct avtp_acf_iter *iter,
+				const struct avtp_ntscf_pdu *pdu, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Late/early packet policy.
+ *
+ * AVTP timestamps only carry the lower 32 bits of the presentation time, so
+ * the listener must pick the 4.29 s wrap they belong to. The policy resolves
+ * the timestamp to the presentation time nearest to 'now' and classifies it
+ * against the acceptance window [now - tolerance, now + max_transit_time +
+ * tolerance]:
+ *
+ *    - On time: within the window.
+ *    - Late: before the window.
+ *    - Early: after the window, i.e. further ahead than the talker may
+ *      schedule.
+ *    - Wrapped: within one window width of half the timestamp range
+ *      (2.1 s) away from 'now', either way. Their wrap can't be told
+ *      apart, e.g. very stale PDUs or a talker on another time base.
+ *
+ * Each class is mapped to an action and counted. With the default actions,
+ * which drop early and wrapped PDUs, nothing is scheduled past the window,
+ * which bounds the amount of data a listener holds to max_transit_time plus
+ * tolerance worth of stream.
+ */
+
+enum avtp_policy_class {
+	AVTP_POLICY_CLASS_ON_TIME,
+	AVTP_POLICY_CLASS_LATE,
+	AVTP_POLICY_CLASS_EARLY,
+	AVTP_POLICY_CLASS_WRAPPED,
+
+	/* Count number of classes. Keep this always as the last enum member. */
+	AVTP_POLICY_CLASS_MAX
+};
+
+enum avtp_policy_action {
+	/* Present at the presentation time. */
+	AVTP_POLICY_ACTION_SCHEDULE,
+	/* Present right away. */
+	AVTP_POLICY_ACTION_PRESENT_NOW,
+	/* Discard the payload and present concealment data (e.g. silence or
+	 * a repeated frame) in its place, right away.
+	 */
+	AVTP_POLICY_ACTION_CONCEAL,
+	/* Discard the PDU. */
+	AVTP_POLICY_ACTION_DROP,
+
+	/* Count number of actions. Keep this always as the last enum member. */
+	AVTP_POLICY_ACTION_MAX
+};
+
+/* Opaque late/early packet policy. */
+struct avtp_policy;
+
+/* Create late/early packet policy. Actions default to schedule on-time
+ * PDUs, present late PDUs right away and drop early and wrapped PDUs.
+ * @policy: Pointer to variable which the policy should be saved. It must be
+ *          destroyed with avtp_policy_destroy() when no longer needed.
+ * @max_transit_time: Max transit time for the network, in nanoseconds.
+ * @tolerance: How far around the acceptance window PDUs are still
+ *             considered on time, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid, including max_transit_time plus
+ *             twice tolerance not fitting half the timestamp range (2.1 s).
+ *    -ENOMEM: If memory could not be allocated.
+ */
+int avtp_policy_create(struct avtp_policy **policy, uint64_t max_transit_time,
+							uint64_t tolerance);
+
+/* Destroy late/early packet policy.
+ * @policy: Pointer to policy.
+ */
+void avtp_policy_destroy(struct avtp_policy *policy);
+
+/* Set the action taken on a class of PDUs.
+ * @policy: Pointer to policy.
+ * @pdu_class: Class of PDUs.
+ * @action: Action to be taken.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_policy_set_action(struct avtp_policy *policy,
+				enum avtp_policy_class pdu_class,
+				enum avtp_policy_action action);
+
+/* Classify a PDU by its AVTP timestamp and count it.
+ * @policy: Pointer to policy.
+ * @avtp_time: AVTP timestamp of the PDU.
+ * @now: Current time, in nanoseconds, in the presentation time base.
+ * @time: Pointer to variable which the time the PDU should be presented at
+ *        is saved: the presentation time for AVTP_POLICY_ACTION_SCHEDULE and
+ *        AVTP_POLICY_ACTION_DROP, 'now' otherwise.
+ * @action: Pointer to variable which the action to be taken is saved.
+ *
+ * Returns:
+ *    >= 0: Class of the PDU, an enum avtp_policy_class.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_policy_classify(struct avtp_policy *policy, uint32_t avtp_time,
+				uint64_t now, uint64_t *time,
+				enum avtp_policy_action *action);
+
+/* Get the number of PDUs classified in a class.
+ * @policy: Pointer to policy.
+ * @pdu_class: Class of PDUs.
+ * @count: Pointer to variable which the count should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_policy_get_count(const struct avtp_policy *policy,
+				enum avtp_policy_class pdu_class,
+				uint64_t *count);
+
+#ifdef __cplusplus
+}
+#endif
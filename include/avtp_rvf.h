@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* RVF 'pixel_depth' field values. */
+#define AVTP_RVF_PIXEL_DEPTH_USER		0x00
+#define AVTP_RVF_PIXEL_DEPTH_8BIT		0x01
+#define AVTP_RVF_PIXEL_DEPTH_10BIT		0x02
+#define AVTP_RVF_PIXEL_DEPTH_12BIT		0x03
+#define AVTP_RVF_PIXEL_DEPTH_16BIT		0x04
+
+/* RVF 'pixel_format' field values. */
+#define AVTP_RVF_PIXEL_FORMAT_MONO		0x00
+#define AVTP_RVF_PIXEL_FORMAT_444		0x01
+#define AVTP_RVF_PIXEL_FORMAT_422		0x02
+#define AVTP_RVF_PIXEL_FORMAT_420		0x03
+#define AVTP_RVF_PIXEL_FORMAT_BAYER_GRBG	0x04
+#define AVTP_RVF_PIXEL_FORMAT_BAYER_RGGB	0x05
+#define AVTP_RVF_PIXEL_FORMAT_BAYER_BGGR	0x06
+#define AVTP_RVF_PIXEL_FORMAT_BAYER_GBRG	0x07
+
+/* RVF 'colorspace' field values. */
+#define AVTP_RVF_COLORSPACE_USER		0x00
+#define AVTP_RVF_COLORSPACE_YCBCR		0x01
+#define AVTP_RVF_COLORSPACE_SRGB		0x02
+#define AVTP_RVF_COLORSPACE_YCGCO		0x03
+#define AVTP_RVF_COLORSPACE_GRAY		0x04
+#define AVTP_RVF_COLORSPACE_XYZ			0x05
+#define AVTP_RVF_COLORSPACE_YCM			0x06
+#define AVTP_RVF_COLORSPACE_BT_601		0x07
+#define AVTP_RVF_COLORSPACE_BT_709		0x08
+#define AVTP_RVF_COLORSPACE_BT_2020		0x09
+
+/* Length of the RVF raw header, which precedes the video data in the
+ * payload, in bytes.
+ */
+#define AVTP_RVF_RAW_HEADER_LEN			8
+
+enum avtp_rvf_field {
+	AVTP_RVF_FIELD_SV,
+	AVTP_RVF_FIELD_MR,
+	AVTP_RVF_FIELD_TV,
+	AVTP_RVF_FIELD_SEQ_NUM,
+	AVTP_RVF_FIELD_TU,
+	AVTP_RVF_FIELD_STREAM_ID,
+	AVTP_RVF_FIELD_TIMESTAMP,
+	AVTP_RVF_FIELD_STREAM_DATA_LEN,
+	AVTP_RVF_FIELD_ACTIVE_PIXELS,
+	AVTP_RVF_FIELD_TOTAL_LINES,
+	AVTP_RVF_FIELD_AP,
+	AVTP_RVF_FIELD_F,
+	AVTP_RVF_FIELD_EF,
+	AVTP_RVF_FIELD_EVT,
+	AVTP_RVF_FIELD_PD,
+	AVTP_RVF_FIELD_I,
+	AVTP_RVF_FIELD_PIXEL_DEPTH,
+	AVTP_RVF_FIELD_PIXEL_FORMAT,
+	AVTP_RVF_FIELD_FRAME_RATE,
+	AVTP_RVF_FIELD_COLORSPACE,
+	AVTP_RVF_FIELD_NUM_LINES,
+	AVTP_RVF_FIELD_I_SEQ_NUM,
+	AVTP_RVF_FIELD_LINE_NUMBER,
+	AVTP_RVF_FIELD_MAX,
+};
+
+struct avtp_rvf_payload {
+	uint32_t raw_header[2];
+	uint8_t raw_data[0];
+} __attribute__((__packed__));
+
+/* Get value from RVF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be retrieved.
+ * @val: Pointer to variable which the retrieved value should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_rvf_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_rvf_field field, uint64_t *val);
+
+/* Set value from RVF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be set.
+ * @val: Value to be set.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_rvf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_rvf_field field,
+								uint64_t val);
+
+/* Initialize RVF AVTPDU. All AVTPDU fields, including the raw header, are
+ * initialized with zero except 'subtype' (which is set to AVTP_SUBTYPE_RVF)
+ * and 'sv' (which is set to 1).
+ * @pdu: Pointer to PDU struct. It must hold the raw header.
+ *
+ * Return values:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_rvf_pdu_init(struct avtp_stream_pdu *pdu);
+
+/* Planar frame buffer descriptor. 8-bit samples are stored as uint8_t and
+ * deeper ones as uint16_t in host byte order. Planes are Y, Cb and Cr for
+ * 4:2:2 (chroma planes being half as wide as the luma one), and the three
+ * components in wire order (e.g. R, G and B) for 4:4:4.
+ */
+struct avtp_rvf_frame {
+	void *planes[3];
+	/* Distance between lines of each plane, in bytes. */
+	size_t strides[3];
+};
+
+/* RVF packetizer/depacketizer state. Fields are private and should not be
+ * accessed directly, use the avtp_rvf_video_*() APIs instead.
+ *
+ * Lines are sent as pixel groups (pgroups), the smallest run of pixels that
+ * takes a whole number of bytes: 2 pixels in 4 bytes for 8-bit 4:2:2
+ * (Cb Y0 Cr Y1), 2 pixels in 5 bytes for 10-bit 4:2:2 and 1 pixel in 3
+ * bytes for 8-bit 4:4:4. Each PDU carries up to 15 whole lines when they fit
+ * in the MTU; otherwise lines are split in pgroup-aligned fragments, which
+ * share the 'line_number' of their line and are reassembled in order.
+ */
+struct avtp_rvf_video {
+	size_t line_len;
+	size_t frag_len;
+	size_t offset;
+	uint64_t lost;
+	unsigned int width;
+	unsigned int height;
+	unsigned int line;
+	unsigned int lines_per_pdu;
+	uint8_t format;
+	uint8_t seq_num;
+	uint8_t started;
+	uint8_t synced;
+};
+
+/* Initialize RVF packetizer or depacketizer.
+ * @video: Pointer to video struct.
+ * @width: Active pixels per line. Must be a multiple of the pgroup size in
+ *         pixels.
+ * @height: Lines per frame.
+ * @pixel_format: AVTP_RVF_PIXEL_FORMAT_422 or AVTP_RVF_PIXEL_FORMAT_444.
+ * @pixel_depth: AVTP_RVF_PIXEL_DEPTH_8BIT, or AVTP_RVF_PIXEL_DEPTH_10BIT for
+ *               4:2:2.
+ * @max_pdu_size: Maximum AVTPDU size, in bytes, usually the network MTU. It
+ *                must hold at least one pgroup.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid or the format isn't supported.
+ */
+int avtp_rvf_video_init(struct avtp_rvf_video *video, unsigned int width,
+				unsigned int height, uint8_t pixel_format,
+				uint8_t pixel_depth, size_t max_pdu_size);
+
+/* Initialize RVF AVTPDU for the video stream. The PDU is initialized as in
+ * avtp_rvf_pdu_init() and 'active_pixels', 'total_lines', 'pixel_format' and
+ * 'pixel_depth' are set. Stream ID, 'frame_rate' and 'colorspace' are left
+ * to the caller.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_rvf_video_pdu_init(const struct avtp_rvf_video *video,
+						struct avtp_stream_pdu *pdu);
+
+/* Packetize the next lines, or line fragment, of a frame. Pixels are
+ * converted from the planar frame buffer into wire pgroups in the PDU
+ * payload, and 'stream_data_length', 'sequence_num', 'ef', 'num_lines' and
+ * 'line_number' are updated.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_rvf_video_pdu_init().
+ *       It must hold 'max_pdu_size' bytes.
+ * @frame: Frame buffer descriptor.
+ * @pdu_len: Pointer to variable which the PDU length should be saved.
+ * @end_of_frame: Pointer to variable which is set to 1 if this was the last
+ *                PDU of the frame, 0 otherwise. The next call starts a new
+ *                frame.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_rvf_video_pack(struct avtp_rvf_video *video,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_rvf_frame *frame,
+				size_t *pdu_len, int *end_of_frame);
+
+/* Depacketize an RVF AVTPDU into a planar frame buffer. Whole lines are
+ * written wherever they fall; after a 'sequence_num' discontinuity,
+ * fragments are dropped until the next line starts, and their area of the
+ * frame is left untouched.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of the PDU, in bytes.
+ * @frame: Frame buffer descriptor.
+ *
+ * Returns:
+ *    1: The last PDU of the frame ('ef' set) was received.
+ *    0: Success, the frame isn't complete yet, or the PDU was dropped.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the PDU isn't a well-formed RVF AVTPDU of this stream.
+ */
+int avtp_rvf_video_unpack(struct avtp_rvf_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				const struct avtp_rvf_frame *frame);
+
+/* Get the number of PDUs lost, as seen by the depacketizer.
+ * @video: Pointer to video struct.
+ * @lost: Pointer to variable which the number of lost PDUs should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_rvf_video_get_lost(const struct avtp_rvf_video *video,
+							uint64_t *lost);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Presentation scheduler.
+ *
+ * Orders payloads by presentation time, whatever the order they are pushed
+ * in, so that a single timer (e.g. one timerfd) can drive presentation for
+ * all the streams of a process. Payloads are referred to by an opaque
+ * pointer and are not copied.
+ *
+ * The scheduler is a 4-ary min-heap over nodes preallocated at creation:
+ * pushing and popping are O(log n), getting the next deadline is O(1). Nodes
+ * are 16 bytes and the 4 children of a node share a cache line, so each
+ * level walked while sifting touches a single cache line. Payloads with the
+ * same presentation time are popped in the order they were pushed.
+ */
+
+/* Opaque presentation scheduler. */
+struct avtp_sched;
+
+/* Create presentation scheduler.
+ * @sched: Pointer to variable which the scheduler should be saved. It must
+ *         be destroyed with avtp_sched_destroy() when no longer needed.
+ * @max_entries: Maximum number of payloads scheduled at once.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOMEM: If memory could not be allocated.
+ */
+int avtp_sched_create(struct avtp_sched **sched, size_t max_entries);
+
+/* Destroy presentation scheduler. Scheduled payloads are not freed.
+ * @sched: Pointer to scheduler.
+ */
+void avtp_sched_destroy(struct avtp_sched *sched);
+
+/* Schedule a payload.
+ * @sched: Pointer to scheduler.
+ * @time: Presentation time, in nanoseconds.
+ * @data: Payload.
+ *
+ * Returns:
+ *    1: Success, the payload is the next one due. A timer armed by
+ *       avtp_sched_arm_timer() should be re-armed.
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOSPC: If max_entries payloads are already scheduled.
+ */
+int avtp_sched_push(struct avtp_sched *sched, uint64_t time, void *data);
+
+/* Get the next payload due, without removing it.
+ * @sched: Pointer to scheduler.
+ * @time: Pointer to variable which the presentation time should be saved.
+ * @data: Pointer to variable which the payload should be saved. May be NULL.
+ *
+ * Returns:
+ *    1: A payload is scheduled, 'time' and 'data' are set.
+ *    0: No payload is scheduled.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_sched_peek(const struct avtp_sched *sched, uint64_t *time,
+								void **data);
+
+/* Remove the next payload due, if its presentation time is not after 'now'.
+ * Call it until it returns 0 to get every payload due.
+ * @sched: Pointer to scheduler.
+ * @now: Current time, in nanoseconds, in the presentation time base.
+ * @time: Pointer to variable which the presentation time should be saved.
+ *        May be NULL.
+ * @data: Pointer to variable which the payload should be saved.
+ *
+ * Returns:
+ *    1: A payload was removed, 'time' and 'data' are set.
+ *    0: No payload is due.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_sched_pop(struct avtp_sched *sched, uint64_t now, uint64_t *time,
+								void **data);
+
+/* Get the number of payloads scheduled.
+ * @sched: Pointer to scheduler.
+ *
+ * Returns:
+ *    >= 0: Number of payloads scheduled.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_sched_get_count(const struct avtp_sched *sched);
+
+/* Arm a timerfd to expire when the next payload is due, or disarm it if no
+ * payload is scheduled.
+ * @sched: Pointer to scheduler.
+ * @fd: timerfd whose clock is the presentation time base, e.g.
+ *      CLOCK_REALTIME or CLOCK_TAI.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by timerfd_settime().
+ */
+int avtp_sched_arm_timer(const struct avtp_sched *sched, int fd);
+
+#ifdef __cplusplus
+}
+#endif
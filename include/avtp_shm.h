@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shared memory presentation ring.
+ *
+ * A sink publishes records (a payload plus its presentation time) into a
+ * ring in a memfd that any number of reader processes map. The sink never
+ * waits for readers: a reader that falls more than the ring size behind is
+ * overrun and told so. Readers are lock-free and consume records in place,
+ * with no copy and no system call; they validate each record after use with
+ * the ring sequence counters, seqlock style.
+ *
+ * Readers that run out of records may sleep on the doorbell, an eventfd. The
+ * sink rings it once per batch of records, with avtp_shm_sink_flush(), and
+ * only when some reader is actually sleeping, so a busy ring costs no system
+ * call on either side.
+ *
+ * The memfd and eventfd are handed to reader processes with
+ * avtp_shm_send_fds() and avtp_shm_recv_fds() over a Unix socket.
+ */
+
+/* Minimum ring size. */
+#define AVTP_SHM_MIN_SIZE			4096
+
+/* Opaque shared memory sink (the writer side). */
+struct avtp_shm_sink;
+
+/* Opaque shared memory reader. */
+struct avtp_shm_reader;
+
+/* Record read from the ring. 'data' points into the shared ring. 'seq' is
+ * the index of the record in the stream, starting from 0.
+ */
+struct avtp_shm_rec {
+	const void *data;
+	size_t len;
+	uint64_t time;
+	uint64_t seq;
+};
+
+/* Create shared memory sink.
+ * @sink: Pointer to variable which the sink should be saved. It must be
+ *        destroyed with avtp_shm_sink_destroy() when no longer needed.
+ * @name: memfd name, only used for debugging (e.g. /proc/<pid>/fd).
+ * @size: Ring size in bytes, a power of 2 not smaller than
+ *        AVTP_SHM_MIN_SIZE.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOMEM: If memory could not be allocated.
+ *    < 0: Negative errno reported by memfd_create(), eventfd() or mmap().
+ */
+int avtp_shm_sink_create(struct avtp_shm_sink **sink, const char *name,
+								size_t size);
+
+/* Destroy shared memory sink. Readers keep their mapping.
+ * @sink: Pointer to sink.
+ */
+void avtp_shm_sink_destroy(struct avtp_shm_sink *sink);
+
+/* Publish a record. Records no longer than a quarter of the ring size are
+ * accepted. Readers sleeping on the doorbell are not woken up, see
+ * avtp_shm_sink_flush().
+ * @sink: Pointer to sink.
+ * @data: Payload.
+ * @len: Payload length, in bytes.
+ * @time: Presentation time, in nanoseconds.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EMSGSIZE: If the payload is too long.
+ */
+int avtp_shm_sink_write(struct avtp_shm_sink *sink, const void *data,
+						size_t len, uint64_t time);
+
+/* Wake up the readers sleeping on the doorbell, if any, so they consume
+ * the records written so far. Records are visible to readers as soon as
+ * they are written, but sleeping readers only learn about them here, so
+ * call this once per batch of records rather than per record.
+ * @sink: Pointer to sink.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_shm_sink_flush(struct avtp_shm_sink *sink);
+
+/* Send the memfd and doorbell file descriptors of a sink over a connected
+ * Unix socket.
+ * @sink: Pointer to sink.
+ * @sock: Unix socket file descriptor.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by sendmsg().
+ */
+int avtp_shm_send_fds(const struct avtp_shm_sink *sink, int sock);
+
+/* Receive the file descriptors sent by avtp_shm_send_fds().
+ * @sock: Unix socket file descriptor.
+ * @mem_fd: Pointer to variable which the memfd should be saved.
+ * @bell_fd: Pointer to variable which the doorbell eventfd should be saved.
+ *
+ * Returns:
+ *    0: Success. Both file descriptors should be closed with close() once
+ *       the reader is created.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the message doesn't carry the file descriptors.
+ *    < 0: Negative errno reported by recvmsg().
+ */
+int avtp_shm_recv_fds(int sock, int *mem_fd, int *bell_fd);
+
+/* Create shared memory reader. It starts at the most recent record.
+ * @reader: Pointer to variable which the reader should be saved. It must be
+ *          destroyed with avtp_shm_reader_destroy() when no longer needed.
+ * @mem_fd: Sink memfd.
+ * @bell_fd: Sink doorbell eventfd.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If 'mem_fd' doesn't hold a ring.
+ *    -ENOMEM: If memory could not be allocated.
+ *    < 0: Negative errno reported by fstat(), dup() or mmap().
+ */
+int avtp_shm_reader_create(struct avtp_shm_reader **reader, int mem_fd,
+								int bell_fd);
+
+/* Destroy shared memory reader.
+ * @reader: Pointer to reader.
+ */
+void avtp_shm_reader_destroy(struct avtp_shm_reader *reader);
+
+/* Get the next record, in place. The record must be released with
+ * avtp_shm_reader_release() before the next call.
+ * @reader: Pointer to reader.
+ * @rec: Pointer to record to be filled.
+ *
+ * Returns:
+ *    1: Record available.
+ *    0: No record available.
+ *    -EINVAL: If any argument is invalid.
+ *    -EOVERFLOW: If the reader was overrun by the sink. It skips to the most
+ *                recent record; the records lost show up as a gap in
+ *                'seq' of the next record.
+ */
+int avtp_shm_reader_next(struct avtp_shm_reader *reader,
+						struct avtp_shm_rec *rec);
+
+/* Release the record returned by avtp_shm_reader_next(), checking it was
+ * not overwritten while in use.
+ * @reader: Pointer to reader.
+ *
+ * Returns:
+ *    0: Success, the record was intact.
+ *    -EINVAL: If any argument is invalid.
+ *    -EOVERFLOW: If the sink overwrote the record while in use. Whatever
+ *                was read from it must be discarded.
+ */
+int avtp_shm_reader_release(struct avtp_shm_reader *reader);
+
+/* Sleep on the doorbell until a record is available.
+ * @reader: Pointer to reader.
+ * @timeout: Timeout in milliseconds, -1 to wait forever.
+ *
+ * Returns:
+ *    0: A record may be available.
+ *    -EINVAL: If any argument is invalid.
+ *    -ETIMEDOUT: If no record was published before the timeout.
+ *    < 0: Negative errno reported by poll().
+ */
+int avtp_shm_reader_wait(struct avtp_shm_reader *reader, int timeout);
+
+#ifdef __cplusplus
+}
+#endif
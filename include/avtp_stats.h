@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-stream statistics registry.
+ *
+ * The registry lives in a file, typically in /dev/shm, that the process
+ * owning it maps read-write and monitoring tools such as avtp-stat map
+ * read-only, so counters can be watched live without touching the data path.
+ *
+ * Each (thread, stream) pair has its own cache line aligned counters block,
+ * written by that thread only: updating counters is a few plain, non-atomic
+ * increments, with no sharing between threads. Readers add up the blocks of
+ * all threads. As counters are updated without synchronization, a reader may
+ * see a snapshot where related counters (e.g. 'packets' and 'bytes') are a
+ * few updates apart.
+ */
+
+/* Maximum length of a stream name, including the terminating null byte. */
+#define AVTP_STATS_NAME_LEN			32
+
+/* Reasons a received PDU failed validation, i.e. the field it was rejected
+ * for.
+ */
+enum avtp_stats_invalid {
+	AVTP_STATS_INVALID_SUBTYPE,
+	AVTP_STATS_INVALID_VERSION,
+	AVTP_STATS_INVALID_STREAM_ID,
+	AVTP_STATS_INVALID_TV,
+	AVTP_STATS_INVALID_SP,
+	AVTP_STATS_INVALID_FORMAT,
+	AVTP_STATS_INVALID_RATE,
+	AVTP_STATS_INVALID_CHANNELS,
+	AVTP_STATS_INVALID_DEPTH,
+	AVTP_STATS_INVALID_DATA_LEN,
+	AVTP_STATS_INVALID_OTHER,
+	AVTP_STATS_INVALID_MAX
+};
+
+/* Counters of a stream. The presentation margin is the time between the
+ * reception of a PDU and its presentation time, in ns, negative if the PDU
+ * arrived late.
+ */
+struct avtp_stats_counters {
+	uint64_t packets;
+	uint64_t bytes;
+	/* Number of PDUs missing according to sequence numbers. */
+	uint64_t seq_gaps;
+	/* PDUs dropped for arriving too late or too early for presentation. */
+	uint64_t late_drops;
+	uint64_t early_drops;
+	uint64_t invalid[AVTP_STATS_INVALID_MAX];
+
+	int64_t margin_min;
+	int64_t margin_max;
+	int64_t margin_sum;
+	uint64_t margin_count;
+} __attribute__((aligned(64)));
+
+/* Opaque statistics registry. */
+struct avtp_stats;
+
+/* Create statistics registry.
+ * @stats: Pointer to variable which the registry should be saved. It must
+ *         be destroyed with avtp_stats_destroy() when no longer needed.
+ * @path: Path of the file backing the registry, e.g.
+ *        /dev/shm/<application>. It is replaced if it exists.
+ * @max_streams: Maximum number of streams.
+ * @max_threads: Number of threads updating counters.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOMEM: If memory could not be allocated.
+ *    < 0: Negative errno reported by open(), ftruncate() or mmap().
+ */
+int avtp_stats_create(struct avtp_stats **stats, const char *path,
+			unsigned int max_streams, unsigned int max_threads);
+
+/* Open an existing statistics registry, read-only.
+ * @stats: Pointer to variable which the registry should be saved. It must
+ *         be destroyed with avtp_stats_destroy() when no longer needed.
+ * @path: Path of the file backing the registry.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the file doesn't hold a registry.
+ *    -ENOMEM: If memory could not be allocated.
+ *    < 0: Negative errno reported by open(), fstat() or mmap().
+ */
+int avtp_stats_open(struct avtp_stats **stats, const char *path);
+
+/* Destroy statistics registry. The backing file is removed if the registry
+ * was created, rather than opened, by the caller.
+ * @stats: Pointer to registry.
+ */
+void avtp_stats_destroy(struct avtp_stats *stats);
+
+/* Register a stream.
+ * @stats: Pointer to registry.
+ * @stream_id: Stream ID.
+ * @name: Stream name, truncated to AVTP_STATS_NAME_LEN - 1 characters.
+ * @index: Pointer to variable which the stream index should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EPERM: If the registry was opened read-only.
+ *    -ENOSPC: If 'max_streams' streams are registered already.
+ */
+int avtp_stats_add_stream(struct avtp_stats *stats, uint64_t stream_id,
+				const char *name, unsigned int *index);
+
+/* Get the counters block a thread updates for a stream. Blocks are private
+ * to each thread, so counters may be updated directly, e.g.
+ * 'counters->packets++', or with the helpers below.
+ * @stats: Pointer to registry.
+ * @thread: Thread index, lower than 'max_threads'.
+ * @stream: Stream index, as returned by avtp_stats_add_stream().
+ *
+ * Returns:
+ *    Pointer to counters, or NULL if any argument is invalid or the registry
+ *    was opened read-only.
+ */
+struct avtp_stats_counters *avtp_stats_get_counters(struct avtp_stats *stats,
+				unsigned int thread, unsigned int stream);
+
+/* Get the number of streams registered.
+ * @stats: Pointer to registry.
+ * @count: Pointer to variable which the count should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_stats_get_stream_count(const struct avtp_stats *stats,
+							unsigned int *count);
+
+/* Read the counters of a stream, added up across threads.
+ * @stats: Pointer to registry.
+ * @stream: Stream index.
+ * @stream_id: Pointer to variable which the stream ID should be saved.
+ * @name: Buffer of AVTP_STATS_NAME_LEN bytes the name should be saved to.
+ * @counters: Pointer to struct which the counters should be saved. If no
+ *            margin was recorded, 'margin_min' and 'margin_max' are 0.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOENT: If no stream has index 'stream'.
+ */
+int avtp_stats_read(const struct avtp_stats *stats, unsigned int stream,
+				uint64_t *stream_id, char *name,
+				struct avtp_stats_counters *counters);
+
+/* Count a PDU received.
+ * @counters: Pointer to counters.
+ * @bytes: PDU length, in bytes.
+ */
+static inline void avtp_stats_packet(struct avtp_stats_counters *counters,
+								size_t bytes)
+{
+	counters->packets++;
+	counters->bytes += bytes;
+}
+
+/* Record the presentation margin of a PDU.
+ * @counters: Pointer to counters.
+ * @margin: Presentation time minus reception time, in ns.
+ */
+static inline void avtp_stats_margin(struct avtp_stats_counters *counters,
+								int64_t margin)
+{
+	if (margin < counters->margin_min)
+		counters->margin_min = margin;
+	if (margin > counters->margin_max)
+		counters->margin_max = margin;
+
+	counters->margin_sum += margin;
+	counters->margin_count++;
+}
+
+#ifdef __cplusplus
+}
+#endif
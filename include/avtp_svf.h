@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum avtp_svf_field {
+	AVTP_SVF_FIELD_SV,
+	AVTP_SVF_FIELD_MR,
+	AVTP_SVF_FIELD_TV,
+	AVTP_SVF_FIELD_SEQ_NUM,
+	AVTP_SVF_FIELD_TU,
+	AVTP_SVF_FIELD_STREAM_ID,
+	AVTP_SVF_FIELD_TIMESTAMP,
+	AVTP_SVF_FIELD_STREAM_DATA_LEN,
+	AVTP_SVF_FIELD_LINE_NUMBER,
+	AVTP_SVF_FIELD_LINE_OFFSET,
+	AVTP_SVF_FIELD_F,
+	AVTP_SVF_FIELD_EF,
+	AVTP_SVF_FIELD_EVT,
+	AVTP_SVF_FIELD_MAX,
+};
+
+/* Get value from SVF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be retrieved.
+ * @val: Pointer to variable which the retrieved value should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_svf_field field, uint64_t *val);
+
+/* Set value from SVF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be set.
+ * @val: Value to be set.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_svf_field field,
+								uint64_t val);
+
+/* Initialize SVF AVTPDU. All AVTPDU fields are initialized with zero except
+ * 'subtype' (which is set to AVTP_SUBTYPE_SVF) and 'sv' (which is set to 1).
+ * @pdu: Pointer to PDU struct.
+ *
+ * Return values:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_pdu_init(struct avtp_stream_pdu *pdu);
+
+/* SDI frame buffer descriptor. Lines hold the SDI data as sent on the wire
+ * (e.g. packed 10-bit words), 'line_len' bytes each.
+ */
+struct avtp_svf_frame {
+	uint8_t *data;
+	/* Distance between lines, in bytes. */
+	size_t stride;
+};
+
+/* Ring of preallocated frame buffers the depacketizer reassembles frames
+ * into. Fields are private and should not be accessed directly, use the
+ * avtp_svf_ring_*() APIs instead.
+ */
+struct avtp_svf_ring {
+	const struct avtp_svf_frame *frames;
+	unsigned int size;
+	unsigned int head;
+	unsigned int tail;
+	uint64_t dropped;
+};
+
+/* SVF packetizer/depacketizer state. Fields are private and should not be
+ * accessed directly, use the avtp_svf_video_*() APIs instead.
+ *
+ * A frame is sent as the concatenation of its lines, so PDUs are filled up
+ * to the MTU regardless of line boundaries and several short lines share a
+ * PDU. Each PDU carries the 'line_number' and 'line_offset' (in bytes) of
+ * its first byte, and the last PDU of a frame has 'ef' set.
+ */
+struct avtp_svf_video {
+	size_t line_len;
+	size_t max_payload;
+	uint64_t frame_len;
+	uint64_t pos;
+	uint64_t lost;
+	unsigned int height;
+	uint8_t seq_num;
+	uint8_t started;
+	uint8_t synced;
+};
+
+/* Initialize SVF packetizer or depacketizer.
+ * @video: Pointer to video struct.
+ * @line_len: Length of an SDI line, in bytes.
+ * @height: Number of lines per frame.
+ * @max_pdu_size: Maximum AVTPDU size, in bytes, usually the network MTU.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_video_init(struct avtp_svf_video *video, size_t line_len,
+				unsigned int height, size_t max_pdu_size);
+
+/* Initialize SVF AVTPDU for the video stream, as avtp_svf_pdu_init() does.
+ * Stream ID is left to the caller.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_video_pdu_init(const struct avtp_svf_video *video,
+						struct avtp_stream_pdu *pdu);
+
+/* Packetize the next part of a frame without copying it. The PDU header is
+ * updated ('stream_data_length', 'sequence_num', 'line_number',
+ * 'line_offset', 'ef') and 'iov' is filled with a gather list for sendmsg()
+ * or avtp_tx_send(): the first entry covers the AVTPDU header in 'pdu', the
+ * following ones point into the frame buffer, one per (part of a) line.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_svf_video_pdu_init().
+ * @frame: Frame buffer descriptor.
+ * @iov: Gather list to be filled.
+ * @iovcnt: Number of entries in 'iov'. PDUs span at most
+ *          max_payload / line_len + 2 lines, so that many plus one entries
+ *          always suffice; fewer entries make for shorter PDUs.
+ * @end_of_frame: Pointer to variable which is set to 1 if this was the last
+ *                PDU of the frame, 0 otherwise. The next call starts a new
+ *                frame.
+ *
+ * Returns:
+ *    > 0: Number of 'iov' entries used.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_video_pack(struct avtp_svf_video *video,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_svf_frame *frame,
+				struct iovec *iov, unsigned int iovcnt,
+				int *end_of_frame);
+
+/* Initialize frame ring.
+ * @ring: Pointer to ring struct.
+ * @frames: Array of 'size' frame buffer descriptors. Each buffer must hold a
+ *          whole frame. The array must outlive the ring.
+ * @size: Number of frames, at least 2. One frame is always being filled, so
+ *        up to size - 1 complete frames are kept.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_ring_init(struct avtp_svf_ring *ring,
+			const struct avtp_svf_frame *frames, unsigned int size);
+
+/* Get the oldest complete frame. It stays valid until avtp_svf_ring_pop().
+ * @ring: Pointer to ring struct.
+ * @frame: Pointer to variable which the frame descriptor should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If there is no complete frame.
+ */
+int avtp_svf_ring_peek(const struct avtp_svf_ring *ring,
+				const struct avtp_svf_frame **frame);
+
+/* Release the oldest complete frame, so its buffer can be reused.
+ * @ring: Pointer to ring struct.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If there is no complete frame.
+ */
+int avtp_svf_ring_pop(struct avtp_svf_ring *ring);
+
+/* Get the number of complete frames dropped because the ring was full. The
+ * newly completed frame is dropped, so the frames already in the ring,
+ * including one held through avtp_svf_ring_peek(), are never overwritten.
+ * @ring: Pointer to ring struct.
+ * @dropped: Pointer to variable which the number of frames should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_ring_get_dropped(const struct avtp_svf_ring *ring,
+							uint64_t *dropped);
+
+/* Depacketize an SVF AVTPDU into the frame being filled in the ring. Data is
+ * copied straight to its line. PDUs are dropped until the start of a frame
+ * is seen; afterwards 'sequence_num' discontinuities are accounted as lost
+ * PDUs, whose area of the frame is left untouched. When the last PDU of a
+ * frame arrives, the frame is completed and the next one starts, unless the
+ * ring is full: the frame is then dropped and its buffer refilled.
+ * @video: Pointer to video struct.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of the PDU, in bytes.
+ * @ring: Pointer to frame ring.
+ *
+ * Returns:
+ *    1: A frame was completed and added to the ring.
+ *    0: Success, the frame isn't complete yet, or the PDU or frame was
+ *       dropped.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the PDU isn't a well-formed SVF AVTPDU of this stream.
+ */
+int avtp_svf_video_unpack(struct avtp_svf_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				struct avtp_svf_ring *ring);
+
+/* Get the number of PDUs lost, as seen by the depacketizer.
+ * @video: Pointer to video struct.
+ * @lost: Pointer to variable which the number of lost PDUs should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_svf_video_get_lost(const struct avtp_svf_video *video,
+							uint64_t *lost);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avtp_acf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum 'stream_data_length' field value, in bytes. */
+#define AVTP_TSCF_MAX_DATA_LEN			65535
+
+enum avtp_tscf_field {
+	AVTP_TSCF_FIELD_SV,
+	AVTP_TSCF_FIELD_MR,
+	AVTP_TSCF_FIELD_TV,
+	AVTP_TSCF_FIELD_SEQ_NUM,
+	AVTP_TSCF_FIELD_TU,
+	AVTP_TSCF_FIELD_STREAM_ID,
+	AVTP_TSCF_FIELD_TIMESTAMP,
+	AVTP_TSCF_FIELD_STREAM_DATA_LEN,
+	AVTP_TSCF_FIELD_MAX,
+};
+
+/* Get value from TSCF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be retrieved.
+ * @val: Pointer to variable which the retrieved value should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tscf_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_tscf_field field, uint64_t *val);
+
+/* Set value from TSCF AVTPDU field.
+ * @pdu: Pointer to PDU struct.
+ * @field: PDU field to be set.
+ * @val: Value to be set.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tscf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_tscf_field field,
+								uint64_t val);
+
+/* Initialize TSCF AVTPDU. All AVTPDU fields are initialized with zero except
+ * 'subtype' (which is set to AVTP_SUBTYPE_TSCF) and 'sv' (which is set to 1).
+ * @pdu: Pointer to PDU struct.
+ *
+ * Return values:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tscf_pdu_init(struct avtp_stream_pdu *pdu);
+
+/* TSCF packetizer state. Fields are private and should not be accessed
+ * directly, use the avtp_tscf_pktzr_*() APIs instead.
+ *
+ * The packetizer batches ACF messages whose presentation times fall within
+ * the same window into one AVTPDU. The window starts at the presentation
+ * time of the first message, which is also the AVTPDU 'avtp_timestamp'.
+ * ACF CAN messages carry their own presentation time in 'message_timestamp'
+ * so listeners can still schedule each one individually.
+ */
+struct avtp_tscf_pktzr {
+	uint64_t start;
+	uint64_t window;
+	size_t max_data_len;
+	size_t data_len;
+	unsigned int count;
+	uint8_t seq_num;
+};
+
+/* Initialize TSCF packetizer.
+ * @pktzr: Pointer to packetizer struct.
+ * @max_pdu_size: Maximum AVTPDU size, in bytes, usually the network MTU.
+ * @window: Presentation window length, in nanoseconds. Must not be zero.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tscf_pktzr_init(struct avtp_tscf_pktzr *pktzr, size_t max_pdu_size,
+							uint64_t window);
+
+/* Pack CAN frames into the AVTPDU. Frames are appended in order until one
+ * doesn't fit or is presented outside the window. The presentation time of
+ * each frame is its 'timestamp' field. For AVTP_ACF_TYPE_CAN the 'mtv' flag
+ * is set on the wire; AVTP_ACF_TYPE_CAN_BRIEF frames have no timestamp of
+ * their own and are presented at the start of the window.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_tscf_pdu_init(). It
+ *       must be 'max_pdu_size' long.
+ * @type: AVTP_ACF_TYPE_CAN or AVTP_ACF_TYPE_CAN_BRIEF.
+ * @msgs: CAN frames.
+ * @count: Number of entries in 'msgs'.
+ *
+ * Returns:
+ *    >= 0: Number of frames packed. Less than 'count' means the AVTPDU
+ *          should be flushed with avtp_tscf_pktzr_flush(), or the next
+ *          frame is invalid.
+ *    -EINVAL: If any argument is invalid, or the first frame is invalid.
+ */
+int avtp_tscf_pktzr_pack_can(struct avtp_tscf_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, uint8_t type,
+				const struct avtp_acf_can *msgs,
+				unsigned int count);
+
+/* Pack an already encoded ACF message, e.g. LIN or FlexRay, into the
+ * AVTPDU.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct, initialized with avtp_tscf_pdu_init(). It
+ *       must be 'max_pdu_size' long.
+ * @msg: ACF message. Its length must be a multiple of 4 bytes.
+ * @time: Presentation time of the message, in nanoseconds.
+ *
+ * Returns:
+ *    1: Message packed.
+ *    0: Message doesn't fit or is outside the window; the AVTPDU should be
+ *       flushed first.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tscf_pktzr_pack_msg(struct avtp_tscf_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_acf_msg *msg, uint64_t time);
+
+/* Get the presentation time of the AVTPDU being filled, i.e. the start of
+ * its window. It should be transmitted no later than this time minus the
+ * maximum transit time.
+ * @pktzr: Pointer to packetizer struct.
+ * @time: Pointer to variable which the time, in nanoseconds, should be
+ *        saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If the AVTPDU is empty.
+ */
+int avtp_tscf_pktzr_get_time(const struct avtp_tscf_pktzr *pktzr,
+							uint64_t *time);
+
+/* Finish the AVTPDU. 'tv', 'avtp_timestamp', 'stream_data_length' and
+ * 'sequence_num' fields are set, and the packetizer starts over so the same
+ * AVTPDU can be filled again once it has been transmitted.
+ * @pktzr: Pointer to packetizer struct.
+ * @pdu: Pointer to PDU struct.
+ * @pdu_len: Pointer to variable which the resulting AVTPDU size should be
+ *           saved.
+ *
+ * Returns:
+ *    > 0: Number of ACF messages in the AVTPDU.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENODATA: If the AVTPDU is empty.
+ */
+int avtp_tscf_pktzr_flush(struct avtp_tscf_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, size_t *pdu_len);
+
+/* TSCF message iterator. Fields are private and should not be accessed
+ * directly, use the avtp_tscf_iter_*() APIs instead.
+ */
+struct avtp_tscf_iter {
+	struct avtp_acf_iter acf;
+	uint64_t time;
+};
+
+/* Initialize message iterator over a received TSCF AVTPDU. Messages are not
+ * copied, see avtp_acf_iter_next().
+ * @iter: Pointer to iterator struct.
+ * @pdu: Pointer to PDU struct.
+ * @len: Length of received data, in bytes.
+ * @now: Current time, in nanoseconds. The 32-bit 'avtp_timestamp' is
+ *       expanded to the 64-bit time closest to it.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If 'pdu' is not a TSCF AVTPDU or is truncated.
+ */
+int avtp_tscf_iter_init(struct avtp_tscf_iter *iter,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				uint64_t now);
+
+/* Get next message and the time it should be presented at. This is the
+ * 'message_timestamp' of ACF CAN messages which have 'mtv' set, or the
+ * AVTPDU presentation time otherwise ('now' if 'tv' is not set).
+ * @iter: Pointer to iterator struct.
+ * @msg: Pointer to struct which the message should be saved.
+ * @time: Pointer to variable which the presentation time, in nanoseconds,
+ *        should be saved.
+ *
+ * Returns:
+ *    1: A message was saved in 'msg'.
+ *    0: No messages left.
+ *    -EINVAL: If any argument is invalid.
+ *    -EBADMSG: If the message is malformed. Iteration stops there.
+ */
+int avtp_tscf_iter_next(struct avtp_tscf_iter *iter, struct avtp_acf_msg *msg,
+							uint64_t *time);
+
+#ifdef __cplusplus
+}
+#endif
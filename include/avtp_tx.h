@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <linux/if_packet.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of payload iovecs per PDU. */
+#define AVTP_TX_MAX_IOV			16
+
+/* Maximum number of zero-copy sends in flight, see avtp_tx_zc_send(). */
+#define AVTP_TX_ZC_WINDOW		256
+
+/* PDU to be transmitted. The PDU is sent as 'header' followed by the 'iov'
+ * buffers, in order, without being copied in user space. The buffers are
+ * owned by the caller.
+ */
+struct avtp_tx_pdu {
+	const void *header;
+	size_t header_len;
+	const struct iovec *iov;
+	int iovcnt;
+};
+
+/* Transmit a PDU made of a header buffer and a list of payload buffers,
+ * e.g. an AVTP header prepared with avtp_*_pdu_set() and the media data
+ * still in application memory.
+ * @fd: Socket file descriptor.
+ * @addr: Destination address, or NULL if the socket is connected.
+ * @header: PDU header.
+ * @header_len: Length of the PDU header, in bytes.
+ * @iov: Payload buffers. May be NULL if 'iovcnt' is 0.
+ * @iovcnt: Number of payload buffers, up to AVTP_TX_MAX_IOV.
+ * @flags: sendmsg() flags.
+ *
+ * Returns:
+ *    >= 0: Number of bytes sent.
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by sendmsg().
+ */
+ssize_t avtp_tx_send(int fd, const struct sockaddr_ll *addr,
+			const void *header, size_t header_len,
+			const struct iovec *iov, int iovcnt, int flags);
+
+/* Transmit a burst of PDUs with as few system calls as possible (one
+ * sendmmsg() per 32 PDUs).
+ * @fd: Socket file descriptor.
+ * @addr: Destination address, or NULL if the socket is connected.
+ * @pdus: PDUs to be sent.
+ * @count: Number of PDUs.
+ * @flags: sendmmsg() flags.
+ *
+ * Returns:
+ *    >= 0: Number of PDUs sent. If less than 'count', the following PDU
+ *          could not be sent (e.g. the socket buffer is full).
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by sendmmsg() for the first PDU.
+ */
+int avtp_tx_send_batch(int fd, const struct sockaddr_ll *addr,
+			const struct avtp_tx_pdu *pdus, unsigned int count,
+			int flags);
+
+/* Zero-copy transmission state. Fields are private and should not be
+ * accessed directly, use the avtp_tx_zc_*() APIs instead.
+ */
+struct avtp_tx_zc {
+	int fd;
+	uint32_t next;
+	uint32_t released;
+	uint64_t done[AVTP_TX_ZC_WINDOW / 64];
+	uint64_t completions;
+	uint64_t copied;
+};
+
+/* Zero-copy transmission statistics. */
+struct avtp_tx_zc_stats {
+	/* Number of sends released by the kernel. */
+	uint64_t completions;
+	/* Number of those sends whose payload the kernel copied anyway (e.g.
+	 * the device does not support scatter/gather). If most sends are
+	 * copied, zero-copy only adds overhead and should be disabled.
+	 */
+	uint64_t copied;
+};
+
+/* Enable zero-copy transmission (SO_ZEROCOPY) on a socket. With zero-copy,
+ * the kernel transmits payload buffers in place, so they must not be
+ * modified or freed until the kernel releases them; see
+ * avtp_tx_zc_reap() and avtp_tx_zc_is_released(). It pays off for large
+ * payloads such as CVF or raw video streams.
+ *
+ * The kernel supports zero-copy on TCP and UDP sockets only, so AVTP over
+ * UDP (IEEE 1722-2016 Annex J) is required; on AF_PACKET sockets this
+ * fails with -EOPNOTSUPP and avtp_tx_send() should be used instead.
+ * @zc: Pointer to zero-copy state struct.
+ * @fd: Connected socket file descriptor.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by setsockopt() (e.g. -EOPNOTSUPP).
+ */
+int avtp_tx_zc_init(struct avtp_tx_zc *zc, int fd);
+
+/* Transmit a PDU with zero-copy. Same as avtp_tx_send() except that the
+ * header and payload buffers are owned by the kernel until the returned
+ * send id is released.
+ * @zc: Pointer to zero-copy state struct.
+ * @header: PDU header.
+ * @header_len: Length of the PDU header, in bytes.
+ * @iov: Payload buffers. May be NULL if 'iovcnt' is 0.
+ * @iovcnt: Number of payload buffers, up to AVTP_TX_MAX_IOV.
+ * @flags: sendmsg() flags. MSG_ZEROCOPY is added.
+ * @id: Pointer to variable which the send id should be saved.
+ *
+ * Returns:
+ *    >= 0: Number of bytes sent.
+ *    -EINVAL: If any argument is invalid.
+ *    -ENOBUFS: If AVTP_TX_ZC_WINDOW sends are in flight. Call
+ *              avtp_tx_zc_reap() and try again.
+ *    < 0: Negative errno reported by sendmsg().
+ */
+ssize_t avtp_tx_zc_send(struct avtp_tx_zc *zc, const void *header,
+				size_t header_len, const struct iovec *iov,
+				int iovcnt, int flags, uint32_t *id);
+
+/* Process zero-copy completion notifications from the socket error queue.
+ * It does not block. Call it when poll() reports POLLERR on the socket, or
+ * periodically.
+ * @zc: Pointer to zero-copy state struct.
+ *
+ * Returns:
+ *    >= 0: Number of notifications processed.
+ *    -EINVAL: If any argument is invalid.
+ *    < 0: Negative errno reported by recvmsg().
+ */
+int avtp_tx_zc_reap(struct avtp_tx_zc *zc);
+
+/* Check whether the buffers of a zero-copy send were released by the
+ * kernel, so they can be reused.
+ * @zc: Pointer to zero-copy state struct.
+ * @id: Send id, as returned by avtp_tx_zc_send().
+ *
+ * Returns:
+ *    1: Buffers released.
+ *    0: Buffers still in use by the kernel.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tx_zc_is_released(const struct avtp_tx_zc *zc, uint32_t id);
+
+/* Get the number of zero-copy sends whose buffers were not released yet.
+ * @zc: Pointer to zero-copy state struct.
+ * @pending: Pointer to variable which the number of sends should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tx_zc_get_pending(const struct avtp_tx_zc *zc, uint32_t *pending);
+
+/* Get zero-copy statistics.
+ * @zc: Pointer to zero-copy state struct.
+ * @stats: Pointer to struct which the statistics should be saved.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int avtp_tx_zc_get_stats(const struct avtp_tx_zc *zc,
+				struct avtp_tx_zc_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* C++20 typed PDU views.
+ *
+ * A view wraps a std::span over a received (or to be transmitted) buffer. It
+ * validates the buffer once, in init(): the buffer must be long enough for
+ * the header, the subtype must match, and the data length field
+ * ('stream_data_len' or 'crf_data_len') must fit in the buffer and agree with
+ * the payload layout. Once init() succeeds, header fields and payload spans
+ * are accessed without any further checks, through the compile-time field
+ * descriptors from avtp.hpp.
+ *
+ * The view is trimmed to the header plus data length, so trailing bytes (e.g.
+ * Ethernet padding) are never part of pdu() or payload(). The data length
+ * field itself can't be set through a view since that would break the
+ * invariant; build a new view instead.
+ *
+ * Views over std::byte may modify the PDU, views over const std::byte are
+ * read-only (e.g. ConstAafView). Members other than init() must only be used
+ * after init() succeeds.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include "avtp.h"
+#include "avtp.hpp"
+#include "avtp_aaf.h"
+#include "avtp_crf.h"
+#include "avtp_cvf.h"
+#include "avtp_ieciidc.h"
+
+namespace avtp {
+
+namespace detail {
+
+/* Common part of all views.
+ * @Byte: std::byte or const std::byte.
+ * @DataOffset: Offset of the data covered by the data length field.
+ * @HeaderLen: Number of bytes accessible with get() and set().
+ * @LenField: Data length field descriptor.
+ */
+template <class Byte, std::size_t DataOffset, std::size_t HeaderLen,
+								class LenField>
+class view {
+public:
+	static constexpr std::size_t header_len = HeaderLen;
+
+	/* Get value from PDU header field.
+	 * @F: Field descriptor, e.g. avtp::aaf::nsr.
+	 */
+	template <class F>
+	constexpr typename F::value_type get() const noexcept
+	{
+		static_assert(F::end <= HeaderLen,
+					"field is not part of this header");
+
+		return avtp::get<F>(pdu_.data());
+	}
+
+	/* Set value to PDU header field.
+	 * @F: Field descriptor, e.g. avtp::aaf::nsr.
+	 * @val: Value to be set.
+	 */
+	template <class F>
+	constexpr void set(typename F::value_type val) const noexcept
+		requires (!std::is_const_v<Byte>)
+	{
+		static_assert(F::end <= HeaderLen,
+					"field is not part of this header");
+		static_assert(F::offset != LenField::offset ||
+				(F::mask & LenField::mask) == 0,
+				"data length can't be changed through a view");
+
+		avtp::set<F>(pdu_.data(), val);
+	}
+
+	/* Whole PDU, header plus data length bytes. */
+	constexpr std::span<Byte> pdu() const noexcept
+	{
+		return pdu_;
+	}
+
+	/* Data length bytes following the header. */
+	constexpr std::span<Byte> payload() const noexcept
+	{
+		return pdu_.subspan(DataOffset);
+	}
+
+protected:
+	constexpr int init_view(std::span<Byte> buf, std::uint8_t subtype)
+									noexcept
+	{
+		std::size_t len;
+
+		if (buf.size() < HeaderLen)
+			return -EBADMSG;
+
+		if (avtp::get<common::subtype>(buf.data()) != subtype)
+			return -EBADMSG;
+
+		len = avtp::get<LenField>(buf.data());
+		if (len < HeaderLen - DataOffset ||
+					len > buf.size() - DataOffset)
+			return -EBADMSG;
+
+		pdu_ = buf.first(DataOffset + len);
+		return 0;
+	}
+
+	std::span<Byte> pdu_;
+};
+
+constexpr std::size_t stream_header_len = 24;
+constexpr std::size_t crf_header_len = 20;
+
+} // namespace detail
+
+/* AAF PCM view. Supported formats are AVTP_AAF_FORMAT_INT_16BIT,
+ * AVTP_AAF_FORMAT_INT_24BIT, AVTP_AAF_FORMAT_INT_32BIT,
+ * AVTP_AAF_FORMAT_FLOAT_32BIT and AVTP_AAF_FORMAT_AES3_32BIT. The payload
+ * holds frames() interleaved frames of 'channels_per_frame' samples each, in
+ * network order.
+ */
+template <class Byte>
+class BasicAafView : public detail::view<Byte, detail::stream_header_len,
+		detail::stream_header_len, aaf::stream_data_len> {
+public:
+	/* Initialize view.
+	 * @buf: PDU buffer.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    -EBADMSG: If the buffer is too short, the subtype is not AAF,
+	 *              'stream_data_len' doesn't fit in the buffer or it isn't
+	 *              a multiple of the frame size.
+	 *    -ENOTSUP: If the format is not a supported PCM format.
+	 */
+	constexpr int init(std::span<Byte> buf) noexcept
+	{
+		int res;
+
+		res = this->init_view(buf, AVTP_SUBTYPE_AAF);
+		if (res < 0)
+			return res;
+
+		switch (this->template get<aaf::format>()) {
+		case AVTP_AAF_FORMAT_INT_16BIT:
+			sample_size_ = 2;
+			break;
+		case AVTP_AAF_FORMAT_INT_24BIT:
+			sample_size_ = 3;
+			break;
+		case AVTP_AAF_FORMAT_INT_32BIT:
+		case AVTP_AAF_FORMAT_FLOAT_32BIT:
+		case AVTP_AAF_FORMAT_AES3_32BIT:
+			sample_size_ = 4;
+			break;
+		default:
+			return -ENOTSUP;
+		}
+
+		frame_size_ = sample_size_ *
+				this->template get<aaf::chan_per_frame>();
+		if (frame_size_ == 0 || this->payload().size() % frame_size_)
+			return -EBADMSG;
+
+		return 0;
+	}
+
+	/* Size of a sample, in bytes. */
+	constexpr std::size_t sample_size() const noexcept
+	{
+		return sample_size_;
+	}
+
+	/* Size of a frame (one sample per channel), in bytes. */
+	constexpr std::size_t frame_size() const noexcept
+	{
+		return frame_size_;
+	}
+
+	/* Number of frames in the payload. */
+	constexpr std::size_t frames() const noexcept
+	{
+		return this->payload().size() / frame_size_;
+	}
+
+	/* Frame 'i' from the payload. 'i' must be less than frames(). */
+	constexpr std::span<Byte> frame(std::size_t i) const noexcept
+	{
+		return this->payload().subspan(i * frame_size_, frame_size_);
+	}
+
+private:
+	std::size_t sample_size_ = 0;
+	std::size_t frame_size_ = 0;
+};
+
+/* CVF view. Only the RFC payload format (AVTP_CVF_FORMAT_RFC) is defined. For
+ * H.264 PDUs the payload starts with the 'h264_timestamp' header, which is
+ * accessed with h264_timestamp() and skipped by h264_data().
+ */
+template <class Byte>
+class BasicCvfView : public detail::view<Byte, detail::stream_header_len,
+		detail::stream_header_len, cvf::stream_data_len> {
+public:
+	/* Initialize view.
+	 * @buf: PDU buffer.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    -EBADMSG: If the buffer is too short, the subtype is not CVF,
+	 *              'stream_data_len' doesn't fit in the buffer or it is
+	 *              too short for the H.264 header.
+	 *    -ENOTSUP: If the format is not AVTP_CVF_FORMAT_RFC.
+	 */
+	constexpr int init(std::span<Byte> buf) noexcept
+	{
+		int res;
+
+		res = this->init_view(buf, AVTP_SUBTYPE_CVF);
+		if (res < 0)
+			return res;
+
+		if (this->template get<cvf::format>() != AVTP_CVF_FORMAT_RFC)
+			return -ENOTSUP;
+
+		if (is_h264() && this->payload().size() < h264_header_len)
+			return -EBADMSG;
+
+		return 0;
+	}
+
+	constexpr bool is_h264() const noexcept
+	{
+		return this->template get<cvf::format_subtype>() ==
+						AVTP_CVF_FORMAT_SUBTYPE_H264;
+	}
+
+	/* H.264 header timestamp. Only valid if is_h264(). */
+	constexpr std::uint32_t h264_timestamp() const noexcept
+	{
+		return avtp::get<cvf::h264_timestamp>(this->pdu_.data());
+	}
+
+	constexpr void set_h264_timestamp(std::uint32_t val) const noexcept
+		requires (!std::is_const_v<Byte>)
+	{
+		avtp::set<cvf::h264_timestamp>(this->pdu_.data(), val);
+	}
+
+	/* H.264 NAL unit data. Only valid if is_h264(). */
+	constexpr std::span<Byte> h264_data() const noexcept
+	{
+		return this->payload().subspan(h264_header_len);
+	}
+
+private:
+	static constexpr std::size_t h264_header_len = 4;
+};
+
+/* CRF view. The payload holds timestamps() big-endian 64-bit timestamps. */
+template <class Byte>
+class BasicCrfView : public detail::view<Byte, detail::crf_header_len,
+		detail::crf_header_len, crf::crf_data_len> {
+public:
+	/* Initialize view.
+	 * @buf: PDU buffer.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    -EBADMSG: If the buffer is too short, the subtype is not CRF,
+	 *              'crf_data_len' doesn't fit in the buffer or it isn't a
+	 *              multiple of the timestamp size.
+	 */
+	constexpr int init(std::span<Byte> buf) noexcept
+	{
+		int res;
+
+		res = this->init_view(buf, AVTP_SUBTYPE_CRF);
+		if (res < 0)
+			return res;
+
+		if (this->payload().size() % sizeof(std::uint64_t))
+			return -EBADMSG;
+
+		return 0;
+	}
+
+	/* Number of timestamps in the payload. */
+	constexpr std::size_t timestamps() const noexcept
+	{
+		return this->payload().size() / sizeof(std::uint64_t);
+	}
+
+	/* Timestamp 'i'. 'i' must be less than timestamps(). */
+	constexpr std::uint64_t timestamp(std::size_t i) const noexcept
+	{
+		return detail::load_be<std::uint64_t>(this->payload().data() +
+						i * sizeof(std::uint64_t));
+	}
+
+	constexpr void set_timestamp(std::size_t i, std::uint64_t val) const
+		noexcept requires (!std::is_const_v<Byte>)
+	{
+		detail::store_be<std::uint64_t>(this->payload().data() +
+					i * sizeof(std::uint64_t), val);
+	}
+};
+
+/* IEC 61883 view. Only CIP PDUs ('tag' 1) are supported; the CIP header
+ * fields are part of the view header. The CIP payload holds
+ * source_packets() source packets of 2^fn data blocks each, a data block
+ * being 'dbs' quadlets (256 if 'dbs' is 0). With 'sph' set, e.g. MPEG-TS,
+ * each source packet starts with its source packet header.
+ */
+template <class Byte>
+class BasicIeciidcView : public detail::view<Byte, detail::stream_header_len,
+		detail::stream_header_len + AVTP_IECIIDC_CIP_HEADER_LEN,
+		ieciidc::stream_data_len> {
+public:
+	/* Initialize view.
+	 * @buf: PDU buffer.
+	 *
+	 * Returns:
+	 *    0: Success.
+	 *    -EBADMSG: If the buffer is too short, the subtype is not
+	 *              IEC 61883/IIDC, 'stream_data_len' doesn't fit in the
+	 *              buffer or the CIP payload isn't a multiple of the source
+	 *              packet size.
+	 *    -ENOTSUP: If the PDU has no CIP header ('tag' is not 1).
+	 */
+	constexpr int init(std::span<Byte> buf) noexcept
+	{
+		int res;
+
+		res = this->init_view(buf, AVTP_SUBTYPE_61883_IIDC);
+		if (res < 0)
+			return res;
+
+		if (this->template get<ieciidc::tag>() != 1)
+			return -ENOTSUP;
+
+		sp_size_ = data_block_size() <<
+				this->template get<ieciidc::cip_fn>();
+		if (cip_payload().size() % sp_size_)
+			return -EBADMSG;
+
+		return 0;
+	}
+
+	/* Size of a data block, in bytes. */
+	constexpr std::size_t data_block_size() const noexcept
+	{
+		std::size_t dbs = this->template get<ieciidc::cip_dbs>();
+
+		return (dbs ? dbs : 256) * 4;
+	}
+
+	/* Payload following the CIP header. */
+	constexpr std::span<Byte> cip_payload() const noexcept
+	{
+		return this->pdu_.subspan(this->header_len);
+	}
+
+	/* Size of a source packet, in bytes. */
+	constexpr std::size_t source_packet_size() const noexcept
+	{
+		return sp_size_;
+	}
+
+	/* Number of source packets in the CIP payload. */
+	constexpr std::size_t source_packets() const noexcept
+	{
+		return cip_payload().size() / sp_size_;
+	}
+
+	/* Source packet 'i'. 'i' must be less than source_packets(). */
+	constexpr std::span<Byte> source_packet(std::size_t i) const noexcept
+	{
+		return cip_payload().subspan(i * sp_size_, sp_size_);
+	}
+
+private:
+	std::size_t sp_size_ = 0;
+};
+
+using AafView = BasicAafView<std::byte>;
+using ConstAafView = BasicAafView<const std::byte>;
+using CvfView = BasicCvfView<std::byte>;
+using ConstCvfView = BasicCvfView<const std::byte>;
+using CrfView = BasicCrfView<std::byte>;
+using ConstCrfView = BasicCrfView<const std::byte>;
+using IeciidcView = BasicIeciidcView<std::byte>;
+using ConstIeciidcView = BasicIeciidcView<const std::byte>;
+
+} // namespace avtp
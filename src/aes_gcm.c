@@ -0,0 +1,684 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AESNI
+#endif
+
+#include "aes_gcm.h"
+
+/* Blocks kept in flight by the AES-NI CTR loop. AESENC has a latency of
+ * several cycles but a throughput of one or two per cycle, so independent
+ * blocks are interleaved round by round to keep the unit busy.
+ */
+#define CTR_LANES			8
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+	0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+	0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc,
+	0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a,
+	0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+	0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+	0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85,
+	0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+	0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17,
+	0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+	0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+	0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9,
+	0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6,
+	0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+	0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94,
+	0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68,
+	0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint8_t rcon[10] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36,
+};
+
+/* Reduction constants for the 4-bit GHASH table method. */
+static const uint64_t last4[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+};
+
+static inline uint32_t ror32(uint32_t x, int n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+	uint32_t x;
+
+	memcpy(&x, p, sizeof(x));
+	return ntohl(x);
+}
+
+static inline void store_be32(uint8_t *p, uint32_t x)
+{
+	x = htonl(x);
+	memcpy(p, &x, sizeof(x));
+}
+
+static inline uint64_t load_be64(const uint8_t *p)
+{
+	uint64_t x;
+
+	memcpy(&x, p, sizeof(x));
+	return be64toh(x);
+}
+
+static inline void store_be64(uint8_t *p, uint64_t x)
+{
+	x = htobe64(x);
+	memcpy(p, &x, sizeof(x));
+}
+
+static uint32_t sub_word(uint32_t w)
+{
+	return (uint32_t) sbox[w >> 24] << 24 |
+		(uint32_t) sbox[(w >> 16) & 0xff] << 16 |
+		(uint32_t) sbox[(w >> 8) & 0xff] << 8 |
+		(uint32_t) sbox[w & 0xff];
+}
+
+static void xor_block(uint8_t *dst, const uint8_t *a, const uint8_t *b)
+{
+	int i;
+
+	for (i = 0; i < AES_BLOCK_LEN; i++)
+		dst[i] = a[i] ^ b[i];
+}
+
+static void expand_key(struct aes_gcm *gcm, const uint8_t *key, int nk)
+{
+	uint32_t *w = gcm->rk32;
+	int i, total;
+
+	gcm->rounds = nk + 6;
+	total = 4 * (gcm->rounds + 1);
+
+	for (i = 0; i < nk; i++)
+		w[i] = load_be32(key + 4 * i);
+
+	for (i = nk; i < total; i++) {
+		uint32_t t = w[i - 1];
+
+		if (i % nk == 0)
+			t = sub_word(ror32(t, 24)) ^
+					(uint32_t) rcon[i / nk - 1] << 24;
+		else if (nk > 6 && i % nk == 4)
+			t = sub_word(t);
+
+		w[i] = w[i - nk] ^ t;
+	}
+
+	for (i = 0; i < total; i++)
+		store_be32(gcm->rk[i / 4] + 4 * (i % 4), w[i]);
+
+	for (i = 0; i < 256; i++) {
+		uint32_t s = sbox[i];
+		uint32_t s2 = ((s << 1) ^ ((s >> 7) * 0x1b)) & 0xff;
+
+		gcm->te[i] = s2 << 24 | s << 16 | s << 8 | (s2 ^ s);
+	}
+}
+
+static void encrypt_block_sw(const struct aes_gcm *gcm, const uint8_t *in,
+								uint8_t *out)
+{
+	const uint32_t *te = gcm->te;
+	const uint32_t *k = gcm->rk32;
+	uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+	int r;
+
+	s0 = load_be32(in) ^ k[0];
+	s1 = load_be32(in + 4) ^ k[1];
+	s2 = load_be32(in + 8) ^ k[2];
+	s3 = load_be32(in + 12) ^ k[3];
+
+	for (r = 1; r < gcm->rounds; r++) {
+		k += 4;
+		t0 = te[s0 >> 24] ^ ror32(te[(s1 >> 16) & 0xff], 8) ^
+			ror32(te[(s2 >> 8) & 0xff], 16) ^
+			ror32(te[s3 & 0xff], 24) ^ k[0];
+		t1 = te[s1 >> 24] ^ ror32(te[(s2 >> 16) & 0xff], 8) ^
+			ror32(te[(s3 >> 8) & 0xff], 16) ^
+			ror32(te[s0 & 0xff], 24) ^ k[1];
+		t2 = te[s2 >> 24] ^ ror32(te[(s3 >> 16) & 0xff], 8) ^
+			ror32(te[(s0 >> 8) & 0xff], 16) ^
+			ror32(te[s1 & 0xff], 24) ^ k[2];
+		t3 = te[s3 >> 24] ^ ror32(te[(s0 >> 16) & 0xff], 8) ^
+			ror32(te[(s1 >> 8) & 0xff], 16) ^
+			ror32(te[s2 & 0xff], 24) ^ k[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	k += 4;
+	t0 = (uint32_t) sbox[s0 >> 24] << 24 |
+		(uint32_t) sbox[(s1 >> 16) & 0xff] << 16 |
+		(uint32_t) sbox[(s2 >> 8) & 0xff] << 8 |
+		(uint32_t) sbox[s3 & 0xff];
+	t1 = (uint32_t) sbox[s1 >> 24] << 24 |
+		(uint32_t) sbox[(s2 >> 16) & 0xff] << 16 |
+		(uint32_t) sbox[(s3 >> 8) & 0xff] << 8 |
+		(uint32_t) sbox[s0 & 0xff];
+	t2 = (uint32_t) sbox[s2 >> 24] << 24 |
+		(uint32_t) sbox[(s3 >> 16) & 0xff] << 16 |
+		(uint32_t) sbox[(s0 >> 8) & 0xff] << 8 |
+		(uint32_t) sbox[s1 & 0xff];
+	t3 = (uint32_t) sbox[s3 >> 24] << 24 |
+		(uint32_t) sbox[(s0 >> 16) & 0xff] << 16 |
+		(uint32_t) sbox[(s1 >> 8) & 0xff] << 8 |
+		(uint32_t) sbox[s2 & 0xff];
+
+	store_be32(out, t0 ^ k[0]);
+	store_be32(out + 4, t1 ^ k[1]);
+	store_be32(out + 8, t2 ^ k[2]);
+	store_be32(out + 12, t3 ^ k[3]);
+}
+
+/* CTR mode from counter 'ctr'. 'len' need not be a multiple of the block
+ * size.
+ */
+static void ctr_sw(const struct aes_gcm *gcm, const uint8_t *iv, uint32_t ctr,
+						uint8_t *data, size_t len)
+{
+	uint8_t block[AES_BLOCK_LEN], ks[AES_BLOCK_LEN];
+	size_t i, n;
+
+	memcpy(block, iv, GCM_IV_LEN);
+
+	while (len) {
+		store_be32(block + GCM_IV_LEN, ctr++);
+		encrypt_block_sw(gcm, block, ks);
+
+		n = len < AES_BLOCK_LEN ? len : AES_BLOCK_LEN;
+		for (i = 0; i < n; i++)
+			data[i] ^= ks[i];
+
+		data += n;
+		len -= n;
+	}
+}
+
+static void init_ghash_table(struct aes_gcm *gcm, const uint8_t *h)
+{
+	uint64_t vh = load_be64(h);
+	uint64_t vl = load_be64(h + 8);
+	int i, j;
+
+	gcm->hl[8] = vl;
+	gcm->hh[8] = vh;
+	gcm->hl[0] = 0;
+	gcm->hh[0] = 0;
+
+	for (i = 4; i > 0; i >>= 1) {
+		uint64_t t = (vl & 1) * 0xe1000000ULL;
+
+		vl = (vh << 63) | (vl >> 1);
+		vh = (vh >> 1) ^ (t << 32);
+		gcm->hl[i] = vl;
+		gcm->hh[i] = vh;
+	}
+
+	for (i = 2; i <= 8; i *= 2) {
+		for (j = 1; j < i; j++) {
+			gcm->hh[i + j] = gcm->hh[i] ^ gcm->hh[j];
+			gcm->hl[i + j] = gcm->hl[i] ^ gcm->hl[j];
+		}
+	}
+}
+
+static void gmul_sw(const struct aes_gcm *gcm, uint8_t *x)
+{
+	uint64_t zh, zl;
+	uint8_t lo, hi, rem;
+	int i;
+
+	lo = x[15] & 0xf;
+	zh = gcm->hh[lo];
+	zl = gcm->hl[lo];
+
+	for (i = 15; i >= 0; i--) {
+		lo = x[i] & 0xf;
+		hi = x[i] >> 4;
+
+		if (i != 15) {
+			rem = zl & 0xf;
+			zl = (zh << 60) | (zl >> 4);
+			zh = (zh >> 4) ^ (last4[rem] << 48);
+			zh ^= gcm->hh[lo];
+			zl ^= gcm->hl[lo];
+		}
+
+		rem = zl & 0xf;
+		zl = (zh << 60) | (zl >> 4);
+		zh = (zh >> 4) ^ (last4[rem] << 48);
+		zh ^= gcm->hh[hi];
+		zl ^= gcm->hl[hi];
+	}
+
+	store_be64(x, zh);
+	store_be64(x + 8, zl);
+}
+
+/* GHASH whole blocks. 'len' must be a multiple of the block size. */
+static void ghash_sw(const struct aes_gcm *gcm, uint8_t *y,
+					const uint8_t *data, size_t len)
+{
+	for (; len; len -= AES_BLOCK_LEN, data += AES_BLOCK_LEN) {
+		xor_block(y, y, data);
+		gmul_sw(gcm, y);
+	}
+}
+
+#ifdef HAVE_AESNI
+
+#define AESNI_TARGET	__attribute__((target("aes,pclmul,ssse3,sse4.1")))
+
+static inline AESNI_TARGET __m128i bswap_mask(void)
+{
+	return _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+									15);
+}
+
+static inline AESNI_TARGET void clmul_wide(__m128i a, __m128i b,
+						__m128i *lo, __m128i *hi)
+{
+	__m128i mid;
+
+	mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+					_mm_clmulepi64_si128(a, b, 0x01));
+	*lo = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00),
+					_mm_slli_si128(mid, 8));
+	*hi = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11),
+					_mm_srli_si128(mid, 8));
+}
+
+/* Reduce a 256-bit carry-less product of byte-reflected operands modulo the
+ * GHASH polynomial. The product is shifted left by one bit first to account
+ * for the bit-reflected representation.
+ */
+static inline AESNI_TARGET __m128i reduce(__m128i lo, __m128i hi)
+{
+	__m128i t7, t8, t9, t2, t4, t5;
+
+	t7 = _mm_srli_epi32(lo, 31);
+	t8 = _mm_srli_epi32(hi, 31);
+	lo = _mm_slli_epi32(lo, 1);
+	hi = _mm_slli_epi32(hi, 1);
+	t9 = _mm_srli_si128(t7, 12);
+	t8 = _mm_slli_si128(t8, 4);
+	t7 = _mm_slli_si128(t7, 4);
+	lo = _mm_or_si128(lo, t7);
+	hi = _mm_or_si128(hi, t8);
+	hi = _mm_or_si128(hi, t9);
+
+	t7 = _mm_slli_epi32(lo, 31);
+	t8 = _mm_slli_epi32(lo, 30);
+	t9 = _mm_slli_epi32(lo, 25);
+	t7 = _mm_xor_si128(t7, t8);
+	t7 = _mm_xor_si128(t7, t9);
+	t8 = _mm_srli_si128(t7, 4);
+	t7 = _mm_slli_si128(t7, 12);
+	lo = _mm_xor_si128(lo, t7);
+
+	t2 = _mm_srli_epi32(lo, 1);
+	t4 = _mm_srli_epi32(lo, 2);
+	t5 = _mm_srli_epi32(lo, 7);
+	t2 = _mm_xor_si128(t2, t4);
+	t2 = _mm_xor_si128(t2, t5);
+	t2 = _mm_xor_si128(t2, t8);
+	lo = _mm_xor_si128(lo, t2);
+
+	return _mm_xor_si128(hi, lo);
+}
+
+static inline AESNI_TARGET __m128i gmul_ni(__m128i a, __m128i b)
+{
+	__m128i lo, hi;
+
+	clmul_wide(a, b, &lo, &hi);
+
+	return reduce(lo, hi);
+}
+
+static AESNI_TARGET void init_hpow_ni(struct aes_gcm *gcm, const uint8_t *h)
+{
+	__m128i h1, hn;
+	int i;
+
+	h1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) h),
+								bswap_mask());
+	hn = h1;
+	_mm_store_si128((__m128i *) gcm->hpow[0], hn);
+
+	for (i = 1; i < GCM_H_POWERS; i++) {
+		hn = gmul_ni(hn, h1);
+		_mm_store_si128((__m128i *) gcm->hpow[i], hn);
+	}
+}
+
+/* GHASH whole blocks, four at a time with a single reduction:
+ * Y' = (Y + X1) * H^4 + X2 * H^3 + X3 * H^2 + X4 * H.
+ */
+static AESNI_TARGET void ghash_ni(const struct aes_gcm *gcm, uint8_t *y,
+					const uint8_t *data, size_t len)
+{
+	const __m128i mask = bswap_mask();
+	const __m128i h1 = _mm_load_si128((const __m128i *) gcm->hpow[0]);
+	const __m128i h2 = _mm_load_si128((const __m128i *) gcm->hpow[1]);
+	const __m128i h3 = _mm_load_si128((const __m128i *) gcm->hpow[2]);
+	const __m128i h4 = _mm_load_si128((const __m128i *) gcm->hpow[3]);
+	const __m128i *p = (const __m128i *) data;
+	__m128i acc;
+
+	acc = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) y), mask);
+
+	for (; len >= 4 * AES_BLOCK_LEN; len -= 4 * AES_BLOCK_LEN, p += 4) {
+		__m128i x1, x2, x3, x4, lo, hi, l, h;
+
+		x1 = _mm_shuffle_epi8(_mm_loadu_si128(p), mask);
+		x2 = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), mask);
+		x3 = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), mask);
+		x4 = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), mask);
+
+		clmul_wide(_mm_xor_si128(acc, x1), h4, &lo, &hi);
+		clmul_wide(x2, h3, &l, &h);
+		lo = _mm_xor_si128(lo, l);
+		hi = _mm_xor_si128(hi, h);
+		clmul_wide(x3, h2, &l, &h);
+		lo = _mm_xor_si128(lo, l);
+		hi = _mm_xor_si128(hi, h);
+		clmul_wide(x4, h1, &l, &h);
+		lo = _mm_xor_si128(lo, l);
+		hi = _mm_xor_si128(hi, h);
+
+		acc = reduce(lo, hi);
+	}
+
+	for (; len; len -= AES_BLOCK_LEN, p++) {
+		__m128i x = _mm_shuffle_epi8(_mm_loadu_si128(p), mask);
+
+		acc = gmul_ni(_mm_xor_si128(acc, x), h1);
+	}
+
+	_mm_storeu_si128((__m128i *) y, _mm_shuffle_epi8(acc, mask));
+}
+
+static AESNI_TARGET void encrypt_block_ni(const struct aes_gcm *gcm,
+					const uint8_t *in, uint8_t *out)
+{
+	const __m128i *k = (const __m128i *) gcm->rk;
+	__m128i b;
+	int r;
+
+	b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in),
+							_mm_load_si128(k));
+	for (r = 1; r < gcm->rounds; r++)
+		b = _mm_aesenc_si128(b, _mm_load_si128(k + r));
+	b = _mm_aesenclast_si128(b, _mm_load_si128(k + gcm->rounds));
+
+	_mm_storeu_si128((__m128i *) out, b);
+}
+
+/* Generate 'n' keystream blocks from counter 'ctr', interleaving the rounds
+ * of all blocks.
+ */
+static inline AESNI_TARGET __attribute__((always_inline)) void
+keystream_ni(const struct aes_gcm *gcm, __m128i base, uint32_t ctr,
+							__m128i *b, int n)
+{
+	const __m128i *k = (const __m128i *) gcm->rk;
+	const int rounds = gcm->rounds;
+	__m128i k0 = _mm_load_si128(k);
+	int i, r;
+
+	for (i = 0; i < n; i++)
+		b[i] = _mm_xor_si128(_mm_insert_epi32(base,
+					(int) htonl(ctr + i), 3), k0);
+
+	for (r = 1; r < rounds; r++) {
+		__m128i kr = _mm_load_si128(k + r);
+
+		for (i = 0; i < n; i++)
+			b[i] = _mm_aesenc_si128(b[i], kr);
+	}
+
+	for (i = 0; i < n; i++)
+		b[i] = _mm_aesenclast_si128(b[i], _mm_load_si128(k + rounds));
+}
+
+static AESNI_TARGET void ctr_ni(const struct aes_gcm *gcm, const uint8_t *iv,
+				uint32_t ctr, uint8_t *data, size_t len)
+{
+	uint8_t tmp[CTR_LANES * AES_BLOCK_LEN] = { 0 };
+	__m128i base, b[CTR_LANES];
+	__m128i *p = (__m128i *) data;
+	size_t j;
+	int i, n;
+
+	memcpy(tmp, iv, GCM_IV_LEN);
+	base = _mm_loadu_si128((const __m128i *) tmp);
+
+	for (; len >= CTR_LANES * AES_BLOCK_LEN;
+			len -= CTR_LANES * AES_BLOCK_LEN, p += CTR_LANES) {
+		keystream_ni(gcm, base, ctr, b, CTR_LANES);
+		ctr += CTR_LANES;
+
+		for (i = 0; i < CTR_LANES; i++)
+			_mm_storeu_si128(p + i, _mm_xor_si128(b[i],
+						_mm_loadu_si128(p + i)));
+	}
+
+	if (!len)
+		return;
+
+	/* The tail is still generated in parallel: PDUs are rarely a
+	 * multiple of CTR_LANES blocks, and one block at a time would pay
+	 * the full AESENC latency for each.
+	 */
+	n = (len + AES_BLOCK_LEN - 1) / AES_BLOCK_LEN;
+	keystream_ni(gcm, base, ctr, b, n);
+	for (i = 0; i < n; i++)
+		_mm_storeu_si128((__m128i *) tmp + i, b[i]);
+
+	for (j = 0; j < len; j++)
+		((uint8_t *) p)[j] ^= tmp[j];
+}
+
+static int has_aesni(void)
+{
+	__builtin_cpu_init();
+
+	return __builtin_cpu_supports("aes") &&
+			__builtin_cpu_supports("pclmul") &&
+			__builtin_cpu_supports("sse4.1");
+}
+
+#endif /* HAVE_AESNI */
+
+static void encrypt_block(const struct aes_gcm *gcm, const uint8_t *in,
+								uint8_t *out)
+{
+#ifdef HAVE_AESNI
+	if (gcm->accel) {
+		encrypt_block_ni(gcm, in, out);
+		return;
+	}
+#endif
+	encrypt_block_sw(gcm, in, out);
+}
+
+static void ctr(const struct aes_gcm *gcm, const uint8_t *iv, uint8_t *data,
+								size_t len)
+{
+	/* Counter 1 is reserved for the tag. */
+#ifdef HAVE_AESNI
+	if (gcm->accel) {
+		ctr_ni(gcm, iv, 2, data, len);
+		return;
+	}
+#endif
+	ctr_sw(gcm, iv, 2, data, len);
+}
+
+/* GHASH 'len' bytes, zero-padding the last block. */
+static void ghash(const struct aes_gcm *gcm, uint8_t *y, const uint8_t *data,
+								size_t len)
+{
+	size_t whole = len & ~(size_t) (AES_BLOCK_LEN - 1);
+	uint8_t block[AES_BLOCK_LEN];
+
+#ifdef HAVE_AESNI
+	if (gcm->accel) {
+		ghash_ni(gcm, y, data, whole);
+	} else
+#endif
+	{
+		ghash_sw(gcm, y, data, whole);
+	}
+
+	if (whole == len)
+		return;
+
+	memset(block, 0, sizeof(block));
+	memcpy(block, data + whole, len - whole);
+
+#ifdef HAVE_AESNI
+	if (gcm->accel) {
+		ghash_ni(gcm, y, block, AES_BLOCK_LEN);
+		return;
+	}
+#endif
+	ghash_sw(gcm, y, block, AES_BLOCK_LEN);
+}
+
+static void compute_tag(const struct aes_gcm *gcm, const uint8_t *iv,
+			const uint8_t *aad, size_t aad_len,
+			const uint8_t *data, size_t len, uint8_t *tag)
+{
+	uint8_t y[AES_BLOCK_LEN] = { 0 };
+	uint8_t block[AES_BLOCK_LEN];
+
+	ghash(gcm, y, aad, aad_len);
+	ghash(gcm, y, data, len);
+
+	store_be64(block, (uint64_t) aad_len * 8);
+	store_be64(block + 8, (uint64_t) len * 8);
+	ghash(gcm, y, block, AES_BLOCK_LEN);
+
+	memcpy(block, iv, GCM_IV_LEN);
+	store_be32(block + GCM_IV_LEN, 1);
+	encrypt_block(gcm, block, block);
+
+	xor_block(tag, y, block);
+}
+
+int aes_gcm_init(struct aes_gcm *gcm, const uint8_t *key, size_t key_len,
+								int accel)
+{
+	uint8_t h[AES_BLOCK_LEN] = { 0 };
+
+	if (!gcm || !key || (key_len != 16 && key_len != 32))
+		return -EINVAL;
+
+	memset(gcm, 0, sizeof(*gcm));
+	expand_key(gcm, key, key_len / 4);
+
+#ifdef HAVE_AESNI
+	gcm->accel = accel && has_aesni();
+#endif
+
+	encrypt_block_sw(gcm, h, h);
+	init_ghash_table(gcm, h);
+
+#ifdef HAVE_AESNI
+	if (gcm->accel)
+		init_hpow_ni(gcm, h);
+#endif
+
+	return 0;
+}
+
+void aes_gcm_encrypt(const struct aes_gcm *gcm, const uint8_t *iv,
+			const uint8_t *aad, size_t aad_len, uint8_t *data,
+			size_t len, uint8_t *tag)
+{
+	ctr(gcm, iv, data, len);
+	compute_tag(gcm, iv, aad, aad_len, data, len, tag);
+}
+
+int aes_gcm_decrypt(const struct aes_gcm *gcm, const uint8_t *iv,
+			const uint8_t *aad, size_t aad_len, uint8_t *data,
+			size_t len, const uint8_t *tag)
+{
+	uint8_t expected[GCM_TAG_LEN];
+	uint8_t diff = 0;
+	int i;
+
+	compute_tag(gcm, iv, aad, aad_len, data, len, expected);
+
+	/* Constant time, so timing doesn't tell how much of a forged tag
+	 * was right.
+	 */
+	for (i = 0; i < GCM_TAG_LEN; i++)
+		diff |= expected[i] ^ tag[i];
+
+	if (diff)
+		return -EBADMSG;
+
+	ctr(gcm, iv, data, len);
+
+	return 0;
+}
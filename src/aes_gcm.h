@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma GCC visibility push(hidden)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AES_BLOCK_LEN			16
+#define AES_MAX_ROUNDS			14
+#define GCM_IV_LEN			12
+#define GCM_TAG_LEN			16
+
+/* Number of H powers kept for aggregated GHASH reduction. */
+#define GCM_H_POWERS			4
+
+/* AES-GCM key context. Round keys are kept both as words, for the portable
+ * table-based implementation, and as bytes in the layout AES-NI expects.
+ * 'hpow' holds H^1..H^GCM_H_POWERS byte-reflected for PCLMULQDQ, and
+ * 'hl'/'hh' the 4-bit multiplication table for the portable GHASH.
+ *
+ * The portable implementation is not constant time: its T-table lookups
+ * and GHASH table lookups are indexed by secret data, so their cache
+ * footprint leaks key material to code sharing the CPU. Only AES-NI and
+ * PCLMULQDQ are constant time.
+ */
+struct aes_gcm {
+	uint8_t rk[AES_MAX_ROUNDS + 1][AES_BLOCK_LEN]
+					__attribute__((aligned(16)));
+	uint8_t hpow[GCM_H_POWERS][AES_BLOCK_LEN]
+					__attribute__((aligned(16)));
+	uint32_t rk32[4 * (AES_MAX_ROUNDS + 1)];
+	uint32_t te[256];
+	uint64_t hl[16];
+	uint64_t hh[16];
+	int rounds;
+	int accel;
+};
+
+/* Initialize AES-GCM key context.
+ * @gcm: Pointer to context.
+ * @key: AES key.
+ * @key_len: Key length, in bytes: 16 or 32.
+ * @accel: Use AES-NI and PCLMULQDQ if the CPU supports them.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EINVAL: If any argument is invalid.
+ */
+int aes_gcm_init(struct aes_gcm *gcm, const uint8_t *key, size_t key_len,
+								int accel);
+
+/* Encrypt in place and compute the authentication tag.
+ * @gcm: Pointer to context.
+ * @iv: GCM_IV_LEN-byte initialization vector.
+ * @aad: Additional authenticated data.
+ * @aad_len: Length of 'aad', in bytes.
+ * @data: Data to be encrypted in place.
+ * @len: Length of 'data', in bytes.
+ * @tag: Buffer which the GCM_TAG_LEN-byte tag should be written to.
+ */
+void aes_gcm_encrypt(const struct aes_gcm *gcm, const uint8_t *iv,
+			const uint8_t *aad, size_t aad_len, uint8_t *data,
+			size_t len, uint8_t *tag);
+
+/* Verify the authentication tag and decrypt in place. 'data' is left
+ * untouched if the tag doesn't match.
+ * @gcm: Pointer to context.
+ * @iv: GCM_IV_LEN-byte initialization vector.
+ * @aad: Additional authenticated data.
+ * @aad_len: Length of 'aad', in bytes.
+ * @data: Data to be decrypted in place.
+ * @len: Length of 'data', in bytes.
+ * @tag: GCM_TAG_LEN-byte tag.
+ *
+ * Returns:
+ *    0: Success.
+ *    -EBADMSG: If the tag doesn't match.
+ */
+int aes_gcm_decrypt(const struct aes_gcm *gcm, const uint8_t *iv,
+			const uint8_t *aad, size_t aad_len, uint8_t *data,
+			size_t len, const uint8_t *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#pragma GCC visibility pop
@@ -29,6 +29,7 @@
 #include <stddef.h>
 
 #include "avtp.h"
+#include "probes.h"
 #include "util.h"
 
 #define SHIFT_SUBTYPE			(31 - 7)
@@ -56,6 +57,7 @@ int avtp_pdu_get(const struct avtp_common_pdu *pdu, enum avtp_field field,
 		shift = SHIFT_VERSION;
 		break;
 	default:
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, -EINVAL);
 		return -EINVAL;
 	}
 
@@ -85,6 +87,7 @@ int avtp_pdu_set(struct avtp_common_pdu *pdu, enum avtp_field field,
 		shift = SHIFT_VERSION;
 		break;
 	default:
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, -EINVAL);
 		return -EINVAL;
 	}
 
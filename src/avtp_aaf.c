@@ -31,6 +31,7 @@
 #include "avtp.h"
 #include "avtp_aaf.h"
 #include "avtp_stream.h"
+#include "probes.h"
 #include "util.h"
 
 #define SHIFT_FORMAT			(31 - 7)
@@ -125,6 +126,9 @@ int avtp_aaf_pdu_get(const struct avtp_stream_pdu *pdu,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -212,6 +216,9 @@ int avtp_aaf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_aaf_field field,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -233,5 +240,7 @@ int avtp_aaf_pdu_init(struct avtp_stream_pdu *pdu)
 	if (res < 0)
 		return res;
 
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
 	return 0;
 };
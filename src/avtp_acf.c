@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <string.h>
+
+#include "avtp_acf.h"
+#include "avtp_acf_pack.h"
+#include "util.h"
+
+#define SHIFT_MSG_TYPE			(31 - 6)
+#define SHIFT_MSG_LEN			(31 - 15)
+#define SHIFT_PAD			(31 - 17)
+#define SHIFT_FLAGS			(31 - 23)
+
+#define MASK_MSG_TYPE			(BITMASK(7) << SHIFT_MSG_TYPE)
+#define MASK_MSG_LEN			(BITMASK(9) << SHIFT_MSG_LEN)
+#define MASK_PAD			(BITMASK(2) << SHIFT_PAD)
+#define MASK_FLAGS			(BITMASK(6) << SHIFT_FLAGS)
+#define MASK_BUS_ID			(BITMASK(5))
+#define MASK_CAN_ID			(BITMASK(29))
+
+#define MAX_STD_ID			BITMASK(11)
+#define MAX_BUS_ID			BITMASK(5)
+#define MAX_CLASSIC_LEN			8
+
+static int is_valid_can_len(const struct avtp_acf_can *can)
+{
+	if (can->len <= MAX_CLASSIC_LEN)
+		return 1;
+
+	if (!(can->flags & AVTP_ACF_CAN_FLAG_FDF))
+		return 0;
+
+	switch (can->len) {
+	case 12:
+	case 16:
+	case 20:
+	case 24:
+	case 32:
+	case 48:
+	case 64:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static size_t get_header_len(uint8_t type)
+{
+	return type == AVTP_ACF_TYPE_CAN ? AVTP_ACF_CAN_HEADER_LEN :
+						AVTP_ACF_CAN_BRIEF_HEADER_LEN;
+}
+
+int avtp_acf_iter_init(struct avtp_acf_iter *iter, const void *data,
+								size_t len)
+{
+	if (!iter || (!data && len))
+		return -EINVAL;
+
+	iter->pos = data;
+	iter->end = iter->pos + len;
+
+	return 0;
+}
+
+int avtp_acf_iter_next(struct avtp_acf_iter *iter, struct avtp_acf_msg *msg)
+{
+	size_t left, len;
+	uint32_t bitmap;
+
+	if (!iter || !msg)
+		return -EINVAL;
+
+	left = iter->end - iter->pos;
+	if (left == 0)
+		return 0;
+
+	if (left < sizeof(uint32_t))
+		goto err;
+
+	bitmap = get_unaligned_be32(iter->pos);
+	len = BITMAP_GET_VALUE(bitmap, MASK_MSG_LEN, SHIFT_MSG_LEN) * 4;
+	if (len == 0 || len > left)
+		goto err;
+
+	msg->data = iter->pos;
+	msg->len = len;
+	msg->type = BITMAP_GET_VALUE(bitmap, MASK_MSG_TYPE, SHIFT_MSG_TYPE);
+
+	iter->pos += len;
+
+	return 1;
+
+err:
+	/* Nothing after a malformed header can be trusted. */
+	iter->pos = iter->end;
+	return -EBADMSG;
+}
+
+ssize_t avtp_acf_can_get_len(const struct avtp_acf_can *can, uint8_t type)
+{
+	if (!can)
+		return -EINVAL;
+
+	if (type != AVTP_ACF_TYPE_CAN && type != AVTP_ACF_TYPE_CAN_BRIEF)
+		return -EINVAL;
+
+	if (!is_valid_can_len(can) || (can->len && !can->data))
+		return -EINVAL;
+
+	if (can->bus_id > MAX_BUS_ID || can->id > MASK_CAN_ID)
+		return -EINVAL;
+
+	if (!(can->flags & AVTP_ACF_CAN_FLAG_EFF) && can->id > MAX_STD_ID)
+		return -EINVAL;
+
+	return get_header_len(type) + ((can->len + 3) & ~3);
+}
+
+ssize_t avtp_acf_can_write(const struct avtp_acf_can *can, uint8_t type,
+							void *buf, size_t len)
+{
+	uint8_t *ptr = buf;
+	ssize_t msg_len;
+	uint32_t bitmap;
+	uint8_t pad;
+
+	msg_len = avtp_acf_can_get_len(can, type);
+	if (msg_len < 0)
+		return msg_len;
+
+	if (!buf)
+		return -EINVAL;
+
+	if ((size_t) msg_len > len)
+		return -ENOSPC;
+
+	pad = msg_len - get_header_len(type) - can->len;
+
+	bitmap = (uint32_t) type << SHIFT_MSG_TYPE;
+	bitmap |= (uint32_t) (msg_len / 4) << SHIFT_MSG_LEN;
+	bitmap |= (uint32_t) pad << SHIFT_PAD;
+	bitmap |= (uint32_t) (can->flags & (MASK_FLAGS >> SHIFT_FLAGS))
+								<< SHIFT_FLAGS;
+	bitmap |= can->bus_id;
+	put_unaligned_be32(bitmap, ptr);
+	ptr += sizeof(uint32_t);
+
+	if (type == AVTP_ACF_TYPE_CAN) {
+		uint64_t ts = htobe64(can->timestamp);
+
+		memcpy(ptr, &ts, sizeof(ts));
+		ptr += sizeof(ts);
+	}
+
+	put_unaligned_be32(can->id, ptr);
+	ptr += sizeof(uint32_t);
+
+	memcpy(ptr, can->data, can->len);
+	memset(ptr + can->len, 0, pad);
+
+	return msg_len;
+}
+
+int avtp_acf_can_read(const struct avtp_acf_msg *msg,
+						struct avtp_acf_can *can)
+{
+	const uint8_t *ptr;
+	size_t header_len;
+	uint32_t bitmap;
+	uint8_t pad;
+
+	if (!msg || !can || !msg->data)
+		return -EINVAL;
+
+	if (msg->type != AVTP_ACF_TYPE_CAN &&
+				msg->type != AVTP_ACF_TYPE_CAN_BRIEF)
+		return -EINVAL;
+
+	header_len = get_header_len(msg->type);
+	if (msg->len < header_len)
+		return -EBADMSG;
+
+	ptr = msg->data;
+	bitmap = get_unaligned_be32(ptr);
+	pad = BITMAP_GET_VALUE(bitmap, MASK_PAD, SHIFT_PAD);
+	if (msg->len - header_len < pad ||
+			msg->len - header_len - pad > AVTP_ACF_CAN_MAX_DATA_LEN)
+		return -EBADMSG;
+
+	can->flags = BITMAP_GET_VALUE(bitmap, MASK_FLAGS, SHIFT_FLAGS);
+	can->bus_id = BITMAP_GET_VALUE(bitmap, MASK_BUS_ID, 0);
+	can->len = msg->len - header_len - pad;
+	ptr += sizeof(uint32_t);
+
+	if (msg->type == AVTP_ACF_TYPE_CAN) {
+		uint64_t ts;
+
+		memcpy(&ts, ptr, sizeof(ts));
+		can->timestamp = be64toh(ts);
+		ptr += sizeof(ts);
+	} else {
+		can->timestamp = 0;
+	}
+
+	can->id = get_unaligned_be32(ptr) & MASK_CAN_ID;
+	can->data = ptr + sizeof(uint32_t);
+
+	return 0;
+}
+
+size_t avtp_acf_pack_get_max_len(size_t max_pdu_size, size_t header_len,
+								size_t limit)
+{
+	size_t max_len;
+
+	if (max_pdu_size <= header_len)
+		return 0;
+
+	/* ACF messages are a whole number of quadlets long. */
+	max_len = max_pdu_size - header_len;
+	if (max_len > limit)
+		max_len = limit;
+
+	return max_len & ~3;
+}
+
+ssize_t avtp_acf_pack_can(void *payload, size_t *len, size_t max_len,
+			const struct avtp_acf_can *can, uint8_t type)
+{
+	ssize_t n;
+
+	n = avtp_acf_can_write(can, type, (uint8_t *) payload + *len,
+							max_len - *len);
+	if (n == -ENOSPC && *len)
+		return 0;
+
+	/* A frame which doesn't fit an empty AVTPDU never will. */
+	if (n < 0)
+		return -EINVAL;
+
+	*len += n;
+
+	return n;
+}
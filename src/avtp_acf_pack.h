@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "avtp_acf.h"
+
+#pragma GCC visibility push(hidden)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Get the room left for ACF messages by an AVTPDU header.
+ * @max_pdu_size: Maximum AVTPDU size, header included.
+ * @header_len: Length of the AVTPDU header.
+ * @limit: Largest payload the format's data length field can express.
+ *
+ * Returns:
+ *    Payload room in bytes, rounded down to whole quadlets; 0 if the
+ *    header alone doesn't fit 'max_pdu_size'.
+ */
+size_t avtp_acf_pack_get_max_len(size_t max_pdu_size, size_t header_len,
+								size_t limit);
+
+/* Append an ACF CAN message to a partially filled AVTPDU payload.
+ * @payload: Pointer to the AVTPDU payload.
+ * @len: Pointer to the bytes already used in 'payload', advanced on success.
+ * @max_len: Payload room, as returned by avtp_acf_pack_get_max_len().
+ * @can: Pointer to the CAN frame.
+ * @type: AVTP_ACF_TYPE_CAN or AVTP_ACF_TYPE_CAN_BRIEF.
+ *
+ * Returns:
+ *    Number of bytes appended on success.
+ *    0: The frame doesn't fit the room left, the AVTPDU should be flushed.
+ *    -EINVAL: If the frame is invalid or doesn't fit even an empty AVTPDU.
+ */
+ssize_t avtp_acf_pack_can(void *payload, size_t *len, size_t max_len,
+			const struct avtp_acf_can *can, uint8_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#pragma GCC visibility pop
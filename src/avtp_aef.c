@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+
+#include "avtp.h"
+#include "avtp_aef.h"
+#include "aes_gcm.h"
+#include "avtp_stream.h"
+#include "probes.h"
+
+#define AEF_ALIGN			64
+#define AEF_SALT_LEN			(GCM_IV_LEN - AVTP_AEF_IV_LEN)
+#define MAX_STREAM_DATA_LEN		0xFFFF
+
+struct avtp_aef {
+	struct aes_gcm gcm;
+	uint64_t iv;
+	uint32_t key_id;
+	uint32_t salt;
+	uint8_t seq_num;
+};
+
+int avtp_aef_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_aef_field field, uint64_t *val)
+{
+	int res;
+
+	if (!pdu || !val)
+		return -EINVAL;
+
+	switch (field) {
+	case AVTP_AEF_FIELD_SV:
+	case AVTP_AEF_FIELD_MR:
+	case AVTP_AEF_FIELD_TV:
+	case AVTP_AEF_FIELD_SEQ_NUM:
+	case AVTP_AEF_FIELD_TU:
+	case AVTP_AEF_FIELD_STREAM_ID:
+	case AVTP_AEF_FIELD_TIMESTAMP:
+	case AVTP_AEF_FIELD_STREAM_DATA_LEN:
+		res = avtp_stream_pdu_get(pdu, (enum avtp_stream_field) field,
+									val);
+		break;
+	case AVTP_AEF_FIELD_KEY_ID:
+		*val = ntohl(pdu->format_specific);
+		res = 0;
+		break;
+	default:
+		res = -EINVAL;
+		break;
+	}
+
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
+	return res;
+}
+
+int avtp_aef_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_aef_field field,
+								uint64_t val)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	switch (field) {
+	case AVTP_AEF_FIELD_SV:
+	case AVTP_AEF_FIELD_MR:
+	case AVTP_AEF_FIELD_TV:
+	case AVTP_AEF_FIELD_SEQ_NUM:
+	case AVTP_AEF_FIELD_TU:
+	case AVTP_AEF_FIELD_STREAM_ID:
+	case AVTP_AEF_FIELD_TIMESTAMP:
+	case AVTP_AEF_FIELD_STREAM_DATA_LEN:
+		res = avtp_stream_pdu_set(pdu, (enum avtp_stream_field) field,
+									val);
+		break;
+	case AVTP_AEF_FIELD_KEY_ID:
+		pdu->format_specific = htonl(val);
+		res = 0;
+		break;
+	default:
+		res = -EINVAL;
+		break;
+	}
+
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
+	return res;
+}
+
+int avtp_aef_pdu_init(struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	memset(pdu, 0, sizeof(struct avtp_stream_pdu));
+
+	res = avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+						AVTP_SUBTYPE_AEF_CONTINUOUS);
+	if (res < 0)
+		return res;
+
+	res = avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_SV, 1);
+	if (res < 0)
+		return res;
+
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+int avtp_aef_create(struct avtp_aef **aef, const void *key, size_t key_len,
+			uint32_t key_id, uint32_t salt, uint32_t flags)
+{
+	struct avtp_aef *a;
+	void *ptr;
+	int res;
+
+	if (!aef || !key)
+		return -EINVAL;
+
+	/* Round keys are loaded with aligned SSE loads. */
+	if (posix_memalign(&ptr, AEF_ALIGN, sizeof(*a)))
+		return -ENOMEM;
+	a = ptr;
+
+	res = aes_gcm_init(&a->gcm, key, key_len, !(flags & AVTP_AEF_PORTABLE));
+	if (res < 0) {
+		free(a);
+		return res;
+	}
+
+	/* Start the explicit IV at a random value, so contexts created
+	 * with the same key and salt, e.g. by a restarted talker, are not
+	 * expected to ever use overlapping IV ranges.
+	 */
+	if (getrandom(&a->iv, sizeof(a->iv), 0) != sizeof(a->iv)) {
+		res = -errno;
+		avtp_aef_destroy(a);
+		return res;
+	}
+
+	a->key_id = key_id;
+	a->salt = salt;
+	a->seq_num = 0;
+
+	*aef = a;
+
+	return 0;
+}
+
+void avtp_aef_destroy(struct avtp_aef *aef)
+{
+	if (!aef)
+		return;
+
+	/* Keep the wipe from being optimized away as a dead store. */
+	memset(aef, 0, sizeof(*aef));
+	__asm__ __volatile__("" : : "r" (aef) : "memory");
+
+	free(aef);
+}
+
+int avtp_aef_is_accelerated(const struct avtp_aef *aef)
+{
+	if (!aef)
+		return -EINVAL;
+
+	return aef->gcm.accel;
+}
+
+static void get_nonce(const struct avtp_aef *aef,
+			const struct avtp_stream_pdu *pdu, uint8_t *nonce)
+{
+	uint32_t salt = htonl(aef->salt);
+
+	memcpy(nonce, &salt, AEF_SALT_LEN);
+	memcpy(nonce + AEF_SALT_LEN, pdu->avtp_payload, AVTP_AEF_IV_LEN);
+}
+
+static int is_aef_pdu(const struct avtp_stream_pdu *pdu)
+{
+	uint32_t subtype;
+
+	avtp_pdu_get((const struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+								&subtype);
+
+	return subtype == AVTP_SUBTYPE_AEF_CONTINUOUS;
+}
+
+static int is_valid_buf(const struct avtp_stream_pdu *pdu, size_t len)
+{
+	return pdu && len && len <= MAX_STREAM_DATA_LEN - AVTP_AEF_IV_LEN -
+					AVTP_AEF_ICV_LEN && is_aef_pdu(pdu);
+}
+
+static void encrypt(struct avtp_aef *aef, struct avtp_stream_pdu *pdu,
+						size_t len, size_t *pdu_len)
+{
+	uint8_t *data = (uint8_t *) pdu + AVTP_AEF_HEADER_LEN;
+	uint8_t nonce[GCM_IV_LEN];
+	uint64_t iv;
+
+	avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_KEY_ID, aef->key_id);
+	avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_SEQ_NUM, aef->seq_num++);
+	avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_STREAM_DATA_LEN,
+				AVTP_AEF_IV_LEN + len + AVTP_AEF_ICV_LEN);
+
+	/* The 64-bit counter only repeats a nonce within this context after
+	 * 2^64 PDUs. Across contexts see avtp_aef_create().
+	 */
+	iv = htobe64(aef->iv++);
+	memcpy(pdu->avtp_payload, &iv, AVTP_AEF_IV_LEN);
+	get_nonce(aef, pdu, nonce);
+
+	aes_gcm_encrypt(&aef->gcm, nonce, (const uint8_t *) pdu,
+			AVTP_AEF_HEADER_LEN, data, len, data + len);
+
+	*pdu_len = AVTP_AEF_HEADER_LEN + len + AVTP_AEF_ICV_LEN;
+}
+
+int avtp_aef_encrypt(struct avtp_aef *aef, struct avtp_stream_pdu *pdu,
+					size_t len, size_t *pdu_len)
+{
+	if (!aef || !pdu_len || !is_valid_buf(pdu, len))
+		return -EINVAL;
+
+	encrypt(aef, pdu, len, pdu_len);
+
+	return 0;
+}
+
+int avtp_aef_decrypt(struct avtp_aef *aef, struct avtp_stream_pdu *pdu,
+					size_t len, size_t *inner_len)
+{
+	uint8_t nonce[GCM_IV_LEN];
+	uint64_t data_len, key_id;
+	uint8_t *data;
+	int res;
+
+	if (!aef || !pdu || !inner_len)
+		return -EINVAL;
+
+	if (len < AVTP_AEF_OVERHEAD || !is_aef_pdu(pdu))
+		return -EBADMSG;
+
+	avtp_aef_pdu_get(pdu, AVTP_AEF_FIELD_STREAM_DATA_LEN, &data_len);
+	if (data_len > len - sizeof(struct avtp_stream_pdu) ||
+			data_len < AVTP_AEF_IV_LEN + AVTP_AEF_ICV_LEN)
+		return -EBADMSG;
+
+	avtp_aef_pdu_get(pdu, AVTP_AEF_FIELD_KEY_ID, &key_id);
+	if (key_id != aef->key_id)
+		return -ENOKEY;
+
+	len = data_len - AVTP_AEF_IV_LEN - AVTP_AEF_ICV_LEN;
+	data = (uint8_t *) pdu + AVTP_AEF_HEADER_LEN;
+	get_nonce(aef, pdu, nonce);
+
+	res = aes_gcm_decrypt(&aef->gcm, nonce, (const uint8_t *) pdu,
+			AVTP_AEF_HEADER_LEN, data, len, data + len);
+	if (res < 0)
+		return res;
+
+	*inner_len = len;
+
+	return 0;
+}
+
+int avtp_aef_encrypt_batch(struct avtp_aef *aef, struct avtp_aef_buf *bufs,
+							unsigned int count)
+{
+	unsigned int i;
+
+	if (!aef || (!bufs && count))
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		if (!is_valid_buf(bufs[i].pdu, bufs[i].len))
+			return -EINVAL;
+	}
+
+	for (i = 0; i < count; i++)
+		encrypt(aef, bufs[i].pdu, bufs[i].len, &bufs[i].out_len);
+
+	return 0;
+}
+
+int avtp_aef_decrypt_batch(struct avtp_aef *aef, struct avtp_aef_buf *bufs,
+							unsigned int count)
+{
+	unsigned int i;
+	int done = 0;
+
+	if (!aef || (!bufs && count))
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		bufs[i].res = avtp_aef_decrypt(aef, bufs[i].pdu, bufs[i].len,
+							&bufs[i].out_len);
+		if (bufs[i].res == 0)
+			done++;
+	}
+
+	return done;
+}
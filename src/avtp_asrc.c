@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <endian.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "avtp.h"
+#include "avtp_aaf.h"
+#include "avtp_asrc.h"
+#include "simd.h"
+
+/* Filter taps per 1:1 conversion. Downsampling scales the number of taps by
+ * the decimation factor so the transition band stays the same relative to
+ * the output rate. Must be a multiple of 4 (the vector width).
+ */
+#define ASRC_TAPS			32
+#define ASRC_PHASE_BITS			8
+#define ASRC_PHASES			(1 << ASRC_PHASE_BITS)
+#define ASRC_BLOCK			256
+#define ASRC_ALIGN			64
+#define ASRC_KAISER_BETA		7.0
+#define ASRC_CUTOFF			0.45
+#define ASRC_MAX_PPB			100000000LL
+#define ASRC_MAX_FRAMES			INT32_MAX
+
+#define FRAC_BITS			32
+#define FRAC_MASK			((1ULL << FRAC_BITS) - 1)
+#define ALPHA_BITS			(FRAC_BITS - ASRC_PHASE_BITS)
+
+struct avtp_asrc {
+	/* Coefficient table: ASRC_PHASES + 1 rows of 'taps' coefficients.
+	 * The extra row lets the kernel interpolate between adjacent phases
+	 * without wrapping.
+	 */
+	float *coefs;
+	/* Kernel for the current output frame, interpolated from 'coefs'. */
+	float *kernel;
+	/* Planar filter history, 'hist_len' frames per channel. */
+	float *hist;
+	size_t hist_len;
+	size_t fill;
+	/* Position of the next output frame in 'hist', in Q32 input frames. */
+	uint64_t pos;
+	/* Input frames per output frame, in Q32. */
+	uint64_t step;
+	uint64_t nominal;
+	uint32_t taps;
+	uint32_t flags;
+	uint16_t channels;
+	uint8_t format;
+	uint8_t sample_size;
+};
+
+static uint32_t get_rate(uint8_t nsr)
+{
+	switch (nsr) {
+	case AVTP_AAF_PCM_NSR_8KHZ:
+		return 8000;
+	case AVTP_AAF_PCM_NSR_16KHZ:
+		return 16000;
+	case AVTP_AAF_PCM_NSR_24KHZ:
+		return 24000;
+	case AVTP_AAF_PCM_NSR_32KHZ:
+		return 32000;
+	case AVTP_AAF_PCM_NSR_44_1KHZ:
+		return 44100;
+	case AVTP_AAF_PCM_NSR_48KHZ:
+		return 48000;
+	case AVTP_AAF_PCM_NSR_88_2KHZ:
+		return 88200;
+	case AVTP_AAF_PCM_NSR_96KHZ:
+		return 96000;
+	case AVTP_AAF_PCM_NSR_176_4KHZ:
+		return 176400;
+	case AVTP_AAF_PCM_NSR_192KHZ:
+		return 192000;
+	default:
+		return 0;
+	}
+}
+
+static uint8_t get_sample_size(uint8_t format)
+{
+	switch (format) {
+	case AVTP_AAF_FORMAT_INT_16BIT:
+		return 2;
+	case AVTP_AAF_FORMAT_INT_24BIT:
+		return 3;
+	case AVTP_AAF_FORMAT_INT_32BIT:
+	case AVTP_AAF_FORMAT_FLOAT_32BIT:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+/* Zeroth order modified Bessel function of the first kind, used by the
+ * Kaiser window.
+ */
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 32; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+/* Build the polyphase table. Row 'p' holds the filter taps for an output
+ * frame located p / ASRC_PHASES input frames after the history position,
+ * with a group delay of (taps / 2 - 1) frames. Each row is normalized to
+ * unity DC gain.
+ */
+static void init_coefs(float *coefs, uint32_t taps, double cutoff)
+{
+	double center = taps / 2 - 1;
+	double i0_beta = bessel_i0(ASRC_KAISER_BETA);
+	int p, k;
+
+	for (p = 0; p <= ASRC_PHASES; p++) {
+		float *row = coefs + (size_t)p * taps;
+		double frac = (double)p / ASRC_PHASES;
+		double sum = 0;
+
+		for (k = 0; k < (int)taps; k++) {
+			double x = k - center - frac;
+			double r = x / (taps / 2.0);
+			double w, s;
+
+			w = (r * r < 1.0) ?
+				bessel_i0(ASRC_KAISER_BETA * sqrt(1 - r * r)) /
+				i0_beta : 0;
+			s = (x == 0) ? 2 * cutoff :
+				sin(2 * M_PI * cutoff * x) / (M_PI * x);
+
+			row[k] = s * w;
+			sum += row[k];
+		}
+
+		for (k = 0; k < (int)taps; k++)
+			row[k] /= sum;
+	}
+}
+
+static inline uint32_t load_u32(const uint8_t *p, bool be)
+{
+	uint32_t val;
+
+	memcpy(&val, p, sizeof(val));
+	return be ? be32toh(val) : val;
+}
+
+static inline void store_u32(uint8_t *p, uint32_t val, bool be)
+{
+	if (be)
+		val = htobe32(val);
+	memcpy(p, &val, sizeof(val));
+}
+
+static inline float load_sample(const struct avtp_asrc *asrc,
+							const uint8_t *p)
+{
+	bool be = asrc->flags & AVTP_ASRC_IN_BIG_ENDIAN;
+	uint16_t u16;
+	uint32_t u32;
+	float f;
+
+	switch (asrc->format) {
+	case AVTP_AAF_FORMAT_INT_16BIT:
+		memcpy(&u16, p, sizeof(u16));
+		u16 = be ? be16toh(u16) : u16;
+		return (int16_t)u16 * (1.0f / 32768);
+	case AVTP_AAF_FORMAT_INT_24BIT:
+		if (be || __BYTE_ORDER == __BIG_ENDIAN)
+			u32 = (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 |
+							(uint32_t) p[2] << 8;
+		else
+			u32 = (uint32_t) p[2] << 24 | (uint32_t) p[1] << 16 |
+							(uint32_t) p[0] << 8;
+		return (int32_t)u32 * (1.0f / 2147483648.0f);
+	case AVTP_AAF_FORMAT_INT_32BIT:
+		return (int32_t)load_u32(p, be) * (1.0f / 2147483648.0f);
+	default:
+		u32 = load_u32(p, be);
+		memcpy(&f, &u32, sizeof(f));
+		return f;
+	}
+}
+
+static inline int32_t to_int(float val, double scale)
+{
+	double v = val * scale;
+
+	if (v >= scale - 1)
+		return scale - 1;
+	if (v <= -scale)
+		return -scale;
+
+	return v < 0 ? (int32_t)(v - 0.5) : (int32_t)(v + 0.5);
+}
+
+static inline void store_sample(const struct avtp_asrc *asrc, uint8_t *p,
+								float val)
+{
+	bool be = asrc->flags & AVTP_ASRC_OUT_BIG_ENDIAN;
+	uint16_t u16;
+	uint32_t u32;
+
+	switch (asrc->format) {
+	case AVTP_AAF_FORMAT_INT_16BIT:
+		u16 = to_int(val, 32768.0);
+		u16 = be ? htobe16(u16) : u16;
+		memcpy(p, &u16, sizeof(u16));
+		break;
+	case AVTP_AAF_FORMAT_INT_24BIT:
+		u32 = to_int(val, 8388608.0);
+		if (be || __BYTE_ORDER == __BIG_ENDIAN) {
+			p[0] = u32 >> 16;
+			p[1] = u32 >> 8;
+			p[2] = u32;
+		} else {
+			p[0] = u32;
+			p[1] = u32 >> 8;
+			p[2] = u32 >> 16;
+		}
+		break;
+	case AVTP_AAF_FORMAT_INT_32BIT:
+		store_u32(p, to_int(val, 2147483648.0), be);
+		break;
+	default:
+		memcpy(&u32, &val, sizeof(u32));
+		store_u32(p, u32, be);
+		break;
+	}
+}
+
+/* Append 'frames' input frames, starting at frame 'offset', to the planar
+ * history.
+ */
+static void load_input(struct avtp_asrc *asrc, const uint8_t *in,
+				size_t in_frames, size_t offset, size_t frames)
+{
+	size_t size = asrc->sample_size;
+	size_t frame_stride, chan_stride;
+	int c;
+	size_t i;
+
+	if (asrc->flags & AVTP_ASRC_IN_PLANAR) {
+		frame_stride = size;
+		chan_stride = in_frames * size;
+	} else {
+		frame_stride = size * asrc->channels;
+		chan_stride = size;
+	}
+
+	for (c = 0; c < asrc->channels; c++) {
+		const uint8_t *src = in + c * chan_stride +
+						offset * frame_stride;
+		float *dst = asrc->hist + c * asrc->hist_len + asrc->fill;
+
+		for (i = 0; i < frames; i++, src += frame_stride)
+			dst[i] = load_sample(asrc, src);
+	}
+
+	asrc->fill += frames;
+}
+
+/* Interpolate the filter kernel for a fractional position (Q32) between
+ * two adjacent rows of the polyphase table.
+ */
+static void update_kernel(struct avtp_asrc *asrc, uint64_t frac)
+{
+	const v4sf *row0 = (const v4sf *)(asrc->coefs +
+				(frac >> ALPHA_BITS) * asrc->taps);
+	const v4sf *row1 = (const v4sf *)((const float *)row0 + asrc->taps);
+	float a = (float)(frac & ((1ULL << ALPHA_BITS) - 1)) /
+							(1ULL << ALPHA_BITS);
+	v4sf alpha = { a, a, a, a };
+	v4sf *kernel = (v4sf *)asrc->kernel;
+	uint32_t i;
+
+	for (i = 0; i < asrc->taps / 4; i++)
+		kernel[i] = row0[i] + alpha * (row1[i] - row0[i]);
+}
+
+/* The kernel is aligned, but the history window starts at an arbitrary input
+ * frame, so it is read with unaligned loads.
+ */
+static float filter(const float *kernel, const float *hist, uint32_t taps)
+{
+	const v4sf *k = (const v4sf *)kernel;
+	v4sf acc0 = { 0 }, acc1 = { 0 };
+	uint32_t i;
+
+	for (i = 0; i + 8 <= taps; i += 8) {
+		acc0 += k[i / 4] * *(const v4sf_u *)(hist + i);
+		acc1 += k[i / 4 + 1] * *(const v4sf_u *)(hist + i + 4);
+	}
+	if (i < taps)
+		acc0 += k[i / 4] * *(const v4sf_u *)(hist + i);
+
+	acc0 += acc1;
+	return (acc0[0] + acc0[2]) + (acc0[1] + acc0[3]);
+}
+
+/* Produce all output frames the history allows, starting at frame 'index'
+ * of the output buffer. Returns the number of frames produced.
+ */
+static size_t run_filter(struct avtp_asrc *asrc, uint8_t *out,
+				size_t out_frames, size_t index)
+{
+	size_t size = asrc->sample_size;
+	size_t frame_stride, chan_stride;
+	size_t count = 0;
+	uint64_t drop;
+	int c;
+
+	if (asrc->flags & AVTP_ASRC_OUT_PLANAR) {
+		frame_stride = size;
+		chan_stride = out_frames * size;
+	} else {
+		frame_stride = size * asrc->channels;
+		chan_stride = size;
+	}
+
+	while ((asrc->pos >> FRAC_BITS) + asrc->taps <= asrc->fill) {
+		size_t start = asrc->pos >> FRAC_BITS;
+		uint8_t *dst = out + (index + count) * frame_stride;
+
+		update_kernel(asrc, asrc->pos & FRAC_MASK);
+
+		for (c = 0; c < asrc->channels; c++) {
+			const float *hist = asrc->hist + c * asrc->hist_len +
+									start;
+
+			store_sample(asrc, dst + c * chan_stride,
+				filter(asrc->kernel, hist, asrc->taps));
+		}
+
+		asrc->pos += asrc->step;
+		count++;
+	}
+
+	/* Discard history which is no longer needed. */
+	drop = asrc->pos >> FRAC_BITS;
+	if (drop > asrc->fill)
+		drop = asrc->fill;
+
+	if (drop) {
+		for (c = 0; c < asrc->channels; c++) {
+			float *hist = asrc->hist + c * asrc->hist_len;
+
+			memmove(hist, hist + drop,
+				(asrc->fill - drop) * sizeof(float));
+		}
+
+		asrc->fill -= drop;
+		asrc->pos -= drop << FRAC_BITS;
+	}
+
+	return count;
+}
+
+int avtp_asrc_create(struct avtp_asrc **asrc, uint8_t in_nsr,
+			uint8_t out_nsr, uint8_t format, uint16_t channels,
+			uint32_t flags)
+{
+	uint32_t in_rate = get_rate(in_nsr);
+	uint32_t out_rate = get_rate(out_nsr);
+	uint8_t sample_size = get_sample_size(format);
+	struct avtp_asrc *a;
+	uint32_t factor;
+	double cutoff;
+	void *ptr;
+
+	if (!asrc || !in_rate || !out_rate || !sample_size || !channels)
+		return -EINVAL;
+
+	a = calloc(1, sizeof(*a));
+	if (!a)
+		return -ENOMEM;
+
+	factor = (in_rate + out_rate - 1) / out_rate;
+	a->taps = ASRC_TAPS * factor;
+	a->hist_len = a->taps + ASRC_BLOCK;
+	a->channels = channels;
+	a->format = format;
+	a->sample_size = sample_size;
+	a->flags = flags;
+	a->nominal = ((uint64_t)in_rate << FRAC_BITS) / out_rate;
+	a->step = a->nominal;
+
+	if (posix_memalign(&ptr, ASRC_ALIGN, (ASRC_PHASES + 1) * a->taps *
+							sizeof(float)))
+		goto err;
+	a->coefs = ptr;
+
+	if (posix_memalign(&ptr, ASRC_ALIGN, a->taps * sizeof(float)))
+		goto err;
+	a->kernel = ptr;
+
+	a->hist = calloc((size_t)channels * a->hist_len, sizeof(float));
+	if (!a->hist)
+		goto err;
+
+	cutoff = ASRC_CUTOFF;
+	if (out_rate < in_rate)
+		cutoff = cutoff * out_rate / in_rate;
+	init_coefs(a->coefs, a->taps, cutoff);
+
+	/* Prime the history with zeros so that the first output frame is
+	 * aligned with the first input frame.
+	 */
+	a->fill = a->taps / 2 - 1;
+
+	*asrc = a;
+	return 0;
+
+err:
+	avtp_asrc_destroy(a);
+	return -ENOMEM;
+}
+
+void avtp_asrc_destroy(struct avtp_asrc *asrc)
+{
+	if (!asrc)
+		return;
+
+	free(asrc->coefs);
+	free(asrc->kernel);
+	free(asrc->hist);
+	free(asrc);
+}
+
+int avtp_asrc_set_ratio(struct avtp_asrc *asrc, int64_t ppb)
+{
+	if (!asrc || ppb > ASRC_MAX_PPB || ppb < -ASRC_MAX_PPB)
+		return -EINVAL;
+
+	asrc->step = asrc->nominal + (int64_t)((double)asrc->nominal * ppb /
+								1e9);
+
+	return 0;
+}
+
+int avtp_asrc_get_output_frames(const struct avtp_asrc *asrc,
+				size_t in_frames, size_t *out_frames)
+{
+	uint64_t avail, limit;
+
+	if (!asrc || !out_frames || in_frames > ASRC_MAX_FRAMES)
+		return -EINVAL;
+
+	/* Output frame k is produced once the history holds
+	 * ((pos + k * step) >> 32) + taps frames.
+	 */
+	avail = asrc->fill + in_frames;
+	if (avail < asrc->taps) {
+		*out_frames = 0;
+		return 0;
+	}
+
+	limit = (avail - asrc->taps + 1) << FRAC_BITS;
+	if (limit <= asrc->pos)
+		*out_frames = 0;
+	else
+		*out_frames = (limit - asrc->pos + asrc->step - 1) /
+								asrc->step;
+
+	return 0;
+}
+
+int avtp_asrc_process(struct avtp_asrc *asrc, const void *in,
+			size_t in_frames, void *out, size_t out_frames,
+			size_t *produced)
+{
+	size_t needed, offset, count = 0;
+	int res;
+
+	if (!in || !out || !produced)
+		return -EINVAL;
+
+	res = avtp_asrc_get_output_frames(asrc, in_frames, &needed);
+	if (res < 0)
+		return res;
+
+	if (needed > out_frames)
+		return -ENOSPC;
+
+	for (offset = 0; offset < in_frames; offset += ASRC_BLOCK) {
+		size_t frames = in_frames - offset;
+
+		if (frames > ASRC_BLOCK)
+			frames = ASRC_BLOCK;
+
+		load_input(asrc, in, in_frames, offset, frames);
+		count += run_filter(asrc, out, out_frames, count);
+	}
+
+	*produced = count;
+	return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "avtp_batch.h"
+#include "probes.h"
+
+struct batch_entry {
+	size_t offset;
+	size_t len;
+	uint64_t time;
+};
+
+/* Queued payloads are stored back to back in 'buf', in queue order. Both
+ * arrays are compacted after each flush, which only moves the payloads not
+ * yet due.
+ */
+struct avtp_batch_sink {
+	int fd;
+	uint64_t window;
+
+	struct batch_entry *entries;
+	size_t max_entries;
+	size_t count;
+
+	uint8_t *buf;
+	size_t max_bytes;
+	size_t used;
+
+	/* Bytes of the first payload written by a short writev(). */
+	size_t partial;
+
+	struct avtp_batch_sink_stats stats;
+};
+
+int avtp_batch_sink_create(struct avtp_batch_sink **sink, int fd,
+				uint64_t window, size_t max_payloads,
+				size_t max_bytes)
+{
+	struct avtp_batch_sink *s;
+
+	if (!sink || fd < 0 || !max_payloads || !max_bytes)
+		return -EINVAL;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+
+	s->entries = calloc(max_payloads, sizeof(*s->entries));
+	s->buf = malloc(max_bytes);
+	if (!s->entries || !s->buf) {
+		avtp_batch_sink_destroy(s);
+		return -ENOMEM;
+	}
+
+	s->fd = fd;
+	s->window = window;
+	s->max_entries = max_payloads;
+	s->max_bytes = max_bytes;
+
+	*sink = s;
+	return 0;
+}
+
+void avtp_batch_sink_destroy(struct avtp_batch_sink *sink)
+{
+	if (!sink)
+		return;
+
+	free(sink->entries);
+	free(sink->buf);
+	free(sink);
+}
+
+int avtp_batch_sink_queue(struct avtp_batch_sink *sink, const void *data,
+						size_t len, uint64_t time)
+{
+	struct batch_entry *entry;
+
+	if (!sink || (!data && len))
+		return -EINVAL;
+
+	if (sink->count == sink->max_entries ||
+				len > sink->max_bytes - sink->used)
+		return -ENOSPC;
+
+	entry = &sink->entries[sink->count++];
+	entry->offset = sink->used;
+	entry->len = len;
+	entry->time = time;
+
+	memcpy(sink->buf + sink->used, data, len);
+	sink->used += len;
+
+	return 0;
+}
+
+int avtp_batch_sink_get_deadline(const struct avtp_batch_sink *sink,
+							uint64_t *time)
+{
+	if (!sink || !time)
+		return -EINVAL;
+
+	if (!sink->count)
+		return 0;
+
+	*time = sink->entries[0].time;
+	return 1;
+}
+
+/* Drop the first 'n' entries, which were written. */
+static void consume(struct avtp_batch_sink *sink, size_t n)
+{
+	size_t offset;
+
+	if (!n)
+		return;
+
+	sink->count -= n;
+	if (!sink->count) {
+		sink->used = 0;
+		return;
+	}
+
+	offset = sink->entries[n].offset;
+	memmove(sink->buf, sink->buf + offset, sink->used - offset);
+	sink->used -= offset;
+
+	memmove(sink->entries, sink->entries + n,
+				sink->count * sizeof(*sink->entries));
+	for (n = 0; n < sink->count; n++)
+		sink->entries[n].offset -= offset;
+}
+
+static void account(struct avtp_batch_sink *sink, size_t n, uint64_t now)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		uint64_t time = sink->entries[i].time;
+
+		AVTP_PROBE3(present, time, now, sink->entries[i].len);
+
+		if (time > now && time - now > sink->stats.max_early)
+			sink->stats.max_early = time - now;
+		if (time < now && now - time > sink->stats.max_late)
+			sink->stats.max_late = now - time;
+	}
+
+	sink->stats.payloads += n;
+}
+
+/* Write the first 'n' entries, with as many writev() calls as needed.
+ * Returns the number of entries fully written, or a negative errno if none
+ * could be.
+ */
+static ssize_t write_entries(struct avtp_batch_sink *sink, size_t n)
+{
+	struct iovec iov[AVTP_BATCH_MAX_IOV];
+	size_t done = 0;
+
+	while (done < n) {
+		size_t i, cnt = n - done;
+		ssize_t res;
+
+		if (cnt > AVTP_BATCH_MAX_IOV)
+			cnt = AVTP_BATCH_MAX_IOV;
+
+		for (i = 0; i < cnt; i++) {
+			struct batch_entry *entry = &sink->entries[done + i];
+
+			iov[i].iov_base = sink->buf + entry->offset;
+			iov[i].iov_len = entry->len;
+		}
+
+		iov[0].iov_base = (uint8_t *) iov[0].iov_base + sink->partial;
+		iov[0].iov_len -= sink->partial;
+
+		res = writev(sink->fd, iov, cnt);
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return done ? (ssize_t) done : -errno;
+		}
+
+		sink->stats.writes++;
+
+		/* Short writes leave 'partial' set for the next attempt. */
+		for (i = 0; i < cnt && (size_t) res >= iov[i].iov_len; i++) {
+			res -= iov[i].iov_len;
+			sink->partial = 0;
+		}
+
+		done += i;
+		if (i < cnt)
+			sink->partial += res;
+	}
+
+	return done;
+}
+
+int avtp_batch_sink_flush(struct avtp_batch_sink *sink, uint64_t now)
+{
+	ssize_t res;
+	size_t n;
+
+	if (!sink)
+		return -EINVAL;
+
+	for (n = 0; n < sink->count; n++) {
+		if (sink->entries[n].time > now + sink->window)
+			break;
+	}
+
+	res = write_entries(sink, n);
+	if (res <= 0)
+		return res;
+
+	account(sink, res, now);
+	consume(sink, res);
+
+	return res;
+}
+
+int avtp_batch_sink_get_stats(const struct avtp_batch_sink *sink,
+				struct avtp_batch_sink_stats *stats)
+{
+	if (!sink || !stats)
+		return -EINVAL;
+
+	*stats = sink->stats;
+	return 0;
+}
@@ -31,6 +31,7 @@
 
 #include "avtp.h"
 #include "avtp_crf.h"
+#include "probes.h"
 #include "util.h"
 
 #define SHIFT_SV			(31 - 8)
@@ -53,6 +54,17 @@
 #define MASK_CRF_DATA_LEN		(BITMASK(16) << SHIFT_CRF_DATA_LEN)
 #define MASK_TIMESTAMP_INTERVAL		(BITMASK(16))
 
+#define NSEC_PER_SEC			1000000000ULL
+#define MAX_CRF_DATA_LEN		BITMASK(16)
+
+/* Media clock servo fixed-point formats and limits. Phase errors are clamped
+ * to SERVO_MAX_ERROR so the products with Q24 gains never overflow 64 bits.
+ */
+#define SERVO_FRAC_BITS			16
+#define SERVO_GAIN_BITS			24
+#define SERVO_MAX_ERROR			(1LL << 20)
+#define SERVO_LOCK_COUNT		16
+
 static int get_field_value(const struct avtp_crf_pdu *pdu,
 				enum avtp_crf_field field, uint64_t *val)
 {
@@ -149,6 +161,9 @@ int avtp_crf_pdu_get(const struct avtp_crf_pdu *pdu,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -263,6 +278,9 @@ int avtp_crf_pdu_set(struct avtp_crf_pdu *pdu, enum avtp_crf_field field,
 		res = -EINVAL;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -284,5 +302,482 @@ int avtp_crf_pdu_init(struct avtp_crf_pdu *pdu)
 	if (res < 0)
 		return res;
 
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+/* Get the 'pull' multiplier as a num/den fraction. */
+static int get_pull_ratio(uint8_t pull, uint64_t *num, uint64_t *den)
+{
+	switch (pull) {
+	case AVTP_CRF_PULL_MULT_BY_1:
+		*num = 1;
+		*den = 1;
+		break;
+	case AVTP_CRF_PULL_MULT_BY_1_OVER_1_001:
+		*num = 1000;
+		*den = 1001;
+		break;
+	case AVTP_CRF_PULL_MULT_BY_1_001:
+		*num = 1001;
+		*den = 1000;
+		break;
+	case AVTP_CRF_PULL_MULT_BY_24_OVER_25:
+		*num = 24;
+		*den = 25;
+		break;
+	case AVTP_CRF_PULL_MULT_BY_25_OVER_24:
+		*num = 25;
+		*den = 24;
+		break;
+	case AVTP_CRF_PULL_MULT_BY_1_OVER_8:
+		*num = 1;
+		*den = 8;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Get the nominal period between two CRF timestamps as the 'period_num' /
+ * 'period_div' fraction of nanoseconds:
+ *
+ *   period = timestamp_interval / (base_freq * pull)
+ *
+ * Since timestamp_interval < 2^16, base_freq < 2^29 and pull terms are at most
+ * 1001, neither numerator nor divisor overflow 64 bits.
+ */
+static int get_period(uint8_t pull, uint32_t base_freq,
+			uint16_t timestamp_interval, uint64_t *period_num,
+			uint64_t *period_div)
+{
+	int res;
+	uint64_t num, den;
+
+	if (base_freq == 0 || base_freq > BITMASK(29) ||
+						timestamp_interval == 0)
+		return -EINVAL;
+
+	res = get_pull_ratio(pull, &num, &den);
+	if (res < 0)
+		return res;
+
+	*period_num = timestamp_interval * NSEC_PER_SEC * den;
+	*period_div = base_freq * num;
+
+	return 0;
+}
+
+int avtp_crf_gen_init(struct avtp_crf_gen *gen, uint8_t type, uint8_t pull,
+				uint32_t base_freq, uint16_t timestamp_interval,
+				uint64_t time)
+{
+	int res;
+	uint64_t num, div;
+
+	if (!gen)
+		return -EINVAL;
+
+	res = get_period(pull, base_freq, timestamp_interval, &num, &div);
+	if (res < 0)
+		return res;
+
+	memset(gen, 0, sizeof(*gen));
+	gen->time = time;
+	gen->period = num / div;
+	gen->period_rem = num % div;
+	gen->div = div;
+	gen->base_freq = base_freq;
+	gen->timestamp_interval = timestamp_interval;
+	gen->type = type;
+	gen->pull = pull;
+
+	return 0;
+}
+
+int avtp_crf_gen_pdu_init(const struct avtp_crf_gen *gen,
+						struct avtp_crf_pdu *pdu)
+{
+	int res;
+
+	if (!gen || !pdu)
+		return -EINVAL;
+
+	res = avtp_crf_pdu_init(pdu);
+	if (res < 0)
+		return res;
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_TYPE, gen->type);
+	if (res < 0)
+		return res;
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_PULL, gen->pull);
+	if (res < 0)
+		return res;
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_BASE_FREQ, gen->base_freq);
+	if (res < 0)
+		return res;
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_TIMESTAMP_INTERVAL,
+						gen->timestamp_interval);
+	if (res < 0)
+		return res;
+
+	return 0;
+}
+
+int avtp_crf_gen_fill(struct avtp_crf_gen *gen, struct avtp_crf_pdu *pdu,
+							unsigned int count)
+{
+	int res;
+	unsigned int i;
+	uint64_t time, rem;
+
+	if (!gen || !pdu || count == 0 ||
+			count > MAX_CRF_DATA_LEN / sizeof(uint64_t))
+		return -EINVAL;
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN,
+						count * sizeof(uint64_t));
+	if (res < 0)
+		return res;
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_SEQ_NUM, gen->seq_num);
+	if (res < 0)
+		return res;
+
+	/* Timestamps are generated and stored in network order in a single
+	 * pass. The fractional nanoseconds are carried over the whole list so
+	 * the generator never drifts from the nominal period.
+	 */
+	time = gen->time;
+	rem = gen->rem;
+
+	for (i = 0; i < count; i++) {
+		pdu->crf_data[i] = htobe64(time);
+
+		time += gen->period;
+		rem += gen->period_rem;
+		if (rem >= gen->div) {
+			rem -= gen->div;
+			time++;
+		}
+	}
+
+	gen->time = time;
+	gen->rem = rem;
+	gen->seq_num++;
+
+	return 0;
+}
+
+int avtp_crf_drift_init(struct avtp_crf_drift *drift)
+{
+	if (!drift)
+		return -EINVAL;
+
+	memset(drift, 0, sizeof(*drift));
+
+	return 0;
+}
+
+/* Fold the residuals of a timestamp list into the drift estimator. The
+ * residual r(i) is the difference between the i-th timestamp and its nominal
+ * position. The least squares line fitted over (i, r(i)) gives the period
+ * error (slope) and the fitted position of the first timestamp (intercept):
+ *
+ *   slope = 6 * (2 * sum(i * r(i)) - (n - 1) * sum(r(i))) / (n * (n^2 - 1))
+ *   intercept = sum(r(i)) / n - slope * (n - 1) / 2
+ *
+ * The per-PDU estimate is then smoothed with an exponential moving average.
+ */
+static void update_drift(struct avtp_crf_drift *drift, uint64_t first,
+				uint64_t period_num, uint64_t period_div,
+				double sum, double wsum, unsigned int n)
+{
+	double slope = 0, ppb;
+
+	if (n > 1) {
+		slope = 6 * (2 * wsum - (n - 1) * sum) /
+					((double) n * ((double) n * n - 1));
+	}
+
+	drift->base_time = first + (int64_t) (sum / n - slope * (n - 1) / 2);
+
+	if (n == 1)
+		return;
+
+	ppb = -slope * period_div * NSEC_PER_SEC / period_num;
+
+	if (drift->count == 0)
+		drift->ppb = ppb;
+	else
+		drift->ppb += ((int64_t) ppb - drift->ppb) / 8;
+
+	drift->count++;
+}
+
+int avtp_crf_pdu_validate(const struct avtp_crf_pdu *pdu, size_t len,
+			uint32_t tolerance, struct avtp_crf_drift *drift)
+{
+	int res;
+	unsigned int i, n;
+	uint32_t subtype;
+	uint64_t data_len, pull, base_freq, interval, mr;
+	uint64_t num, div, period, period_rem;
+	uint64_t first, prev, ts, exp, exp_rem;
+	int64_t r, prev_r;
+	double sum, wsum;
+
+	if (!pdu || len < sizeof(*pdu))
+		return -EINVAL;
+
+	res = avtp_pdu_get((const struct avtp_common_pdu *) pdu,
+						AVTP_FIELD_SUBTYPE, &subtype);
+	if (res < 0)
+		return res;
+
+	if (subtype != AVTP_SUBTYPE_CRF)
+		return -EBADMSG;
+
+	get_field_value(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN, &data_len);
+	get_field_value(pdu, AVTP_CRF_FIELD_PULL, &pull);
+	get_field_value(pdu, AVTP_CRF_FIELD_BASE_FREQ, &base_freq);
+	get_field_value(pdu, AVTP_CRF_FIELD_TIMESTAMP_INTERVAL, &interval);
+	get_field_value(pdu, AVTP_CRF_FIELD_MR, &mr);
+
+	if (data_len == 0 || data_len % sizeof(uint64_t) ||
+					data_len > len - sizeof(*pdu))
+		return -EBADMSG;
+
+	res = get_period(pull, base_freq, interval, &num, &div);
+	if (res < 0)
+		return -EBADMSG;
+
+	period = num / div;
+	period_rem = num % div;
+
+	/* Walk the list once, checking each timestamp against the previous
+	 * one and accumulating the sums needed by the least squares fit.
+	 * Nominal positions are carried as integer plus remainder so they are
+	 * exact for any list length.
+	 */
+	n = data_len / sizeof(uint64_t);
+	first = be64toh(pdu->crf_data[0]);
+	prev = first;
+	prev_r = 0;
+	exp = 0;
+	exp_rem = 0;
+	sum = 0;
+	wsum = 0;
+
+	for (i = 1; i < n; i++) {
+		ts = be64toh(pdu->crf_data[i]);
+		if (ts <= prev)
+			return -EBADMSG;
+
+		exp += period;
+		exp_rem += period_rem;
+		if (exp_rem >= div) {
+			exp_rem -= div;
+			exp++;
+		}
+
+		r = (int64_t) (ts - first - exp);
+		if (r - prev_r > tolerance || prev_r - r > tolerance)
+			return -EBADMSG;
+
+		sum += r;
+		wsum += (double) i * r;
+		prev = ts;
+		prev_r = r;
+	}
+
+	if (!drift)
+		return 0;
+
+	if (drift->count && drift->mr != mr)
+		avtp_crf_drift_init(drift);
+
+	drift->mr = mr;
+	update_drift(drift, first, num, div, sum, wsum, n);
+
+	return 0;
+}
+
+int avtp_crf_servo_init(struct avtp_crf_servo *servo, uint8_t pull,
+			uint32_t base_freq, uint16_t timestamp_interval,
+			uint32_t bandwidth, uint32_t lock_threshold,
+			uint64_t holdover_timeout)
+{
+	int res;
+	uint64_t num, div, nominal;
+	double wt, kp, ki;
+
+	if (!servo || bandwidth == 0)
+		return -EINVAL;
+
+	res = get_period(pull, base_freq, timestamp_interval, &num, &div);
+	if (res < 0)
+		return res;
+
+	nominal = ((num / div) << SERVO_FRAC_BITS) +
+			((num % div) << SERVO_FRAC_BITS) / div;
+
+	/* Loop gains for a critically damped (zeta = 1/sqrt(2)) second order
+	 * loop updated once per CRF timestamp period T:
+	 *
+	 *   Kp = 2 * zeta * wn * T
+	 *   Ki = (wn * T)^2
+	 *
+	 * Gains are only computed here, the loop itself runs in fixed-point.
+	 */
+	wt = 2 * 3.14159265358979 * bandwidth / 1000.0 *
+		nominal / (1 << SERVO_FRAC_BITS) / NSEC_PER_SEC;
+	kp = 2 * 0.70710678118655 * wt;
+	ki = wt * wt;
+
+	if (kp >= 1.0 || ki * (1 << SERVO_GAIN_BITS) < 1.0)
+		return -EINVAL;
+
+	memset(servo, 0, sizeof(*servo));
+	servo->period = nominal;
+	servo->nominal = nominal;
+	servo->kp = kp * (1 << SERVO_GAIN_BITS);
+	servo->ki = ki * (1 << SERVO_GAIN_BITS);
+	servo->holdover_timeout = holdover_timeout;
+	servo->lock_threshold = lock_threshold;
+	servo->timestamp_interval = timestamp_interval;
+	servo->state = AVTP_CRF_SERVO_UNLOCKED;
+
+	return 0;
+}
+
+static void servo_restart(struct avtp_crf_servo *servo, uint64_t timestamp)
+{
+	servo->phase = timestamp;
+	servo->phase_frac = 0;
+	servo->lock_count = 0;
+	servo->state = AVTP_CRF_SERVO_UNLOCKED;
+	servo->started = 1;
+}
+
+int avtp_crf_servo_update(struct avtp_crf_servo *servo, uint64_t timestamp,
+								uint64_t now)
+{
+	int64_t diff, err, frac;
+	uint64_t n, pred, pred_frac;
+
+	if (!servo)
+		return -EINVAL;
+
+	if (!servo->started) {
+		servo_restart(servo, timestamp);
+		servo->last_update = now;
+		return 0;
+	}
+
+	/* Coming back from holdover, lock has to be acquired again. */
+	if (now - servo->last_update > servo->holdover_timeout) {
+		servo->lock_count = 0;
+		servo->state = AVTP_CRF_SERVO_UNLOCKED;
+	}
+	servo->last_update = now;
+
+	diff = timestamp - servo->phase;
+	if (diff <= 0)
+		return 0;
+
+	if (diff >= (1LL << (63 - SERVO_FRAC_BITS))) {
+		servo_restart(servo, timestamp);
+		return 0;
+	}
+
+	/* Predict the position of the closest media clock edge and measure the
+	 * phase error against it.
+	 */
+	n = (((uint64_t) diff << SERVO_FRAC_BITS) - servo->phase_frac +
+					servo->period / 2) / servo->period;
+	if (n == 0)
+		return 0;
+
+	pred_frac = servo->phase_frac + n * servo->period;
+	pred = servo->phase + (pred_frac >> SERVO_FRAC_BITS);
+	pred_frac &= BITMASK(SERVO_FRAC_BITS);
+
+	err = (int64_t) (timestamp - pred) * (1 << SERVO_FRAC_BITS) -
+							(int64_t) pred_frac;
+	if (err > (SERVO_MAX_ERROR << SERVO_FRAC_BITS) ||
+			err < -(SERVO_MAX_ERROR << SERVO_FRAC_BITS)) {
+		servo_restart(servo, timestamp);
+		servo->phase_error = err >> SERVO_FRAC_BITS;
+		return 0;
+	}
+
+	/* Integral path steers the period, proportional path the phase. */
+	servo->period += (err * servo->ki) >> SERVO_GAIN_BITS;
+
+	frac = pred_frac + ((err * servo->kp) >> SERVO_GAIN_BITS);
+	servo->phase = pred + (frac >> SERVO_FRAC_BITS);
+	servo->phase_frac = frac & BITMASK(SERVO_FRAC_BITS);
+	servo->phase_error = err >> SERVO_FRAC_BITS;
+
+	if (servo->phase_error <= (int64_t) servo->lock_threshold &&
+		servo->phase_error >= -(int64_t) servo->lock_threshold) {
+		if (servo->lock_count < SERVO_LOCK_COUNT)
+			servo->lock_count++;
+		if (servo->lock_count == SERVO_LOCK_COUNT)
+			servo->state = AVTP_CRF_SERVO_LOCKED;
+	} else {
+		servo->lock_count = 0;
+		servo->state = AVTP_CRF_SERVO_UNLOCKED;
+	}
+
+	return 0;
+}
+
+int avtp_crf_servo_get_time(const struct avtp_crf_servo *servo,
+					uint64_t events, uint64_t *time)
+{
+	uint64_t q, r, offset;
+
+	if (!servo || !time || !servo->started)
+		return -EINVAL;
+
+	/* Split 'events' in whole CRF periods plus remaining events so the
+	 * products below don't overflow for any sane number of events.
+	 */
+	q = events / servo->timestamp_interval;
+	r = events % servo->timestamp_interval;
+
+	offset = servo->phase_frac + q * servo->period +
+		(servo->period / servo->timestamp_interval) * r +
+		(servo->period % servo->timestamp_interval) * r /
+						servo->timestamp_interval;
+
+	*time = servo->phase + (offset >> SERVO_FRAC_BITS);
+
+	return 0;
+}
+
+int avtp_crf_servo_get_status(const struct avtp_crf_servo *servo,
+			uint64_t now, struct avtp_crf_servo_status *status)
+{
+	if (!servo || !status)
+		return -EINVAL;
+
+	status->state = servo->state;
+	if (servo->state == AVTP_CRF_SERVO_LOCKED &&
+			now - servo->last_update > servo->holdover_timeout)
+		status->state = AVTP_CRF_SERVO_HOLDOVER;
+
+	status->phase_error = servo->phase_error;
+	status->ppb = ((double) servo->nominal - servo->period) *
+					NSEC_PER_SEC / servo->period;
+
 	return 0;
 }
@@ -31,6 +31,7 @@
 #include "avtp.h"
 #include "avtp_cvf.h"
 #include "avtp_stream.h"
+#include "probes.h"
 #include "util.h"
 
 #define SHIFT_FORMAT		(31 - 7)
@@ -127,6 +128,9 @@ int avtp_cvf_pdu_get(const struct avtp_stream_pdu *pdu,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -217,6 +221,9 @@ int avtp_cvf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_cvf_field field,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -249,5 +256,7 @@ int avtp_cvf_pdu_init(struct avtp_stream_pdu *pdu, uint8_t subtype)
 	if (res < 0)
 		return res;
 
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
 	return 0;
 }
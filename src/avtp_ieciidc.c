@@ -32,6 +32,8 @@
 #include "avtp.h"
 #include "avtp_ieciidc.h"
 #include "avtp_stream.h"
+#include "probes.h"
+#include "simd.h"
 #include "util.h"
 
 #define SHIFT_GV			(31 - 14)
@@ -76,6 +78,53 @@
 #define MASK_NO_DATA			(BITMASK(8) << SHIFT_NO_DATA)
 #define MASK_ND				(BITMASK(1) << SHIFT_ND)
 
+#define NSEC_PER_SEC			1000000000ULL
+
+/* IEC 61883-4 CIP header values. A source packet is split into 8 data blocks
+ * (fn 3) of 6 quadlets each.
+ */
+#define TS_SID				63
+#define TS_CHANNEL			31
+#define TS_DBS				6
+#define TS_FN				3
+#define TS_BLOCKS_PER_SP		(1 << TS_FN)
+#define TS_FMT				0x20
+#define TS_QI_2				2U
+
+/* IEC 61883-6 AM824 CIP header values. */
+#define AM824_FMT			0x10
+#define AM824_QI_2			2U
+#define AM824_NO_DATA			0xFF
+#define AM824_NO_INFO			0xFFFF
+
+/* IEC 61883-8 CIP header values. */
+#define VIDEO_FMT			0x01
+#define VIDEO_QI_2			2U
+
+/* 'syt' is expressed in IEEE 1394 cycle time: a 4-bit cycle count and a
+ * 12-bit offset in ticks of 24.576 MHz, 3072 ticks per 125 us cycle.
+ */
+#define SYT_TICKS_PER_CYCLE		3072
+#define SYT_NSEC_PER_CYCLE		125000
+#define SYT_CYCLES			16
+
+/* AM824 quadlets are built and parsed with plain shifts and masks so that
+ * they map onto vector operations, with no byte swap. AM824_QUADLET() turns
+ * a 24-bit sample into a quadlet already in network order, and
+ * AM824_SAMPLE() returns the sample of a quadlet in network order, left
+ * justified in 32 bits.
+ */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define AM824_QUADLET(s, label)		((label) | (((s) >> 8) & 0xff00) | \
+					(((s) << 8) & 0xff0000) | ((s) << 24))
+#define AM824_SAMPLE(q)			((((q) & 0xff00) << 16) | \
+					((q) & 0xff0000) | \
+					(((q) >> 16) & 0xff00))
+#else
+#define AM824_QUADLET(s, label)		(((label) << 24) | ((s) & 0xffffff))
+#define AM824_SAMPLE(q)			((q) << 8)
+#endif
+
 static int get_field_value(const struct avtp_stream_pdu *pdu,
 				enum avtp_ieciidc_field field, uint64_t *val)
 {
@@ -252,6 +301,9 @@ int avtp_ieciidc_pdu_get(const struct avtp_stream_pdu *pdu,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -436,6 +488,9 @@ int avtp_ieciidc_pdu_set(struct avtp_stream_pdu *pdu,
 		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -466,5 +521,1048 @@ int avtp_ieciidc_pdu_init(struct avtp_stream_pdu *pdu, uint8_t tag)
 	if (res < 0)
 		return res;
 
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+/* Per-packet CIP fields, in the 64-bit big endian view of both quadlets. */
+#define CIP_MASK_DBC			(BITMASK(8) << 32)
+#define CIP_MASK_FDF_SYT		BITMASK(24)
+#define CIP_SHIFT_DBC			32
+#define CIP_SHIFT_FDF			16
+
+/* Build a CIP header template from both CIP quadlets in host order. */
+static void init_cip(struct avtp_ieciidc_cip *cip, uint32_t cip_1,
+							uint32_t cip_2)
+{
+	uint64_t header = (uint64_t) cip_1 << 32 | cip_2;
+
+	cip->header = htobe64(header & ~(CIP_MASK_DBC | CIP_MASK_FDF_SYT));
+}
+
+int avtp_ieciidc_ts_pktzr_init(struct avtp_ieciidc_ts_pktzr *pktzr,
+				uint64_t bitrate, size_t max_pdu_size,
+				uint64_t time)
+{
+	uint64_t bits = AVTP_IECIIDC_TS_PACKET_LEN * 8 * NSEC_PER_SEC;
+	size_t header = sizeof(struct avtp_stream_pdu) +
+						AVTP_IECIIDC_CIP_HEADER_LEN;
+	uint32_t cip_1 = 0, cip_2 = 0;
+	size_t max_packets;
+
+	if (!pktzr || bitrate == 0 || bitrate > bits ||
+			max_pdu_size < header + AVTP_IECIIDC_TS_SP_LEN)
+		return -EINVAL;
+
+	/* 'stream_data_length' is a 16-bit field. */
+	max_packets = (max_pdu_size - header) / AVTP_IECIIDC_TS_SP_LEN;
+	if (max_packets > (BITMASK(16) - AVTP_IECIIDC_CIP_HEADER_LEN) /
+						AVTP_IECIIDC_TS_SP_LEN)
+		max_packets = (BITMASK(16) - AVTP_IECIIDC_CIP_HEADER_LEN) /
+						AVTP_IECIIDC_TS_SP_LEN;
+
+	memset(pktzr, 0, sizeof(*pktzr));
+	pktzr->time = time;
+	pktzr->period = bits / bitrate;
+	pktzr->period_rem = bits % bitrate;
+	pktzr->bitrate = bitrate;
+	pktzr->max_packets = max_packets;
+
+	BITMAP_SET_VALUE(cip_1, TS_SID, MASK_SID, SHIFT_SID);
+	BITMAP_SET_VALUE(cip_1, TS_DBS, MASK_DBS, SHIFT_DBS);
+	BITMAP_SET_VALUE(cip_1, TS_FN, MASK_FN, SHIFT_FN);
+	BITMAP_SET_VALUE(cip_1, 1, MASK_SPH, SHIFT_SPH);
+	BITMAP_SET_VALUE(cip_2, TS_QI_2, MASK_QI_2, SHIFT_QI_2);
+	BITMAP_SET_VALUE(cip_2, TS_FMT, MASK_FMT, SHIFT_FMT);
+	init_cip(&pktzr->cip, cip_1, cip_2);
+
+	return 0;
+}
+
+int avtp_ieciidc_ts_pktzr_pdu_init(const struct avtp_ieciidc_ts_pktzr *pktzr,
+						struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!pktzr || !pdu)
+		return -EINVAL;
+
+	res = avtp_ieciidc_pdu_init(pdu, AVTP_IECIIDC_TAG_CIP);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CHANNEL,
+								TS_CHANNEL);
+	if (res < 0)
+		return res;
+
+	return avtp_ieciidc_cip_write(&pktzr->cip, pdu, 0, 0, 0);
+}
+
+int avtp_ieciidc_ts_pktzr_fill(struct avtp_ieciidc_ts_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, const void *data,
+				size_t len, size_t *pdu_len)
+{
+	struct avtp_ieciidc_cip_payload *pay;
+	const uint8_t *src = data;
+	uint8_t *dst;
+	unsigned int i, count;
+	uint64_t time, rem;
+	size_t data_len;
+	int res;
+
+	if (!pktzr || !pdu || !data || !pdu_len ||
+					len < AVTP_IECIIDC_TS_PACKET_LEN)
+		return -EINVAL;
+
+	count = len / AVTP_IECIIDC_TS_PACKET_LEN;
+	if (count > pktzr->max_packets)
+		count = pktzr->max_packets;
+
+	data_len = AVTP_IECIIDC_CIP_HEADER_LEN +
+					count * AVTP_IECIIDC_TS_SP_LEN;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+								data_len);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM,
+							pktzr->seq_num);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_cip_write(&pktzr->cip, pdu, pktzr->dbc, 0, 0);
+	if (res < 0)
+		return res;
+
+	pay = (struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	dst = pay->cip_data_payload;
+	time = pktzr->time;
+	rem = pktzr->rem;
+
+	for (i = 0; i < count; i++) {
+		/* The SPH timestamp carries the lower 32 bits of the
+		 * presentation time, as the AVTP timestamp does.
+		 */
+		put_unaligned_be32((uint32_t) time, dst);
+		memcpy(dst + sizeof(uint32_t), src,
+						AVTP_IECIIDC_TS_PACKET_LEN);
+
+		dst += AVTP_IECIIDC_TS_SP_LEN;
+		src += AVTP_IECIIDC_TS_PACKET_LEN;
+
+		time += pktzr->period;
+		rem += pktzr->period_rem;
+		if (rem >= pktzr->bitrate) {
+			rem -= pktzr->bitrate;
+			time++;
+		}
+	}
+
+	pktzr->time = time;
+	pktzr->rem = rem;
+	pktzr->dbc += count * TS_BLOCKS_PER_SP;
+	pktzr->seq_num++;
+
+	*pdu_len = sizeof(struct avtp_stream_pdu) + data_len;
+
+	return count;
+}
+
+int avtp_ieciidc_ts_pktzr_get_time(const struct avtp_ieciidc_ts_pktzr *pktzr,
+							uint64_t *time)
+{
+	if (!pktzr || !time)
+		return -EINVAL;
+
+	*time = pktzr->time;
+
+	return 0;
+}
+
+int avtp_ieciidc_ts_dpktzr_init(struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				void *data, uint64_t *times,
+				unsigned int capacity)
+{
+	if (!dpktzr || !data || !times || capacity == 0 ||
+					(capacity & (capacity - 1)))
+		return -EINVAL;
+
+	memset(dpktzr, 0, sizeof(*dpktzr));
+	dpktzr->data = data;
+	dpktzr->times = times;
+	dpktzr->capacity = capacity;
+
+	return 0;
+}
+
+/* Check the PDU is an IEC 61883-4 AVTPDU carrying whole source packets and
+ * return the number of source packets in it, or a negative error code.
+ */
+static int validate_ts_pdu(const struct avtp_stream_pdu *pdu, size_t len)
+{
+	const struct avtp_ieciidc_cip_payload *pay;
+	uint32_t cip_1, cip_2, subtype;
+	uint64_t data_len, tag;
+	int res;
+
+	if (len < sizeof(*pdu) + AVTP_IECIIDC_CIP_HEADER_LEN)
+		return -EBADMSG;
+
+	res = avtp_pdu_get((const struct avtp_common_pdu *) pdu,
+					AVTP_FIELD_SUBTYPE, &subtype);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TAG, &tag);
+	if (res < 0)
+		return res;
+
+	if (subtype != AVTP_SUBTYPE_61883_IIDC || tag != AVTP_IECIIDC_TAG_CIP)
+		return -EBADMSG;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+								&data_len);
+	if (res < 0)
+		return res;
+
+	if (data_len < AVTP_IECIIDC_CIP_HEADER_LEN ||
+			sizeof(*pdu) + data_len > len ||
+			(data_len - AVTP_IECIIDC_CIP_HEADER_LEN) %
+						AVTP_IECIIDC_TS_SP_LEN)
+		return -EBADMSG;
+
+	pay = (const struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	cip_1 = get_unaligned_be32(&pay->cip_1);
+	cip_2 = get_unaligned_be32(&pay->cip_2);
+
+	if (BITMAP_GET_VALUE(cip_1, MASK_DBS, SHIFT_DBS) != TS_DBS ||
+			BITMAP_GET_VALUE(cip_1, MASK_FN, SHIFT_FN) != TS_FN ||
+			BITMAP_GET_VALUE(cip_1, MASK_SPH, SHIFT_SPH) != 1 ||
+			BITMAP_GET_VALUE(cip_2, MASK_FMT, SHIFT_FMT) != TS_FMT)
+		return -EBADMSG;
+
+	return (data_len - AVTP_IECIIDC_CIP_HEADER_LEN) /
+						AVTP_IECIIDC_TS_SP_LEN;
+}
+
+int avtp_ieciidc_ts_dpktzr_push(struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				uint64_t now)
+{
+	const struct avtp_ieciidc_cip_payload *pay;
+	unsigned int i, mask, queued;
+	const uint8_t *sp;
+	uint64_t last = 0, seq;
+	uint8_t dbc;
+	int count;
+
+	if (!dpktzr || !pdu)
+		return -EINVAL;
+
+	count = validate_ts_pdu(pdu, len);
+	if (count < 0)
+		return count;
+
+	AVTP_PROBE4(rx_pdu, probe_stream_id(pdu), probe_seq_num(pdu),
+						probe_avtp_time(pdu), count);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM, &seq);
+
+	pay = (const struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	dbc = BITMAP_GET_VALUE(get_unaligned_be32(&pay->cip_1), MASK_DBC, 0);
+
+	/* 'dbc' counts data blocks, 8 per source packet, modulo 256, so a
+	 * burst loss of 16 or more packets looks like a step back. A PDU is
+	 * only taken as a duplicate, or as overtaken by the next one, if its
+	 * 'sequence_num' doesn't move forward either: its packets were then
+	 * either queued already or accounted as lost. Any other
+	 * discontinuity is loss, and tracking resyncs to the PDU.
+	 */
+	if (dpktzr->started) {
+		if ((int8_t)(dbc - dpktzr->expected_dbc) < 0 &&
+				(int8_t)(seq - dpktzr->seq_num) <= 0)
+			return 0;
+
+		dpktzr->lost += (uint8_t)(dbc - dpktzr->expected_dbc) /
+							TS_BLOCKS_PER_SP;
+	}
+
+	dpktzr->expected_dbc = dbc + count * TS_BLOCKS_PER_SP;
+	dpktzr->seq_num = seq;
+	dpktzr->started = 1;
+
+	queued = dpktzr->head - dpktzr->tail;
+	if (dpktzr->capacity - queued < (unsigned int) count) {
+		dpktzr->dropped += count;
+		return -ENOSPC;
+	}
+
+	mask = dpktzr->capacity - 1;
+	if (queued)
+		last = dpktzr->times[(dpktzr->head - 1) & mask];
+
+	sp = pay->cip_data_payload;
+
+	for (i = 0; i < (unsigned int) count; i++) {
+		unsigned int idx = dpktzr->head & mask;
+		uint32_t sph = get_unaligned_be32(sp);
+		uint64_t time;
+
+		/* The SPH timestamp holds the lower 32 bits of the
+		 * presentation time. Pick the time closest to 'now', which
+		 * works for early and late packets alike as long as they are
+		 * within 2^31 ns (about 2 seconds).
+		 */
+		time = now + (int32_t)(sph - (uint32_t) now);
+		if (time < last)
+			time = last;
+
+		dpktzr->times[idx] = time;
+		memcpy(dpktzr->data + idx * AVTP_IECIIDC_TS_PACKET_LEN,
+				sp + sizeof(uint32_t),
+				AVTP_IECIIDC_TS_PACKET_LEN);
+
+		last = time;
+		sp += AVTP_IECIIDC_TS_SP_LEN;
+		dpktzr->head++;
+	}
+
+	dpktzr->packets += count;
+
+	AVTP_PROBE2(jb_enqueue, last, dpktzr->head - dpktzr->tail);
+
+	return count;
+}
+
+int avtp_ieciidc_ts_dpktzr_front(const struct avtp_ieciidc_ts_dpktzr *dpktzr,
+							uint64_t *time)
+{
+	if (!dpktzr || !time)
+		return -EINVAL;
+
+	if (dpktzr->head == dpktzr->tail)
+		return -ENODATA;
+
+	*time = dpktzr->times[dpktzr->tail & (dpktzr->capacity - 1)];
+
+	return 0;
+}
+
+int avtp_ieciidc_ts_dpktzr_peek(const struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				uint64_t now, const void **data)
+{
+	unsigned int mask, start, count = 0;
+
+	if (!dpktzr || !data)
+		return -EINVAL;
+
+	mask = dpktzr->capacity - 1;
+	start = dpktzr->tail & mask;
+
+	/* Stop at the end of the ring so the run is contiguous. */
+	while (dpktzr->tail + count != dpktzr->head &&
+			start + count < dpktzr->capacity &&
+			dpktzr->times[start + count] <= now)
+		count++;
+
+	*data = dpktzr->data + start * AVTP_IECIIDC_TS_PACKET_LEN;
+
+	return count;
+}
+
+int avtp_ieciidc_ts_dpktzr_pop(struct avtp_ieciidc_ts_dpktzr *dpktzr,
+							unsigned int count)
+{
+	if (!dpktzr || count > dpktzr->head - dpktzr->tail)
+		return -EINVAL;
+
+	AVTP_PROBE3(jb_dequeue,
+		count ? dpktzr->times[dpktzr->tail & (dpktzr->capacity - 1)] : 0,
+		count, dpktzr->head - dpktzr->tail - count);
+
+	dpktzr->tail += count;
+
+	return 0;
+}
+
+int avtp_ieciidc_ts_dpktzr_get_stats(
+				const struct avtp_ieciidc_ts_dpktzr *dpktzr,
+				struct avtp_ieciidc_ts_dpktzr_stats *stats)
+{
+	if (!dpktzr || !stats)
+		return -EINVAL;
+
+	stats->packets = dpktzr->packets;
+	stats->lost = dpktzr->lost;
+	stats->dropped = dpktzr->dropped;
+
+	return 0;
+}
+
+static uint32_t get_sfc_rate(uint8_t sfc)
+{
+	switch (sfc) {
+	case AVTP_IECIIDC_SFC_32KHZ:
+		return 32000;
+	case AVTP_IECIIDC_SFC_44_1KHZ:
+		return 44100;
+	case AVTP_IECIIDC_SFC_48KHZ:
+		return 48000;
+	case AVTP_IECIIDC_SFC_88_2KHZ:
+		return 88200;
+	case AVTP_IECIIDC_SFC_96KHZ:
+		return 96000;
+	case AVTP_IECIIDC_SFC_176_4KHZ:
+		return 176400;
+	case AVTP_IECIIDC_SFC_192KHZ:
+		return 192000;
+	default:
+		return 0;
+	}
+}
+
+static uint8_t get_syt_interval(uint8_t sfc)
+{
+	if (sfc <= AVTP_IECIIDC_SFC_48KHZ)
+		return 8;
+	if (sfc <= AVTP_IECIIDC_SFC_96KHZ)
+		return 16;
+
+	return 32;
+}
+
+static uint16_t get_syt(uint64_t time)
+{
+	uint64_t ticks = time % (SYT_CYCLES * SYT_NSEC_PER_CYCLE) *
+				SYT_TICKS_PER_CYCLE / SYT_NSEC_PER_CYCLE;
+
+	return (ticks / SYT_TICKS_PER_CYCLE) << 12 |
+					(ticks % SYT_TICKS_PER_CYCLE);
+}
+
+/* The AM824 kernels convert four samples at a time. PCM buffers and PDU
+ * payloads have no particular alignment, so they are accessed with unaligned
+ * loads and stores.
+ */
+static void pack_am824_16(uint8_t *dst, const int16_t *src, size_t n)
+{
+	const uint32_t label = AVTP_IECIIDC_AM824_LABEL_MBLA_16BIT;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		v4su s = { (uint32_t) src[i], (uint32_t) src[i + 1],
+				(uint32_t) src[i + 2], (uint32_t) src[i + 3] };
+
+		s <<= 8;
+		*(v4su_u *)(dst + i * 4) = AM824_QUADLET(s, label);
+	}
+
+	for (; i < n; i++) {
+		uint32_t s = (uint32_t) src[i] << 8;
+		uint32_t q = AM824_QUADLET(s, label);
+
+		memcpy(dst + i * 4, &q, sizeof(q));
+	}
+}
+
+static void pack_am824_24(uint8_t *dst, const int32_t *src, size_t n)
+{
+	const uint32_t label = AVTP_IECIIDC_AM824_LABEL_MBLA_24BIT;
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		v4su s = (v4su) *(const v4si_u *)(src + i);
+
+		*(v4su_u *)(dst + i * 4) = AM824_QUADLET(s, label);
+	}
+
+	for (; i < n; i++) {
+		uint32_t s = src[i];
+		uint32_t q = AM824_QUADLET(s, label);
+
+		memcpy(dst + i * 4, &q, sizeof(q));
+	}
+}
+
+static void unpack_am824_16(int16_t *dst, const uint8_t *src, size_t n)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		v4su q = *(const v4su_u *)(src + i * 4);
+		v4si s = (v4si) AM824_SAMPLE(q) >> 16;
+
+		dst[i] = s[0];
+		dst[i + 1] = s[1];
+		dst[i + 2] = s[2];
+		dst[i + 3] = s[3];
+	}
+
+	for (; i < n; i++) {
+		uint32_t q;
+
+		memcpy(&q, src + i * 4, sizeof(q));
+		dst[i] = (int32_t) AM824_SAMPLE(q) >> 16;
+	}
+}
+
+static void unpack_am824_24(int32_t *dst, const uint8_t *src, size_t n)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		v4su q = *(const v4su_u *)(src + i * 4);
+
+		*(v4si_u *)(dst + i) = (v4si) AM824_SAMPLE(q) >> 8;
+	}
+
+	for (; i < n; i++) {
+		uint32_t q;
+
+		memcpy(&q, src + i * 4, sizeof(q));
+		dst[i] = (int32_t) AM824_SAMPLE(q) >> 8;
+	}
+}
+
+int avtp_ieciidc_am824_init(struct avtp_ieciidc_am824 *am824, uint8_t sfc,
+				uint16_t channels, uint8_t bits, int blocking,
+				uint64_t time)
+{
+	uint32_t rate = get_sfc_rate(sfc);
+	uint32_t cip_1 = 0, cip_2 = 0;
+
+	if (!am824 || !rate || channels == 0 || channels > BITMASK(8) ||
+						(bits != 16 && bits != 24))
+		return -EINVAL;
+
+	memset(am824, 0, sizeof(*am824));
+	am824->time = time;
+	am824->period = NSEC_PER_SEC / rate;
+	am824->period_rem = NSEC_PER_SEC % rate;
+	am824->rate = rate;
+	am824->channels = channels;
+	am824->sfc = sfc;
+	am824->bits = bits;
+	am824->syt_interval = get_syt_interval(sfc);
+	am824->blocking = !!blocking;
+
+	BITMAP_SET_VALUE(cip_1, TS_SID, MASK_SID, SHIFT_SID);
+	BITMAP_SET_VALUE(cip_1, (uint32_t) channels, MASK_DBS, SHIFT_DBS);
+	BITMAP_SET_VALUE(cip_2, AM824_QI_2, MASK_QI_2, SHIFT_QI_2);
+	BITMAP_SET_VALUE(cip_2, AM824_FMT, MASK_FMT, SHIFT_FMT);
+	init_cip(&am824->cip, cip_1, cip_2);
+
+	return 0;
+}
+
+int avtp_ieciidc_am824_pdu_init(const struct avtp_ieciidc_am824 *am824,
+						struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!am824 || !pdu)
+		return -EINVAL;
+
+	res = avtp_ieciidc_pdu_init(pdu, AVTP_IECIIDC_TAG_CIP);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CHANNEL,
+								TS_CHANNEL);
+	if (res < 0)
+		return res;
+
+	return avtp_ieciidc_cip_write(&am824->cip, pdu, 0, am824->sfc,
+								AM824_NO_INFO);
+}
+
+int avtp_ieciidc_am824_pack(struct avtp_ieciidc_am824 *am824,
+				struct avtp_stream_pdu *pdu, const void *pcm,
+				unsigned int frames, size_t *pdu_len)
+{
+	struct avtp_ieciidc_cip_payload *pay;
+	uint64_t syt_time = 0;
+	uint32_t syt = AM824_NO_INFO;
+	size_t samples, data_len;
+	unsigned int offset;
+	int syt_valid = 0;
+	int res;
+
+	if (!am824 || !pdu || !pdu_len || (frames && !pcm))
+		return -EINVAL;
+
+	if (am824->blocking && frames && frames != am824->syt_interval)
+		return -EINVAL;
+
+	samples = (size_t) frames * am824->channels;
+	data_len = AVTP_IECIIDC_CIP_HEADER_LEN + samples * sizeof(uint32_t);
+	if (data_len > BITMASK(16))
+		return -EINVAL;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+								data_len);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM,
+							am824->seq_num++);
+	if (res < 0)
+		return res;
+
+	/* 'syt' refers to the first data block in the packet which starts
+	 * a SYT interval, if any. In blocking mode that's always the first
+	 * one.
+	 */
+	offset = (am824->syt_interval -
+			am824->dbc % am824->syt_interval) %
+							am824->syt_interval;
+	if (offset < frames) {
+		syt_time = am824->time + offset * am824->period +
+			(am824->rem + offset * am824->period_rem) /
+								am824->rate;
+		syt = get_syt(syt_time);
+		syt_valid = 1;
+	}
+
+	/* FDF is EVT 0 (AM824), N 0 and 'sfc', or NO-DATA. */
+	res = avtp_ieciidc_cip_write(&am824->cip, pdu, am824->dbc,
+				frames ? am824->sfc : AM824_NO_DATA, syt);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TV, syt_valid);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TIMESTAMP,
+						syt_valid ? (uint32_t) syt_time : 0);
+	if (res < 0)
+		return res;
+
+	pay = (struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	if (am824->bits == 16)
+		pack_am824_16(pay->cip_data_payload, pcm, samples);
+	else
+		pack_am824_24(pay->cip_data_payload, pcm, samples);
+
+	/* Advance time by 'frames' sample periods. */
+	am824->time += frames * am824->period;
+	am824->rem += frames * am824->period_rem;
+	am824->time += am824->rem / am824->rate;
+	am824->rem %= am824->rate;
+	am824->dbc += frames;
+
+	*pdu_len = sizeof(struct avtp_stream_pdu) + data_len;
+
+	return 0;
+}
+
+int avtp_ieciidc_am824_unpack(const struct avtp_stream_pdu *pdu, size_t len,
+				uint8_t bits, unsigned int channels, void *pcm,
+				unsigned int max_frames)
+{
+	const struct avtp_ieciidc_cip_payload *pay;
+	uint32_t cip_1, cip_2, dbs, subtype;
+	uint64_t data_len, tag;
+	size_t samples;
+	int res;
+
+	if (!pdu || !pcm || (bits != 16 && bits != 24) || channels == 0 ||
+						channels > BITMASK(8))
+		return -EINVAL;
+
+	if (len < sizeof(*pdu) + AVTP_IECIIDC_CIP_HEADER_LEN)
+		return -EBADMSG;
+
+	res = avtp_pdu_get((const struct avtp_common_pdu *) pdu,
+					AVTP_FIELD_SUBTYPE, &subtype);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TAG, &tag);
+	if (res < 0)
+		return res;
+
+	if (subtype != AVTP_SUBTYPE_61883_IIDC || tag != AVTP_IECIIDC_TAG_CIP)
+		return -EBADMSG;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+								&data_len);
+	if (res < 0)
+		return res;
+
+	pay = (const struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	cip_1 = get_unaligned_be32(&pay->cip_1);
+	cip_2 = get_unaligned_be32(&pay->cip_2);
+	dbs = BITMAP_GET_VALUE(cip_1, MASK_DBS, SHIFT_DBS);
+
+	/* 'pcm' is sized for 'channels', so a PDU with a different data
+	 * block size belongs to some other stream.
+	 */
+	if (BITMAP_GET_VALUE(cip_2, MASK_FMT, SHIFT_FMT) != AM824_FMT ||
+			dbs != channels ||
+			data_len < AVTP_IECIIDC_CIP_HEADER_LEN ||
+			sizeof(*pdu) + data_len > len)
+		return -EBADMSG;
+
+	if (BITMAP_GET_VALUE(cip_2, MASK_NO_DATA, SHIFT_NO_DATA) ==
+								AM824_NO_DATA)
+		return 0;
+
+	samples = (data_len - AVTP_IECIIDC_CIP_HEADER_LEN) / sizeof(uint32_t);
+	if (BITMAP_GET_VALUE(cip_2, MASK_EVT, SHIFT_EVT) != 0 ||
+			(data_len - AVTP_IECIIDC_CIP_HEADER_LEN) %
+						(dbs * sizeof(uint32_t)))
+		return -EBADMSG;
+
+	if (samples / dbs > max_frames)
+		return -ENOSPC;
+
+	if (bits == 16)
+		unpack_am824_16(pcm, pay->cip_data_payload, samples);
+	else
+		unpack_am824_24(pcm, pay->cip_data_payload, samples);
+
+	return samples / dbs;
+}
+
+int avtp_ieciidc_video_init(struct avtp_ieciidc_video *video, uint8_t dbs,
+				size_t line_len, unsigned int height,
+				size_t max_pdu_size)
+{
+	size_t header = sizeof(struct avtp_stream_pdu) +
+						AVTP_IECIIDC_CIP_HEADER_LEN;
+	size_t block_len = dbs * sizeof(uint32_t);
+	uint32_t cip_1 = 0, cip_2 = 0;
+	size_t max_blocks;
+
+	if (!video || dbs == 0 || line_len == 0 || line_len % block_len ||
+			height == 0 || max_pdu_size < header + block_len)
+		return -EINVAL;
+
+	/* 'dbc' is 8-bit, so a lost packet of more than 255 data blocks
+	 * would leave the depacketizer unable to tell where the next one
+	 * goes.
+	 */
+	max_blocks = (max_pdu_size - header) / block_len;
+	if (max_blocks > UINT8_MAX)
+		max_blocks = UINT8_MAX;
+
+	memset(video, 0, sizeof(*video));
+	video->line_len = line_len;
+	video->block_len = block_len;
+	video->frame_blocks = (uint64_t) line_len * height / block_len;
+	video->height = height;
+	video->max_blocks = max_blocks;
+	video->dbs = dbs;
+
+	BITMAP_SET_VALUE(cip_1, TS_SID, MASK_SID, SHIFT_SID);
+	BITMAP_SET_VALUE(cip_1, (uint32_t) dbs, MASK_DBS, SHIFT_DBS);
+	BITMAP_SET_VALUE(cip_2, VIDEO_QI_2, MASK_QI_2, SHIFT_QI_2);
+	BITMAP_SET_VALUE(cip_2, VIDEO_FMT, MASK_FMT, SHIFT_FMT);
+	init_cip(&video->cip, cip_1, cip_2);
+
+	return 0;
+}
+
+int avtp_ieciidc_video_pdu_init(const struct avtp_ieciidc_video *video,
+						struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!video || !pdu)
+		return -EINVAL;
+
+	res = avtp_ieciidc_pdu_init(pdu, AVTP_IECIIDC_TAG_CIP);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CHANNEL,
+								TS_CHANNEL);
+	if (res < 0)
+		return res;
+
+	return avtp_ieciidc_cip_write(&video->cip, pdu, 0, 0, 0);
+}
+
+int avtp_ieciidc_video_pack(struct avtp_ieciidc_video *video,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_ieciidc_video_frame *frame,
+				struct iovec *iov, unsigned int iovcnt,
+				int *end_of_frame)
+{
+	uint64_t pos, blocks;
+	size_t bytes;
+	unsigned int i;
+	int res;
+
+	if (!video || !pdu || !frame || !frame->data || !iov || iovcnt < 2 ||
+							!end_of_frame)
+		return -EINVAL;
+
+	blocks = video->frame_blocks - video->block;
+	if (blocks > video->max_blocks)
+		blocks = video->max_blocks;
+
+	/* Gather the data blocks straight from the frame buffer, one entry
+	 * per line. Lines are made of whole data blocks, so running out of
+	 * entries still leaves a whole number of blocks.
+	 */
+	pos = video->block * video->block_len;
+	bytes = blocks * video->block_len;
+
+	for (i = 1; i < iovcnt && bytes; i++) {
+		size_t line = pos / video->line_len;
+		size_t offset = pos % video->line_len;
+		size_t chunk = video->line_len - offset;
+
+		if (chunk > bytes)
+			chunk = bytes;
+
+		iov[i].iov_base = frame->data + line * frame->stride + offset;
+		iov[i].iov_len = chunk;
+
+		pos += chunk;
+		bytes -= chunk;
+	}
+
+	blocks -= bytes / video->block_len;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+			AVTP_IECIIDC_CIP_HEADER_LEN + blocks * video->block_len);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM,
+							video->seq_num++);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_SY,
+							video->block == 0);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_cip_write(&video->cip, pdu, video->dbc, 0, 0);
+	if (res < 0)
+		return res;
+
+	iov[0].iov_base = pdu;
+	iov[0].iov_len = sizeof(struct avtp_stream_pdu) +
+						AVTP_IECIIDC_CIP_HEADER_LEN;
+
+	video->dbc += blocks;
+	video->block += blocks;
+
+	*end_of_frame = video->block == video->frame_blocks;
+	if (*end_of_frame)
+		video->block = 0;
+
+	return i;
+}
+
+int avtp_ieciidc_video_unpack(struct avtp_ieciidc_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				const struct avtp_ieciidc_video_frame *frame)
+{
+	const struct avtp_ieciidc_cip_payload *pay;
+	uint32_t cip_1, cip_2, subtype;
+	uint64_t data_len, tag, sy, seq, blocks, pos;
+	uint8_t dbc, missing, gap;
+	const uint8_t *src;
+	size_t bytes;
+	int res;
+
+	if (!video || !pdu || !frame || !frame->data)
+		return -EINVAL;
+
+	if (len < sizeof(*pdu) + AVTP_IECIIDC_CIP_HEADER_LEN)
+		return -EBADMSG;
+
+	res = avtp_pdu_get((const struct avtp_common_pdu *) pdu,
+					AVTP_FIELD_SUBTYPE, &subtype);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TAG, &tag);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+								&data_len);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SY, &sy);
+	if (res < 0)
+		return res;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM, &seq);
+	if (res < 0)
+		return res;
+
+	pay = (const struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	cip_1 = get_unaligned_be32(&pay->cip_1);
+	cip_2 = get_unaligned_be32(&pay->cip_2);
+
+	if (subtype != AVTP_SUBTYPE_61883_IIDC ||
+			tag != AVTP_IECIIDC_TAG_CIP ||
+			BITMAP_GET_VALUE(cip_2, MASK_FMT, SHIFT_FMT) !=
+								VIDEO_FMT ||
+			BITMAP_GET_VALUE(cip_1, MASK_DBS, SHIFT_DBS) !=
+								video->dbs ||
+			data_len < AVTP_IECIIDC_CIP_HEADER_LEN ||
+			sizeof(*pdu) + data_len > len ||
+			(data_len - AVTP_IECIIDC_CIP_HEADER_LEN) %
+							video->block_len)
+		return -EBADMSG;
+
+	dbc = BITMAP_GET_VALUE(cip_1, MASK_DBC, 0);
+	blocks = (data_len - AVTP_IECIIDC_CIP_HEADER_LEN) / video->block_len;
+
+	/* Lost blocks are skipped over, so following packets still land on
+	 * the right spot of the frame. 'dbc' only gives their number modulo
+	 * 256, so it's trusted as long as the packets lost, according to
+	 * 'sequence_num', can't hold 256 blocks or more. Otherwise packets
+	 * are dropped until the next frame starts.
+	 */
+	if (video->synced) {
+		missing = seq - video->seq_num;
+		gap = dbc - video->dbc;
+
+		if ((!missing && gap) ||
+				missing * video->max_blocks > UINT8_MAX) {
+			video->synced = 0;
+		} else {
+			video->lost += gap;
+			video->block += gap;
+		}
+	}
+
+	video->dbc = dbc + blocks;
+	video->seq_num = seq + 1;
+
+	if (BITMAP_GET_VALUE(cip_2, MASK_ND, SHIFT_ND))
+		return 0;
+
+	if (sy) {
+		video->block = 0;
+		video->synced = 1;
+	}
+
+	if (!video->synced)
+		return 0;
+
+	if (video->block + blocks > video->frame_blocks) {
+		/* Either too many blocks were lost to tell the position or
+		 * the frame is longer than expected. Wait for the next one.
+		 */
+		video->synced = 0;
+		return -EBADMSG;
+	}
+
+	pos = video->block * video->block_len;
+	bytes = blocks * video->block_len;
+	src = pay->cip_data_payload;
+
+	while (bytes) {
+		size_t line = pos / video->line_len;
+		size_t offset = pos % video->line_len;
+		size_t chunk = video->line_len - offset;
+
+		if (chunk > bytes)
+			chunk = bytes;
+
+		memcpy(frame->data + line * frame->stride + offset, src,
+									chunk);
+
+		src += chunk;
+		pos += chunk;
+		bytes -= chunk;
+	}
+
+	video->block += blocks;
+	if (video->block < video->frame_blocks)
+		return 0;
+
+	video->block = 0;
+
+	return 1;
+}
+
+int avtp_ieciidc_video_get_lost(const struct avtp_ieciidc_video *video,
+							uint64_t *lost)
+{
+	if (!video || !lost)
+		return -EINVAL;
+
+	*lost = video->lost;
+
+	return 0;
+}
+
+int avtp_ieciidc_cip_init(struct avtp_ieciidc_cip *cip,
+					const struct avtp_stream_pdu *pdu)
+{
+	uint64_t header, tag;
+	int res;
+
+	if (!cip || !pdu)
+		return -EINVAL;
+
+	res = avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TAG, &tag);
+	if (res < 0)
+		return res;
+
+	if (tag != AVTP_IECIIDC_TAG_CIP)
+		return -EINVAL;
+
+	memcpy(&header, pdu->avtp_payload, sizeof(header));
+	cip->header = header & ~htobe64(CIP_MASK_DBC | CIP_MASK_FDF_SYT);
+
+	return 0;
+}
+
+int avtp_ieciidc_cip_write(const struct avtp_ieciidc_cip *cip,
+				struct avtp_stream_pdu *pdu, uint8_t dbc,
+				uint8_t fdf, uint16_t syt)
+{
+	uint64_t header;
+
+	if (!cip || !pdu)
+		return -EINVAL;
+
+	header = cip->header | htobe64((uint64_t) dbc << CIP_SHIFT_DBC |
+					(uint32_t) fdf << CIP_SHIFT_FDF | syt);
+	memcpy(pdu->avtp_payload, &header, sizeof(header));
+
+	return 0;
+}
+
+int avtp_ieciidc_cip_write_batch(const struct avtp_ieciidc_cip *cip,
+				struct avtp_stream_pdu *const pdus[],
+				unsigned int count, uint8_t dbc,
+				uint8_t dbc_step, uint8_t fdf,
+				const uint16_t *syt)
+{
+	uint64_t fdf_syt = (uint32_t) fdf << CIP_SHIFT_FDF;
+	unsigned int i;
+
+	if (!cip || !pdus)
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		uint64_t header;
+
+		header = cip->header | htobe64((uint64_t) dbc << CIP_SHIFT_DBC |
+				fdf_syt | (syt ? syt[i] : AM824_NO_INFO));
+		memcpy(pdus[i]->avtp_payload, &header, sizeof(header));
+
+		dbc += dbc_step;
+	}
+
 	return 0;
 }
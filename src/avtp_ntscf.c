@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <string.h>
+
+#include "avtp.h"
+#include "avtp_ntscf.h"
+#include "avtp_acf_pack.h"
+#include "probes.h"
+#include "util.h"
+
+#define SHIFT_SV			(31 - 8)
+#define SHIFT_DATA_LEN			(31 - 23)
+
+#define MASK_SV				(BITMASK(1) << SHIFT_SV)
+#define MASK_DATA_LEN			(BITMASK(11) << SHIFT_DATA_LEN)
+#define MASK_SEQ_NUM			(BITMASK(8))
+
+static int get_field_mask(enum avtp_ntscf_field field, uint32_t *mask,
+							uint8_t *shift)
+{
+	switch (field) {
+	case AVTP_NTSCF_FIELD_SV:
+		*mask = MASK_SV;
+		*shift = SHIFT_SV;
+		break;
+	case AVTP_NTSCF_FIELD_DATA_LEN:
+		*mask = MASK_DATA_LEN;
+		*shift = SHIFT_DATA_LEN;
+		break;
+	case AVTP_NTSCF_FIELD_SEQ_NUM:
+		*mask = MASK_SEQ_NUM;
+		*shift = 0;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int avtp_ntscf_pdu_get(const struct avtp_ntscf_pdu *pdu,
+				enum avtp_ntscf_field field, uint64_t *val)
+{
+	uint32_t bitmap, mask;
+	uint8_t shift;
+	int res;
+
+	if (!pdu || !val)
+		return -EINVAL;
+
+	if (field == AVTP_NTSCF_FIELD_STREAM_ID) {
+		*val = be64toh(pdu->stream_id);
+		return 0;
+	}
+
+	res = get_field_mask(field, &mask, &shift);
+	if (res < 0) {
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+		return res;
+	}
+
+	bitmap = ntohl(pdu->subtype_data);
+
+	*val = BITMAP_GET_VALUE(bitmap, mask, shift);
+
+	return 0;
+}
+
+int avtp_ntscf_pdu_set(struct avtp_ntscf_pdu *pdu,
+				enum avtp_ntscf_field field, uint64_t val)
+{
+	uint32_t bitmap, mask;
+	uint8_t shift;
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	if (field == AVTP_NTSCF_FIELD_STREAM_ID) {
+		pdu->stream_id = htobe64(val);
+		return 0;
+	}
+
+	res = get_field_mask(field, &mask, &shift);
+	if (res < 0) {
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+		return res;
+	}
+
+	bitmap = ntohl(pdu->subtype_data);
+
+	BITMAP_SET_VALUE(bitmap, val, mask, shift);
+
+	pdu->subtype_data = htonl(bitmap);
+
+	return 0;
+}
+
+int avtp_ntscf_pdu_init(struct avtp_ntscf_pdu *pdu)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	memset(pdu, 0, sizeof(struct avtp_ntscf_pdu));
+
+	res = avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_NTSCF);
+	if (res < 0)
+		return res;
+
+	res = avtp_ntscf_pdu_set(pdu, AVTP_NTSCF_FIELD_SV, 1);
+	if (res < 0)
+		return res;
+
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+int avtp_ntscf_pktzr_init(struct avtp_ntscf_pktzr *pktzr, size_t max_pdu_size,
+							uint64_t latency)
+{
+	size_t max_data_len;
+
+	if (!pktzr)
+		return -EINVAL;
+
+	max_data_len = avtp_acf_pack_get_max_len(max_pdu_size,
+				sizeof(struct avtp_ntscf_pdu),
+				AVTP_NTSCF_MAX_DATA_LEN);
+	if (!max_data_len)
+		return -EINVAL;
+
+	memset(pktzr, 0, sizeof(*pktzr));
+	pktzr->max_data_len = max_data_len;
+	pktzr->latency = latency;
+
+	return 0;
+}
+
+int avtp_ntscf_pktzr_pack_can(struct avtp_ntscf_pktzr *pktzr,
+				struct avtp_ntscf_pdu *pdu, uint8_t type,
+				const struct avtp_acf_can *msgs,
+				unsigned int count, uint64_t now)
+{
+	unsigned int i;
+
+	if (!pktzr || !pdu || (!msgs && count))
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		ssize_t n;
+
+		n = avtp_acf_pack_can(pdu->acf_msgs, &pktzr->data_len,
+					pktzr->max_data_len, &msgs[i], type);
+		if (n == 0)
+			break;
+		if (n < 0)
+			return i ? (int) i : n;
+
+		if (pktzr->count == 0)
+			pktzr->deadline = now + pktzr->latency;
+
+		pktzr->count++;
+	}
+
+	return i;
+}
+
+int avtp_ntscf_pktzr_get_deadline(const struct avtp_ntscf_pktzr *pktzr,
+							uint64_t *deadline)
+{
+	if (!pktzr || !deadline)
+		return -EINVAL;
+
+	if (pktzr->count == 0)
+		return -ENODATA;
+
+	*deadline = pktzr->deadline;
+
+	return 0;
+}
+
+int avtp_ntscf_pktzr_flush(struct avtp_ntscf_pktzr *pktzr,
+				struct avtp_ntscf_pdu *pdu, size_t *pdu_len)
+{
+	unsigned int count;
+	int res;
+
+	if (!pktzr || !pdu || !pdu_len)
+		return -EINVAL;
+
+	if (pktzr->count == 0)
+		return -ENODATA;
+
+	res = avtp_ntscf_pdu_set(pdu, AVTP_NTSCF_FIELD_DATA_LEN,
+							pktzr->data_len);
+	if (res < 0)
+		return res;
+
+	res = avtp_ntscf_pdu_set(pdu, AVTP_NTSCF_FIELD_SEQ_NUM,
+							pktzr->seq_num++);
+	if (res < 0)
+		return res;
+
+	*pdu_len = sizeof(struct avtp_ntscf_pdu) + pktzr->data_len;
+	count = pktzr->count;
+
+	pktzr->data_len = 0;
+	pktzr->count = 0;
+
+	return count;
+}
+
+int avtp_ntscf_iter_init(struct avtp_acf_iter *iter,
+				const struct avtp_ntscf_pdu *pdu, size_t len)
+{
+	uint32_t subtype;
+	uint64_t data_len;
+
+	if (!iter || !pdu)
+		return -EINVAL;
+
+	if (len < sizeof(struct avtp_ntscf_pdu))
+		return -EBADMSG;
+
+	avtp_pdu_get((const struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+								&subtype);
+	if (subtype != AVTP_SUBTYPE_NTSCF)
+		return -EBADMSG;
+
+	avtp_ntscf_pdu_get(pdu, AVTP_NTSCF_FIELD_DATA_LEN, &data_len);
+	if (data_len > len - sizeof(struct avtp_ntscf_pdu))
+		return -EBADMSG;
+
+	return avtp_acf_iter_init(iter, pdu->acf_msgs, data_len);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdlib.h>
+
+#include "avtp_policy.h"
+
+/* Furthest a timestamp can be from 'now' and still be resolved to a single
+ * wrap.
+ */
+#define MAX_DELTA		(1ULL << 31)
+
+struct avtp_policy {
+	uint64_t max_transit_time;
+	uint64_t tolerance;
+
+	enum avtp_policy_action actions[AVTP_POLICY_CLASS_MAX];
+	uint64_t counts[AVTP_POLICY_CLASS_MAX];
+};
+
+int avtp_policy_create(struct avtp_policy **policy, uint64_t max_transit_time,
+							uint64_t tolerance)
+{
+	struct avtp_policy *p;
+
+	if (!policy || max_transit_time >= MAX_DELTA ||
+			tolerance >= (MAX_DELTA - max_transit_time) / 2)
+		return -EINVAL;
+
+	p = calloc(1, sizeof(*p));
+	if (!p)
+		return -ENOMEM;
+
+	p->max_transit_time = max_transit_time;
+	p->tolerance = tolerance;
+	p->actions[AVTP_POLICY_CLASS_ON_TIME] = AVTP_POLICY_ACTION_SCHEDULE;
+	p->actions[AVTP_POLICY_CLASS_LATE] = AVTP_POLICY_ACTION_PRESENT_NOW;
+	p->actions[AVTP_POLICY_CLASS_EARLY] = AVTP_POLICY_ACTION_DROP;
+	p->actions[AVTP_POLICY_CLASS_WRAPPED] = AVTP_POLICY_ACTION_DROP;
+
+	*policy = p;
+	return 0;
+}
+
+void avtp_policy_destroy(struct avtp_policy *policy)
+{
+	free(policy);
+}
+
+int avtp_policy_set_action(struct avtp_policy *policy,
+				enum avtp_policy_class pdu_class,
+				enum avtp_policy_action action)
+{
+	if (!policy || pdu_class >= AVTP_POLICY_CLASS_MAX ||
+					action >= AVTP_POLICY_ACTION_MAX)
+		return -EINVAL;
+
+	policy->actions[pdu_class] = action;
+	return 0;
+}
+
+int avtp_policy_classify(struct avtp_policy *policy, uint32_t avtp_time,
+				uint64_t now, uint64_t *time,
+				enum avtp_policy_action *action)
+{
+	enum avtp_policy_class pdu_class;
+	int64_t delta, early, late, wrap;
+
+	if (!policy || !time || !action)
+		return -EINVAL;
+
+	/* Offset of the presentation time from 'now', picking the wrap
+	 * nearest to 'now'.
+	 */
+	delta = (int32_t) (avtp_time - (uint32_t) now);
+
+	late = -(int64_t) policy->tolerance;
+	early = policy->max_transit_time + policy->tolerance;
+
+	/* Within one acceptance window of half a wrap away from 'now', the
+	 * timestamp may as well belong to the other wrap.
+	 */
+	wrap = MAX_DELTA - policy->max_transit_time - 2 * policy->tolerance;
+
+	if (delta >= wrap || delta <= -wrap)
+		pdu_class = AVTP_POLICY_CLASS_WRAPPED;
+	else if (delta > early)
+		pdu_class = AVTP_POLICY_CLASS_EARLY;
+	else if (delta >= late)
+		pdu_class = AVTP_POLICY_CLASS_ON_TIME;
+	else
+		pdu_class = AVTP_POLICY_CLASS_LATE;
+
+	policy->counts[pdu_class]++;
+	*action = policy->actions[pdu_class];
+
+	switch (*action) {
+	case AVTP_POLICY_ACTION_SCHEDULE:
+	case AVTP_POLICY_ACTION_DROP:
+		*time = now + delta;
+		break;
+	default:
+		*time = now;
+		break;
+	}
+
+	return pdu_class;
+}
+
+int avtp_policy_get_count(const struct avtp_policy *policy,
+				enum avtp_policy_class pdu_class,
+				uint64_t *count)
+{
+	if (!policy || pdu_class >= AVTP_POLICY_CLASS_MAX || !count)
+		return -EINVAL;
+
+	*count = policy->counts[pdu_class];
+	return 0;
+}
@@ -0,0 +1,924 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <string.h>
+
+#include "avtp.h"
+#include "avtp_rvf.h"
+#include "avtp_stream.h"
+#include "probes.h"
+#include "simd.h"
+#include "util.h"
+
+#define SHIFT_ACTIVE_PIXELS		(31 - 15)
+#define SHIFT_TOTAL_LINES		(31 - 31)
+#define SHIFT_AP			(31 - 16)
+#define SHIFT_F				(31 - 18)
+#define SHIFT_EF			(31 - 19)
+#define SHIFT_EVT			(31 - 23)
+#define SHIFT_PD			(31 - 24)
+#define SHIFT_I				(31 - 25)
+#define SHIFT_PIXEL_DEPTH		(31 - 3)
+#define SHIFT_PIXEL_FORMAT		(31 - 7)
+#define SHIFT_FRAME_RATE		(31 - 15)
+#define SHIFT_COLORSPACE		(31 - 19)
+#define SHIFT_NUM_LINES			(31 - 23)
+#define SHIFT_I_SEQ_NUM			(31 - 15)
+#define SHIFT_LINE_NUMBER		(31 - 31)
+
+#define MASK_ACTIVE_PIXELS		(BITMASK(16) << SHIFT_ACTIVE_PIXELS)
+#define MASK_TOTAL_LINES		(BITMASK(16) << SHIFT_TOTAL_LINES)
+#define MASK_AP				(BITMASK(1) << SHIFT_AP)
+#define MASK_F				(BITMASK(1) << SHIFT_F)
+#define MASK_EF				(BITMASK(1) << SHIFT_EF)
+#define MASK_EVT			(BITMASK(4) << SHIFT_EVT)
+#define MASK_PD				(BITMASK(1) << SHIFT_PD)
+#define MASK_I				(BITMASK(1) << SHIFT_I)
+#define MASK_PIXEL_DEPTH		(BITMASK(4) << SHIFT_PIXEL_DEPTH)
+#define MASK_PIXEL_FORMAT		(BITMASK(4) << SHIFT_PIXEL_FORMAT)
+#define MASK_FRAME_RATE			(BITMASK(8) << SHIFT_FRAME_RATE)
+#define MASK_COLORSPACE			(BITMASK(4) << SHIFT_COLORSPACE)
+#define MASK_NUM_LINES			(BITMASK(4) << SHIFT_NUM_LINES)
+#define MASK_I_SEQ_NUM			(BITMASK(8) << SHIFT_I_SEQ_NUM)
+#define MASK_LINE_NUMBER		(BITMASK(16) << SHIFT_LINE_NUMBER)
+
+#define RVF_MAX_LINES_PER_PDU		15
+#define RVF_HEADER_LEN			(sizeof(struct avtp_stream_pdu) + \
+						AVTP_RVF_RAW_HEADER_LEN)
+
+/* 8-bit 4:2:2 pgroup (Cb Y0 Cr Y1) as a 32-bit word in host order, bytes
+ * in wire order.
+ */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define PG_422_8(cb, y0, cr, y1)	((cb) | (y0) << 8 | (cr) << 16 | \
+								(y1) << 24)
+#define PG_422_8_CB(w)			((w) & 0xFF)
+#define PG_422_8_Y0(w)			(((w) >> 8) & 0xFF)
+#define PG_422_8_CR(w)			(((w) >> 16) & 0xFF)
+#define PG_422_8_Y1(w)			((w) >> 24)
+#else
+#define PG_422_8(cb, y0, cr, y1)	((cb) << 24 | (y0) << 16 | \
+							(cr) << 8 | (y1))
+#define PG_422_8_CB(w)			((w) >> 24)
+#define PG_422_8_Y0(w)			(((w) >> 16) & 0xFF)
+#define PG_422_8_CR(w)			(((w) >> 8) & 0xFF)
+#define PG_422_8_Y1(w)			((w) & 0xFF)
+#endif
+
+/* 10-bit 4:2:2 pgroup (Cb Y0 Cr Y1, 10 bits each, 5 bytes) in the 40 least
+ * significant bits of a 64-bit word.
+ */
+#define PG_422_10(cb, y0, cr, y1)	(((cb) & 0x3FF) << 30 | \
+					((y0) & 0x3FF) << 20 | \
+					((cr) & 0x3FF) << 10 | ((y1) & 0x3FF))
+
+typedef void (*pack_fn_t)(const struct avtp_rvf_frame *frame,
+				unsigned int line, size_t pg, size_t count,
+				uint8_t *dst);
+typedef void (*unpack_fn_t)(const struct avtp_rvf_frame *frame,
+				unsigned int line, size_t pg, size_t count,
+				const uint8_t *src);
+
+struct pgroup_format {
+	uint8_t pixel_format;
+	uint8_t pixel_depth;
+	uint8_t len;
+	uint8_t pixels;
+	/* Kernels built for SHUFFLE_TARGET, only picked if has_shuffle(). */
+	uint8_t shuffle;
+	pack_fn_t pack;
+	unpack_fn_t unpack;
+};
+
+static int get_field_desc(enum avtp_rvf_field field, size_t *offset,
+					uint32_t *mask, uint8_t *shift)
+{
+	const size_t raw_header = offsetof(struct avtp_stream_pdu, avtp_payload);
+
+	switch (field) {
+	case AVTP_RVF_FIELD_ACTIVE_PIXELS:
+		*mask = MASK_ACTIVE_PIXELS;
+		*shift = SHIFT_ACTIVE_PIXELS;
+		*offset = offsetof(struct avtp_stream_pdu, format_specific);
+		break;
+	case AVTP_RVF_FIELD_TOTAL_LINES:
+		*mask = MASK_TOTAL_LINES;
+		*shift = SHIFT_TOTAL_LINES;
+		*offset = offsetof(struct avtp_stream_pdu, format_specific);
+		break;
+	case AVTP_RVF_FIELD_AP:
+		*mask = MASK_AP;
+		*shift = SHIFT_AP;
+		*offset = offsetof(struct avtp_stream_pdu, packet_info);
+		break;
+	case AVTP_RVF_FIELD_F:
+		*mask = MASK_F;
+		*shift = SHIFT_F;
+		*offset = offsetof(struct avtp_stream_pdu, packet_info);
+		break;
+	case AVTP_RVF_FIELD_EF:
+		*mask = MASK_EF;
+		*shift = SHIFT_EF;
+		*offset = offsetof(struct avtp_stream_pdu, packet_info);
+		break;
+	case AVTP_RVF_FIELD_EVT:
+		*mask = MASK_EVT;
+		*shift = SHIFT_EVT;
+		*offset = offsetof(struct avtp_stream_pdu, packet_info);
+		break;
+	case AVTP_RVF_FIELD_PD:
+		*mask = MASK_PD;
+		*shift = SHIFT_PD;
+		*offset = offsetof(struct avtp_stream_pdu, packet_info);
+		break;
+	case AVTP_RVF_FIELD_I:
+		*mask = MASK_I;
+		*shift = SHIFT_I;
+		*offset = offsetof(struct avtp_stream_pdu, packet_info);
+		break;
+	case AVTP_RVF_FIELD_PIXEL_DEPTH:
+		*mask = MASK_PIXEL_DEPTH;
+		*shift = SHIFT_PIXEL_DEPTH;
+		*offset = raw_header;
+		break;
+	case AVTP_RVF_FIELD_PIXEL_FORMAT:
+		*mask = MASK_PIXEL_FORMAT;
+		*shift = SHIFT_PIXEL_FORMAT;
+		*offset = raw_header;
+		break;
+	case AVTP_RVF_FIELD_FRAME_RATE:
+		*mask = MASK_FRAME_RATE;
+		*shift = SHIFT_FRAME_RATE;
+		*offset = raw_header;
+		break;
+	case AVTP_RVF_FIELD_COLORSPACE:
+		*mask = MASK_COLORSPACE;
+		*shift = SHIFT_COLORSPACE;
+		*offset = raw_header;
+		break;
+	case AVTP_RVF_FIELD_NUM_LINES:
+		*mask = MASK_NUM_LINES;
+		*shift = SHIFT_NUM_LINES;
+		*offset = raw_header;
+		break;
+	case AVTP_RVF_FIELD_I_SEQ_NUM:
+		*mask = MASK_I_SEQ_NUM;
+		*shift = SHIFT_I_SEQ_NUM;
+		*offset = raw_header + sizeof(uint32_t);
+		break;
+	case AVTP_RVF_FIELD_LINE_NUMBER:
+		*mask = MASK_LINE_NUMBER;
+		*shift = SHIFT_LINE_NUMBER;
+		*offset = raw_header + sizeof(uint32_t);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int avtp_rvf_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_rvf_field field, uint64_t *val)
+{
+	uint32_t bitmap, mask;
+	uint8_t shift;
+	size_t offset;
+	int res;
+
+	if (!pdu || !val)
+		return -EINVAL;
+
+	switch (field) {
+	case AVTP_RVF_FIELD_SV:
+	case AVTP_RVF_FIELD_MR:
+	case AVTP_RVF_FIELD_TV:
+	case AVTP_RVF_FIELD_SEQ_NUM:
+	case AVTP_RVF_FIELD_TU:
+	case AVTP_RVF_FIELD_STREAM_DATA_LEN:
+	case AVTP_RVF_FIELD_TIMESTAMP:
+	case AVTP_RVF_FIELD_STREAM_ID:
+		return avtp_stream_pdu_get(pdu, (enum avtp_stream_field) field,
+									val);
+	default:
+		res = get_field_desc(field, &offset, &mask, &shift);
+		if (res < 0) {
+			AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+			return res;
+		}
+	}
+
+	bitmap = get_unaligned_be32((const uint8_t *) pdu + offset);
+
+	*val = BITMAP_GET_VALUE(bitmap, mask, shift);
+
+	return 0;
+}
+
+int avtp_rvf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_rvf_field field,
+								uint64_t val)
+{
+	uint32_t bitmap, mask;
+	uint8_t shift;
+	size_t offset;
+	void *ptr;
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	switch (field) {
+	case AVTP_RVF_FIELD_SV:
+	case AVTP_RVF_FIELD_MR:
+	case AVTP_RVF_FIELD_TV:
+	case AVTP_RVF_FIELD_SEQ_NUM:
+	case AVTP_RVF_FIELD_TU:
+	case AVTP_RVF_FIELD_STREAM_DATA_LEN:
+	case AVTP_RVF_FIELD_TIMESTAMP:
+	case AVTP_RVF_FIELD_STREAM_ID:
+		return avtp_stream_pdu_set(pdu, (enum avtp_stream_field) field,
+									val);
+	default:
+		res = get_field_desc(field, &offset, &mask, &shift);
+		if (res < 0) {
+			AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+			return res;
+		}
+	}
+
+	ptr = (uint8_t *) pdu + offset;
+	bitmap = get_unaligned_be32(ptr);
+
+	BITMAP_SET_VALUE(bitmap, val, mask, shift);
+
+	put_unaligned_be32(bitmap, ptr);
+
+	return 0;
+}
+
+int avtp_rvf_pdu_init(struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	memset(pdu, 0, RVF_HEADER_LEN);
+
+	res = avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_RVF);
+	if (res < 0)
+		return res;
+
+	res = avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_SV, 1);
+	if (res < 0)
+		return res;
+
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+static inline const uint8_t *row8(const struct avtp_rvf_frame *frame,
+					unsigned int plane, unsigned int line)
+{
+	return (const uint8_t *) frame->planes[plane] +
+					line * frame->strides[plane];
+}
+
+static inline const uint16_t *row16(const struct avtp_rvf_frame *frame,
+					unsigned int plane, unsigned int line)
+{
+	return (const uint16_t *) row8(frame, plane, line);
+}
+
+static inline void put_be64(uint64_t val, uint8_t *dst)
+{
+	val = htobe64(val);
+	memcpy(dst, &val, sizeof(val));
+}
+
+static inline uint64_t get_be64(const uint8_t *src)
+{
+	uint64_t val;
+
+	memcpy(&val, src, sizeof(val));
+	return be64toh(val);
+}
+
+/* Each vector lane holds one pgroup, which is assembled in a register and
+ * written with one unaligned store.
+ */
+static void pack_422_8(const struct avtp_rvf_frame *frame, unsigned int line,
+				size_t pg, size_t count, uint8_t *dst)
+{
+	const uint8_t *y = row8(frame, 0, line) + pg * 2;
+	const uint8_t *cb = row8(frame, 1, line) + pg;
+	const uint8_t *cr = row8(frame, 2, line) + pg;
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		const uint8_t *yp = y + i * 2;
+		v4su y0 = { yp[0], yp[2], yp[4], yp[6] };
+		v4su y1 = { yp[1], yp[3], yp[5], yp[7] };
+		v4su vcb = { cb[i], cb[i + 1], cb[i + 2], cb[i + 3] };
+		v4su vcr = { cr[i], cr[i + 1], cr[i + 2], cr[i + 3] };
+
+		*(v4su_u *)(dst + i * 4) = PG_422_8(vcb, y0, vcr, y1);
+	}
+
+	for (; i < count; i++) {
+		dst[i * 4] = cb[i];
+		dst[i * 4 + 1] = y[i * 2];
+		dst[i * 4 + 2] = cr[i];
+		dst[i * 4 + 3] = y[i * 2 + 1];
+	}
+}
+
+static void unpack_422_8(const struct avtp_rvf_frame *frame, unsigned int line,
+				size_t pg, size_t count, const uint8_t *src)
+{
+	uint8_t *y = (uint8_t *) row8(frame, 0, line) + pg * 2;
+	uint8_t *cb = (uint8_t *) row8(frame, 1, line) + pg;
+	uint8_t *cr = (uint8_t *) row8(frame, 2, line) + pg;
+	size_t i;
+	int k;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		v4su w = *(const v4su_u *)(src + i * 4);
+		v4su vcb = PG_422_8_CB(w);
+		v4su y0 = PG_422_8_Y0(w);
+		v4su vcr = PG_422_8_CR(w);
+		v4su y1 = PG_422_8_Y1(w);
+
+		for (k = 0; k < 4; k++) {
+			cb[i + k] = vcb[k];
+			cr[i + k] = vcr[k];
+			y[(i + k) * 2] = y0[k];
+			y[(i + k) * 2 + 1] = y1[k];
+		}
+	}
+
+	for (; i < count; i++) {
+		cb[i] = src[i * 4];
+		y[i * 2] = src[i * 4 + 1];
+		cr[i] = src[i * 4 + 2];
+		y[i * 2 + 1] = src[i * 4 + 3];
+	}
+}
+
+/* 10-bit pgroups are 5 bytes long, so they are written and read with 8-byte
+ * accesses that overlap the next pgroup. The vector loops stop one pgroup
+ * early so they never touch memory past the last one.
+ */
+static void pack_422_10(const struct avtp_rvf_frame *frame, unsigned int line,
+				size_t pg, size_t count, uint8_t *dst)
+{
+	const uint16_t *y = row16(frame, 0, line) + pg * 2;
+	const uint16_t *cb = row16(frame, 1, line) + pg;
+	const uint16_t *cr = row16(frame, 2, line) + pg;
+	size_t i;
+	int k;
+
+	for (i = 0; i + 4 < count; i += 4) {
+		const uint16_t *yp = y + i * 2;
+		v4du y0 = { yp[0], yp[2], yp[4], yp[6] };
+		v4du y1 = { yp[1], yp[3], yp[5], yp[7] };
+		v4du vcb = { cb[i], cb[i + 1], cb[i + 2], cb[i + 3] };
+		v4du vcr = { cr[i], cr[i + 1], cr[i + 2], cr[i + 3] };
+		v4du w = PG_422_10(vcb, y0, vcr, y1) << 24;
+
+		for (k = 0; k < 4; k++)
+			put_be64(w[k], dst + (i + k) * 5);
+	}
+
+	for (; i < count; i++) {
+		uint64_t w = PG_422_10((uint64_t) cb[i], (uint64_t) y[i * 2],
+				(uint64_t) cr[i], (uint64_t) y[i * 2 + 1]);
+
+		for (k = 0; k < 5; k++)
+			dst[i * 5 + k] = w >> (32 - 8 * k);
+	}
+}
+
+static void unpack_422_10(const struct avtp_rvf_frame *frame,
+				unsigned int line, size_t pg, size_t count,
+				const uint8_t *src)
+{
+	uint16_t *y = (uint16_t *) row16(frame, 0, line) + pg * 2;
+	uint16_t *cb = (uint16_t *) row16(frame, 1, line) + pg;
+	uint16_t *cr = (uint16_t *) row16(frame, 2, line) + pg;
+	size_t i;
+	int k;
+
+	for (i = 0; i + 4 < count; i += 4) {
+		v4du w = {
+			get_be64(src + i * 5), get_be64(src + (i + 1) * 5),
+			get_be64(src + (i + 2) * 5),
+			get_be64(src + (i + 3) * 5),
+		};
+		v4du vcb, y0, vcr, y1;
+
+		w >>= 24;
+		vcb = (w >> 30) & 0x3FF;
+		y0 = (w >> 20) & 0x3FF;
+		vcr = (w >> 10) & 0x3FF;
+		y1 = w & 0x3FF;
+
+		for (k = 0; k < 4; k++) {
+			cb[i + k] = vcb[k];
+			cr[i + k] = vcr[k];
+			y[(i + k) * 2] = y0[k];
+			y[(i + k) * 2 + 1] = y1[k];
+		}
+	}
+
+	for (; i < count; i++) {
+		uint64_t w = 0;
+
+		for (k = 0; k < 5; k++)
+			w = w << 8 | src[i * 5 + k];
+
+		cb[i] = (w >> 30) & 0x3FF;
+		y[i * 2] = (w >> 20) & 0x3FF;
+		cr[i] = (w >> 10) & 0x3FF;
+		y[i * 2 + 1] = w & 0x3FF;
+	}
+}
+
+/* 8-bit 4:4:4 pixels are 3 bytes long. 16 pixels, i.e. 48 bytes, are
+ * interleaved or deinterleaved at a time with byte shuffles: three-input
+ * shuffles are done in two steps, first picking from two inputs and then
+ * filling the remaining bytes from the third one. On x86 byte shuffles need
+ * SSSE3 (PSHUFB), without it GCC expands them byte by byte, so the vector
+ * loops are built for SSSE3 and only picked by avtp_rvf_video_init() if the
+ * CPU supports it.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define SHUFFLE_TARGET		__attribute__((target("ssse3")))
+
+static int has_shuffle(void)
+{
+	__builtin_cpu_init();
+
+	return __builtin_cpu_supports("ssse3");
+}
+#else
+#define SHUFFLE_TARGET
+
+static int has_shuffle(void)
+{
+	return 1;
+}
+#endif
+
+static const v16qu pack_444_8_masks[3][2] = {
+	{
+		{ 0, 16, 0, 1, 17, 0, 2, 18, 0, 3, 19, 0, 4, 20, 0, 5 },
+		{ 0, 1, 16, 3, 4, 17, 6, 7, 18, 9, 10, 19, 12, 13, 20, 15 },
+	},
+	{
+		{ 21, 0, 6, 22, 0, 7, 23, 0, 8, 24, 0, 9, 25, 0, 10, 26 },
+		{ 0, 21, 2, 3, 22, 5, 6, 23, 8, 9, 24, 11, 12, 25, 14, 15 },
+	},
+	{
+		{ 0, 11, 27, 0, 12, 28, 0, 13, 29, 0, 14, 30, 0, 15, 31, 0 },
+		{ 26, 1, 2, 27, 4, 5, 28, 7, 8, 29, 10, 11, 30, 13, 14, 31 },
+	},
+};
+
+static const v16qu unpack_444_8_masks[3][2] = {
+	{
+		{ 0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30, 0, 0, 0, 0, 0 },
+		{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 17, 20, 23, 26, 29 },
+	},
+	{
+		{ 1, 4, 7, 10, 13, 16, 19, 22, 25, 28, 31, 0, 0, 0, 0, 0 },
+		{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 18, 21, 24, 27, 30 },
+	},
+	{
+		{ 2, 5, 8, 11, 14, 17, 20, 23, 26, 29, 0, 0, 0, 0, 0, 0 },
+		{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 16, 19, 22, 25, 28, 31 },
+	},
+};
+
+static void pack_444_8_tail(const uint8_t *c0, const uint8_t *c1,
+				const uint8_t *c2, size_t i, size_t count,
+				uint8_t *dst)
+{
+	for (; i < count; i++) {
+		dst[i * 3] = c0[i];
+		dst[i * 3 + 1] = c1[i];
+		dst[i * 3 + 2] = c2[i];
+	}
+}
+
+static void unpack_444_8_tail(uint8_t *c0, uint8_t *c1, uint8_t *c2,
+				size_t i, size_t count, const uint8_t *src)
+{
+	for (; i < count; i++) {
+		c0[i] = src[i * 3];
+		c1[i] = src[i * 3 + 1];
+		c2[i] = src[i * 3 + 2];
+	}
+}
+
+static void pack_444_8(const struct avtp_rvf_frame *frame, unsigned int line,
+				size_t pg, size_t count, uint8_t *dst)
+{
+	pack_444_8_tail(row8(frame, 0, line) + pg, row8(frame, 1, line) + pg,
+			row8(frame, 2, line) + pg, 0, count, dst);
+}
+
+static void unpack_444_8(const struct avtp_rvf_frame *frame, unsigned int line,
+				size_t pg, size_t count, const uint8_t *src)
+{
+	unpack_444_8_tail((uint8_t *) row8(frame, 0, line) + pg,
+			(uint8_t *) row8(frame, 1, line) + pg,
+			(uint8_t *) row8(frame, 2, line) + pg, 0, count, src);
+}
+
+static SHUFFLE_TARGET void pack_444_8_shuffle(
+				const struct avtp_rvf_frame *frame,
+				unsigned int line, size_t pg, size_t count,
+				uint8_t *dst)
+{
+	const uint8_t *c0 = row8(frame, 0, line) + pg;
+	const uint8_t *c1 = row8(frame, 1, line) + pg;
+	const uint8_t *c2 = row8(frame, 2, line) + pg;
+	size_t i;
+	int k;
+
+	for (i = 0; i + 16 <= count; i += 16) {
+		v16qu v0 = *(const v16qu_u *)(c0 + i);
+		v16qu v1 = *(const v16qu_u *)(c1 + i);
+		v16qu v2 = *(const v16qu_u *)(c2 + i);
+
+		for (k = 0; k < 3; k++) {
+			v16qu w = __builtin_shuffle(v0, v1,
+						pack_444_8_masks[k][0]);
+
+			*(v16qu_u *)(dst + i * 3 + k * 16) =
+				__builtin_shuffle(w, v2,
+						pack_444_8_masks[k][1]);
+		}
+	}
+
+	pack_444_8_tail(c0, c1, c2, i, count, dst);
+}
+
+static SHUFFLE_TARGET void unpack_444_8_shuffle(
+				const struct avtp_rvf_frame *frame,
+				unsigned int line, size_t pg, size_t count,
+				const uint8_t *src)
+{
+	uint8_t *c[3] = {
+		(uint8_t *) row8(frame, 0, line) + pg,
+		(uint8_t *) row8(frame, 1, line) + pg,
+		(uint8_t *) row8(frame, 2, line) + pg,
+	};
+	size_t i;
+	int k;
+
+	for (i = 0; i + 16 <= count; i += 16) {
+		v16qu s0 = *(const v16qu_u *)(src + i * 3);
+		v16qu s1 = *(const v16qu_u *)(src + i * 3 + 16);
+		v16qu s2 = *(const v16qu_u *)(src + i * 3 + 32);
+
+		for (k = 0; k < 3; k++) {
+			v16qu w = __builtin_shuffle(s0, s1,
+						unpack_444_8_masks[k][0]);
+
+			*(v16qu_u *)(c[k] + i) = __builtin_shuffle(w, s2,
+						unpack_444_8_masks[k][1]);
+		}
+	}
+
+	unpack_444_8_tail(c[0], c[1], c[2], i, count, src);
+}
+
+static const struct pgroup_format formats[] = {
+	{
+		AVTP_RVF_PIXEL_FORMAT_422, AVTP_RVF_PIXEL_DEPTH_8BIT, 4, 2, 0,
+		pack_422_8, unpack_422_8,
+	},
+	{
+		AVTP_RVF_PIXEL_FORMAT_422, AVTP_RVF_PIXEL_DEPTH_10BIT, 5, 2, 0,
+		pack_422_10, unpack_422_10,
+	},
+	{
+		AVTP_RVF_PIXEL_FORMAT_444, AVTP_RVF_PIXEL_DEPTH_8BIT, 3, 1, 1,
+		pack_444_8_shuffle, unpack_444_8_shuffle,
+	},
+	{
+		AVTP_RVF_PIXEL_FORMAT_444, AVTP_RVF_PIXEL_DEPTH_8BIT, 3, 1, 0,
+		pack_444_8, unpack_444_8,
+	},
+};
+
+int avtp_rvf_video_init(struct avtp_rvf_video *video, unsigned int width,
+				unsigned int height, uint8_t pixel_format,
+				uint8_t pixel_depth, size_t max_pdu_size)
+{
+	const struct pgroup_format *fmt = NULL;
+	size_t max_payload;
+	unsigned int i;
+
+	if (!video || !width || !height || width > UINT16_MAX ||
+							height > UINT16_MAX)
+		return -EINVAL;
+
+	/* The first kernels the CPU can run are the fastest ones. */
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		if (formats[i].pixel_format != pixel_format ||
+				formats[i].pixel_depth != pixel_depth)
+			continue;
+
+		if (formats[i].shuffle && !has_shuffle())
+			continue;
+
+		fmt = &formats[i];
+		break;
+	}
+
+	if (!fmt || width % fmt->pixels)
+		return -EINVAL;
+
+	if (max_pdu_size < RVF_HEADER_LEN + fmt->len)
+		return -EINVAL;
+
+	max_payload = max_pdu_size - RVF_HEADER_LEN;
+	if (max_payload > UINT16_MAX - AVTP_RVF_RAW_HEADER_LEN)
+		max_payload = UINT16_MAX - AVTP_RVF_RAW_HEADER_LEN;
+
+	memset(video, 0, sizeof(*video));
+	video->format = fmt - formats;
+	video->width = width;
+	video->height = height;
+	video->line_len = (size_t) width / fmt->pixels * fmt->len;
+	video->frag_len = max_payload / fmt->len * fmt->len;
+	video->lines_per_pdu = max_payload / video->line_len;
+	if (video->lines_per_pdu > RVF_MAX_LINES_PER_PDU)
+		video->lines_per_pdu = RVF_MAX_LINES_PER_PDU;
+
+	return 0;
+}
+
+int avtp_rvf_video_pdu_init(const struct avtp_rvf_video *video,
+						struct avtp_stream_pdu *pdu)
+{
+	const struct pgroup_format *fmt;
+	int res;
+
+	if (!video || !pdu)
+		return -EINVAL;
+
+	fmt = &formats[video->format];
+
+	res = avtp_rvf_pdu_init(pdu);
+	if (res < 0)
+		return res;
+
+	res = avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_ACTIVE_PIXELS,
+								video->width);
+	if (res < 0)
+		return res;
+
+	res = avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_TOTAL_LINES, video->height);
+	if (res < 0)
+		return res;
+
+	res = avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_PIXEL_FORMAT,
+							fmt->pixel_format);
+	if (res < 0)
+		return res;
+
+	res = avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_PIXEL_DEPTH,
+							fmt->pixel_depth);
+	if (res < 0)
+		return res;
+
+	return 0;
+}
+
+int avtp_rvf_video_pack(struct avtp_rvf_video *video,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_rvf_frame *frame,
+				size_t *pdu_len, int *end_of_frame)
+{
+	const struct pgroup_format *fmt;
+	struct avtp_rvf_payload *pay;
+	unsigned int line, lines;
+	size_t len;
+	int eof;
+
+	if (!video || !pdu || !frame || !pdu_len || !end_of_frame)
+		return -EINVAL;
+
+	fmt = &formats[video->format];
+	pay = (struct avtp_rvf_payload *) pdu->avtp_payload;
+	line = video->line;
+
+	if (video->lines_per_pdu) {
+		unsigned int i;
+
+		lines = video->height - line;
+		if (lines > video->lines_per_pdu)
+			lines = video->lines_per_pdu;
+
+		for (i = 0; i < lines; i++)
+			fmt->pack(frame, line + i, 0, video->width / fmt->pixels,
+					pay->raw_data + i * video->line_len);
+
+		len = lines * video->line_len;
+		video->line += lines;
+	} else {
+		len = video->line_len - video->offset;
+		if (len > video->frag_len)
+			len = video->frag_len;
+
+		lines = 1;
+		fmt->pack(frame, line, video->offset / fmt->len,
+					len / fmt->len, pay->raw_data);
+
+		video->offset += len;
+		if (video->offset == video->line_len) {
+			video->offset = 0;
+			video->line++;
+		}
+	}
+
+	eof = video->line == video->height;
+	if (eof)
+		video->line = 0;
+
+	avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_STREAM_DATA_LEN,
+					AVTP_RVF_RAW_HEADER_LEN + len);
+	avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_SEQ_NUM, video->seq_num++);
+	avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_EF, eof);
+	avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_NUM_LINES, lines);
+	avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_LINE_NUMBER, line);
+
+	*pdu_len = RVF_HEADER_LEN + len;
+	*end_of_frame = eof;
+
+	return 0;
+}
+
+static int validate_pdu(const struct avtp_rvf_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				size_t *payload_len)
+{
+	const struct pgroup_format *fmt = &formats[video->format];
+	uint32_t subtype;
+	uint64_t val;
+
+	if (len < RVF_HEADER_LEN)
+		return -EBADMSG;
+
+	avtp_pdu_get((const struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+								&subtype);
+	if (subtype != AVTP_SUBTYPE_RVF)
+		return -EBADMSG;
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_STREAM_DATA_LEN, &val);
+	if (val < AVTP_RVF_RAW_HEADER_LEN ||
+			val > len - sizeof(struct avtp_stream_pdu))
+		return -EBADMSG;
+
+	*payload_len = val - AVTP_RVF_RAW_HEADER_LEN;
+	if (*payload_len % fmt->len)
+		return -EBADMSG;
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_ACTIVE_PIXELS, &val);
+	if (val != video->width)
+		return -EBADMSG;
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_TOTAL_LINES, &val);
+	if (val != video->height)
+		return -EBADMSG;
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_PIXEL_FORMAT, &val);
+	if (val != fmt->pixel_format)
+		return -EBADMSG;
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_PIXEL_DEPTH, &val);
+	if (val != fmt->pixel_depth)
+		return -EBADMSG;
+
+	return 0;
+}
+
+int avtp_rvf_video_unpack(struct avtp_rvf_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				const struct avtp_rvf_frame *frame)
+{
+	const struct pgroup_format *fmt;
+	const struct avtp_rvf_payload *pay;
+	uint64_t seq_num, ef, lines, line;
+	size_t payload_len;
+	int res;
+
+	if (!video || !pdu || !frame)
+		return -EINVAL;
+
+	res = validate_pdu(video, pdu, len, &payload_len);
+	if (res < 0)
+		return res;
+
+	fmt = &formats[video->format];
+	pay = (const struct avtp_rvf_payload *) pdu->avtp_payload;
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_SEQ_NUM, &seq_num);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_EF, &ef);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_NUM_LINES, &lines);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_LINE_NUMBER, &line);
+
+	if (!lines || line + lines > video->height)
+		return -EBADMSG;
+
+	/* A fragment can only be placed if the previous PDU was received:
+	 * it starts a new line if the previous PDU belonged to another line
+	 * or completed its line, otherwise it follows the bytes received so
+	 * far.
+	 */
+	if (video->started && (uint8_t) seq_num != video->seq_num) {
+		video->lost += (uint8_t) (seq_num - video->seq_num);
+		video->synced = 0;
+		video->offset = 0;
+	} else if (video->started && (line != video->line ||
+				video->offset == video->line_len)) {
+		video->synced = 1;
+		video->offset = 0;
+	}
+
+	video->started = 1;
+	video->seq_num = seq_num + 1;
+
+	if (payload_len == lines * video->line_len) {
+		unsigned int i;
+
+		for (i = 0; i < lines; i++)
+			fmt->unpack(frame, line + i, 0,
+					video->width / fmt->pixels,
+					pay->raw_data + i * video->line_len);
+
+		video->synced = 1;
+		video->line = line + lines - 1;
+		video->offset = video->line_len;
+	} else if (lines == 1 && payload_len < video->line_len) {
+		video->line = line;
+
+		if (video->synced) {
+			if (video->offset + payload_len > video->line_len) {
+				video->synced = 0;
+				return -EBADMSG;
+			}
+
+			fmt->unpack(frame, line, video->offset / fmt->len,
+					payload_len / fmt->len, pay->raw_data);
+			video->offset += payload_len;
+		}
+	} else {
+		return -EBADMSG;
+	}
+
+	return ef ? 1 : 0;
+}
+
+int avtp_rvf_video_get_lost(const struct avtp_rvf_video *video,
+							uint64_t *lost)
+{
+	if (!video || !lost)
+		return -EINVAL;
+
+	*lost = video->lost;
+
+	return 0;
+}
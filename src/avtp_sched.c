@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/timerfd.h>
+
+#include "avtp_sched.h"
+#include "probes.h"
+
+#define ARITY			4
+#define CACHE_LINE		64
+#define NSEC_PER_SEC		1000000000ULL
+
+/* Payloads are kept in 'data', at the slot recorded in their heap node, so
+ * nodes stay small and only they move while sifting.
+ */
+struct heap_node {
+	uint64_t time;
+	/* Push order, breaking ties between equal times. */
+	uint32_t seq;
+	uint32_t slot;
+};
+
+/* 'heap' points ARITY - 1 nodes into the cache line aligned 'nodes', so
+ * the children of node i, 4i + 1 to 4i + 4, start on a cache line.
+ */
+struct avtp_sched {
+	struct heap_node *nodes;
+	struct heap_node *heap;
+	size_t count;
+	size_t max_entries;
+	uint32_t seq;
+
+	void **data;
+	/* Stack of unused slots of 'data'. */
+	uint32_t *free_slots;
+	size_t free_count;
+};
+
+static inline bool before(const struct heap_node *a,
+						const struct heap_node *b)
+{
+	if (a->time != b->time)
+		return a->time < b->time;
+
+	return (int32_t) (a->seq - b->seq) < 0;
+}
+
+/* Returns the index the node at 'i' ends up at. */
+static size_t sift_up(struct heap_node *heap, size_t i)
+{
+	struct heap_node node = heap[i];
+
+	while (i > 0) {
+		size_t parent = (i - 1) / ARITY;
+
+		if (!before(&node, &heap[parent]))
+			break;
+
+		heap[i] = heap[parent];
+		i = parent;
+	}
+
+	heap[i] = node;
+	return i;
+}
+
+static void sift_down(struct heap_node *heap, size_t count, size_t i)
+{
+	struct heap_node node = heap[i];
+
+	while (1) {
+		size_t first = i * ARITY + 1;
+		size_t last, best, j;
+
+		if (first >= count)
+			break;
+
+		last = first + ARITY < count ? first + ARITY : count;
+		best = first;
+		for (j = first + 1; j < last; j++)
+			if (before(&heap[j], &heap[best]))
+				best = j;
+
+		if (!before(&heap[best], &node))
+			break;
+
+		heap[i] = heap[best];
+		i = best;
+	}
+
+	heap[i] = node;
+}
+
+int avtp_sched_create(struct avtp_sched **sched, size_t max_entries)
+{
+	struct avtp_sched *s;
+	size_t size, i;
+
+	if (!sched || !max_entries || max_entries > INT_MAX)
+		return -EINVAL;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+
+	size = (max_entries + ARITY - 1) * sizeof(struct heap_node);
+	size = (size + CACHE_LINE - 1) & ~((size_t) CACHE_LINE - 1);
+
+	s->nodes = aligned_alloc(CACHE_LINE, size);
+	s->data = calloc(max_entries, sizeof(*s->data));
+	s->free_slots = calloc(max_entries, sizeof(*s->free_slots));
+	if (!s->nodes || !s->data || !s->free_slots) {
+		avtp_sched_destroy(s);
+		return -ENOMEM;
+	}
+
+	s->heap = s->nodes + ARITY - 1;
+	s->max_entries = max_entries;
+
+	for (i = 0; i < max_entries; i++)
+		s->free_slots[i] = max_entries - 1 - i;
+	s->free_count = max_entries;
+
+	*sched = s;
+	return 0;
+}
+
+void avtp_sched_destroy(struct avtp_sched *sched)
+{
+	if (!sched)
+		return;
+
+	free(sched->nodes);
+	free(sched->data);
+	free(sched->free_slots);
+	free(sched);
+}
+
+int avtp_sched_push(struct avtp_sched *sched, uint64_t time, void *data)
+{
+	struct heap_node *node;
+
+	if (!sched)
+		return -EINVAL;
+
+	if (sched->count == sched->max_entries)
+		return -ENOSPC;
+
+	node = &sched->heap[sched->count];
+	node->time = time;
+	node->seq = sched->seq++;
+	node->slot = sched->free_slots[--sched->free_count];
+	sched->data[node->slot] = data;
+
+	AVTP_PROBE2(jb_enqueue, time, sched->count + 1);
+
+	return sift_up(sched->heap, sched->count++) == 0;
+}
+
+int avtp_sched_peek(const struct avtp_sched *sched, uint64_t *time,
+								void **data)
+{
+	if (!sched || !time)
+		return -EINVAL;
+
+	if (!sched->count)
+		return 0;
+
+	*time = sched->heap[0].time;
+	if (data)
+		*data = sched->data[sched->heap[0].slot];
+
+	return 1;
+}
+
+int avtp_sched_pop(struct avtp_sched *sched, uint64_t now, uint64_t *time,
+								void **data)
+{
+	struct heap_node *head;
+
+	if (!sched || !data)
+		return -EINVAL;
+
+	head = &sched->heap[0];
+	if (!sched->count || head->time > now)
+		return 0;
+
+	AVTP_PROBE3(jb_dequeue, head->time, 1, sched->count - 1);
+
+	if (time)
+		*time = head->time;
+	*data = sched->data[head->slot];
+	sched->free_slots[sched->free_count++] = head->slot;
+
+	if (--sched->count) {
+		*head = sched->heap[sched->count];
+		sift_down(sched->heap, sched->count, 0);
+	}
+
+	return 1;
+}
+
+int avtp_sched_get_count(const struct avtp_sched *sched)
+{
+	if (!sched)
+		return -EINVAL;
+
+	return sched->count;
+}
+
+int avtp_sched_arm_timer(const struct avtp_sched *sched, int fd)
+{
+	struct itimerspec spec = { 0 };
+	uint64_t time;
+	int res;
+
+	if (!sched || fd < 0)
+		return -EINVAL;
+
+	if (sched->count) {
+		/* A zero it_value would disarm the timer instead. */
+		time = sched->heap[0].time ? sched->heap[0].time : 1;
+
+		spec.it_value.tv_sec = time / NSEC_PER_SEC;
+		spec.it_value.tv_nsec = time % NSEC_PER_SEC;
+	}
+
+	res = timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, NULL);
+	if (res < 0)
+		return -errno;
+
+	return 0;
+}
@@ -0,0 +1,522 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "avtp_shm.h"
+#include "probes.h"
+
+#define SHM_MAGIC			0x41565450 /* 'AVTP' */
+#define SHM_VERSION			1
+
+/* The ring header takes the first page of the memfd, records follow. */
+#define SHM_HEADER_SIZE			4096
+#define SHM_CACHELINE			64
+
+#define REC_ALIGN			8
+#define REC_FLAG_PAD			(1 << 0)
+#define ALIGN_UP(x, a)			(((x) + (a) - 1) & ~((size_t)(a) - 1))
+
+/* Ring positions are byte counters that never wrap in practice, the ring
+ * offset being 'pos & (size - 1)'. All records below 'head' are complete.
+ * 'reserve' is the end of the record being written, so a reader at 'pos'
+ * knows its record is intact as long as 'reserve - pos <= size'.
+ */
+struct shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+
+	uint64_t head __attribute__((aligned(SHM_CACHELINE)));
+	uint64_t reserve;
+	uint64_t seq;
+
+	/* Number of readers sleeping on the doorbell. */
+	uint32_t waiters __attribute__((aligned(SHM_CACHELINE)));
+};
+
+_Static_assert(sizeof(struct shm_header) <= SHM_HEADER_SIZE,
+					"ring header must fit in a page");
+
+struct shm_rec {
+	uint32_t len;
+	uint32_t flags;
+	uint64_t seq;
+	uint64_t time;
+};
+
+struct avtp_shm_sink {
+	struct shm_header *hdr;
+	uint8_t *ring;
+	size_t map_len;
+	uint64_t mask;
+	uint64_t head;
+	uint64_t seq;
+	int mem_fd;
+	int bell_fd;
+};
+
+struct avtp_shm_reader {
+	const struct shm_header *hdr;
+	const uint8_t *ring;
+	size_t map_len;
+	uint64_t size;
+	uint64_t pos;
+	uint64_t next_pos;
+	uint32_t *waiters;
+	int bell_fd;
+};
+
+static uint64_t load_acquire(const uint64_t *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+int avtp_shm_sink_create(struct avtp_shm_sink **sink, const char *name,
+								size_t size)
+{
+	struct avtp_shm_sink *s;
+	void *map;
+	int res;
+
+	if (!sink || !name || size < AVTP_SHM_MIN_SIZE || (size & (size - 1)))
+		return -EINVAL;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+
+	s->mem_fd = -1;
+	s->bell_fd = -1;
+	s->map_len = SHM_HEADER_SIZE + size;
+	s->mask = size - 1;
+
+	s->mem_fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (s->mem_fd < 0)
+		goto err_errno;
+
+	/* Readers rely on the ring size, so don't let it change. */
+	if (ftruncate(s->mem_fd, s->map_len) < 0 ||
+			fcntl(s->mem_fd, F_ADD_SEALS, F_SEAL_SHRINK |
+					F_SEAL_GROW | F_SEAL_SEAL) < 0)
+		goto err_errno;
+
+	s->bell_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+	if (s->bell_fd < 0)
+		goto err_errno;
+
+	map = mmap(NULL, s->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+							s->mem_fd, 0);
+	if (map == MAP_FAILED)
+		goto err_errno;
+
+	s->hdr = map;
+	s->ring = (uint8_t *) map + SHM_HEADER_SIZE;
+	s->hdr->size = size;
+	s->hdr->version = SHM_VERSION;
+	__atomic_store_n(&s->hdr->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+	*sink = s;
+	return 0;
+
+err_errno:
+	res = -errno;
+	avtp_shm_sink_destroy(s);
+	return res;
+}
+
+void avtp_shm_sink_destroy(struct avtp_shm_sink *sink)
+{
+	if (!sink)
+		return;
+
+	if (sink->hdr)
+		munmap(sink->hdr, sink->map_len);
+	if (sink->bell_fd >= 0)
+		close(sink->bell_fd);
+	if (sink->mem_fd >= 0)
+		close(sink->mem_fd);
+
+	free(sink);
+}
+
+int avtp_shm_sink_write(struct avtp_shm_sink *sink, const void *data,
+						size_t len, uint64_t time)
+{
+	uint64_t size, off, room, total;
+	struct shm_rec *rec;
+
+	if (!sink || (!data && len))
+		return -EINVAL;
+
+	size = sink->mask + 1;
+	if (len > size / 4)
+		return -EMSGSIZE;
+
+	total = sizeof(*rec) + ALIGN_UP(len, REC_ALIGN);
+	off = sink->head & sink->mask;
+	room = size - off;
+
+	/* Records are contiguous: if this one doesn't fit before the end of
+	 * the ring, the room left is skipped with a padding record (or
+	 * implicitly, when not even a record header fits).
+	 */
+	if (room < total) {
+		__atomic_store_n(&sink->hdr->reserve, sink->head + room +
+						total, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+
+		if (room >= sizeof(*rec)) {
+			rec = (struct shm_rec *) (sink->ring + off);
+			rec->len = room - sizeof(*rec);
+			rec->flags = REC_FLAG_PAD;
+		}
+
+		sink->head += room;
+		off = 0;
+	} else {
+		__atomic_store_n(&sink->hdr->reserve, sink->head + total,
+							__ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+	}
+
+	rec = (struct shm_rec *) (sink->ring + off);
+	rec->len = len;
+	rec->flags = 0;
+	rec->seq = sink->seq;
+	rec->time = time;
+	memcpy(rec + 1, data, len);
+
+	sink->head += total;
+	sink->seq++;
+	__atomic_store_n(&sink->hdr->seq, sink->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&sink->hdr->head, sink->head, __ATOMIC_SEQ_CST);
+
+	AVTP_PROBE3(shm_publish, sink->seq - 1, time, len);
+
+	return 0;
+}
+
+int avtp_shm_sink_flush(struct avtp_shm_sink *sink)
+{
+	uint64_t waiters;
+	ssize_t n;
+
+	if (!sink)
+		return -EINVAL;
+
+	/* Pairs with avtp_shm_reader_wait(): either the reader sees the new
+	 * head or we see it waiting. Each waiter takes one doorbell token.
+	 */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	waiters = __atomic_load_n(&sink->hdr->waiters, __ATOMIC_SEQ_CST);
+	if (!waiters)
+		return 0;
+
+	/* The doorbell can only fail to ring if it already holds plenty of
+	 * tokens, which wakes readers up just as well.
+	 */
+	n = write(sink->bell_fd, &waiters, sizeof(waiters));
+	(void) n;
+
+	return 0;
+}
+
+int avtp_shm_send_fds(const struct avtp_shm_sink *sink, int sock)
+{
+	char control[CMSG_SPACE(2 * sizeof(int))] = { 0 };
+	uint8_t version = SHM_VERSION;
+	struct iovec iov = { &version, sizeof(version) };
+	struct msghdr msg = { 0 };
+	struct cmsghdr *cmsg;
+	int fds[2];
+
+	if (!sink)
+		return -EINVAL;
+
+	fds[0] = sink->mem_fd;
+	fds[1] = sink->bell_fd;
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if (sendmsg(sock, &msg, MSG_NOSIGNAL) < 0)
+		return -errno;
+
+	return 0;
+}
+
+int avtp_shm_recv_fds(int sock, int *mem_fd, int *bell_fd)
+{
+	char control[CMSG_SPACE(2 * sizeof(int))];
+	uint8_t version;
+	struct iovec iov = { &version, sizeof(version) };
+	struct msghdr msg = { 0 };
+	struct cmsghdr *cmsg;
+	int fds[2];
+	ssize_t n;
+
+	if (!mem_fd || !bell_fd)
+		return -EINVAL;
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+	if (n < 0)
+		return -errno;
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+				cmsg->cmsg_type != SCM_RIGHTS ||
+				cmsg->cmsg_len != CMSG_LEN(sizeof(fds)))
+		return -EBADMSG;
+
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+	if (n != sizeof(version) || version != SHM_VERSION) {
+		close(fds[0]);
+		close(fds[1]);
+		return -EBADMSG;
+	}
+
+	*mem_fd = fds[0];
+	*bell_fd = fds[1];
+	return 0;
+}
+
+int avtp_shm_reader_create(struct avtp_shm_reader **reader, int mem_fd,
+								int bell_fd)
+{
+	const struct shm_header *hdr;
+	struct avtp_shm_reader *r;
+	struct stat st;
+	void *map;
+	int res;
+
+	if (!reader || mem_fd < 0 || bell_fd < 0)
+		return -EINVAL;
+
+	if (fstat(mem_fd, &st) < 0)
+		return -errno;
+
+	if (st.st_size <= SHM_HEADER_SIZE)
+		return -EBADMSG;
+
+	r = calloc(1, sizeof(*r));
+	if (!r)
+		return -ENOMEM;
+
+	r->map_len = st.st_size;
+
+	/* The mapping is shared read-write only for the 'waiters' counter,
+	 * readers never write to the ring itself.
+	 */
+	map = mmap(NULL, r->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+								mem_fd, 0);
+	if (map == MAP_FAILED) {
+		res = -errno;
+		free(r);
+		return res;
+	}
+
+	hdr = map;
+	r->hdr = hdr;
+	r->ring = (const uint8_t *) map + SHM_HEADER_SIZE;
+	r->waiters = &((struct shm_header *) map)->waiters;
+	r->bell_fd = -1;
+
+	if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC ||
+			hdr->version != SHM_VERSION ||
+			hdr->size + SHM_HEADER_SIZE != r->map_len) {
+		avtp_shm_reader_destroy(r);
+		return -EBADMSG;
+	}
+
+	r->bell_fd = dup(bell_fd);
+	if (r->bell_fd < 0) {
+		res = -errno;
+		avtp_shm_reader_destroy(r);
+		return res;
+	}
+
+	r->size = hdr->size;
+	r->pos = load_acquire(&hdr->head);
+
+	*reader = r;
+	return 0;
+}
+
+void avtp_shm_reader_destroy(struct avtp_shm_reader *reader)
+{
+	if (!reader)
+		return;
+
+	munmap((void *) reader->hdr, reader->map_len);
+	if (reader->bell_fd >= 0)
+		close(reader->bell_fd);
+
+	free(reader);
+}
+
+/* Whether the bytes from 'pos' on weren't overwritten since read. */
+static bool is_intact(const struct avtp_shm_reader *reader, uint64_t pos)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(&reader->hdr->reserve, __ATOMIC_RELAXED) -
+							pos <= reader->size;
+}
+
+int avtp_shm_reader_next(struct avtp_shm_reader *reader,
+						struct avtp_shm_rec *rec)
+{
+	uint64_t head, off, room;
+	struct shm_rec r;
+
+	if (!reader || !rec)
+		return -EINVAL;
+
+	while (true) {
+		head = load_acquire(&reader->hdr->head);
+		if (reader->pos == head)
+			return 0;
+
+		if (head - reader->pos > reader->size)
+			goto overrun;
+
+		off = reader->pos & (reader->size - 1);
+		room = reader->size - off;
+		if (room < sizeof(r)) {
+			reader->pos += room;
+			continue;
+		}
+
+		memcpy(&r, reader->ring + off, sizeof(r));
+		if (!is_intact(reader, reader->pos))
+			goto overrun;
+
+		if (r.flags & REC_FLAG_PAD) {
+			reader->pos += room;
+			continue;
+		}
+
+		/* The header is intact so the length can be trusted. */
+		rec->data = reader->ring + off + sizeof(r);
+		rec->len = r.len;
+		rec->time = r.time;
+		rec->seq = r.seq;
+		reader->next_pos = reader->pos + sizeof(r) +
+						ALIGN_UP(r.len, REC_ALIGN);
+		return 1;
+	}
+
+overrun:
+	reader->pos = load_acquire(&reader->hdr->head);
+	reader->next_pos = 0;
+	return -EOVERFLOW;
+}
+
+int avtp_shm_reader_release(struct avtp_shm_reader *reader)
+{
+	uint64_t pos;
+
+	if (!reader || !reader->next_pos)
+		return -EINVAL;
+
+	pos = reader->pos;
+	reader->pos = reader->next_pos;
+	reader->next_pos = 0;
+
+	return is_intact(reader, pos) ? 0 : -EOVERFLOW;
+}
+
+int avtp_shm_reader_wait(struct avtp_shm_reader *reader, int timeout)
+{
+	struct pollfd pfd;
+	uint64_t token;
+	int res;
+
+	if (!reader)
+		return -EINVAL;
+
+	if (load_acquire(&reader->hdr->head) != reader->pos)
+		return 0;
+
+	__atomic_add_fetch(reader->waiters, 1, __ATOMIC_SEQ_CST);
+
+	if (__atomic_load_n(&reader->hdr->head, __ATOMIC_SEQ_CST) !=
+								reader->pos) {
+		res = 0;
+		goto out;
+	}
+
+	pfd.fd = reader->bell_fd;
+	pfd.events = POLLIN;
+	res = poll(&pfd, 1, timeout);
+	if (res < 0) {
+		res = -errno;
+		goto out;
+	}
+	if (res == 0) {
+		res = -ETIMEDOUT;
+		goto out;
+	}
+
+	/* Another reader may have taken the token, that's fine. */
+	if (read(reader->bell_fd, &token, sizeof(token)) < 0 &&
+							errno != EAGAIN) {
+		res = -errno;
+		goto out;
+	}
+
+	res = 0;
+
+out:
+	__atomic_sub_fetch(reader->waiters, 1, __ATOMIC_SEQ_CST);
+	return res;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "avtp_stats.h"
+
+#define STATS_MAGIC			0x41565453 /* 'AVTS' */
+#define STATS_VERSION			1
+#define STATS_ALIGN			64
+#define ALIGN_UP(x, a)			(((x) + (a) - 1) & ~((size_t)(a) - 1))
+
+/* File layout: the header, 'max_streams' stream entries, then the counters
+ * blocks, 'max_streams' per thread. Entries are published by incrementing
+ * 'streams' last.
+ */
+struct stats_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t max_streams;
+	uint32_t max_threads;
+	uint32_t counters_size;
+	uint32_t streams;
+} __attribute__((aligned(STATS_ALIGN)));
+
+struct stats_stream {
+	uint64_t stream_id;
+	char name[AVTP_STATS_NAME_LEN];
+} __attribute__((aligned(STATS_ALIGN)));
+
+struct avtp_stats {
+	struct stats_header *hdr;
+	struct stats_stream *streams;
+	struct avtp_stats_counters *counters;
+	size_t map_len;
+	char *path;
+};
+
+static size_t get_map_len(unsigned int max_streams, unsigned int max_threads)
+{
+	return sizeof(struct stats_header) +
+		max_streams * sizeof(struct stats_stream) +
+		(size_t) max_streams * max_threads *
+				sizeof(struct avtp_stats_counters);
+}
+
+static void set_layout(struct avtp_stats *stats, void *map)
+{
+	stats->hdr = map;
+	stats->streams = (struct stats_stream *) (stats->hdr + 1);
+	stats->counters = (struct avtp_stats_counters *)
+				(stats->streams + stats->hdr->max_streams);
+}
+
+int avtp_stats_create(struct avtp_stats **stats, const char *path,
+			unsigned int max_streams, unsigned int max_threads)
+{
+	struct avtp_stats *s;
+	size_t i, blocks;
+	void *map;
+	int fd, res;
+
+	if (!stats || !path || !max_streams || !max_threads)
+		return -EINVAL;
+
+	s = calloc(1, sizeof(*s));
+	if (!s)
+		return -ENOMEM;
+
+	s->path = strdup(path);
+	if (!s->path) {
+		free(s);
+		return -ENOMEM;
+	}
+
+	s->map_len = get_map_len(max_streams, max_threads);
+
+	/* Start from a fresh file so readers never see stale counters. */
+	unlink(path);
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if (fd < 0)
+		goto err_errno;
+
+	if (ftruncate(fd, s->map_len) < 0) {
+		res = -errno;
+		close(fd);
+		unlink(path);
+		goto err;
+	}
+
+	map = mmap(NULL, s->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+									0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		res = -errno;
+		unlink(path);
+		goto err;
+	}
+
+	s->hdr = map;
+	s->hdr->max_streams = max_streams;
+	s->hdr->max_threads = max_threads;
+	s->hdr->counters_size = sizeof(struct avtp_stats_counters);
+	s->hdr->version = STATS_VERSION;
+	set_layout(s, map);
+
+	blocks = (size_t) max_streams * max_threads;
+	for (i = 0; i < blocks; i++) {
+		s->counters[i].margin_min = INT64_MAX;
+		s->counters[i].margin_max = INT64_MIN;
+	}
+
+	__atomic_store_n(&s->hdr->magic, STATS_MAGIC, __ATOMIC_RELEASE);
+
+	*stats = s;
+	return 0;
+
+err_errno:
+	res = -errno;
+err:
+	free(s->path);
+	free(s);
+	return res;
+}
+
+int avtp_stats_open(struct avtp_stats **stats, const char *path)
+{
+	const struct stats_header *hdr;
+	struct avtp_stats *s;
+	struct stat st;
+	void *map;
+	int fd, res;
+
+	if (!stats || !path)
+		return -EINVAL;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	if (fstat(fd, &st) < 0) {
+		res = -errno;
+		close(fd);
+		return res;
+	}
+
+	if ((size_t) st.st_size < sizeof(struct stats_header)) {
+		close(fd);
+		return -EBADMSG;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -errno;
+
+	hdr = map;
+	if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != STATS_MAGIC ||
+			hdr->version != STATS_VERSION ||
+			hdr->counters_size !=
+				sizeof(struct avtp_stats_counters) ||
+			get_map_len(hdr->max_streams, hdr->max_threads) !=
+							(size_t) st.st_size) {
+		munmap(map, st.st_size);
+		return -EBADMSG;
+	}
+
+	s = calloc(1, sizeof(*s));
+	if (!s) {
+		munmap(map, st.st_size);
+		return -ENOMEM;
+	}
+
+	s->map_len = st.st_size;
+	set_layout(s, map);
+
+	*stats = s;
+	return 0;
+}
+
+void avtp_stats_destroy(struct avtp_stats *stats)
+{
+	if (!stats)
+		return;
+
+	munmap(stats->hdr, stats->map_len);
+	if (stats->path) {
+		unlink(stats->path);
+		free(stats->path);
+	}
+
+	free(stats);
+}
+
+int avtp_stats_add_stream(struct avtp_stats *stats, uint64_t stream_id,
+				const char *name, unsigned int *index)
+{
+	struct stats_stream *stream;
+	unsigned int n;
+
+	if (!stats || !name || !index)
+		return -EINVAL;
+
+	/* Only the creator knows the path, see avtp_stats_create(). */
+	if (!stats->path)
+		return -EPERM;
+
+	n = stats->hdr->streams;
+	if (n == stats->hdr->max_streams)
+		return -ENOSPC;
+
+	stream = &stats->streams[n];
+	stream->stream_id = stream_id;
+	strncpy(stream->name, name, AVTP_STATS_NAME_LEN - 1);
+
+	__atomic_store_n(&stats->hdr->streams, n + 1, __ATOMIC_RELEASE);
+
+	*index = n;
+	return 0;
+}
+
+struct avtp_stats_counters *avtp_stats_get_counters(struct avtp_stats *stats,
+				unsigned int thread, unsigned int stream)
+{
+	if (!stats || !stats->path || thread >= stats->hdr->max_threads ||
+					stream >= stats->hdr->max_streams)
+		return NULL;
+
+	return &stats->counters[thread * stats->hdr->max_streams + stream];
+}
+
+int avtp_stats_get_stream_count(const struct avtp_stats *stats,
+							unsigned int *count)
+{
+	if (!stats || !count)
+		return -EINVAL;
+
+	*count = __atomic_load_n(&stats->hdr->streams, __ATOMIC_ACQUIRE);
+	return 0;
+}
+
+/* Counters are written with plain stores by their thread, read them once
+ * each so a concurrent update can't be seen half way through a merge.
+ */
+#define READ_ONCE(x)			(*(const volatile __typeof__(x) *) &(x))
+
+int avtp_stats_read(const struct avtp_stats *stats, unsigned int stream,
+				uint64_t *stream_id, char *name,
+				struct avtp_stats_counters *counters)
+{
+	const struct avtp_stats_counters *c;
+	unsigned int count, t, i;
+
+	if (!stats || !stream_id || !name || !counters)
+		return -EINVAL;
+
+	avtp_stats_get_stream_count(stats, &count);
+	if (stream >= count)
+		return -ENOENT;
+
+	*stream_id = stats->streams[stream].stream_id;
+	memcpy(name, stats->streams[stream].name, AVTP_STATS_NAME_LEN);
+	name[AVTP_STATS_NAME_LEN - 1] = '\0';
+
+	memset(counters, 0, sizeof(*counters));
+	counters->margin_min = INT64_MAX;
+	counters->margin_max = INT64_MIN;
+
+	for (t = 0; t < stats->hdr->max_threads; t++) {
+		int64_t min, max;
+
+		c = &stats->counters[t * stats->hdr->max_streams + stream];
+
+		counters->packets += READ_ONCE(c->packets);
+		counters->bytes += READ_ONCE(c->bytes);
+		counters->seq_gaps += READ_ONCE(c->seq_gaps);
+		counters->late_drops += READ_ONCE(c->late_drops);
+		counters->early_drops += READ_ONCE(c->early_drops);
+		for (i = 0; i < AVTP_STATS_INVALID_MAX; i++)
+			counters->invalid[i] += READ_ONCE(c->invalid[i]);
+
+		if (!READ_ONCE(c->margin_count))
+			continue;
+
+		min = READ_ONCE(c->margin_min);
+		max = READ_ONCE(c->margin_max);
+		if (min < counters->margin_min)
+			counters->margin_min = min;
+		if (max > counters->margin_max)
+			counters->margin_max = max;
+
+		counters->margin_sum += READ_ONCE(c->margin_sum);
+		counters->margin_count += READ_ONCE(c->margin_count);
+	}
+
+	if (counters->margin_min == INT64_MAX)
+		counters->margin_min = 0;
+	if (counters->margin_max == INT64_MIN)
+		counters->margin_max = 0;
+
+	return 0;
+}
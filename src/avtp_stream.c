@@ -30,6 +30,7 @@
 
 #include "avtp.h"
 #include "avtp_stream.h"
+#include "probes.h"
 #include "util.h"
 
 #define SHIFT_SV			(31 - 8)
@@ -117,9 +118,13 @@ int avtp_stream_pdu_get(const struct avtp_stream_pdu *pdu,
 		res = 0;
 		break;
 	default:
-		return -EINVAL;
+		res = -EINVAL;
+		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
 	return res;
 }
 
@@ -200,8 +205,12 @@ int avtp_stream_pdu_set(struct avtp_stream_pdu *pdu,
 		res = 0;
 		break;
 	default:
-		return -EINVAL;
+		res = -EINVAL;
+		break;
 	}
 
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
 	return res;
 }
@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arpa/inet.h>
+#include <string.h>
+
+#include "avtp.h"
+#include "avtp_stream.h"
+#include "avtp_svf.h"
+#include "probes.h"
+#include "util.h"
+
+#define SHIFT_LINE_NUMBER		(31 - 15)
+#define SHIFT_LINE_OFFSET		(31 - 31)
+#define SHIFT_F				(31 - 18)
+#define SHIFT_EF			(31 - 19)
+#define SHIFT_EVT			(31 - 23)
+
+#define MASK_LINE_NUMBER		(BITMASK(16) << SHIFT_LINE_NUMBER)
+#define MASK_LINE_OFFSET		(BITMASK(16) << SHIFT_LINE_OFFSET)
+#define MASK_F				(BITMASK(1) << SHIFT_F)
+#define MASK_EF				(BITMASK(1) << SHIFT_EF)
+#define MASK_EVT			(BITMASK(4) << SHIFT_EVT)
+
+static int get_field_value(const struct avtp_stream_pdu *pdu,
+				enum avtp_svf_field field, uint64_t *val)
+{
+	uint32_t bitmap, mask;
+	uint8_t shift;
+
+	switch (field) {
+	case AVTP_SVF_FIELD_LINE_NUMBER:
+		mask = MASK_LINE_NUMBER;
+		shift = SHIFT_LINE_NUMBER;
+		bitmap = ntohl(pdu->format_specific);
+		break;
+	case AVTP_SVF_FIELD_LINE_OFFSET:
+		mask = MASK_LINE_OFFSET;
+		shift = SHIFT_LINE_OFFSET;
+		bitmap = ntohl(pdu->format_specific);
+		break;
+	case AVTP_SVF_FIELD_F:
+		mask = MASK_F;
+		shift = SHIFT_F;
+		bitmap = ntohl(pdu->packet_info);
+		break;
+	case AVTP_SVF_FIELD_EF:
+		mask = MASK_EF;
+		shift = SHIFT_EF;
+		bitmap = ntohl(pdu->packet_info);
+		break;
+	case AVTP_SVF_FIELD_EVT:
+		mask = MASK_EVT;
+		shift = SHIFT_EVT;
+		bitmap = ntohl(pdu->packet_info);
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	*val = BITMAP_GET_VALUE(bitmap, mask, shift);
+
+	return 0;
+}
+
+int avtp_svf_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_svf_field field, uint64_t *val)
+{
+	int res;
+
+	if (!pdu || !val)
+		return -EINVAL;
+
+	switch (field) {
+	case AVTP_SVF_FIELD_SV:
+	case AVTP_SVF_FIELD_MR:
+	case AVTP_SVF_FIELD_TV:
+	case AVTP_SVF_FIELD_SEQ_NUM:
+	case AVTP_SVF_FIELD_TU:
+	case AVTP_SVF_FIELD_STREAM_DATA_LEN:
+	case AVTP_SVF_FIELD_TIMESTAMP:
+	case AVTP_SVF_FIELD_STREAM_ID:
+		res = avtp_stream_pdu_get(pdu, (enum avtp_stream_field) field,
+									val);
+		break;
+	case AVTP_SVF_FIELD_LINE_NUMBER:
+	case AVTP_SVF_FIELD_LINE_OFFSET:
+	case AVTP_SVF_FIELD_F:
+	case AVTP_SVF_FIELD_EF:
+	case AVTP_SVF_FIELD_EVT:
+		res = get_field_value(pdu, field, val);
+		break;
+	default:
+		res = -EINVAL;
+		break;
+	}
+
+	if (res < 0)
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, res);
+
+	return res;
+}
+
+static int set_field_value(struct avtp_stream_pdu *pdu,
+				enum avtp_svf_field field, uint32_t val)
+{
+	uint32_t bitmap, mask;
+	uint8_t shift;
+	void *ptr;
+
+	switch (field) {
+	case AVTP_SVF_FIELD_LINE_NUMBER:
+		mask = MASK_LINE_NUMBER;
+		shift = SHIFT_LINE_NUMBER;
+		ptr = &pdu->format_specific;
+		break;
+	case AVTP_SVF_FIELD_LINE_OFFSET:
+		mask = MASK_LINE_OFFSET;
+		shift = SHIFT_LINE_OFFSET;
+		ptr = &pdu->format_specific;
+		break;
+	case AVTP_SVF_FIELD_F:
+		mask = MASK_F;
+		shift = SHIFT_F;
+		ptr = &pdu->packet_info;
+		break;
+	case AVTP_SVF_FIELD_EF:
+		mask = MASK_EF;
+		shift = SHIFT_EF;
+		ptr = &pdu->packet_info;
+		break;
+	case AVTP_SVF_FIELD_EVT:
+		mask = MASK_EVT;
+		shift = SHIFT_EVT;
+		ptr = &pdu->packet_info;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	bitmap = get_unaligned_be32(ptr);
+
+	BITMAP_SET_VALUE(bitmap, val, mask, shift);
+
+	put_unaligned_be32(bitmap, ptr);
+
+	return 0;
+}
+
+int avtp_svf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_svf_field field,
+								uint64_t val)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	switch (field) {
+	case AVTP_SVF_FIELD_SV:
+	case AVTP_SVF_FIELD_MR:
+	case AVTP_SVF_FIELD_TV:
+	case AVTP_SVF_FIELD_SEQ_NUM:
+	case AVTP_SVF_FIELD_TU:
+	case AVTP_SVF_FIELD_STREAM_DATA_LEN:
+	case AVTP_SVF_FIELD_TIMESTAMP:
+	case AVTP_SVF_FIELD_STREAM_ID:
+		res = avtp_stream_pdu_set(pdu, (enum avtp_stream_field) field,
+									val);
+		break;
+	case AVTP_SVF_FIELD_LINE_NUMBER:
+	case AVTP_SVF_FIELD_LINE_OFFSET:
+	case AVTP_SVF_FIELD_F:
+	case AVTP_SVF_FIELD_EF:
+	case AVTP_SVF_FIELD_EVT:
+		res = set_field_value(pdu, field, val);
+		break;
+	default:
+		res = -EINVAL;
+		break;
+	}
+
+	if (res < 0)
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, res);
+
+	return res;
+}
+
+int avtp_svf_pdu_init(struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	memset(pdu, 0, sizeof(struct avtp_stream_pdu));
+
+	res = avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_SVF);
+	if (res < 0)
+		return res;
+
+	res = avtp_svf_pdu_set(pdu, AVTP_SVF_FIELD_SV, 1);
+	if (res < 0)
+		return res;
+
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+int avtp_svf_video_init(struct avtp_svf_video *video, size_t line_len,
+				unsigned int height, size_t max_pdu_size)
+{
+	size_t max_payload;
+
+	/* 'line_number' and 'line_offset' are 16-bit fields. */
+	if (!video || !line_len || line_len > UINT16_MAX + 1 || !height ||
+						height > UINT16_MAX + 1)
+		return -EINVAL;
+
+	if (max_pdu_size <= sizeof(struct avtp_stream_pdu))
+		return -EINVAL;
+
+	max_payload = max_pdu_size - sizeof(struct avtp_stream_pdu);
+	if (max_payload > UINT16_MAX)
+		max_payload = UINT16_MAX;
+
+	memset(video, 0, sizeof(*video));
+	video->line_len = line_len;
+	video->height = height;
+	video->frame_len = (uint64_t) line_len * height;
+	video->max_payload = max_payload;
+
+	return 0;
+}
+
+int avtp_svf_video_pdu_init(const struct avtp_svf_video *video,
+						struct avtp_stream_pdu *pdu)
+{
+	if (!video)
+		return -EINVAL;
+
+	return avtp_svf_pdu_init(pdu);
+}
+
+int avtp_svf_video_pack(struct avtp_svf_video *video,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_svf_frame *frame,
+				struct iovec *iov, unsigned int iovcnt,
+				int *end_of_frame)
+{
+	size_t bytes, sent = 0;
+	unsigned int i;
+	uint64_t pos;
+
+	if (!video || !pdu || !frame || !frame->data || !iov || iovcnt < 2 ||
+							!end_of_frame)
+		return -EINVAL;
+
+	pos = video->pos;
+	bytes = video->max_payload;
+	if (bytes > video->frame_len - pos)
+		bytes = video->frame_len - pos;
+
+	/* Gather the lines straight from the frame buffer, one entry per
+	 * (part of a) line. Running out of entries makes a shorter PDU.
+	 */
+	for (i = 1; i < iovcnt && sent < bytes; i++) {
+		size_t line = (pos + sent) / video->line_len;
+		size_t offset = (pos + sent) % video->line_len;
+		size_t chunk = video->line_len - offset;
+
+		if (chunk > bytes - sent)
+			chunk = bytes - sent;
+
+		iov[i].iov_base = frame->data + line * frame->stride + offset;
+		iov[i].iov_len = chunk;
+
+		sent += chunk;
+	}
+
+	video->pos += sent;
+	*end_of_frame = video->pos == video->frame_len;
+	if (*end_of_frame)
+		video->pos = 0;
+
+	avtp_svf_pdu_set(pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, sent);
+	avtp_svf_pdu_set(pdu, AVTP_SVF_FIELD_SEQ_NUM, video->seq_num++);
+	avtp_svf_pdu_set(pdu, AVTP_SVF_FIELD_LINE_NUMBER,
+						pos / video->line_len);
+	avtp_svf_pdu_set(pdu, AVTP_SVF_FIELD_LINE_OFFSET,
+						pos % video->line_len);
+	avtp_svf_pdu_set(pdu, AVTP_SVF_FIELD_EF, *end_of_frame);
+
+	iov[0].iov_base = pdu;
+	iov[0].iov_len = sizeof(struct avtp_stream_pdu);
+
+	return i;
+}
+
+int avtp_svf_ring_init(struct avtp_svf_ring *ring,
+			const struct avtp_svf_frame *frames, unsigned int size)
+{
+	if (!ring || !frames || size < 2)
+		return -EINVAL;
+
+	/* Size must be a power of 2 so indexes survive wrap around. */
+	if (size & (size - 1))
+		return -EINVAL;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->frames = frames;
+	ring->size = size;
+
+	return 0;
+}
+
+int avtp_svf_ring_peek(const struct avtp_svf_ring *ring,
+				const struct avtp_svf_frame **frame)
+{
+	if (!ring || !frame)
+		return -EINVAL;
+
+	if (ring->tail == ring->head)
+		return -ENODATA;
+
+	*frame = &ring->frames[ring->tail & (ring->size - 1)];
+
+	return 0;
+}
+
+int avtp_svf_ring_pop(struct avtp_svf_ring *ring)
+{
+	if (!ring)
+		return -EINVAL;
+
+	if (ring->tail == ring->head)
+		return -ENODATA;
+
+	ring->tail++;
+
+	return 0;
+}
+
+int avtp_svf_ring_get_dropped(const struct avtp_svf_ring *ring,
+							uint64_t *dropped)
+{
+	if (!ring || !dropped)
+		return -EINVAL;
+
+	*dropped = ring->dropped;
+
+	return 0;
+}
+
+/* Complete the frame being filled and start the next one. If the ring is
+ * full, the completed frame is dropped instead and its buffer filled again:
+ * complete frames may be held by the consumer through avtp_svf_ring_peek().
+ *
+ * Returns 1 if the frame was added to the ring, 0 if it was dropped.
+ */
+static int ring_commit(struct avtp_svf_ring *ring)
+{
+	if (ring->head - ring->tail == ring->size - 1) {
+		ring->dropped++;
+		return 0;
+	}
+
+	ring->head++;
+	return 1;
+}
+
+static void copy_to_frame(const struct avtp_svf_video *video,
+				const struct avtp_svf_frame *frame,
+				uint64_t pos, const uint8_t *src, size_t len)
+{
+	while (len) {
+		size_t line = pos / video->line_len;
+		size_t offset = pos % video->line_len;
+		size_t chunk = video->line_len - offset;
+
+		if (chunk > len)
+			chunk = len;
+
+		memcpy(frame->data + line * frame->stride + offset, src, chunk);
+
+		pos += chunk;
+		src += chunk;
+		len -= chunk;
+	}
+}
+
+int avtp_svf_video_unpack(struct avtp_svf_video *video,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				struct avtp_svf_ring *ring)
+{
+	uint64_t data_len, seq_num, line, offset, ef, pos;
+	uint32_t subtype;
+
+	if (!video || !pdu || !ring)
+		return -EINVAL;
+
+	if (len < sizeof(struct avtp_stream_pdu))
+		return -EBADMSG;
+
+	avtp_pdu_get((const struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+								&subtype);
+	if (subtype != AVTP_SUBTYPE_SVF)
+		return -EBADMSG;
+
+	avtp_svf_pdu_get(pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, &data_len);
+	avtp_svf_pdu_get(pdu, AVTP_SVF_FIELD_SEQ_NUM, &seq_num);
+	avtp_svf_pdu_get(pdu, AVTP_SVF_FIELD_LINE_NUMBER, &line);
+	avtp_svf_pdu_get(pdu, AVTP_SVF_FIELD_LINE_OFFSET, &offset);
+	avtp_svf_pdu_get(pdu, AVTP_SVF_FIELD_EF, &ef);
+
+	if (data_len > len - sizeof(struct avtp_stream_pdu))
+		return -EBADMSG;
+
+	if (line >= video->height || offset >= video->line_len)
+		return -EBADMSG;
+
+	pos = line * video->line_len + offset;
+	if (pos + data_len > video->frame_len)
+		return -EBADMSG;
+
+	if (video->started && (uint8_t) seq_num != video->seq_num)
+		video->lost += (uint8_t) (seq_num - video->seq_num);
+
+	video->started = 1;
+	video->seq_num = seq_num + 1;
+
+	/* A new frame starts: whatever was received of the previous one, if
+	 * its last PDU was lost, is overwritten.
+	 */
+	if (pos == 0)
+		video->synced = 1;
+
+	if (!video->synced)
+		return 0;
+
+	copy_to_frame(video, &ring->frames[ring->head & (ring->size - 1)], pos,
+					pdu->avtp_payload, data_len);
+
+	if (!ef)
+		return 0;
+
+	return ring_commit(ring);
+}
+
+int avtp_svf_video_get_lost(const struct avtp_svf_video *video,
+							uint64_t *lost)
+{
+	if (!video || !lost)
+		return -EINVAL;
+
+	*lost = video->lost;
+
+	return 0;
+}
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "avtp.h"
+#include "avtp_acf_pack.h"
+#include "avtp_tscf.h"
+#include "avtp_stream.h"
+#include "probes.h"
+
+int avtp_tscf_pdu_get(const struct avtp_stream_pdu *pdu,
+				enum avtp_tscf_field field, uint64_t *val)
+{
+	if (field >= AVTP_TSCF_FIELD_MAX) {
+		AVTP_PROBE_FIELD_GET_FAIL(pdu, field, -EINVAL);
+		return -EINVAL;
+	}
+
+	return avtp_stream_pdu_get(pdu, (enum avtp_stream_field) field, val);
+}
+
+int avtp_tscf_pdu_set(struct avtp_stream_pdu *pdu, enum avtp_tscf_field field,
+								uint64_t val)
+{
+	if (field >= AVTP_TSCF_FIELD_MAX) {
+		AVTP_PROBE_FIELD_SET_FAIL(pdu, field, -EINVAL);
+		return -EINVAL;
+	}
+
+	return avtp_stream_pdu_set(pdu, (enum avtp_stream_field) field, val);
+}
+
+int avtp_tscf_pdu_init(struct avtp_stream_pdu *pdu)
+{
+	int res;
+
+	if (!pdu)
+		return -EINVAL;
+
+	memset(pdu, 0, sizeof(struct avtp_stream_pdu));
+
+	res = avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_TSCF);
+	if (res < 0)
+		return res;
+
+	res = avtp_tscf_pdu_set(pdu, AVTP_TSCF_FIELD_SV, 1);
+	if (res < 0)
+		return res;
+
+	AVTP_PROBE2(pdu_init, probe_subtype(pdu), pdu);
+
+	return 0;
+}
+
+int avtp_tscf_pktzr_init(struct avtp_tscf_pktzr *pktzr, size_t max_pdu_size,
+							uint64_t window)
+{
+	size_t max_data_len;
+
+	if (!pktzr || !window)
+		return -EINVAL;
+
+	max_data_len = avtp_acf_pack_get_max_len(max_pdu_size,
+				sizeof(struct avtp_stream_pdu),
+				AVTP_TSCF_MAX_DATA_LEN);
+	if (!max_data_len)
+		return -EINVAL;
+
+	memset(pktzr, 0, sizeof(*pktzr));
+	pktzr->max_data_len = max_data_len;
+	pktzr->window = window;
+
+	return 0;
+}
+
+static int is_in_window(const struct avtp_tscf_pktzr *pktzr, uint64_t time)
+{
+	if (pktzr->count == 0)
+		return 1;
+
+	return time >= pktzr->start && time - pktzr->start < pktzr->window;
+}
+
+static void append(struct avtp_tscf_pktzr *pktzr, uint64_t time)
+{
+	if (pktzr->count == 0)
+		pktzr->start = time;
+
+	pktzr->count++;
+}
+
+int avtp_tscf_pktzr_pack_can(struct avtp_tscf_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, uint8_t type,
+				const struct avtp_acf_can *msgs,
+				unsigned int count)
+{
+	unsigned int i;
+
+	if (!pktzr || !pdu || (!msgs && count))
+		return -EINVAL;
+
+	for (i = 0; i < count; i++) {
+		struct avtp_acf_can can = msgs[i];
+		ssize_t n;
+
+		if (!is_in_window(pktzr, can.timestamp))
+			break;
+
+		if (type == AVTP_ACF_TYPE_CAN)
+			can.flags |= AVTP_ACF_CAN_FLAG_MTV;
+
+		n = avtp_acf_pack_can(pdu->avtp_payload, &pktzr->data_len,
+					pktzr->max_data_len, &can, type);
+		if (n == 0)
+			break;
+		if (n < 0)
+			return i ? (int) i : n;
+
+		append(pktzr, can.timestamp);
+	}
+
+	return i;
+}
+
+int avtp_tscf_pktzr_pack_msg(struct avtp_tscf_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu,
+				const struct avtp_acf_msg *msg, uint64_t time)
+{
+	if (!pktzr || !pdu || !msg || !msg->data)
+		return -EINVAL;
+
+	if (msg->len == 0 || msg->len % 4 || msg->len > pktzr->max_data_len)
+		return -EINVAL;
+
+	if (!is_in_window(pktzr, time) ||
+			msg->len > pktzr->max_data_len - pktzr->data_len)
+		return 0;
+
+	memcpy(pdu->avtp_payload + pktzr->data_len, msg->data, msg->len);
+	pktzr->data_len += msg->len;
+
+	append(pktzr, time);
+
+	return 1;
+}
+
+int avtp_tscf_pktzr_get_time(const struct avtp_tscf_pktzr *pktzr,
+							uint64_t *time)
+{
+	if (!pktzr || !time)
+		return -EINVAL;
+
+	if (pktzr->count == 0)
+		return -ENODATA;
+
+	*time = pktzr->start;
+
+	return 0;
+}
+
+int avtp_tscf_pktzr_flush(struct avtp_tscf_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, size_t *pdu_len)
+{
+	unsigned int count;
+	int res;
+
+	if (!pktzr || !pdu || !pdu_len)
+		return -EINVAL;
+
+	if (pktzr->count == 0)
+		return -ENODATA;
+
+	res = avtp_tscf_pdu_set(pdu, AVTP_TSCF_FIELD_TV, 1);
+	if (res < 0)
+		return res;
+
+	res = avtp_tscf_pdu_set(pdu, AVTP_TSCF_FIELD_TIMESTAMP,
+						(uint32_t) pktzr->start);
+	if (res < 0)
+		return res;
+
+	res = avtp_tscf_pdu_set(pdu, AVTP_TSCF_FIELD_STREAM_DATA_LEN,
+							pktzr->data_len);
+	if (res < 0)
+		return res;
+
+	res = avtp_tscf_pdu_set(pdu, AVTP_TSCF_FIELD_SEQ_NUM,
+							pktzr->seq_num++);
+	if (res < 0)
+		return res;
+
+	*pdu_len = sizeof(struct avtp_stream_pdu) + pktzr->data_len;
+	count = pktzr->count;
+
+	pktzr->data_len = 0;
+	pktzr->count = 0;
+
+	return count;
+}
+
+int avtp_tscf_iter_init(struct avtp_tscf_iter *iter,
+				const struct avtp_stream_pdu *pdu, size_t len,
+				uint64_t now)
+{
+	uint64_t data_len, tv, timestamp;
+	uint32_t subtype;
+
+	if (!iter || !pdu)
+		return -EINVAL;
+
+	if (len < sizeof(struct avtp_stream_pdu))
+		return -EBADMSG;
+
+	avtp_pdu_get((const struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+								&subtype);
+	if (subtype != AVTP_SUBTYPE_TSCF)
+		return -EBADMSG;
+
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_STREAM_DATA_LEN, &data_len);
+	if (data_len > len - sizeof(struct avtp_stream_pdu))
+		return -EBADMSG;
+
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_TV, &tv);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_TIMESTAMP, &timestamp);
+
+	/* 'avtp_timestamp' wraps every ~4.3 s. Pick the time closest to
+	 * 'now', which is right as long as the PDU is presented within 2 s.
+	 */
+	if (tv)
+		iter->time = now + (int32_t)((uint32_t) timestamp -
+							(uint32_t) now);
+	else
+		iter->time = now;
+
+	return avtp_acf_iter_init(&iter->acf, pdu->avtp_payload, data_len);
+}
+
+int avtp_tscf_iter_next(struct avtp_tscf_iter *iter, struct avtp_acf_msg *msg,
+							uint64_t *time)
+{
+	struct avtp_acf_can can;
+	int res;
+
+	if (!iter || !msg || !time)
+		return -EINVAL;
+
+	res = avtp_acf_iter_next(&iter->acf, msg);
+	if (res <= 0)
+		return res;
+
+	*time = iter->time;
+
+	/* A malformed CAN message is reported by avtp_acf_can_read() when
+	 * the caller decodes it, so it just gets the AVTPDU time here.
+	 */
+	if (msg->type == AVTP_ACF_TYPE_CAN &&
+				avtp_acf_can_read(msg, &can) == 0 &&
+				(can.flags & AVTP_ACF_CAN_FLAG_MTV))
+		*time = can.timestamp;
+
+	return 1;
+}
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <string.h>
+#include <sys/socket.h>
+/* linux/errqueue.h uses struct timespec without including time.h. */
+#include <time.h>
+#include <linux/errqueue.h>
+
+#include "avtp_tx.h"
+#include "probes.h"
+
+/* Number of PDUs sent per sendmmsg() call. */
+#define TX_BATCH			32
+
+/* Up to this many completion notifications are read per recvmmsg() call. */
+#define ZC_REAP_BATCH			16
+#define ZC_CONTROL_LEN			CMSG_SPACE(sizeof(struct sock_extended_err))
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY			60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY			0x4000000
+#endif
+
+static bool is_valid_pdu(const void *header, const struct iovec *payload,
+								int iovcnt)
+{
+	return header && iovcnt >= 0 && iovcnt <= AVTP_TX_MAX_IOV &&
+						(payload || !iovcnt);
+}
+
+/* Trace a PDU sent. Headers too short to hold the stream ID and timestamp
+ * are traced with those fields at 0.
+ */
+static inline void probe_tx_pdu(const void *header, size_t header_len,
+								size_t len)
+{
+	AVTP_PROBE4(tx_pdu, header_len >= 16 ? probe_stream_id(header) : 0,
+			header_len > 2 ? probe_seq_num(header) : 0,
+			header_len >= 16 ? probe_avtp_time(header) : 0, len);
+}
+
+static void init_msg(struct msghdr *msg, struct iovec *iov,
+				const struct sockaddr_ll *addr,
+				const void *header, size_t header_len,
+				const struct iovec *payload, int iovcnt)
+{
+	iov[0].iov_base = (void *) header;
+	iov[0].iov_len = header_len;
+	if (iovcnt)
+		memcpy(&iov[1], payload, iovcnt * sizeof(*payload));
+
+	memset(msg, 0, sizeof(*msg));
+	msg->msg_name = (void *) addr;
+	msg->msg_namelen = addr ? sizeof(*addr) : 0;
+	msg->msg_iov = iov;
+	msg->msg_iovlen = iovcnt + 1;
+}
+
+ssize_t avtp_tx_send(int fd, const struct sockaddr_ll *addr,
+			const void *header, size_t header_len,
+			const struct iovec *iov, int iovcnt, int flags)
+{
+	struct iovec msg_iov[AVTP_TX_MAX_IOV + 1];
+	struct msghdr msg;
+	ssize_t n;
+
+	if (!is_valid_pdu(header, iov, iovcnt))
+		return -EINVAL;
+
+	init_msg(&msg, msg_iov, addr, header, header_len, iov, iovcnt);
+
+	n = sendmsg(fd, &msg, flags);
+	if (n < 0)
+		return -errno;
+
+	probe_tx_pdu(header, header_len, n);
+
+	return n;
+}
+
+int avtp_tx_send_batch(int fd, const struct sockaddr_ll *addr,
+			const struct avtp_tx_pdu *pdus, unsigned int count,
+			int flags)
+{
+	struct iovec iov[TX_BATCH][AVTP_TX_MAX_IOV + 1];
+	struct mmsghdr msgs[TX_BATCH];
+	unsigned int i, sent = 0;
+
+	if (!pdus)
+		return -EINVAL;
+
+	/* Validate the whole burst upfront so an invalid PDU is not
+	 * reported after some PDUs were already sent.
+	 */
+	for (i = 0; i < count; i++) {
+		if (!is_valid_pdu(pdus[i].header, pdus[i].iov,
+							pdus[i].iovcnt))
+			return -EINVAL;
+	}
+
+	while (sent < count) {
+		unsigned int batch = count - sent;
+		int res;
+
+		if (batch > TX_BATCH)
+			batch = TX_BATCH;
+
+		for (i = 0; i < batch; i++) {
+			const struct avtp_tx_pdu *pdu = &pdus[sent + i];
+
+			init_msg(&msgs[i].msg_hdr, iov[i], addr, pdu->header,
+					pdu->header_len, pdu->iov, pdu->iovcnt);
+			msgs[i].msg_len = 0;
+		}
+
+		res = sendmmsg(fd, msgs, batch, flags);
+		if (res < 0) {
+			if (sent)
+				break;
+			return -errno;
+		}
+
+		for (i = 0; i < (unsigned int) res; i++)
+			probe_tx_pdu(pdus[sent + i].header,
+					pdus[sent + i].header_len,
+					msgs[i].msg_len);
+
+		sent += res;
+		if ((unsigned int) res < batch)
+			break;
+	}
+
+	AVTP_PROBE2(tx_batch, count, sent);
+
+	return sent;
+}
+
+int avtp_tx_zc_init(struct avtp_tx_zc *zc, int fd)
+{
+	int one = 1;
+
+	if (!zc || fd < 0)
+		return -EINVAL;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0)
+		return -errno;
+
+	memset(zc, 0, sizeof(*zc));
+	zc->fd = fd;
+
+	return 0;
+}
+
+ssize_t avtp_tx_zc_send(struct avtp_tx_zc *zc, const void *header,
+				size_t header_len, const struct iovec *iov,
+				int iovcnt, int flags, uint32_t *id)
+{
+	struct iovec msg_iov[AVTP_TX_MAX_IOV + 1];
+	struct msghdr msg;
+	ssize_t n;
+
+	if (!zc || !id || !is_valid_pdu(header, iov, iovcnt))
+		return -EINVAL;
+
+	if (zc->next - zc->released >= AVTP_TX_ZC_WINDOW)
+		return -ENOBUFS;
+
+	init_msg(&msg, msg_iov, NULL, header, header_len, iov, iovcnt);
+
+	/* The kernel numbers zero-copy sends on the socket sequentially and
+	 * does not consume an id when sendmsg() fails.
+	 */
+	n = sendmsg(zc->fd, &msg, flags | MSG_ZEROCOPY);
+	if (n < 0)
+		return -errno;
+
+	probe_tx_pdu(header, header_len, n);
+
+	*id = zc->next++;
+
+	return n;
+}
+
+static inline bool is_done(const struct avtp_tx_zc *zc, uint32_t id)
+{
+	id %= AVTP_TX_ZC_WINDOW;
+
+	return zc->done[id / 64] & (1ULL << (id % 64));
+}
+
+/* Mark sends 'lo' to 'hi' (inclusive) as released. Notifications for
+ * different ranges may arrive out of order, so 'released' only advances
+ * over contiguous released sends.
+ */
+static void release_range(struct avtp_tx_zc *zc, uint32_t lo, uint32_t hi)
+{
+	uint32_t id;
+
+	/* No more than the window can be in flight. */
+	if (hi - lo >= AVTP_TX_ZC_WINDOW)
+		hi = lo + AVTP_TX_ZC_WINDOW - 1;
+
+	for (id = lo; id - lo <= hi - lo; id++) {
+		uint32_t slot = id % AVTP_TX_ZC_WINDOW;
+
+		/* Ignore ids outside the in-flight window. */
+		if (id - zc->released >= zc->next - zc->released)
+			continue;
+
+		zc->done[slot / 64] |= 1ULL << (slot % 64);
+	}
+
+	while (zc->released != zc->next && is_done(zc, zc->released)) {
+		uint32_t slot = zc->released % AVTP_TX_ZC_WINDOW;
+
+		zc->done[slot / 64] &= ~(1ULL << (slot % 64));
+		zc->released++;
+	}
+}
+
+int avtp_tx_zc_reap(struct avtp_tx_zc *zc)
+{
+	char control[ZC_REAP_BATCH][ZC_CONTROL_LEN];
+	struct mmsghdr msgs[ZC_REAP_BATCH];
+	int i, res, count = 0;
+
+	if (!zc)
+		return -EINVAL;
+
+	while (1) {
+		memset(msgs, 0, sizeof(msgs));
+		for (i = 0; i < ZC_REAP_BATCH; i++) {
+			msgs[i].msg_hdr.msg_control = control[i];
+			msgs[i].msg_hdr.msg_controllen = ZC_CONTROL_LEN;
+		}
+
+		res = recvmmsg(zc->fd, msgs, ZC_REAP_BATCH,
+					MSG_ERRQUEUE | MSG_DONTWAIT, NULL);
+		if (res < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return -errno;
+		}
+
+		for (i = 0; i < res; i++) {
+			struct cmsghdr *cm = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+			struct sock_extended_err serr;
+
+			if (!cm || cm->cmsg_len < CMSG_LEN(sizeof(serr)))
+				continue;
+
+			memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+			if (serr.ee_errno != 0 ||
+				serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+				continue;
+
+			/* The kernel reports the range of released send ids
+			 * in 'ee_info' (first) and 'ee_data' (last).
+			 */
+			release_range(zc, serr.ee_info, serr.ee_data);
+
+			zc->completions += serr.ee_data - serr.ee_info + 1;
+			if (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				zc->copied += serr.ee_data - serr.ee_info + 1;
+
+			count++;
+		}
+
+		if (res < ZC_REAP_BATCH)
+			break;
+	}
+
+	return count;
+}
+
+int avtp_tx_zc_is_released(const struct avtp_tx_zc *zc, uint32_t id)
+{
+	if (!zc)
+		return -EINVAL;
+
+	/* Sends from 'released' up to 'next' are in flight. */
+	if (id - zc->released < zc->next - zc->released)
+		return is_done(zc, id);
+
+	return 1;
+}
+
+int avtp_tx_zc_get_pending(const struct avtp_tx_zc *zc, uint32_t *pending)
+{
+	uint32_t id;
+
+	if (!zc || !pending)
+		return -EINVAL;
+
+	*pending = 0;
+	for (id = zc->released; id != zc->next; id++)
+		*pending += !is_done(zc, id);
+
+	return 0;
+}
+
+int avtp_tx_zc_get_stats(const struct avtp_tx_zc *zc,
+				struct avtp_tx_zc_stats *stats)
+{
+	if (!zc || !stats)
+		return -EINVAL;
+
+	stats->completions = zc->completions;
+	stats->copied = zc->copied;
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+/* USDT static tracepoints, provider 'avtp'. They are only built with the
+ * 'usdt' build option, which defines AVTP_USDT, and compile to nothing
+ * otherwise. With probes built in, each one is a single nop until a tracer
+ * attaches to it, e.g.:
+ *
+ * $ bpftrace -e 'usdt:/usr/lib/libavtp.so:avtp:tx_pdu { @[arg0] = count(); }'
+ *
+ * Probes of the data path carry the stream ID, sequence number and AVTP
+ * timestamp of the PDU, so per-packet latency can be traced end to end:
+ *
+ *   pdu_init(subtype, pdu)
+ *   field_get_fail(subtype, field, err)
+ *   field_set_fail(subtype, field, err)
+ *   tx_pdu(stream_id, seq_num, avtp_time, len)
+ *   tx_batch(count, sent)
+ *   rx_pdu(stream_id, seq_num, avtp_time, source_packets)
+ *   jb_enqueue(time, queued)
+ *   jb_dequeue(time, count, queued)
+ *      (presentation scheduler and IEC 61883-4 TS depacketizer queues)
+ *   shm_publish(seq, time, len)
+ *   present(time, now, len)
+ */
+
+#include <endian.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef AVTP_USDT
+
+#include <sys/sdt.h>
+
+#define AVTP_PROBE2(name, a, b)		DTRACE_PROBE2(avtp, name, a, b)
+#define AVTP_PROBE3(name, a, b, c)	DTRACE_PROBE3(avtp, name, a, b, c)
+#define AVTP_PROBE4(name, a, b, c, d)	DTRACE_PROBE4(avtp, name, a, b, c, d)
+
+#else
+
+/* Arguments are consumed with sizeof, so they count as used but are not
+ * evaluated.
+ */
+#define AVTP_PROBE2(name, a, b)						\
+	do { (void) sizeof(a); (void) sizeof(b); } while (0)
+#define AVTP_PROBE3(name, a, b, c)					\
+	do { AVTP_PROBE2(name, a, b); (void) sizeof(c); } while (0)
+#define AVTP_PROBE4(name, a, b, c, d)					\
+	do { AVTP_PROBE3(name, a, b, c); (void) sizeof(d); } while (0)
+
+#endif
+
+/* Helpers to extract probe arguments from a PDU, evaluated only when probes
+ * are built in. The stream ID, sequence number and timestamp are at the same
+ * offsets in all stream PDUs, as well as in CRF and NTSCF PDUs for the stream
+ * ID and sequence number.
+ */
+static inline uint8_t probe_subtype(const void *pdu)
+{
+	return pdu ? *(const uint8_t *) pdu : 0;
+}
+
+static inline uint8_t probe_seq_num(const void *pdu)
+{
+	return ((const uint8_t *) pdu)[2];
+}
+
+static inline uint64_t probe_stream_id(const void *pdu)
+{
+	uint64_t val;
+
+	memcpy(&val, (const uint8_t *) pdu + 4, sizeof(val));
+	return be64toh(val);
+}
+
+static inline uint32_t probe_avtp_time(const void *pdu)
+{
+	uint32_t val;
+
+	memcpy(&val, (const uint8_t *) pdu + 12, sizeof(val));
+	return be32toh(val);
+}
+
+#define AVTP_PROBE_FIELD_GET_FAIL(pdu, field, err)			\
+	AVTP_PROBE3(field_get_fail, probe_subtype(pdu), (int) (field), err)
+
+#define AVTP_PROBE_FIELD_SET_FAIL(pdu, field, err)			\
+	AVTP_PROBE3(field_set_fail, probe_subtype(pdu), (int) (field), err)
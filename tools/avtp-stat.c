@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2017, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* avtp-stat: display the statistics of an AVTP application.
+ *
+ * Applications export per-stream counters through a registry file created
+ * with avtp_stats_create() (see avtp_stats.h), e.g. 'aaf-listener --stats
+ * /dev/shm/aaf-listener'. This tool maps that file read-only and prints the
+ * counters of every stream, once or, with '--interval', periodically along
+ * with packet and byte rates. It never touches the application data path.
+ *
+ * $ avtp-stat --interval 1000 /dev/shm/aaf-listener
+ */
+
+#include <argp.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "avtp_stats.h"
+
+#define NSEC_PER_USEC		1000.0
+#define MAX_STREAMS		256
+
+static const char *invalid_names[AVTP_STATS_INVALID_MAX] = {
+	[AVTP_STATS_INVALID_SUBTYPE] = "subtype",
+	[AVTP_STATS_INVALID_VERSION] = "version",
+	[AVTP_STATS_INVALID_STREAM_ID] = "stream_id",
+	[AVTP_STATS_INVALID_TV] = "tv",
+	[AVTP_STATS_INVALID_SP] = "sp",
+	[AVTP_STATS_INVALID_FORMAT] = "format",
+	[AVTP_STATS_INVALID_RATE] = "rate",
+	[AVTP_STATS_INVALID_CHANNELS] = "channels",
+	[AVTP_STATS_INVALID_DEPTH] = "depth",
+	[AVTP_STATS_INVALID_DATA_LEN] = "data_len",
+	[AVTP_STATS_INVALID_OTHER] = "other",
+};
+
+static char *path;
+static int interval;
+
+static struct argp_option options[] = {
+	{"interval", 'n', "MSEC", 0, "Refresh every MSEC milliseconds" },
+	{ 0 }
+};
+
+static error_t parser(int key, char *arg, struct argp_state *state)
+{
+	switch (key) {
+	case 'n':
+		interval = atoi(arg);
+		break;
+	case ARGP_KEY_ARG:
+		if (path)
+			argp_usage(state);
+		path = arg;
+		break;
+	case ARGP_KEY_END:
+		if (!path)
+			argp_usage(state);
+		break;
+	}
+
+	return 0;
+}
+
+static struct argp argp = { options, parser, "PATH" };
+
+static void print_stream(unsigned int index, uint64_t stream_id,
+				const char *name,
+				const struct avtp_stats_counters *c,
+				const struct avtp_stats_counters *prev)
+{
+	uint64_t invalid = 0;
+	int i;
+
+	for (i = 0; i < AVTP_STATS_INVALID_MAX; i++)
+		invalid += c->invalid[i];
+
+	printf("stream %u '%s' %016" PRIx64 "\n", index, name, stream_id);
+
+	printf("  packets %" PRIu64 " bytes %" PRIu64, c->packets, c->bytes);
+	if (prev && interval > 0) {
+		double secs = interval / 1000.0;
+
+		printf(" (%.0f packets/s, %.0f bytes/s)",
+				(c->packets - prev->packets) / secs,
+				(c->bytes - prev->bytes) / secs);
+	}
+	printf("\n");
+
+	printf("  seq gaps %" PRIu64 " late drops %" PRIu64
+				" early drops %" PRIu64 " invalid %" PRIu64,
+				c->seq_gaps, c->late_drops, c->early_drops,
+				invalid);
+	for (i = 0; i < AVTP_STATS_INVALID_MAX; i++) {
+		if (c->invalid[i])
+			printf(" %s=%" PRIu64, invalid_names[i],
+							c->invalid[i]);
+	}
+	printf("\n");
+
+	if (c->margin_count) {
+		printf("  margin us min %.1f avg %.1f max %.1f\n",
+			c->margin_min / NSEC_PER_USEC,
+			(double) c->margin_sum / c->margin_count /
+							NSEC_PER_USEC,
+			c->margin_max / NSEC_PER_USEC);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	static struct avtp_stats_counters prev[MAX_STREAMS];
+	struct avtp_stats *stats;
+	bool first = true;
+	int res;
+
+	argp_parse(&argp, argc, argv, 0, NULL, NULL);
+
+	res = avtp_stats_open(&stats, path);
+	if (res < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path,
+							strerror(-res));
+		return 1;
+	}
+
+	while (1) {
+		unsigned int count, i;
+
+		avtp_stats_get_stream_count(stats, &count);
+		for (i = 0; i < count; i++) {
+			struct avtp_stats_counters c;
+			char name[AVTP_STATS_NAME_LEN];
+			uint64_t stream_id;
+
+			res = avtp_stats_read(stats, i, &stream_id, name, &c);
+			if (res < 0)
+				break;
+
+			print_stream(i, stream_id, name, &c,
+				(!first && i < MAX_STREAMS) ? &prev[i] : NULL);
+			if (i < MAX_STREAMS)
+				prev[i] = c;
+		}
+
+		if (interval <= 0)
+			break;
+
+		printf("\n");
+		fflush(stdout);
+		first = false;
+		usleep(interval * 1000);
+	}
+
+	avtp_stats_destroy(stats);
+	return 0;
+}
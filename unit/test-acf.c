@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "avtp_acf.h"
+
+static const uint8_t can_data[] = { 0xAA, 0xBB, 0xCC };
+
+/* ACF CAN message with 'mtv' and 'eff' set, 'can_bus_id' 3, timestamp
+ * 0x0102030405060708, identifier 0x1ABCDEF0 and can_data as payload, followed
+ * by a 2-quadlet user message.
+ */
+static const uint8_t msgs[] = {
+	0x02, 0x05, 0x68, 0x03,
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+	0x1A, 0xBC, 0xDE, 0xF0,
+	0xAA, 0xBB, 0xCC, 0x00,
+	0xF0, 0x02, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00,
+};
+
+static void acf_iter(void **state)
+{
+	int res;
+	struct avtp_acf_iter iter;
+	struct avtp_acf_msg msg;
+
+	res = avtp_acf_iter_init(NULL, msgs, sizeof(msgs));
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_acf_iter_init(&iter, msgs, sizeof(msgs));
+	assert_int_equal(res, 0);
+
+	res = avtp_acf_iter_next(&iter, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 1);
+	assert_ptr_equal(msg.data, msgs);
+	assert_int_equal(msg.len, 20);
+	assert_int_equal(msg.type, AVTP_ACF_TYPE_CAN);
+
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 1);
+	assert_ptr_equal(msg.data, msgs + 20);
+	assert_int_equal(msg.len, 8);
+	assert_int_equal(msg.type, AVTP_ACF_TYPE_USER0);
+
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 0);
+}
+
+static void acf_iter_malformed(void **state)
+{
+	int res;
+	struct avtp_acf_iter iter;
+	struct avtp_acf_msg msg;
+	uint8_t buf[sizeof(msgs)];
+
+	/* Second message runs past the end. */
+	avtp_acf_iter_init(&iter, msgs, sizeof(msgs) - 4);
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 1);
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, -EBADMSG);
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 0);
+
+	/* Zero length message. */
+	memcpy(buf, msgs, sizeof(msgs));
+	buf[1] = 0;
+	avtp_acf_iter_init(&iter, buf, sizeof(buf));
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, -EBADMSG);
+
+	/* Trailing bytes shorter than a quadlet. */
+	avtp_acf_iter_init(&iter, msgs, 22);
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 1);
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, -EBADMSG);
+}
+
+static void acf_can_read(void **state)
+{
+	int res;
+	struct avtp_acf_msg msg = { msgs, 20, AVTP_ACF_TYPE_CAN };
+	struct avtp_acf_can can;
+
+	res = avtp_acf_can_read(&msg, &can);
+	assert_int_equal(res, 0);
+	assert_true(can.timestamp == 0x0102030405060708ULL);
+	assert_int_equal(can.id, 0x1ABCDEF0);
+	assert_int_equal(can.flags, AVTP_ACF_CAN_FLAG_MTV |
+						AVTP_ACF_CAN_FLAG_EFF);
+	assert_int_equal(can.bus_id, 3);
+	assert_int_equal(can.len, sizeof(can_data));
+	assert_ptr_equal(can.data, msgs + 16);
+
+	msg.type = AVTP_ACF_TYPE_USER0;
+	res = avtp_acf_can_read(&msg, &can);
+	assert_int_equal(res, -EINVAL);
+
+	/* Padding longer than the message. */
+	msg.type = AVTP_ACF_TYPE_CAN;
+	msg.len = 16;
+	res = avtp_acf_can_read(&msg, &can);
+	assert_int_equal(res, -EBADMSG);
+}
+
+static void acf_can_write(void **state)
+{
+	ssize_t res;
+	uint8_t buf[sizeof(msgs)];
+	struct avtp_acf_can can = {
+		.timestamp = 0x0102030405060708ULL,
+		.id = 0x1ABCDEF0,
+		.data = can_data,
+		.len = sizeof(can_data),
+		.flags = AVTP_ACF_CAN_FLAG_MTV | AVTP_ACF_CAN_FLAG_EFF,
+		.bus_id = 3,
+	};
+
+	memset(buf, 0xFF, sizeof(buf));
+
+	res = avtp_acf_can_get_len(&can, AVTP_ACF_TYPE_CAN);
+	assert_int_equal(res, 20);
+
+	res = avtp_acf_can_get_len(&can, AVTP_ACF_TYPE_CAN_BRIEF);
+	assert_int_equal(res, 12);
+
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_CAN, buf, 19);
+	assert_int_equal(res, -ENOSPC);
+	assert_int_equal(buf[0], 0xFF);
+
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_CAN, buf, sizeof(buf));
+	assert_int_equal(res, 20);
+	assert_memory_equal(buf, msgs, 20);
+}
+
+static void acf_can_write_invalid(void **state)
+{
+	ssize_t res;
+	uint8_t buf[128];
+	uint8_t data[AVTP_ACF_CAN_MAX_DATA_LEN] = { 0 };
+	struct avtp_acf_can can = { .data = data };
+
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_USER0, buf, sizeof(buf));
+	assert_int_equal(res, -EINVAL);
+
+	/* CAN FD length without 'fdf'. */
+	can.len = 12;
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_CAN, buf, sizeof(buf));
+	assert_int_equal(res, -EINVAL);
+
+	/* Not a CAN FD length. */
+	can.flags = AVTP_ACF_CAN_FLAG_FDF;
+	can.len = 13;
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_CAN, buf, sizeof(buf));
+	assert_int_equal(res, -EINVAL);
+
+	/* 29-bit identifier without 'eff'. */
+	can.len = 8;
+	can.id = 0x800;
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_CAN, buf, sizeof(buf));
+	assert_int_equal(res, -EINVAL);
+
+	can.id = 0;
+	can.bus_id = 32;
+	res = avtp_acf_can_write(&can, AVTP_ACF_TYPE_CAN, buf, sizeof(buf));
+	assert_int_equal(res, -EINVAL);
+}
+
+static void acf_can_round_trip(void **state)
+{
+	int i;
+	uint8_t buf[128];
+	uint8_t data[AVTP_ACF_CAN_MAX_DATA_LEN];
+	static const uint8_t types[] = {
+		AVTP_ACF_TYPE_CAN,
+		AVTP_ACF_TYPE_CAN_BRIEF,
+	};
+	static const uint8_t lens[] = { 0, 1, 7, 8, 12, 20, 48, 64 };
+
+	for (i = 0; i < (int) sizeof(data); i++)
+		data[i] = i;
+
+	for (i = 0; i < 16; i++) {
+		ssize_t len;
+		int res;
+		struct avtp_acf_iter iter;
+		struct avtp_acf_msg msg;
+		struct avtp_acf_can out;
+		struct avtp_acf_can in = {
+			.timestamp = 1000 * i,
+			.id = 0x123,
+			.data = data,
+			.len = lens[i % 8],
+			.flags = AVTP_ACF_CAN_FLAG_FDF | AVTP_ACF_CAN_FLAG_BRS,
+			.bus_id = i,
+		};
+
+		len = avtp_acf_can_write(&in, types[i / 8], buf, sizeof(buf));
+		assert_true(len > 0);
+		assert_int_equal(len % 4, 0);
+
+		avtp_acf_iter_init(&iter, buf, len);
+		res = avtp_acf_iter_next(&iter, &msg);
+		assert_int_equal(res, 1);
+		assert_int_equal(msg.type, types[i / 8]);
+		assert_int_equal(msg.len, len);
+
+		res = avtp_acf_can_read(&msg, &out);
+		assert_int_equal(res, 0);
+		assert_int_equal(out.id, in.id);
+		assert_int_equal(out.len, in.len);
+		assert_int_equal(out.flags, in.flags);
+		assert_int_equal(out.bus_id, in.bus_id);
+		assert_memory_equal(out.data, data, in.len);
+		if (types[i / 8] == AVTP_ACF_TYPE_CAN)
+			assert_true(out.timestamp == in.timestamp);
+	}
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(acf_iter),
+		cmocka_unit_test(acf_iter_malformed),
+		cmocka_unit_test(acf_can_read),
+		cmocka_unit_test(acf_can_write),
+		cmocka_unit_test(acf_can_write_invalid),
+		cmocka_unit_test(acf_can_round_trip),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
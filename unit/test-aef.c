@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <arpa/inet.h>
+#include <endian.h>
+
+#include "avtp.h"
+#include "avtp_aef.h"
+
+#define KEY_ID			0x11223344
+#define SALT			0xCAFEBABE
+#define INNER_LEN		100
+#define BUF_LEN			(INNER_LEN + AVTP_AEF_OVERHEAD)
+#define BURST			4
+
+static const uint8_t key[32] = {
+	0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+	0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+	0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+	0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+};
+
+/* Build an AEF AVTPDU encapsulating INNER_LEN bytes of 'inner'. */
+static struct avtp_stream_pdu *prepare(uint8_t *buf, const uint8_t *inner)
+{
+	struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *) buf;
+
+	avtp_aef_pdu_init(pdu);
+	avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_STREAM_ID, 0xAABBCCDDEEFF0001);
+	memcpy(buf + AVTP_AEF_HEADER_LEN, inner, INNER_LEN);
+
+	return pdu;
+}
+
+static void fill_inner(uint8_t *inner)
+{
+	int i;
+
+	for (i = 0; i < INNER_LEN; i++)
+		inner[i] = rand();
+}
+
+static void aef_get_set_fields(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	res = avtp_aef_pdu_get(NULL, AVTP_AEF_FIELD_SV, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_pdu_get(&pdu, AVTP_AEF_FIELD_MAX, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_pdu_set(&pdu, AVTP_AEF_FIELD_MAX, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_pdu_set(&pdu, AVTP_AEF_FIELD_KEY_ID, KEY_ID);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.format_specific), KEY_ID);
+
+	res = avtp_aef_pdu_get(&pdu, AVTP_AEF_FIELD_KEY_ID, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == KEY_ID);
+
+	res = avtp_aef_pdu_set(&pdu, AVTP_AEF_FIELD_STREAM_DATA_LEN, 124);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.packet_info), 124 << 16);
+}
+
+static void aef_pdu_init(void **state)
+{
+	int res;
+	struct avtp_stream_pdu pdu;
+
+	memset(&pdu, 0xFF, sizeof(pdu));
+
+	res = avtp_aef_pdu_init(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_pdu_init(&pdu);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.subtype_data), 0x6E800000);
+	assert_true(pdu.stream_id == 0);
+	assert_true(pdu.format_specific == 0);
+}
+
+static void aef_create_invalid(void **state)
+{
+	int res;
+	struct avtp_aef *aef;
+
+	res = avtp_aef_create(NULL, key, 16, KEY_ID, SALT, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_create(&aef, NULL, 16, KEY_ID, SALT, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_create(&aef, key, 24, KEY_ID, SALT, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_create(&aef, key, 16, KEY_ID, SALT, AVTP_AEF_PORTABLE);
+	assert_int_equal(res, 0);
+	assert_int_equal(avtp_aef_is_accelerated(aef), 0);
+	avtp_aef_destroy(aef);
+}
+
+static void round_trip(uint32_t tx_flags, uint32_t rx_flags, size_t key_len)
+{
+	int res, i;
+	uint64_t val, first_iv = 0;
+	size_t pdu_len, inner_len;
+	uint8_t inner[INNER_LEN], buf[BUF_LEN];
+	struct avtp_aef *tx, *rx;
+	struct avtp_stream_pdu *pdu;
+
+	res = avtp_aef_create(&tx, key, key_len, KEY_ID, SALT, tx_flags);
+	assert_int_equal(res, 0);
+	res = avtp_aef_create(&rx, key, key_len, KEY_ID, SALT, rx_flags);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < 3; i++) {
+		fill_inner(inner);
+		pdu = prepare(buf, inner);
+
+		res = avtp_aef_encrypt(tx, pdu, INNER_LEN, &pdu_len);
+		assert_int_equal(res, 0);
+		assert_int_equal(pdu_len, BUF_LEN);
+		assert_true(memcmp(buf + AVTP_AEF_HEADER_LEN, inner,
+							INNER_LEN) != 0);
+
+		avtp_aef_pdu_get(pdu, AVTP_AEF_FIELD_KEY_ID, &val);
+		assert_true(val == KEY_ID);
+		avtp_aef_pdu_get(pdu, AVTP_AEF_FIELD_SEQ_NUM, &val);
+		assert_true(val == (uint64_t) i);
+		avtp_aef_pdu_get(pdu, AVTP_AEF_FIELD_STREAM_DATA_LEN, &val);
+		assert_true(val == BUF_LEN - sizeof(struct avtp_stream_pdu));
+
+		/* Explicit IV is a per-PDU counter. */
+		memcpy(&val, pdu->avtp_payload, sizeof(val));
+		if (!i)
+			first_iv = be64toh(val);
+		assert_true(be64toh(val) == first_iv + i);
+
+		res = avtp_aef_decrypt(rx, pdu, pdu_len, &inner_len);
+		assert_int_equal(res, 0);
+		assert_int_equal(inner_len, INNER_LEN);
+		assert_memory_equal(buf + AVTP_AEF_HEADER_LEN, inner,
+								INNER_LEN);
+	}
+
+	avtp_aef_destroy(tx);
+	avtp_aef_destroy(rx);
+}
+
+static void aef_round_trip(void **state)
+{
+	round_trip(0, 0, 16);
+	round_trip(0, 0, 32);
+}
+
+/* Both implementations interoperate. */
+static void aef_round_trip_portable(void **state)
+{
+	round_trip(AVTP_AEF_PORTABLE, AVTP_AEF_PORTABLE, 16);
+	round_trip(0, AVTP_AEF_PORTABLE, 16);
+	round_trip(AVTP_AEF_PORTABLE, 0, 32);
+}
+
+static void aef_encrypt_invalid(void **state)
+{
+	int res;
+	size_t pdu_len;
+	uint8_t inner[INNER_LEN] = { 0 }, buf[BUF_LEN];
+	struct avtp_aef *aef;
+	struct avtp_stream_pdu *pdu = prepare(buf, inner);
+
+	avtp_aef_create(&aef, key, 16, KEY_ID, SALT, 0);
+
+	res = avtp_aef_encrypt(NULL, pdu, INNER_LEN, &pdu_len);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_encrypt(aef, pdu, 0, &pdu_len);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_aef_encrypt(aef, pdu, 65536, &pdu_len);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_AAF);
+	res = avtp_aef_encrypt(aef, pdu, INNER_LEN, &pdu_len);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_aef_destroy(aef);
+}
+
+static void aef_decrypt_rejected(void **state)
+{
+	int res;
+	size_t pdu_len, inner_len;
+	uint8_t inner[INNER_LEN], buf[BUF_LEN], copy[BUF_LEN];
+	uint8_t other_key[16] = { 0 };
+	struct avtp_aef *tx, *rx, *other;
+	struct avtp_stream_pdu *pdu;
+
+	fill_inner(inner);
+	pdu = prepare(buf, inner);
+
+	avtp_aef_create(&tx, key, 16, KEY_ID, SALT, 0);
+	avtp_aef_create(&rx, key, 16, KEY_ID, SALT, 0);
+	avtp_aef_encrypt(tx, pdu, INNER_LEN, &pdu_len);
+	memcpy(copy, buf, sizeof(buf));
+
+	res = avtp_aef_decrypt(rx, pdu, AVTP_AEF_OVERHEAD - 1, &inner_len);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_aef_decrypt(rx, pdu, pdu_len - 1, &inner_len);
+	assert_int_equal(res, -EBADMSG);
+
+	/* Payload, header and tag are all authenticated. */
+	buf[AVTP_AEF_HEADER_LEN + 10] ^= 1;
+	res = avtp_aef_decrypt(rx, pdu, pdu_len, &inner_len);
+	assert_int_equal(res, -EBADMSG);
+	assert_memory_equal(buf + AVTP_AEF_HEADER_LEN + 11,
+				copy + AVTP_AEF_HEADER_LEN + 11, INNER_LEN - 11);
+	buf[AVTP_AEF_HEADER_LEN + 10] ^= 1;
+
+	buf[5] ^= 1;
+	res = avtp_aef_decrypt(rx, pdu, pdu_len, &inner_len);
+	assert_int_equal(res, -EBADMSG);
+	buf[5] ^= 1;
+
+	buf[pdu_len - 1] ^= 1;
+	res = avtp_aef_decrypt(rx, pdu, pdu_len, &inner_len);
+	assert_int_equal(res, -EBADMSG);
+	buf[pdu_len - 1] ^= 1;
+
+	avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_KEY_ID, KEY_ID + 1);
+	res = avtp_aef_decrypt(rx, pdu, pdu_len, &inner_len);
+	assert_int_equal(res, -ENOKEY);
+	avtp_aef_pdu_set(pdu, AVTP_AEF_FIELD_KEY_ID, KEY_ID);
+
+	avtp_aef_create(&other, other_key, 16, KEY_ID, SALT, 0);
+	res = avtp_aef_decrypt(other, pdu, pdu_len, &inner_len);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_aef_decrypt(rx, pdu, pdu_len, &inner_len);
+	assert_int_equal(res, 0);
+	assert_memory_equal(buf + AVTP_AEF_HEADER_LEN, inner, INNER_LEN);
+
+	avtp_aef_destroy(tx);
+	avtp_aef_destroy(rx);
+	avtp_aef_destroy(other);
+}
+
+/* Contexts created with the same key and salt, e.g. by a restarted talker,
+ * must not start with the same nonce.
+ */
+static void aef_nonce_not_reused(void **state)
+{
+	uint8_t inner[INNER_LEN], buf[2][BUF_LEN];
+	struct avtp_aef *first, *second;
+	size_t pdu_len;
+	int res;
+
+	res = avtp_aef_create(&first, key, 16, KEY_ID, SALT, 0);
+	assert_int_equal(res, 0);
+	res = avtp_aef_create(&second, key, 16, KEY_ID, SALT, 0);
+	assert_int_equal(res, 0);
+
+	fill_inner(inner);
+
+	res = avtp_aef_encrypt(first, prepare(buf[0], inner), INNER_LEN,
+								&pdu_len);
+	assert_int_equal(res, 0);
+	res = avtp_aef_encrypt(second, prepare(buf[1], inner), INNER_LEN,
+								&pdu_len);
+	assert_int_equal(res, 0);
+
+	assert_true(memcmp(buf[0] + sizeof(struct avtp_stream_pdu),
+			buf[1] + sizeof(struct avtp_stream_pdu),
+			AVTP_AEF_IV_LEN) != 0);
+	assert_true(memcmp(buf[0] + AVTP_AEF_HEADER_LEN,
+			buf[1] + AVTP_AEF_HEADER_LEN, INNER_LEN) != 0);
+
+	avtp_aef_destroy(first);
+	avtp_aef_destroy(second);
+}
+
+static void aef_batch(void **state)
+{
+	int res, i;
+	uint8_t inner[BURST][INNER_LEN], bufs[BURST][BUF_LEN];
+	struct avtp_aef_buf burst[BURST];
+	struct avtp_aef *tx, *rx;
+
+	avtp_aef_create(&tx, key, 16, KEY_ID, SALT, 0);
+	avtp_aef_create(&rx, key, 16, KEY_ID, SALT, 0);
+
+	for (i = 0; i < BURST; i++) {
+		fill_inner(inner[i]);
+		burst[i].pdu = prepare(bufs[i], inner[i]);
+		burst[i].len = INNER_LEN;
+	}
+
+	/* Nothing is encrypted if any entry is invalid. */
+	burst[BURST - 1].len = 0;
+	res = avtp_aef_encrypt_batch(tx, burst, BURST);
+	assert_int_equal(res, -EINVAL);
+	assert_memory_equal(bufs[0] + AVTP_AEF_HEADER_LEN, inner[0],
+								INNER_LEN);
+
+	burst[BURST - 1].len = INNER_LEN;
+	res = avtp_aef_encrypt_batch(tx, burst, BURST);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < BURST; i++) {
+		assert_int_equal(burst[i].out_len, BUF_LEN);
+		burst[i].len = burst[i].out_len;
+	}
+
+	bufs[1][AVTP_AEF_HEADER_LEN] ^= 1;
+	res = avtp_aef_decrypt_batch(rx, burst, BURST);
+	assert_int_equal(res, BURST - 1);
+
+	for (i = 0; i < BURST; i++) {
+		if (i == 1) {
+			assert_int_equal(burst[i].res, -EBADMSG);
+			continue;
+		}
+
+		assert_int_equal(burst[i].res, 0);
+		assert_int_equal(burst[i].out_len, INNER_LEN);
+		assert_memory_equal(bufs[i] + AVTP_AEF_HEADER_LEN, inner[i],
+								INNER_LEN);
+	}
+
+	avtp_aef_destroy(tx);
+	avtp_aef_destroy(rx);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(aef_get_set_fields),
+		cmocka_unit_test(aef_pdu_init),
+		cmocka_unit_test(aef_create_invalid),
+		cmocka_unit_test(aef_round_trip),
+		cmocka_unit_test(aef_round_trip_portable),
+		cmocka_unit_test(aef_encrypt_invalid),
+		cmocka_unit_test(aef_decrypt_rejected),
+		cmocka_unit_test(aef_nonce_not_reused),
+		cmocka_unit_test(aef_batch),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "aes_gcm.h"
+
+/* Test cases 2, 4 and 16 from the GCM specification (McGrew and Viega). */
+struct test_vector {
+	const char *key;
+	const char *iv;
+	const char *aad;
+	const char *pt;
+	const char *ct;
+	const char *tag;
+};
+
+static const struct test_vector vectors[] = {
+	{
+		"00000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"00000000000000000000000000000000",
+		"0388dace60b6a392f328c2b971b2fe78",
+		"ab6e47d42cec13bdf53a67b21257bddf",
+	},
+	{
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b39",
+		"42831ec2217774244b7221b784d0d49c"
+		"e3aa212f2c02a4e035c17e2329aca12e"
+		"21d514b25466931c7d8f6a5aac84aa05"
+		"1ba30b396a0aac973d58e091",
+		"5bc94fbc3221a5db94fae95ae7121a47",
+	},
+	{
+		"feffe9928665731c6d6a8f9467308308"
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeefabaddad2",
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b39",
+		"522dc1f099567d07f47f37a32a84427d"
+		"643a8cdcbfe5c0c97598a2bd2555d1aa"
+		"8cb08e48590dbb3da7b08b1056828838"
+		"c5f61e6393ba7a0abcc9f662",
+		"76fc6ece0f4e1768cddf8853bb2d551b",
+	},
+};
+
+static size_t unhex(const char *hex, uint8_t *buf)
+{
+	size_t i, len = strlen(hex) / 2;
+
+	for (i = 0; i < len; i++) {
+		char byte[3] = { hex[2 * i], hex[2 * i + 1], 0 };
+
+		buf[i] = strtoul(byte, NULL, 16);
+	}
+
+	return len;
+}
+
+static void run_vectors(int accel)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+		uint8_t key[32], iv[GCM_IV_LEN], aad[64], data[64], ct[64];
+		uint8_t tag[GCM_TAG_LEN], expected_tag[GCM_TAG_LEN];
+		size_t key_len, aad_len, len;
+		struct aes_gcm gcm;
+		int res;
+
+		key_len = unhex(vectors[i].key, key);
+		unhex(vectors[i].iv, iv);
+		aad_len = unhex(vectors[i].aad, aad);
+		len = unhex(vectors[i].pt, data);
+		unhex(vectors[i].ct, ct);
+		unhex(vectors[i].tag, expected_tag);
+
+		res = aes_gcm_init(&gcm, key, key_len, accel);
+		assert_int_equal(res, 0);
+
+		aes_gcm_encrypt(&gcm, iv, aad, aad_len, data, len, tag);
+		assert_memory_equal(data, ct, len);
+		assert_memory_equal(tag, expected_tag, GCM_TAG_LEN);
+
+		res = aes_gcm_decrypt(&gcm, iv, aad, aad_len, data, len, tag);
+		assert_int_equal(res, 0);
+		unhex(vectors[i].pt, ct);
+		assert_memory_equal(data, ct, len);
+	}
+}
+
+static void aes_gcm_init_invalid(void **state)
+{
+	int res;
+	uint8_t key[32] = { 0 };
+	struct aes_gcm gcm;
+
+	res = aes_gcm_init(NULL, key, 16, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = aes_gcm_init(&gcm, key, 24, 0);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void aes_gcm_vectors_portable(void **state)
+{
+	run_vectors(0);
+}
+
+static void aes_gcm_vectors_accel(void **state)
+{
+	run_vectors(1);
+}
+
+/* The accelerated and portable paths agree on every length, exercising the
+ * interleaved CTR loop, aggregated GHASH and partial blocks.
+ */
+static void aes_gcm_cross_check(void **state)
+{
+	uint8_t key[16], iv[GCM_IV_LEN], aad[100];
+	uint8_t a[300], b[300], tag_a[GCM_TAG_LEN], tag_b[GCM_TAG_LEN];
+	struct aes_gcm sw, ni;
+	size_t len, i;
+
+	for (i = 0; i < sizeof(key); i++)
+		key[i] = rand();
+	for (i = 0; i < sizeof(iv); i++)
+		iv[i] = rand();
+	for (i = 0; i < sizeof(aad); i++)
+		aad[i] = rand();
+
+	aes_gcm_init(&sw, key, sizeof(key), 0);
+	aes_gcm_init(&ni, key, sizeof(key), 1);
+
+	for (len = 0; len <= sizeof(a); len++) {
+		for (i = 0; i < len; i++)
+			a[i] = b[i] = rand();
+
+		aes_gcm_encrypt(&sw, iv, aad, len % sizeof(aad), a, len,
+									tag_a);
+		aes_gcm_encrypt(&ni, iv, aad, len % sizeof(aad), b, len,
+									tag_b);
+		assert_memory_equal(a, b, len);
+		assert_memory_equal(tag_a, tag_b, GCM_TAG_LEN);
+	}
+}
+
+static void aes_gcm_tampered(void **state)
+{
+	int res;
+	uint8_t key[16] = { 0 }, iv[GCM_IV_LEN] = { 0 };
+	uint8_t data[40] = { 0 }, copy[40], tag[GCM_TAG_LEN];
+	uint8_t aad[4] = { 1, 2, 3, 4 };
+	struct aes_gcm gcm;
+
+	aes_gcm_init(&gcm, key, sizeof(key), 1);
+	aes_gcm_encrypt(&gcm, iv, aad, sizeof(aad), data, sizeof(data), tag);
+	memcpy(copy, data, sizeof(data));
+
+	data[20] ^= 1;
+	res = aes_gcm_decrypt(&gcm, iv, aad, sizeof(aad), data, sizeof(data),
+									tag);
+	assert_int_equal(res, -EBADMSG);
+	data[20] ^= 1;
+	assert_memory_equal(data, copy, sizeof(data));
+
+	aad[0] ^= 1;
+	res = aes_gcm_decrypt(&gcm, iv, aad, sizeof(aad), data, sizeof(data),
+									tag);
+	assert_int_equal(res, -EBADMSG);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(aes_gcm_init_invalid),
+		cmocka_unit_test(aes_gcm_vectors_portable),
+		cmocka_unit_test(aes_gcm_vectors_accel),
+		cmocka_unit_test(aes_gcm_cross_check),
+		cmocka_unit_test(aes_gcm_tampered),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <endian.h>
+#include <math.h>
+#include <string.h>
+
+#include "avtp.h"
+#include "avtp_aaf.h"
+#include "avtp_asrc.h"
+
+#define FRAMES				4800
+
+static void asrc_create_null_asrc(void **state)
+{
+	int res;
+
+	res = avtp_asrc_create(NULL, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void asrc_create_invalid_nsr(void **state)
+{
+	int res;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_USER,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ, 0x0B,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void asrc_create_invalid_format(void **state)
+{
+	int res;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_AES3_32BIT, 2, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void asrc_create_invalid_channels(void **state)
+{
+	int res;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 0, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void asrc_set_ratio_invalid_ppb(void **state)
+{
+	int res;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_set_ratio(asrc, 100000001);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_asrc_set_ratio(asrc, -100000001);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_asrc_set_ratio(NULL, 0);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_null_buffer(void **state)
+{
+	int res;
+	size_t produced;
+	int16_t buf[16];
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_process(asrc, NULL, 8, buf, 8, &produced);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_asrc_process(asrc, buf, 8, NULL, 8, &produced);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_asrc_process(asrc, buf, 8, buf, 8, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_asrc_process(NULL, buf, 8, buf, 8, &produced);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_no_space(void **state)
+{
+	int res;
+	size_t needed, produced;
+	int16_t *in, *out;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_96KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 1, 0);
+	assert_int_equal(res, 0);
+
+	in = calloc(FRAMES, sizeof(*in));
+	out = calloc(FRAMES, sizeof(*out));
+
+	res = avtp_asrc_get_output_frames(asrc, FRAMES, &needed);
+	assert_int_equal(res, 0);
+	assert_true(needed > FRAMES);
+
+	res = avtp_asrc_process(asrc, in, FRAMES, out, FRAMES, &produced);
+	assert_int_equal(res, -ENOSPC);
+
+	free(in);
+	free(out);
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_dc(void **state)
+{
+	int res, i;
+	size_t produced;
+	int16_t in[FRAMES * 2], out[FRAMES * 2];
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < FRAMES; i++) {
+		in[i * 2] = 8192;
+		in[i * 2 + 1] = -8192;
+	}
+
+	res = avtp_asrc_process(asrc, in, FRAMES, out, FRAMES, &produced);
+	assert_int_equal(res, 0);
+	assert_true(produced > FRAMES - 32);
+
+	/* Skip the filter ramp-up. */
+	for (i = 32; i < (int)produced; i++) {
+		assert_in_range(out[i * 2], 8191, 8193);
+		assert_in_range(out[i * 2 + 1], -8193, -8191);
+	}
+
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_output_frames(void **state)
+{
+	int res, i;
+	size_t needed, produced, total = 0;
+	int16_t *in, *out;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_96KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 1, 0);
+	assert_int_equal(res, 0);
+
+	in = calloc(FRAMES, sizeof(*in));
+	out = calloc(FRAMES * 2, sizeof(*out));
+
+	/* Odd chunk sizes exercise the history handling across calls. */
+	for (i = 0; i < 100; i++) {
+		res = avtp_asrc_get_output_frames(asrc, 47, &needed);
+		assert_int_equal(res, 0);
+
+		res = avtp_asrc_process(asrc, in, 47, out, needed, &produced);
+		assert_int_equal(res, 0);
+		assert_int_equal(produced, needed);
+
+		total += produced;
+	}
+
+	/* Output lags the input by the filter delay only. */
+	assert_in_range(total, 4700 * 2 - 64, 4700 * 2);
+
+	free(in);
+	free(out);
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_sine(void **state)
+{
+	int res, i;
+	size_t produced;
+	float *in, *out;
+	double max_err = 0;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_44_1KHZ,
+				AVTP_AAF_FORMAT_FLOAT_32BIT, 1, 0);
+	assert_int_equal(res, 0);
+
+	in = calloc(FRAMES, sizeof(*in));
+	out = calloc(FRAMES, sizeof(*out));
+
+	for (i = 0; i < FRAMES; i++)
+		in[i] = 0.5 * sin(2 * M_PI * 1000 * i / 48000.0);
+
+	res = avtp_asrc_process(asrc, in, FRAMES, out, FRAMES, &produced);
+	assert_int_equal(res, 0);
+	assert_true(produced > 4000);
+
+	for (i = 32; i < (int)produced; i++) {
+		double ref = 0.5 * sin(2 * M_PI * 1000 * i / 44100.0);
+		double err = fabs(out[i] - ref);
+
+		if (err > max_err)
+			max_err = err;
+	}
+
+	assert_true(max_err < 1e-3);
+
+	free(in);
+	free(out);
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_ratio(void **state)
+{
+	int res;
+	size_t nominal, adjusted;
+	struct avtp_asrc *asrc;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_get_output_frames(asrc, 1000000, &nominal);
+	assert_int_equal(res, 0);
+
+	/* A talker 1000 ppm fast delivers more frames than the local clock
+	 * consumes, so fewer output frames are produced.
+	 */
+	res = avtp_asrc_set_ratio(asrc, 1000000);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_get_output_frames(asrc, 1000000, &adjusted);
+	assert_int_equal(res, 0);
+	assert_in_range(nominal - adjusted, 998, 1000);
+
+	avtp_asrc_destroy(asrc);
+}
+
+static void asrc_process_planar(void **state)
+{
+	int res, i, c;
+	size_t produced, produced_planar;
+	int32_t in[FRAMES * 2], in_planar[FRAMES * 2];
+	int32_t out[FRAMES * 2], out_planar[FRAMES * 2];
+	struct avtp_asrc *asrc, *asrc_planar;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_96KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_32BIT, 2, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_create(&asrc_planar, AVTP_AAF_PCM_NSR_96KHZ,
+				AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_FORMAT_INT_32BIT, 2,
+				AVTP_ASRC_IN_PLANAR | AVTP_ASRC_OUT_PLANAR);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < FRAMES; i++) {
+		in[i * 2] = in_planar[i] = rand() - RAND_MAX / 2;
+		in[i * 2 + 1] = in_planar[FRAMES + i] = rand() - RAND_MAX / 2;
+	}
+
+	res = avtp_asrc_process(asrc, in, FRAMES, out, FRAMES, &produced);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_process(asrc_planar, in_planar, FRAMES, out_planar,
+					FRAMES, &produced_planar);
+	assert_int_equal(res, 0);
+	assert_int_equal(produced, produced_planar);
+
+	for (i = 0; i < (int)produced; i++)
+		for (c = 0; c < 2; c++)
+			assert_int_equal(out[i * 2 + c],
+					out_planar[c * FRAMES + i]);
+
+	avtp_asrc_destroy(asrc);
+	avtp_asrc_destroy(asrc_planar);
+}
+
+static void asrc_process_big_endian(void **state)
+{
+	int res, i;
+	size_t produced, produced_be;
+	uint8_t in[FRAMES * 3], in_be[FRAMES * 3];
+	uint8_t out[FRAMES * 3], out_be[FRAMES * 3];
+	struct avtp_asrc *asrc, *asrc_be;
+
+	res = avtp_asrc_create(&asrc, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_32KHZ,
+				AVTP_AAF_FORMAT_INT_24BIT, 1, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_create(&asrc_be, AVTP_AAF_PCM_NSR_48KHZ,
+				AVTP_AAF_PCM_NSR_32KHZ,
+				AVTP_AAF_FORMAT_INT_24BIT, 1,
+				AVTP_ASRC_IN_BIG_ENDIAN |
+				AVTP_ASRC_OUT_BIG_ENDIAN);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < FRAMES * 3; i++)
+		in[i] = rand();
+
+	/* Byte swap each 24-bit sample. */
+	for (i = 0; i < FRAMES; i++) {
+		in_be[i * 3] = in[i * 3 + 2];
+		in_be[i * 3 + 1] = in[i * 3 + 1];
+		in_be[i * 3 + 2] = in[i * 3];
+	}
+
+	res = avtp_asrc_process(asrc, in, FRAMES, out, FRAMES, &produced);
+	assert_int_equal(res, 0);
+
+	res = avtp_asrc_process(asrc_be, in_be, FRAMES, out_be, FRAMES,
+								&produced_be);
+	assert_int_equal(res, 0);
+	assert_int_equal(produced, produced_be);
+
+	for (i = 0; i < (int)produced; i++) {
+		assert_int_equal(out[i * 3], out_be[i * 3 + 2]);
+		assert_int_equal(out[i * 3 + 1], out_be[i * 3 + 1]);
+		assert_int_equal(out[i * 3 + 2], out_be[i * 3]);
+	}
+
+	avtp_asrc_destroy(asrc);
+	avtp_asrc_destroy(asrc_be);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(asrc_create_null_asrc),
+		cmocka_unit_test(asrc_create_invalid_nsr),
+		cmocka_unit_test(asrc_create_invalid_format),
+		cmocka_unit_test(asrc_create_invalid_channels),
+		cmocka_unit_test(asrc_set_ratio_invalid_ppb),
+		cmocka_unit_test(asrc_process_null_buffer),
+		cmocka_unit_test(asrc_process_no_space),
+		cmocka_unit_test(asrc_process_dc),
+		cmocka_unit_test(asrc_process_output_frames),
+		cmocka_unit_test(asrc_process_sine),
+		cmocka_unit_test(asrc_process_ratio),
+		cmocka_unit_test(asrc_process_planar),
+		cmocka_unit_test(asrc_process_big_endian),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "avtp_batch.h"
+
+#define WINDOW				1000
+
+static size_t drain(int fd, uint8_t *buf, size_t len)
+{
+	ssize_t n = read(fd, buf, len);
+
+	return n < 0 ? 0 : n;
+}
+
+static void batch_invalid(void **state)
+{
+	struct avtp_batch_sink *sink;
+	struct avtp_batch_sink_stats stats;
+	uint64_t time;
+	int fds[2], res;
+
+	res = pipe(fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_create(NULL, fds[1], 0, 1, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_create(&sink, -1, 0, 1, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_create(&sink, fds[1], 0, 0, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_create(&sink, fds[1], 0, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_create(&sink, fds[1], WINDOW, 2048, 64 * 1024);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_queue(NULL, "x", 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_queue(sink, NULL, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_get_deadline(NULL, &time);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_get_deadline(sink, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_flush(NULL, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_get_stats(NULL, &stats);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_batch_sink_get_stats(sink, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_batch_sink_destroy(sink);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void batch_full(void **state)
+{
+	struct avtp_batch_sink *sink;
+	int fds[2], res;
+
+	res = pipe(fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_create(&sink, fds[1], 0, 2, 8);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_queue(sink, "123456789", 9, 0);
+	assert_int_equal(res, -ENOSPC);
+
+	res = avtp_batch_sink_queue(sink, "1234", 4, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_queue(sink, "56789", 5, 0);
+	assert_int_equal(res, -ENOSPC);
+
+	res = avtp_batch_sink_queue(sink, "5", 1, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_queue(sink, "6", 1, 0);
+	assert_int_equal(res, -ENOSPC);
+
+	/* Room is made once payloads are written. */
+	res = avtp_batch_sink_flush(sink, 0);
+	assert_int_equal(res, 2);
+
+	res = avtp_batch_sink_queue(sink, "12345678", 8, 0);
+	assert_int_equal(res, 0);
+
+	avtp_batch_sink_destroy(sink);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void batch_window(void **state)
+{
+	struct avtp_batch_sink *sink;
+	struct avtp_batch_sink_stats stats;
+	uint8_t buf[64];
+	uint64_t time;
+	int fds[2], res;
+
+	res = pipe(fds);
+	assert_int_equal(res, 0);
+
+	/* The sink expects a blocking fd, but reads must not block. */
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+	res = avtp_batch_sink_create(&sink, fds[1], WINDOW, 2048, 64 * 1024);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_get_deadline(sink, &time);
+	assert_int_equal(res, 0);
+
+	avtp_batch_sink_queue(sink, "aa", 2, 10000);
+	avtp_batch_sink_queue(sink, "bb", 2, 10500);
+	avtp_batch_sink_queue(sink, "cc", 2, 11000);
+	avtp_batch_sink_queue(sink, "dd", 2, 11001);
+
+	res = avtp_batch_sink_get_deadline(sink, &time);
+	assert_int_equal(res, 1);
+	assert_int_equal(time, 10000);
+
+	/* Nothing is due yet. */
+	res = avtp_batch_sink_flush(sink, 8000);
+	assert_int_equal(res, 0);
+	assert_int_equal(drain(fds[0], buf, sizeof(buf)), 0);
+
+	/* All payloads due within the window go out together. */
+	res = avtp_batch_sink_flush(sink, 10000);
+	assert_int_equal(res, 3);
+	assert_int_equal(drain(fds[0], buf, sizeof(buf)), 6);
+	assert_memory_equal(buf, "aabbcc", 6);
+
+	res = avtp_batch_sink_get_deadline(sink, &time);
+	assert_int_equal(res, 1);
+	assert_int_equal(time, 11001);
+
+	/* A late flush writes the payload late. */
+	res = avtp_batch_sink_flush(sink, 11500);
+	assert_int_equal(res, 1);
+	assert_int_equal(drain(fds[0], buf, sizeof(buf)), 2);
+	assert_memory_equal(buf, "dd", 2);
+
+	res = avtp_batch_sink_get_deadline(sink, &time);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_get_stats(sink, &stats);
+	assert_int_equal(res, 0);
+	assert_int_equal(stats.payloads, 4);
+	assert_int_equal(stats.writes, 2);
+	assert_int_equal(stats.max_early, WINDOW);
+	assert_int_equal(stats.max_late, 499);
+
+	avtp_batch_sink_destroy(sink);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/* More payloads than fit in a writev() are split across calls. */
+static void batch_many(void **state)
+{
+	struct avtp_batch_sink *sink;
+	struct avtp_batch_sink_stats stats;
+	uint8_t buf[2048];
+	size_t total = 0, n;
+	int i, fds[2], res;
+
+	res = pipe(fds);
+	assert_int_equal(res, 0);
+
+	/* The sink expects a blocking fd, but reads must not block. */
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+	res = avtp_batch_sink_create(&sink, fds[1], WINDOW, 2048, 64 * 1024);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < 2000; i++) {
+		uint8_t b = i;
+
+		res = avtp_batch_sink_queue(sink, &b, 1, 0);
+		assert_int_equal(res, 0);
+	}
+
+	res = avtp_batch_sink_flush(sink, 0);
+	assert_int_equal(res, 2000);
+
+	while ((n = drain(fds[0], buf + total, sizeof(buf) - total)))
+		total += n;
+
+	assert_int_equal(total, 2000);
+	for (i = 0; i < 2000; i++)
+		assert_int_equal(buf[i], (uint8_t) i);
+
+	avtp_batch_sink_get_stats(sink, &stats);
+	assert_int_equal(stats.writes, 2);
+
+	avtp_batch_sink_destroy(sink);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/* Payloads not due stay queued, intact, across flushes. */
+static void batch_compact(void **state)
+{
+	struct avtp_batch_sink *sink;
+	uint8_t buf[64];
+	int fds[2], res;
+
+	res = pipe(fds);
+	assert_int_equal(res, 0);
+
+	/* The sink expects a blocking fd, but reads must not block. */
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+	res = avtp_batch_sink_create(&sink, fds[1], WINDOW, 2048, 64 * 1024);
+	assert_int_equal(res, 0);
+
+	avtp_batch_sink_queue(sink, "first", 5, 0);
+	avtp_batch_sink_queue(sink, "second", 6, 5000);
+	avtp_batch_sink_queue(sink, "third", 5, 9000);
+
+	res = avtp_batch_sink_flush(sink, 0);
+	assert_int_equal(res, 1);
+
+	avtp_batch_sink_queue(sink, "fourth", 6, 9500);
+
+	res = avtp_batch_sink_flush(sink, 5000);
+	assert_int_equal(res, 1);
+
+	res = avtp_batch_sink_flush(sink, 9000);
+	assert_int_equal(res, 2);
+
+	assert_int_equal(drain(fds[0], buf, sizeof(buf)), 22);
+	assert_memory_equal(buf, "firstsecondthirdfourth", 22);
+
+	avtp_batch_sink_destroy(sink);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void batch_write_error(void **state)
+{
+	struct avtp_batch_sink *sink;
+	int fds[2], res;
+
+	res = pipe(fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_batch_sink_create(&sink, fds[1], 0, 4, 64);
+	assert_int_equal(res, 0);
+
+	avtp_batch_sink_queue(sink, "x", 1, 0);
+	close(fds[0]);
+
+	/* EPIPE rather than SIGPIPE. */
+	signal(SIGPIPE, SIG_IGN);
+	res = avtp_batch_sink_flush(sink, 0);
+	assert_int_equal(res, -EPIPE);
+
+	res = avtp_batch_sink_get_deadline(sink, &(uint64_t){ 0 });
+	assert_int_equal(res, 1);
+
+	avtp_batch_sink_destroy(sink);
+	close(fds[1]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(batch_invalid),
+		cmocka_unit_test(batch_full),
+		cmocka_unit_test(batch_window),
+		cmocka_unit_test(batch_many),
+		cmocka_unit_test(batch_compact),
+		cmocka_unit_test(batch_write_error),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
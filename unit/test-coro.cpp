@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "avtp_coro.hpp"
+
+#define NSEC_PER_SEC		1000000000ULL
+#define NSEC_PER_MSEC		1000000ULL
+#define MAX_PDU_SIZE		64
+#define STREAMS			200
+#define PACKETS			8
+
+static uint64_t realtime_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static void send_packet(int fd, uint8_t val, size_t len)
+{
+	uint8_t buf[MAX_PDU_SIZE * 2];
+	ssize_t n;
+
+	memset(buf, val, len);
+	n = send(fd, buf, len, 0);
+	assert_int_equal(n, len);
+}
+
+struct rx_state {
+	std::vector<int> batches;
+	std::vector<uint8_t> values;
+	bool done;
+};
+
+static avtp::task receive(avtp::receiver &rx, unsigned int total,
+							struct rx_state &st)
+{
+	while (st.values.size() < total) {
+		int n = co_await rx.recv();
+
+		if (n < 0)
+			break;
+
+		st.batches.push_back(n);
+		for (int i = 0; i < n; i++)
+			st.values.push_back((uint8_t) rx.packet(i)[0]);
+	}
+
+	st.done = true;
+}
+
+static void coro_init_invalid(void **state)
+{
+	avtp::reactor r;
+	avtp::receiver rx;
+	avtp::timer tm;
+
+	assert_int_equal(r.init(), 0);
+	assert_int_equal(rx.init(r, -1, 4, MAX_PDU_SIZE), -EINVAL);
+	assert_int_equal(rx.init(r, 0, 0, MAX_PDU_SIZE), -EINVAL);
+	assert_int_equal(rx.init(r, 0, 4, 0), -EINVAL);
+	assert_int_equal(tm.init(r), 0);
+	assert_int_equal(tm.init(r), -EINVAL);
+}
+
+static void coro_recv_batch(void **state)
+{
+	avtp::reactor r;
+	avtp::receiver rx;
+	struct rx_state st = {};
+	int sv[2], i;
+
+	assert_int_equal(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv), 0);
+	assert_int_equal(r.init(), 0);
+	assert_int_equal(rx.init(r, sv[0], 4, MAX_PDU_SIZE), 0);
+
+	/* Packets already queued are received without suspending. */
+	for (i = 0; i < 5; i++)
+		send_packet(sv[1], i, 16);
+
+	receive(rx, 7, st);
+
+	assert_false(st.done);
+	assert_int_equal(st.batches.size(), 2);
+	assert_int_equal(st.batches[0], 4);
+	assert_int_equal(st.batches[1], 1);
+
+	/* Nothing to receive, the coroutine stays suspended. */
+	assert_int_equal(r.poll(0), 0);
+	assert_false(st.done);
+
+	send_packet(sv[1], 5, 16);
+	send_packet(sv[1], 6, MAX_PDU_SIZE * 2);
+	while (!st.done)
+		assert_true(r.poll(1000) > 0);
+
+	assert_int_equal(st.values.size(), 7);
+	for (i = 0; i < 7; i++)
+		assert_int_equal(st.values[i], i);
+	assert_int_equal(rx.packet(st.batches.back() - 1).size(),
+								MAX_PDU_SIZE);
+	assert_true(rx.truncated(st.batches.back() - 1));
+
+	close(sv[0]);
+	close(sv[1]);
+}
+
+static avtp::task sleep(avtp::timer &tm, uint64_t time, int *res, bool *done)
+{
+	*res = co_await tm.sleep_until(time);
+	*done = true;
+}
+
+static void coro_sleep_until(void **state)
+{
+	avtp::reactor r;
+	avtp::timer tm;
+	uint64_t start, deadline;
+	bool done = false;
+	int res = -1;
+
+	assert_int_equal(r.init(), 0);
+	assert_int_equal(tm.init(r), 0);
+
+	/* Past deadlines don't suspend. */
+	sleep(tm, realtime_ns() - NSEC_PER_MSEC, &res, &done);
+	assert_true(done);
+	assert_int_equal(res, 0);
+
+	done = false;
+	res = -1;
+	start = realtime_ns();
+	deadline = start + 2 * NSEC_PER_MSEC;
+	sleep(tm, deadline, &res, &done);
+	assert_false(done);
+
+	while (!done)
+		assert_true(r.poll(1000) >= 0);
+
+	assert_int_equal(res, 0);
+	assert_true(realtime_ns() >= deadline);
+}
+
+static void coro_many_streams(void **state)
+{
+	avtp::reactor r;
+	std::vector<avtp::receiver> rx(STREAMS);
+	std::vector<struct rx_state> st(STREAMS);
+	int sv[STREAMS][2];
+	int i, j, done;
+
+	assert_int_equal(r.init(), 0);
+
+	for (i = 0; i < STREAMS; i++) {
+		assert_int_equal(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv[i]), 0);
+		assert_int_equal(rx[i].init(r, sv[i][0], 4, MAX_PDU_SIZE), 0);
+		receive(rx[i], PACKETS, st[i]);
+	}
+
+	for (j = 0; j < PACKETS; j++) {
+		for (i = 0; i < STREAMS; i++)
+			send_packet(sv[i][1], i + j, 16);
+
+		assert_true(r.poll(0) > 0);
+	}
+
+	do {
+		assert_true(r.poll(0) >= 0);
+
+		for (i = 0, done = 0; i < STREAMS; i++)
+			done += st[i].done;
+	} while (done < STREAMS);
+
+	for (i = 0; i < STREAMS; i++) {
+		assert_int_equal(st[i].values.size(), PACKETS);
+		for (j = 0; j < PACKETS; j++)
+			assert_int_equal(st[i].values[j], (uint8_t) (i + j));
+
+		close(sv[i][0]);
+		close(sv[i][1]);
+	}
+}
+
+static avtp::task short_lived(avtp::reactor &r, int fd, bool *done)
+{
+	avtp::receiver rx;
+	avtp::timer tm;
+
+	if (rx.init(r, fd, 1, MAX_PDU_SIZE) < 0 || tm.init(r) < 0)
+		co_return;
+
+	co_await tm.sleep_until(realtime_ns() + NSEC_PER_MSEC);
+	*done = true;
+}
+
+static void coro_destroy_on_resume(void **state)
+{
+	avtp::reactor r;
+	bool done = false;
+	int sv[2];
+
+	assert_int_equal(socketpair(AF_UNIX, SOCK_DGRAM, 0, sv), 0);
+	assert_int_equal(r.init(), 0);
+
+	/* The timer expires before the packet arrives, so the receiver event
+	 * is still pending when the timer resumes the coroutine, which then
+	 * destroys the receiver. The event must be dropped.
+	 */
+	short_lived(r, sv[0], &done);
+	usleep(2000);
+	send_packet(sv[1], 0, 16);
+
+	while (!done)
+		assert_true(r.poll(1000) >= 0);
+
+	assert_int_equal(r.poll(0), 0);
+
+	close(sv[0]);
+	close(sv[1]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(coro_init_invalid),
+		cmocka_unit_test(coro_recv_batch),
+		cmocka_unit_test(coro_sleep_until),
+		cmocka_unit_test(coro_many_streams),
+		cmocka_unit_test(coro_destroy_on_resume),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
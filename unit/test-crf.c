@@ -27,9 +27,12 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <setjmp.h>
 #include <cmocka.h>
+#include <alloca.h>
 #include <arpa/inet.h>
+#include <endian.h>
 
 #include "avtp.h"
 #include "avtp_crf.h"
@@ -417,6 +420,543 @@ static void crf_pdu_init(void **state)
 	assert_true(pdu.packet_info == 0);
 }
 
+static void crf_gen_init_null_gen(void **state)
+{
+	int res;
+
+	res = avtp_crf_gen_init(NULL, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, 48000, 160, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_gen_init_invalid_pull(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE, 6, 48000,
+								160, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_gen_init_invalid_base_freq(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, 0, 160, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, 0x20000000, 160, 0);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_gen_init_invalid_timestamp_interval(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, 48000, 0, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_gen_pdu_init(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu pdu;
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1_001, 48000, 160, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_pdu_init(&gen, &pdu);
+
+	assert_int_equal(res, 0);
+	assert_true(ntohl(pdu.subtype_data) == 0x04800001);
+	assert_true(pdu.stream_id == 0);
+	assert_true(be64toh(pdu.packet_info) == 0x4000BB80000000A0);
+}
+
+static void crf_gen_fill_null_pdu(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, 48000, 160, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_fill(&gen, NULL, 6);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_gen_fill_invalid_count(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu pdu;
+
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, 48000, 160, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_fill(&gen, &pdu, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_crf_gen_fill(&gen, &pdu, 8192);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_gen_fill(void **state)
+{
+	int res, i;
+	uint64_t val;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = alloca(sizeof(*pdu) + 6 * sizeof(uint64_t));
+
+	/* 160 samples at 48 kHz is 3333333.33... ns so the fractional part
+	 * must be carried over to keep the timestamps exact.
+	 */
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+			AVTP_CRF_PULL_MULT_BY_1, 48000, 160, 1000000000);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_pdu_init(&gen, pdu);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < 2; i++) {
+		res = avtp_crf_gen_fill(&gen, pdu, 6);
+		assert_int_equal(res, 0);
+	}
+
+	res = avtp_crf_pdu_get(pdu, AVTP_CRF_FIELD_SEQ_NUM, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_crf_pdu_get(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 6 * sizeof(uint64_t));
+
+	assert_true(be64toh(pdu->crf_data[0]) == 1020000000);
+	assert_true(be64toh(pdu->crf_data[1]) == 1023333333);
+	assert_true(be64toh(pdu->crf_data[2]) == 1026666666);
+	assert_true(be64toh(pdu->crf_data[3]) == 1030000000);
+	assert_true(be64toh(pdu->crf_data[4]) == 1033333333);
+	assert_true(be64toh(pdu->crf_data[5]) == 1036666666);
+}
+
+static void crf_gen_fill_pull(void **state)
+{
+	int res, i;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = alloca(sizeof(*pdu) + sizeof(uint64_t));
+
+	/* With 1/1.001 pull, 48000 timestamps spaced by 1000 samples at
+	 * 48 kHz span exactly 1001 seconds.
+	 */
+	res = avtp_crf_gen_init(&gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+			AVTP_CRF_PULL_MULT_BY_1_OVER_1_001, 48000, 1000, 0);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i <= 48000; i++) {
+		res = avtp_crf_gen_fill(&gen, pdu, 1);
+		assert_int_equal(res, 0);
+	}
+
+	assert_true(be64toh(pdu->crf_data[0]) == 1001 * 1000000000ULL);
+}
+
+static void crf_drift_init_null_drift(void **state)
+{
+	int res;
+
+	res = avtp_crf_drift_init(NULL);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+/* Build a CRF PDU with 'count' timestamps generated at 'gen_freq' while the
+ * PDU header advertises 48 kHz.
+ */
+static struct avtp_crf_pdu *build_crf_pdu(struct avtp_crf_gen *gen,
+				uint32_t gen_freq, unsigned int count)
+{
+	int res;
+	struct avtp_crf_pdu *pdu;
+
+	pdu = calloc(1, sizeof(*pdu) + count * sizeof(uint64_t));
+	assert_true(pdu != NULL);
+
+	res = avtp_crf_gen_init(gen, AVTP_CRF_TYPE_AUDIO_SAMPLE,
+				AVTP_CRF_PULL_MULT_BY_1, gen_freq, 160,
+				1000000000);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_pdu_init(gen, pdu);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_BASE_FREQ, 48000);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_fill(gen, pdu, count);
+	assert_int_equal(res, 0);
+
+	return pdu;
+}
+
+static void crf_pdu_validate_null_pdu(void **state)
+{
+	int res;
+
+	res = avtp_crf_pdu_validate(NULL, 100, 0, NULL);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_pdu_validate_short_len(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48000, 6);
+
+	res = avtp_crf_pdu_validate(pdu, sizeof(*pdu) - 1, 0, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	/* 'crf_data_length' says 6 timestamps but only 5 are available. */
+	res = avtp_crf_pdu_validate(pdu, sizeof(*pdu) + 5 * sizeof(uint64_t),
+								0, NULL);
+	assert_int_equal(res, -EBADMSG);
+
+	free(pdu);
+}
+
+static void crf_pdu_validate_invalid_subtype(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48000, 6);
+
+	res = avtp_pdu_set((struct avtp_common_pdu *) pdu,
+				AVTP_FIELD_SUBTYPE, AVTP_SUBTYPE_AAF);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_validate(pdu, sizeof(*pdu) + 6 * sizeof(uint64_t),
+								0, NULL);
+	assert_int_equal(res, -EBADMSG);
+
+	free(pdu);
+}
+
+static void crf_pdu_validate_invalid_data_len(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48000, 6);
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN, 12);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_validate(pdu, sizeof(*pdu) + 6 * sizeof(uint64_t),
+								0, NULL);
+	assert_int_equal(res, -EBADMSG);
+
+	free(pdu);
+}
+
+static void crf_pdu_validate_not_monotonic(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48000, 6);
+
+	pdu->crf_data[3] = pdu->crf_data[2];
+
+	res = avtp_crf_pdu_validate(pdu, sizeof(*pdu) + 6 * sizeof(uint64_t),
+							UINT32_MAX, NULL);
+	assert_int_equal(res, -EBADMSG);
+
+	free(pdu);
+}
+
+static void crf_pdu_validate_spacing(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48000, 6);
+	size_t len = sizeof(*pdu) + 6 * sizeof(uint64_t);
+
+	res = avtp_crf_pdu_validate(pdu, len, 0, NULL);
+	assert_int_equal(res, 0);
+
+	/* Move one timestamp 1000 ns away from its nominal position. */
+	pdu->crf_data[4] = htobe64(be64toh(pdu->crf_data[4]) + 1000);
+
+	res = avtp_crf_pdu_validate(pdu, len, 999, NULL);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_crf_pdu_validate(pdu, len, 1000, NULL);
+	assert_int_equal(res, 0);
+
+	free(pdu);
+}
+
+static void crf_pdu_validate_drift(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_drift drift;
+	/* Timestamps generated at 48048 Hz are 1000 ppm faster than the
+	 * 48000 Hz advertised in the PDU header.
+	 */
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48048, 6);
+	size_t len = sizeof(*pdu) + 6 * sizeof(uint64_t);
+
+	res = avtp_crf_drift_init(&drift);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_validate(pdu, len, 5000, &drift);
+	assert_int_equal(res, 0);
+
+	assert_true(drift.count == 1);
+	assert_true(drift.base_time == 1000000000);
+	assert_true(drift.ppb > 999000 && drift.ppb < 1001000);
+
+	free(pdu);
+}
+
+static void crf_pdu_validate_drift_mr_toggle(void **state)
+{
+	int res;
+	struct avtp_crf_gen gen;
+	struct avtp_crf_drift drift;
+	struct avtp_crf_pdu *pdu = build_crf_pdu(&gen, 48000, 6);
+	size_t len = sizeof(*pdu) + 6 * sizeof(uint64_t);
+
+	res = avtp_crf_drift_init(&drift);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_validate(pdu, len, 0, &drift);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_gen_fill(&gen, pdu, 6);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_validate(pdu, len, 0, &drift);
+	assert_int_equal(res, 0);
+	assert_true(drift.count == 2);
+
+	res = avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_MR, 1);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_pdu_validate(pdu, len, 0, &drift);
+	assert_int_equal(res, 0);
+	assert_true(drift.count == 1);
+	assert_true(drift.ppb == 0);
+
+	free(pdu);
+}
+
+static void crf_servo_init_null_servo(void **state)
+{
+	int res;
+
+	res = avtp_crf_servo_init(NULL, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						1000, 5000, 100000000);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_servo_init_invalid_bandwidth(void **state)
+{
+	int res;
+	struct avtp_crf_servo servo;
+
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						0, 5000, 100000000);
+	assert_int_equal(res, -EINVAL);
+
+	/* 100 Hz bandwidth is way too high for 300 updates per second. */
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						100000, 5000, 100000000);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void crf_servo_get_time_not_started(void **state)
+{
+	int res;
+	uint64_t time;
+	struct avtp_crf_servo servo;
+
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						1000, 5000, 100000000);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_servo_get_time(&servo, 0, &time);
+	assert_int_equal(res, -EINVAL);
+}
+
+/* Feed the servo with 'count' timestamps from a 48 kHz media clock running
+ * 'ppm' faster than nominal, with up to +/-'jitter' ns of pseudo-random
+ * jitter. Local time is the ideal timestamp. Returns the largest error from
+ * the recovered clock over the last half of the run.
+ */
+static int64_t feed_servo(struct avtp_crf_servo *servo, int ppm,
+				int jitter, int count, uint64_t *now)
+{
+	int i, res;
+	uint32_t seed = 1;
+	int64_t err, max_err = 0;
+	uint64_t time;
+	double period = 1000000000.0 * 160 / 48000 / (1 + ppm / 1e6);
+
+	for (i = 0; i < count; i++) {
+		uint64_t ideal = 1000000000 + (uint64_t) (i * period);
+		int j;
+
+		seed = seed * 1103515245 + 12345;
+		j = jitter ? (int) ((seed >> 8) % (2 * jitter + 1)) - jitter : 0;
+
+		res = avtp_crf_servo_update(servo, ideal + j, ideal);
+		assert_int_equal(res, 0);
+
+		res = avtp_crf_servo_get_time(servo, 0, &time);
+		assert_int_equal(res, 0);
+
+		err = (int64_t) (time - ideal);
+		if (i > count / 2 && (err > max_err || -err > max_err))
+			max_err = err > 0 ? err : -err;
+
+		*now = ideal;
+	}
+
+	return max_err;
+}
+
+static void crf_servo_track(void **state)
+{
+	int res;
+	uint64_t now;
+	int64_t max_err;
+	struct avtp_crf_servo servo;
+	struct avtp_crf_servo_status status;
+
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						1000, 5000, 100000000);
+	assert_int_equal(res, 0);
+
+	/* 10 seconds of a +50 ppm clock with 4 us peak-to-peak jitter. */
+	max_err = feed_servo(&servo, 50, 2000, 3000, &now);
+
+	res = avtp_crf_servo_get_status(&servo, now, &status);
+	assert_int_equal(res, 0);
+	assert_true(status.state == AVTP_CRF_SERVO_LOCKED);
+	assert_true(status.ppb > 48000 && status.ppb < 52000);
+
+	/* Jitter must be attenuated by the loop. */
+	assert_true(max_err < 1000);
+}
+
+static void crf_servo_get_time(void **state)
+{
+	int res;
+	uint64_t now, t0, t1;
+	struct avtp_crf_servo servo;
+
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						1000, 5000, 100000000);
+	assert_int_equal(res, 0);
+
+	feed_servo(&servo, 0, 0, 300, &now);
+
+	res = avtp_crf_servo_get_time(&servo, 0, &t0);
+	assert_int_equal(res, 0);
+
+	/* 48000 samples later is one second later. */
+	res = avtp_crf_servo_get_time(&servo, 48000, &t1);
+	assert_int_equal(res, 0);
+	assert_true(t1 - t0 >= 999999999 && t1 - t0 <= 1000000001);
+
+	/* A single sample is 20833.33 ns. */
+	res = avtp_crf_servo_get_time(&servo, 1, &t1);
+	assert_int_equal(res, 0);
+	assert_true(t1 - t0 == 20833 || t1 - t0 == 20834);
+}
+
+static void crf_servo_holdover(void **state)
+{
+	int res;
+	uint64_t now, t0, t1;
+	struct avtp_crf_servo servo;
+	struct avtp_crf_servo_status status;
+
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						1000, 5000, 100000000);
+	assert_int_equal(res, 0);
+
+	feed_servo(&servo, 0, 0, 300, &now);
+
+	res = avtp_crf_servo_get_time(&servo, 0, &t0);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_servo_get_status(&servo, now + 100000000, &status);
+	assert_int_equal(res, 0);
+	assert_true(status.state == AVTP_CRF_SERVO_LOCKED);
+
+	res = avtp_crf_servo_get_status(&servo, now + 100000001, &status);
+	assert_int_equal(res, 0);
+	assert_true(status.state == AVTP_CRF_SERVO_HOLDOVER);
+
+	/* The media clock freewheels while in holdover. */
+	res = avtp_crf_servo_get_time(&servo, 48000, &t1);
+	assert_int_equal(res, 0);
+	assert_true(t1 - t0 >= 999999999 && t1 - t0 <= 1000000001);
+
+	/* Lock must be acquired again once timestamps are back. */
+	res = avtp_crf_servo_update(&servo, t1, now + 1000000000);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_servo_get_status(&servo, now + 1000000000, &status);
+	assert_int_equal(res, 0);
+	assert_true(status.state == AVTP_CRF_SERVO_UNLOCKED);
+}
+
+static void crf_servo_phase_step(void **state)
+{
+	int res;
+	uint64_t now, t0, t1;
+	struct avtp_crf_servo servo;
+	struct avtp_crf_servo_status status;
+
+	res = avtp_crf_servo_init(&servo, AVTP_CRF_PULL_MULT_BY_1, 48000, 160,
+						1000, 5000, 100000000);
+	assert_int_equal(res, 0);
+
+	feed_servo(&servo, 0, 0, 300, &now);
+
+	res = avtp_crf_servo_get_time(&servo, 160, &t0);
+	assert_int_equal(res, 0);
+
+	/* A 1.5 ms phase step can't be tracked so acquisition restarts. */
+	res = avtp_crf_servo_update(&servo, t0 + 1500000, now + 3333333);
+	assert_int_equal(res, 0);
+
+	res = avtp_crf_servo_get_status(&servo, now + 3333333, &status);
+	assert_int_equal(res, 0);
+	assert_true(status.state == AVTP_CRF_SERVO_UNLOCKED);
+
+	res = avtp_crf_servo_get_time(&servo, 0, &t1);
+	assert_int_equal(res, 0);
+	assert_true(t1 == t0 + 1500000);
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -449,6 +989,31 @@ int main(void)
 		cmocka_unit_test(crf_set_field_timestamp_interval),
 		cmocka_unit_test(crf_pdu_init_null_pdu),
 		cmocka_unit_test(crf_pdu_init),
+		cmocka_unit_test(crf_gen_init_null_gen),
+		cmocka_unit_test(crf_gen_init_invalid_pull),
+		cmocka_unit_test(crf_gen_init_invalid_base_freq),
+		cmocka_unit_test(crf_gen_init_invalid_timestamp_interval),
+		cmocka_unit_test(crf_gen_pdu_init),
+		cmocka_unit_test(crf_gen_fill_null_pdu),
+		cmocka_unit_test(crf_gen_fill_invalid_count),
+		cmocka_unit_test(crf_gen_fill),
+		cmocka_unit_test(crf_gen_fill_pull),
+		cmocka_unit_test(crf_drift_init_null_drift),
+		cmocka_unit_test(crf_pdu_validate_null_pdu),
+		cmocka_unit_test(crf_pdu_validate_short_len),
+		cmocka_unit_test(crf_pdu_validate_invalid_subtype),
+		cmocka_unit_test(crf_pdu_validate_invalid_data_len),
+		cmocka_unit_test(crf_pdu_validate_not_monotonic),
+		cmocka_unit_test(crf_pdu_validate_spacing),
+		cmocka_unit_test(crf_pdu_validate_drift),
+		cmocka_unit_test(crf_pdu_validate_drift_mr_toggle),
+		cmocka_unit_test(crf_servo_init_null_servo),
+		cmocka_unit_test(crf_servo_init_invalid_bandwidth),
+		cmocka_unit_test(crf_servo_get_time_not_started),
+		cmocka_unit_test(crf_servo_track),
+		cmocka_unit_test(crf_servo_get_time),
+		cmocka_unit_test(crf_servo_holdover),
+		cmocka_unit_test(crf_servo_phase_step),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "avtp.h"
+#include "avtp.hpp"
+#include "avtp_aaf.h"
+#include "avtp_crf.h"
+#include "avtp_cvf.h"
+#include "avtp_ieciidc.h"
+
+#define PDU_SIZE		64
+
+/* Descriptors must agree with the masks used by the C implementation. */
+static_assert(avtp::aaf::chan_per_frame::mask == 0x0003ff00, "");
+static_assert(avtp::cvf::h264_ptv::mask == 0x00002000, "");
+static_assert(avtp::crf::base_freq::mask == 0x1fffffff00000000ULL, "");
+static_assert(avtp::ieciidc::cip_qi_1::mask == 0xc0000000, "");
+static_assert(avtp::stream::stream_id::mask == ~0ULL, "");
+static_assert(std::is_same_v<avtp::aaf::chan_per_frame::value_type,
+							std::uint16_t>, "");
+static_assert(std::is_same_v<avtp::crf::stream_id::value_type,
+							std::uint64_t>, "");
+
+/* Accessors are usable in constant expressions. */
+static constexpr std::array<std::uint8_t, PDU_SIZE> make_aaf_pdu()
+{
+	std::array<std::uint8_t, PDU_SIZE> pdu{};
+
+	avtp::set<avtp::aaf::subtype>(pdu, AVTP_SUBTYPE_AAF);
+	avtp::set<avtp::aaf::sv>(pdu, 1);
+	avtp::set<avtp::aaf::stream_id>(pdu, 0xAABBCCDDEEFF0001ULL);
+	avtp::set<avtp::aaf::chan_per_frame>(pdu, 0x3ff);
+	avtp::set<avtp::aaf::bit_depth>(pdu, 24);
+
+	return pdu;
+}
+
+static constexpr auto aaf_pdu = make_aaf_pdu();
+static_assert(aaf_pdu[0] == AVTP_SUBTYPE_AAF && aaf_pdu[1] == 0x80, "");
+static_assert(aaf_pdu[4] == 0xAA && aaf_pdu[11] == 0x01, "");
+static_assert(aaf_pdu[17] == 0x03 && aaf_pdu[18] == 0xff, "");
+static_assert(avtp::get<avtp::aaf::chan_per_frame>(aaf_pdu) == 0x3ff, "");
+static_assert(avtp::get<avtp::aaf::bit_depth>(aaf_pdu) == 24, "");
+static_assert(avtp::get<avtp::aaf::nsr>(aaf_pdu) == 0, "");
+static_assert(avtp::get<avtp::aaf::stream_id>(aaf_pdu) ==
+						0xAABBCCDDEEFF0001ULL, "");
+
+static void fill_random(std::uint8_t *buf)
+{
+	for (int i = 0; i < PDU_SIZE; i++)
+		buf[i] = rand();
+}
+
+/* Check that field F reads and writes the same bits as the C API. c_set and
+ * c_get wrap avtp_*_pdu_set() and avtp_*_pdu_get() for the matching field.
+ */
+template <class F, class Set, class Get>
+static void check_field(Set c_set, Get c_get)
+{
+	const std::uint64_t max = F::mask >> F::shift;
+	const std::uint64_t vals[] = { 0, 1, max, max >> 1,
+				(0x5a5a5a5a5a5a5a5aULL & max),
+				((std::uint64_t) rand() << 32 | rand()) & max };
+
+	for (std::uint64_t v : vals) {
+		alignas(8) std::uint8_t a[PDU_SIZE], b[PDU_SIZE];
+		std::uint64_t val;
+		int res;
+
+		fill_random(a);
+		memcpy(b, a, PDU_SIZE);
+
+		res = c_set(a, v);
+		assert_int_equal(res, 0);
+		avtp::set<F>(b, v);
+		assert_memory_equal(a, b, PDU_SIZE);
+
+		res = c_get(b, &val);
+		assert_int_equal(res, 0);
+		assert_true(val == v);
+		assert_true(avtp::get<F>(a) == v);
+	}
+}
+
+#define CHECK_COMMON(name, c_field)					\
+	check_field<avtp::common::name>(				\
+		[](std::uint8_t *p, std::uint64_t v) {			\
+			return avtp_pdu_set((struct avtp_common_pdu *) p,	\
+								c_field, v);	\
+		},							\
+		[](const std::uint8_t *p, std::uint64_t *v) {		\
+			std::uint32_t v32;				\
+			int res = avtp_pdu_get(				\
+				(const struct avtp_common_pdu *) p,	\
+							c_field, &v32);	\
+			*v = v32;					\
+			return res;					\
+		})
+
+#define CHECK_FIELD(fmt, pdu_type, name, c_field)			\
+	check_field<avtp::fmt::name>(					\
+		[](std::uint8_t *p, std::uint64_t v) {			\
+			return avtp_##fmt##_pdu_set((pdu_type *) p,	\
+								c_field, v);	\
+		},							\
+		[](const std::uint8_t *p, std::uint64_t *v) {		\
+			return avtp_##fmt##_pdu_get(			\
+				(const pdu_type *) p, c_field, v);	\
+		})
+
+#define CHECK_STREAM(fmt, name, c_field)				\
+	CHECK_FIELD(fmt, struct avtp_stream_pdu, name, c_field)
+
+static void hpp_common_fields(void **state)
+{
+	CHECK_COMMON(subtype, AVTP_FIELD_SUBTYPE);
+	CHECK_COMMON(version, AVTP_FIELD_VERSION);
+}
+
+static void hpp_aaf_fields(void **state)
+{
+	CHECK_STREAM(aaf, sv, AVTP_AAF_FIELD_SV);
+	CHECK_STREAM(aaf, mr, AVTP_AAF_FIELD_MR);
+	CHECK_STREAM(aaf, tv, AVTP_AAF_FIELD_TV);
+	CHECK_STREAM(aaf, seq_num, AVTP_AAF_FIELD_SEQ_NUM);
+	CHECK_STREAM(aaf, tu, AVTP_AAF_FIELD_TU);
+	CHECK_STREAM(aaf, stream_id, AVTP_AAF_FIELD_STREAM_ID);
+	CHECK_STREAM(aaf, timestamp, AVTP_AAF_FIELD_TIMESTAMP);
+	CHECK_STREAM(aaf, stream_data_len, AVTP_AAF_FIELD_STREAM_DATA_LEN);
+	CHECK_STREAM(aaf, format, AVTP_AAF_FIELD_FORMAT);
+	CHECK_STREAM(aaf, nsr, AVTP_AAF_FIELD_NSR);
+	CHECK_STREAM(aaf, chan_per_frame, AVTP_AAF_FIELD_CHAN_PER_FRAME);
+	CHECK_STREAM(aaf, bit_depth, AVTP_AAF_FIELD_BIT_DEPTH);
+	CHECK_STREAM(aaf, sp, AVTP_AAF_FIELD_SP);
+	CHECK_STREAM(aaf, evt, AVTP_AAF_FIELD_EVT);
+}
+
+static void hpp_cvf_fields(void **state)
+{
+	CHECK_STREAM(cvf, sv, AVTP_CVF_FIELD_SV);
+	CHECK_STREAM(cvf, stream_id, AVTP_CVF_FIELD_STREAM_ID);
+	CHECK_STREAM(cvf, timestamp, AVTP_CVF_FIELD_TIMESTAMP);
+	CHECK_STREAM(cvf, stream_data_len, AVTP_CVF_FIELD_STREAM_DATA_LEN);
+	CHECK_STREAM(cvf, format, AVTP_CVF_FIELD_FORMAT);
+	CHECK_STREAM(cvf, format_subtype, AVTP_CVF_FIELD_FORMAT_SUBTYPE);
+	CHECK_STREAM(cvf, m, AVTP_CVF_FIELD_M);
+	CHECK_STREAM(cvf, evt, AVTP_CVF_FIELD_EVT);
+	CHECK_STREAM(cvf, h264_ptv, AVTP_CVF_FIELD_H264_PTV);
+	CHECK_STREAM(cvf, h264_timestamp, AVTP_CVF_FIELD_H264_TIMESTAMP);
+}
+
+static void hpp_crf_fields(void **state)
+{
+	CHECK_FIELD(crf, struct avtp_crf_pdu, sv, AVTP_CRF_FIELD_SV);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, mr, AVTP_CRF_FIELD_MR);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, fs, AVTP_CRF_FIELD_FS);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, tu, AVTP_CRF_FIELD_TU);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, seq_num, AVTP_CRF_FIELD_SEQ_NUM);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, type, AVTP_CRF_FIELD_TYPE);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, stream_id,
+						AVTP_CRF_FIELD_STREAM_ID);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, pull, AVTP_CRF_FIELD_PULL);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, base_freq,
+						AVTP_CRF_FIELD_BASE_FREQ);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, crf_data_len,
+						AVTP_CRF_FIELD_CRF_DATA_LEN);
+	CHECK_FIELD(crf, struct avtp_crf_pdu, timestamp_interval,
+					AVTP_CRF_FIELD_TIMESTAMP_INTERVAL);
+}
+
+static void hpp_ieciidc_fields(void **state)
+{
+	CHECK_STREAM(ieciidc, tv, AVTP_IECIIDC_FIELD_TV);
+	CHECK_STREAM(ieciidc, stream_data_len,
+					AVTP_IECIIDC_FIELD_STREAM_DATA_LEN);
+	CHECK_STREAM(ieciidc, gv, AVTP_IECIIDC_FIELD_GV);
+	CHECK_STREAM(ieciidc, gateway_info, AVTP_IECIIDC_FIELD_GATEWAY_INFO);
+	CHECK_STREAM(ieciidc, tag, AVTP_IECIIDC_FIELD_TAG);
+	CHECK_STREAM(ieciidc, channel, AVTP_IECIIDC_FIELD_CHANNEL);
+	CHECK_STREAM(ieciidc, tcode, AVTP_IECIIDC_FIELD_TCODE);
+	CHECK_STREAM(ieciidc, sy, AVTP_IECIIDC_FIELD_SY);
+	CHECK_STREAM(ieciidc, cip_qi_1, AVTP_IECIIDC_FIELD_CIP_QI_1);
+	CHECK_STREAM(ieciidc, cip_sid, AVTP_IECIIDC_FIELD_CIP_SID);
+	CHECK_STREAM(ieciidc, cip_dbs, AVTP_IECIIDC_FIELD_CIP_DBS);
+	CHECK_STREAM(ieciidc, cip_fn, AVTP_IECIIDC_FIELD_CIP_FN);
+	CHECK_STREAM(ieciidc, cip_qpc, AVTP_IECIIDC_FIELD_CIP_QPC);
+	CHECK_STREAM(ieciidc, cip_sph, AVTP_IECIIDC_FIELD_CIP_SPH);
+	CHECK_STREAM(ieciidc, cip_dbc, AVTP_IECIIDC_FIELD_CIP_DBC);
+	CHECK_STREAM(ieciidc, cip_qi_2, AVTP_IECIIDC_FIELD_CIP_QI_2);
+	CHECK_STREAM(ieciidc, cip_fmt, AVTP_IECIIDC_FIELD_CIP_FMT);
+	CHECK_STREAM(ieciidc, cip_tsf, AVTP_IECIIDC_FIELD_CIP_TSF);
+	CHECK_STREAM(ieciidc, cip_nd, AVTP_IECIIDC_FIELD_CIP_ND);
+	CHECK_STREAM(ieciidc, cip_evt, AVTP_IECIIDC_FIELD_CIP_EVT);
+	CHECK_STREAM(ieciidc, cip_n, AVTP_IECIIDC_FIELD_CIP_N);
+	CHECK_STREAM(ieciidc, cip_sfc, AVTP_IECIIDC_FIELD_CIP_SFC);
+	CHECK_STREAM(ieciidc, cip_no_data, AVTP_IECIIDC_FIELD_CIP_NO_DATA);
+	CHECK_STREAM(ieciidc, cip_syt, AVTP_IECIIDC_FIELD_CIP_SYT);
+}
+
+static void hpp_truncate(void **state)
+{
+	std::array<std::uint8_t, PDU_SIZE> pdu{};
+
+	/* Like avtp_aaf_pdu_set(), out of range values are truncated and
+	 * neighbour fields are left untouched.
+	 */
+	avtp::set<avtp::aaf::bit_depth>(pdu, 0xff);
+	avtp::set<avtp::aaf::chan_per_frame>(pdu, 0xffff);
+
+	assert_int_equal(avtp::get<avtp::aaf::chan_per_frame>(pdu), 0x3ff);
+	assert_int_equal(avtp::get<avtp::aaf::nsr>(pdu), 0);
+	assert_int_equal(avtp::get<avtp::aaf::bit_depth>(pdu), 0xff);
+}
+
+static void hpp_containers(void **state)
+{
+	std::vector<std::byte> vec(PDU_SIZE);
+	std::uint8_t raw[PDU_SIZE] = { 0 };
+
+	avtp::set<avtp::crf::timestamp_interval>(vec, 160);
+	avtp::set<avtp::crf::timestamp_interval>(&raw[0], 160);
+
+	assert_int_equal(avtp::get<avtp::crf::timestamp_interval>(vec), 160);
+	assert_int_equal(avtp::get<avtp::crf::timestamp_interval>(raw), 160);
+	assert_memory_equal(vec.data(), raw, PDU_SIZE);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(hpp_common_fields),
+		cmocka_unit_test(hpp_aaf_fields),
+		cmocka_unit_test(hpp_cvf_fields),
+		cmocka_unit_test(hpp_crf_fields),
+		cmocka_unit_test(hpp_ieciidc_fields),
+		cmocka_unit_test(hpp_truncate),
+		cmocka_unit_test(hpp_containers),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
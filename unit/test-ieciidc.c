@@ -1190,6 +1190,1138 @@ static void ieciidc_pdu_init(void **state)
 	assert_true(ntohl(pdu.packet_info) == 0x000040A0);
 }
 
+static void ieciidc_ts_pktzr_init_null_pktzr(void **state)
+{
+	int res;
+
+	res = avtp_ieciidc_ts_pktzr_init(NULL, 8000000, 1500, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_ts_pktzr_init_invalid_bitrate(void **state)
+{
+	int res;
+	struct avtp_ieciidc_ts_pktzr pktzr;
+
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 0, 1500, 0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_ts_pktzr_init_invalid_pdu_size(void **state)
+{
+	int res;
+	struct avtp_ieciidc_ts_pktzr pktzr;
+
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000,
+			IECIIDC_PDU_HEADER_SIZE + AVTP_IECIIDC_TS_SP_LEN - 1,
+			0);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_ts_pktzr_pdu_init(void **state)
+{
+	int res;
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_ts_pktzr_pdu_init(&pktzr, pdu);
+	assert_int_equal(res, 0);
+
+	assert_int_equal(ntohl(pdu->subtype_data), 0x00800000);
+	assert_int_equal(ntohl(pdu->packet_info), 0x00005FA0);
+	/* SID 63, DBS 6, FN 3, QPC 0, SPH 1, DBC 0 */
+	assert_int_equal(ntohl(pay->cip_1), 0x3F06C400);
+	/* QI_2 2, FMT 0x20, FDF and SYT 0 */
+	assert_int_equal(ntohl(pay->cip_2), 0xA0000000);
+}
+
+static void ieciidc_ts_pktzr_fill_invalid_len(void **state)
+{
+	int res;
+	size_t pdu_len;
+	uint8_t data[AVTP_IECIIDC_TS_PACKET_LEN] = { 0 };
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_ts_pktzr_fill(&pktzr, pdu, data,
+				AVTP_IECIIDC_TS_PACKET_LEN - 1, &pdu_len);
+
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_ts_pktzr_fill(void **state)
+{
+	int res, i;
+	size_t pdu_len;
+	uint64_t val;
+	uint8_t data[AVTP_IECIIDC_TS_PACKET_LEN * 10];
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+
+	for (i = 0; i < (int) sizeof(data); i++)
+		data[i] = i / AVTP_IECIIDC_TS_PACKET_LEN;
+
+	/* 188 bytes at 1 Mbit/s take 1504000 ns. */
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 1000000, 1500,
+							0x1FFFFFFF0ULL);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_ts_pktzr_pdu_init(&pktzr, pdu);
+	assert_int_equal(res, 0);
+
+	/* 1500 byte PDUs hold 7 source packets. */
+	res = avtp_ieciidc_ts_pktzr_fill(&pktzr, pdu, data, sizeof(data),
+								&pdu_len);
+	assert_int_equal(res, 7);
+	assert_int_equal(pdu_len, IECIIDC_PDU_HEADER_SIZE +
+						7 * AVTP_IECIIDC_TS_SP_LEN);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, &val);
+	assert_int_equal(val, 8 + 7 * AVTP_IECIIDC_TS_SP_LEN);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 0);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM, &val);
+	assert_int_equal(val, 0);
+
+	for (i = 0; i < 7; i++) {
+		uint8_t *sp = pay->cip_data_payload +
+						i * AVTP_IECIIDC_TS_SP_LEN;
+		uint32_t sph;
+
+		memcpy(&sph, sp, sizeof(sph));
+		assert_int_equal(ntohl(sph),
+				(uint32_t) (0x1FFFFFFF0ULL + i * 1504000));
+		assert_int_equal(sp[4], i);
+		assert_int_equal(sp[AVTP_IECIIDC_TS_SP_LEN - 1], i);
+	}
+
+	/* Remaining 3 packets. */
+	res = avtp_ieciidc_ts_pktzr_fill(&pktzr, pdu,
+				data + 7 * AVTP_IECIIDC_TS_PACKET_LEN,
+				3 * AVTP_IECIIDC_TS_PACKET_LEN, &pdu_len);
+	assert_int_equal(res, 3);
+	assert_int_equal(pdu_len, IECIIDC_PDU_HEADER_SIZE +
+						3 * AVTP_IECIIDC_TS_SP_LEN);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 56);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM, &val);
+	assert_int_equal(val, 1);
+
+	res = avtp_ieciidc_ts_pktzr_get_time(&pktzr, &val);
+	assert_int_equal(res, 0);
+	assert_int_equal(val, 0x1FFFFFFF0ULL + 10 * 1504000);
+}
+
+static void ieciidc_ts_pktzr_fill_bitrate(void **state)
+{
+	int res, i;
+	size_t pdu_len;
+	uint64_t time, val;
+	uint8_t data[AVTP_IECIIDC_TS_PACKET_LEN] = { 0 };
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	/* 1504 bits at 3 Mbit/s take 501333.33 ns, so the fractional part
+	 * must be carried over.
+	 */
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 3000000, 1500, 0);
+	assert_int_equal(res, 0);
+	res = avtp_ieciidc_ts_pktzr_pdu_init(&pktzr, pdu);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < 3000; i++) {
+		res = avtp_ieciidc_ts_pktzr_fill(&pktzr, pdu, data,
+							sizeof(data), &pdu_len);
+		assert_int_equal(res, 1);
+	}
+
+	avtp_ieciidc_ts_pktzr_get_time(&pktzr, &time);
+	assert_int_equal(time, 1504000000);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, (2999 * 8) % 256);
+}
+
+/* Pack 'count' TS packets, whose bytes are set to their index, into 'pdu'
+ * using a packetizer.
+ */
+static size_t build_ts_pdu(struct avtp_ieciidc_ts_pktzr *pktzr,
+				struct avtp_stream_pdu *pdu, int first,
+				int count)
+{
+	uint8_t data[AVTP_IECIIDC_TS_PACKET_LEN * 7];
+	size_t pdu_len;
+	int res, i;
+
+	for (i = 0; i < count; i++)
+		memset(data + i * AVTP_IECIIDC_TS_PACKET_LEN, first + i,
+						AVTP_IECIIDC_TS_PACKET_LEN);
+
+	res = avtp_ieciidc_ts_pktzr_pdu_init(pktzr, pdu);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_ts_pktzr_fill(pktzr, pdu, data,
+			count * AVTP_IECIIDC_TS_PACKET_LEN, &pdu_len);
+	assert_int_equal(res, count);
+
+	return pdu_len;
+}
+
+static void ieciidc_ts_dpktzr_init_invalid_capacity(void **state)
+{
+	int res;
+	uint64_t times[6];
+	uint8_t data[6 * AVTP_IECIIDC_TS_PACKET_LEN];
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+
+	res = avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 6);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_ts_dpktzr_init(NULL, data, times, 4);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_ts_dpktzr_push_invalid_pdu(void **state)
+{
+	int res;
+	size_t len;
+	uint64_t times[8];
+	uint8_t data[8 * AVTP_IECIIDC_TS_PACKET_LEN];
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 0);
+	avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 8);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 2);
+
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len - 1, 0);
+	assert_int_equal(res, -EBADMSG);
+
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+					AVTP_IECIIDC_CIP_HEADER_LEN + 100);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, -EBADMSG);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 2);
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_FN, 0);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, -EBADMSG);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 2);
+	avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_AAF);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, NULL, len, 0);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_ts_dpktzr_push(void **state)
+{
+	int res, i;
+	size_t len;
+	uint64_t time, times[16];
+	uint8_t data[16 * AVTP_IECIIDC_TS_PACKET_LEN];
+	const uint8_t *ptr;
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+	struct avtp_ieciidc_ts_dpktzr_stats stats;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	/* Presentation times cross a 2^32 ns boundary, while 'now' doesn't. */
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 1000000, 1500, 0x2FFFFF000ULL);
+	avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 16);
+
+	res = avtp_ieciidc_ts_dpktzr_front(&dpktzr, &time);
+	assert_int_equal(res, -ENODATA);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 7);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0x2FFF00000ULL);
+	assert_int_equal(res, 7);
+
+	len = build_ts_pdu(&pktzr, pdu, 7, 3);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0x2FFF00000ULL);
+	assert_int_equal(res, 3);
+
+	res = avtp_ieciidc_ts_dpktzr_front(&dpktzr, &time);
+	assert_int_equal(res, 0);
+	assert_int_equal(time, 0x2FFFFF000ULL);
+
+	/* Only the first 4 packets are due. */
+	res = avtp_ieciidc_ts_dpktzr_peek(&dpktzr,
+				0x2FFFFF000ULL + 3 * 1504000, (const void **)
+								&ptr);
+	assert_int_equal(res, 4);
+
+	res = avtp_ieciidc_ts_dpktzr_peek(&dpktzr, UINT64_MAX,
+						(const void **) &ptr);
+	assert_int_equal(res, 10);
+
+	for (i = 0; i < 10; i++) {
+		assert_int_equal(ptr[i * AVTP_IECIIDC_TS_PACKET_LEN], i);
+		assert_int_equal(ptr[(i + 1) * AVTP_IECIIDC_TS_PACKET_LEN - 1],
+									i);
+		assert_int_equal(times[i], 0x2FFFFF000ULL + i * 1504000);
+	}
+
+	res = avtp_ieciidc_ts_dpktzr_pop(&dpktzr, 11);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_ts_dpktzr_pop(&dpktzr, 10);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	assert_int_equal(res, 0);
+	assert_int_equal(stats.packets, 10);
+	assert_int_equal(stats.lost, 0);
+	assert_int_equal(stats.dropped, 0);
+}
+
+static void ieciidc_ts_dpktzr_push_lost(void **state)
+{
+	int res;
+	size_t len;
+	uint64_t times[16];
+	uint8_t data[16 * AVTP_IECIIDC_TS_PACKET_LEN];
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+	struct avtp_ieciidc_ts_dpktzr_stats stats;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 1000000);
+	avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 16);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 3);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 3);
+
+	/* This PDU never makes it. */
+	build_ts_pdu(&pktzr, pdu, 3, 5);
+
+	len = build_ts_pdu(&pktzr, pdu, 8, 2);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 2);
+
+	avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	assert_int_equal(stats.packets, 5);
+	assert_int_equal(stats.lost, 5);
+}
+
+/* A burst loss of more than half the 'dbc' range isn't taken as a step
+ * back.
+ */
+static void ieciidc_ts_dpktzr_push_burst_lost(void **state)
+{
+	int res, i;
+	size_t len;
+	uint64_t times[16];
+	uint8_t data[16 * AVTP_IECIIDC_TS_PACKET_LEN];
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+	struct avtp_ieciidc_ts_dpktzr_stats stats;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 1000000);
+	avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 16);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 1);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 1);
+
+	/* 25 source packets, i.e. 200 data blocks, never make it. */
+	for (i = 0; i < 5; i++)
+		build_ts_pdu(&pktzr, pdu, 1 + i * 5, 5);
+
+	len = build_ts_pdu(&pktzr, pdu, 26, 2);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 2);
+
+	len = build_ts_pdu(&pktzr, pdu, 28, 2);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 2);
+
+	avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	assert_int_equal(stats.packets, 5);
+	assert_int_equal(stats.lost, 25);
+}
+
+/* Duplicated and reordered PDUs are neither queued nor accounted as lost. */
+static void ieciidc_ts_dpktzr_push_reordered(void **state)
+{
+	int res, i;
+	size_t len[3];
+	uint64_t times[16];
+	uint8_t data[16 * AVTP_IECIIDC_TS_PACKET_LEN];
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+	struct avtp_ieciidc_ts_dpktzr_stats stats;
+	struct avtp_stream_pdu *pdu[3];
+
+	for (i = 0; i < 3; i++)
+		pdu[i] = alloca(1500);
+
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 1000000);
+	avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 16);
+
+	len[0] = build_ts_pdu(&pktzr, pdu[0], 0, 1);
+	len[1] = build_ts_pdu(&pktzr, pdu[1], 1, 1);
+	len[2] = build_ts_pdu(&pktzr, pdu[2], 2, 1);
+
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu[0], len[0], 0);
+	assert_int_equal(res, 1);
+
+	/* Duplicate. */
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu[0], len[0], 0);
+	assert_int_equal(res, 0);
+
+	/* Second PDU arrives after the third one. */
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu[2], len[2], 0);
+	assert_int_equal(res, 1);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu[1], len[1], 0);
+	assert_int_equal(res, 0);
+
+	avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	assert_int_equal(stats.packets, 2);
+	assert_int_equal(stats.lost, 1);
+
+	/* 'dbc' tracking wasn't moved back. */
+	len[0] = build_ts_pdu(&pktzr, pdu[0], 3, 1);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu[0], len[0], 0);
+	assert_int_equal(res, 1);
+
+	avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	assert_int_equal(stats.packets, 3);
+	assert_int_equal(stats.lost, 1);
+}
+
+static void ieciidc_ts_dpktzr_push_full(void **state)
+{
+	int res;
+	size_t len;
+	const void *ptr;
+	uint64_t times[8];
+	uint8_t data[8 * AVTP_IECIIDC_TS_PACKET_LEN];
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_ieciidc_ts_dpktzr dpktzr;
+	struct avtp_ieciidc_ts_dpktzr_stats stats;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 1000000);
+	avtp_ieciidc_ts_dpktzr_init(&dpktzr, data, times, 8);
+
+	len = build_ts_pdu(&pktzr, pdu, 0, 7);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 7);
+
+	len = build_ts_pdu(&pktzr, pdu, 7, 7);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, -ENOSPC);
+
+	avtp_ieciidc_ts_dpktzr_get_stats(&dpktzr, &stats);
+	assert_int_equal(stats.dropped, 7);
+	assert_int_equal(stats.lost, 0);
+
+	avtp_ieciidc_ts_dpktzr_pop(&dpktzr, 7);
+
+	/* Ring wraps around: the first run stops at its end. */
+	len = build_ts_pdu(&pktzr, pdu, 14, 7);
+	res = avtp_ieciidc_ts_dpktzr_push(&dpktzr, pdu, len, 0);
+	assert_int_equal(res, 7);
+
+	res = avtp_ieciidc_ts_dpktzr_peek(&dpktzr, UINT64_MAX, &ptr);
+	assert_int_equal(res, 1);
+	assert_ptr_equal(ptr, data + 7 * AVTP_IECIIDC_TS_PACKET_LEN);
+	assert_int_equal(data[7 * AVTP_IECIIDC_TS_PACKET_LEN], 14);
+
+	avtp_ieciidc_ts_dpktzr_pop(&dpktzr, 1);
+
+	res = avtp_ieciidc_ts_dpktzr_peek(&dpktzr, UINT64_MAX, &ptr);
+	assert_int_equal(res, 6);
+	assert_ptr_equal(ptr, data);
+	assert_int_equal(data[0], 15);
+}
+
+static void ieciidc_am824_init_invalid(void **state)
+{
+	int res;
+	struct avtp_ieciidc_am824 am824;
+
+	res = avtp_ieciidc_am824_init(NULL, AVTP_IECIIDC_SFC_48KHZ, 2, 16, 1,
+									0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_am824_init(&am824, 0x07, 2, 16, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 0, 16,
+									1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 256, 16,
+									1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 2, 20,
+									1, 0);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_am824_pdu_init(void **state)
+{
+	int res;
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+
+	res = avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 2, 16,
+									1, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_am824_pdu_init(&am824, pdu);
+	assert_int_equal(res, 0);
+
+	assert_int_equal(ntohl(pdu->packet_info), 0x00005FA0);
+	/* SID 63, DBS 2, FN 0, QPC 0, SPH 0, DBC 0 */
+	assert_int_equal(ntohl(pay->cip_1), 0x3F020000);
+	/* QI_2 2, FMT 0x10, EVT 0, SFC 2, SYT 0xFFFF */
+	assert_int_equal(ntohl(pay->cip_2), 0x9002FFFF);
+}
+
+static void ieciidc_am824_pack_16bit(void **state)
+{
+	int res, i;
+	size_t pdu_len;
+	uint64_t val;
+	int16_t pcm[16];
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+	uint8_t *q = pay->cip_data_payload;
+
+	for (i = 0; i < 16; i++)
+		pcm[i] = (i % 2) ? -i : 0x1234 + i;
+
+	/* 3 cycles and 1000 ns: 3 * 3072 + 24 ticks. */
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 2, 16, 1,
+								376000);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+
+	res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 7, &pdu_len);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 8, &pdu_len);
+	assert_int_equal(res, 0);
+	assert_int_equal(pdu_len, IECIIDC_PDU_HEADER_SIZE + 16 * 4);
+
+	for (i = 0; i < 16; i++) {
+		assert_int_equal(q[i * 4], AVTP_IECIIDC_AM824_LABEL_MBLA_16BIT);
+		assert_int_equal(q[i * 4 + 1], (uint8_t) (pcm[i] >> 8));
+		assert_int_equal(q[i * 4 + 2], (uint8_t) pcm[i]);
+		assert_int_equal(q[i * 4 + 3], 0);
+	}
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 0);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_SYT, &val);
+	assert_int_equal(val, 0x3018);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TV, &val);
+	assert_int_equal(val, 1);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TIMESTAMP, &val);
+	assert_int_equal(val, 376000);
+
+	res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 8, &pdu_len);
+	assert_int_equal(res, 0);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 8);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TIMESTAMP, &val);
+	assert_int_equal(val, 376000 + 8 * 20833 + 2);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SEQ_NUM, &val);
+	assert_int_equal(val, 1);
+}
+
+static void ieciidc_am824_pack_24bit(void **state)
+{
+	int res;
+	size_t pdu_len;
+	int32_t pcm[5] = { 0x123456, -1, -0x800000, 0x7FFFFF, 0x000102 };
+	const uint8_t expected[] = {
+		0x40, 0x12, 0x34, 0x56,
+		0x40, 0xFF, 0xFF, 0xFF,
+		0x40, 0x80, 0x00, 0x00,
+		0x40, 0x7F, 0xFF, 0xFF,
+		0x40, 0x00, 0x01, 0x02,
+	};
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_96KHZ, 1, 24, 0, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+
+	res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 5, &pdu_len);
+	assert_int_equal(res, 0);
+	assert_int_equal(pdu_len, IECIIDC_PDU_HEADER_SIZE + 5 * 4);
+	assert_memory_equal(pay->cip_data_payload, expected,
+							sizeof(expected));
+}
+
+static void ieciidc_am824_pack_no_data(void **state)
+{
+	int res;
+	size_t pdu_len;
+	uint64_t val;
+	int16_t pcm[16] = { 0 };
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 2, 16, 1, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+
+	res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 8, &pdu_len);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_am824_pack(&am824, pdu, NULL, 0, &pdu_len);
+	assert_int_equal(res, 0);
+	assert_int_equal(pdu_len, IECIIDC_PDU_HEADER_SIZE);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_NO_DATA, &val);
+	assert_int_equal(val, 0xFF);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_SYT, &val);
+	assert_int_equal(val, 0xFFFF);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 8);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TV, &val);
+	assert_int_equal(val, 0);
+
+	/* Data packets restore the FDF. */
+	res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 8, &pdu_len);
+	assert_int_equal(res, 0);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_SFC, &val);
+	assert_int_equal(val, AVTP_IECIIDC_SFC_48KHZ);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_EVT, &val);
+	assert_int_equal(val, 0);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 8);
+}
+
+static void ieciidc_am824_pack_non_blocking(void **state)
+{
+	int res, i;
+	size_t pdu_len;
+	uint64_t val;
+	int16_t pcm[6] = { 0 };
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	/* 6 data blocks per packet at 48 kHz: SYT intervals (8 blocks)
+	 * start on blocks 0, 8, 16 and 24, i.e. on packets 0, 1, 2 and 4.
+	 */
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 1, 16, 0, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+
+	for (i = 0; i < 5; i++) {
+		res = avtp_ieciidc_am824_pack(&am824, pdu, pcm, 6, &pdu_len);
+		assert_int_equal(res, 0);
+
+		avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TV, &val);
+		assert_int_equal(val, i != 3);
+
+		avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_SYT, &val);
+		if (i == 3)
+			assert_int_equal(val, 0xFFFF);
+		else
+			assert_int_not_equal(val, 0xFFFF);
+
+		avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+		assert_int_equal(val, i * 6);
+	}
+
+	/* Packet 4 refers to block 24, which is at 500 us. */
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_TIMESTAMP, &val);
+	assert_int_equal(val, 500000);
+}
+
+static void ieciidc_am824_unpack(void **state)
+{
+	int res, i;
+	size_t pdu_len;
+	int16_t pcm16[15], out16[15];
+	int32_t pcm24[15], out24[15];
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	for (i = 0; i < 15; i++) {
+		pcm16[i] = (i * 4099) ^ 0x8000;
+		pcm24[i] = (i * 1048573) % 0x800000 - (i % 2) * 0x400000;
+	}
+
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_44_1KHZ, 3, 16, 0, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+	avtp_ieciidc_am824_pack(&am824, pdu, pcm16, 5, &pdu_len);
+
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 3, out16, 4);
+	assert_int_equal(res, -ENOSPC);
+
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 3, out16, 5);
+	assert_int_equal(res, 5);
+	assert_memory_equal(out16, pcm16, sizeof(pcm16));
+
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_44_1KHZ, 3, 24, 0, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+	avtp_ieciidc_am824_pack(&am824, pdu, pcm24, 5, &pdu_len);
+
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 24, 3, out24, 5);
+	assert_int_equal(res, 5);
+	assert_memory_equal(out24, pcm24, sizeof(pcm24));
+
+	/* 24-bit data read as 16-bit keeps the upper bits. */
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 3, out16, 5);
+	assert_int_equal(res, 5);
+	for (i = 0; i < 15; i++)
+		assert_int_equal(out16[i], pcm24[i] >> 8);
+
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len - 1, 24, 3, out24, 5);
+	assert_int_equal(res, -EBADMSG);
+
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_FMT, 0x20);
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 24, 3, out24, 5);
+	assert_int_equal(res, -EBADMSG);
+
+	/* NO-DATA packets carry no frames. */
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+	avtp_ieciidc_am824_pack(&am824, pdu, NULL, 0, &pdu_len);
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 24, 3, out24, 5);
+	assert_int_equal(res, 0);
+}
+
+static void ieciidc_am824_unpack_dbs_mismatch(void **state)
+{
+	int res;
+	size_t pdu_len;
+	int16_t pcm[64 * 6] = { 0 }, out[2 * 6];
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(2048);
+
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 64, 16, 0, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+	avtp_ieciidc_am824_pack(&am824, pdu, pcm, 6, &pdu_len);
+
+	/* 6 frames of 64 channels don't fit 6 frames of 2 channels. */
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 2, out, 6);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 0, out, 6);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_am824_unpack_not_cip(void **state)
+{
+	int res;
+	size_t pdu_len;
+	int16_t pcm[2 * 6] = { 0 }, out[2 * 6];
+	struct avtp_ieciidc_am824 am824;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+
+	avtp_ieciidc_am824_init(&am824, AVTP_IECIIDC_SFC_48KHZ, 2, 16, 0, 0);
+	avtp_ieciidc_am824_pdu_init(&am824, pdu);
+	avtp_ieciidc_am824_pack(&am824, pdu, pcm, 6, &pdu_len);
+
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TAG,
+						AVTP_IECIIDC_TAG_NO_CIP);
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 2, out, 6);
+	assert_int_equal(res, -EBADMSG);
+
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TAG,
+						AVTP_IECIIDC_TAG_CIP);
+	avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_AAF);
+	res = avtp_ieciidc_am824_unpack(pdu, pdu_len, 16, 2, out, 6);
+	assert_int_equal(res, -EBADMSG);
+}
+
+#define VIDEO_DBS		2
+#define VIDEO_LINE_LEN		24
+#define VIDEO_HEIGHT		5
+#define VIDEO_STRIDE		32
+#define VIDEO_PDU_SIZE		(IECIIDC_PDU_HEADER_SIZE + 40)
+
+/* Flatten a gather list into a contiguous PDU. */
+static size_t gather_video_pdu(const struct iovec *iov, int iovcnt,
+								void *buf)
+{
+	size_t len = 0;
+	int i;
+
+	for (i = 0; i < iovcnt; i++) {
+		memcpy((uint8_t *) buf + len, iov[i].iov_base, iov[i].iov_len);
+		len += iov[i].iov_len;
+	}
+
+	return len;
+}
+
+static void ieciidc_video_init_invalid(void **state)
+{
+	int res;
+	struct avtp_ieciidc_video video;
+
+	res = avtp_ieciidc_video_init(NULL, VIDEO_DBS, VIDEO_LINE_LEN,
+					VIDEO_HEIGHT, VIDEO_PDU_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_video_init(&video, VIDEO_DBS, VIDEO_LINE_LEN + 4,
+					VIDEO_HEIGHT, VIDEO_PDU_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_video_init(&video, VIDEO_DBS, VIDEO_LINE_LEN, 0,
+							VIDEO_PDU_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_video_init(&video, VIDEO_DBS, VIDEO_LINE_LEN,
+					VIDEO_HEIGHT, IECIIDC_PDU_HEADER_SIZE);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_video_pack(void **state)
+{
+	int res, eof;
+	uint64_t val;
+	struct iovec iov[4];
+	uint8_t data[VIDEO_STRIDE * VIDEO_HEIGHT];
+	struct avtp_ieciidc_video_frame frame = { data, VIDEO_STRIDE };
+	struct avtp_ieciidc_video video;
+	struct avtp_stream_pdu *pdu = alloca(IECIIDC_PDU_HEADER_SIZE);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+
+	res = avtp_ieciidc_video_init(&video, VIDEO_DBS, VIDEO_LINE_LEN,
+					VIDEO_HEIGHT, VIDEO_PDU_SIZE);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_video_pdu_init(&video, pdu);
+	assert_int_equal(res, 0);
+	/* SID 63, DBS 2 */
+	assert_int_equal(ntohl(pay->cip_1), 0x3F020000);
+	/* QI_2 2, FMT 0x01 */
+	assert_int_equal(ntohl(pay->cip_2), 0x81000000);
+
+	/* 5 blocks per packet: all of line 0 and 16 bytes of line 1. */
+	res = avtp_ieciidc_video_pack(&video, pdu, &frame, iov, 4, &eof);
+	assert_int_equal(res, 3);
+	assert_int_equal(eof, 0);
+	assert_ptr_equal(iov[0].iov_base, pdu);
+	assert_int_equal(iov[0].iov_len, IECIIDC_PDU_HEADER_SIZE);
+	assert_ptr_equal(iov[1].iov_base, data);
+	assert_int_equal(iov[1].iov_len, 24);
+	assert_ptr_equal(iov[2].iov_base, data + VIDEO_STRIDE);
+	assert_int_equal(iov[2].iov_len, 16);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SY, &val);
+	assert_int_equal(val, 1);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, &val);
+	assert_int_equal(val, 8 + 40);
+
+	/* With only 2 entries, packets stop at the end of the line. */
+	res = avtp_ieciidc_video_pack(&video, pdu, &frame, iov, 2, &eof);
+	assert_int_equal(res, 2);
+	assert_ptr_equal(iov[1].iov_base, data + VIDEO_STRIDE + 16);
+	assert_int_equal(iov[1].iov_len, 8);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SY, &val);
+	assert_int_equal(val, 0);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 5);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, &val);
+	assert_int_equal(val, 8 + 8);
+
+	/* 15 blocks per frame: 6 sent, then 5 and 4. */
+	res = avtp_ieciidc_video_pack(&video, pdu, &frame, iov, 4, &eof);
+	assert_int_equal(eof, 0);
+	res = avtp_ieciidc_video_pack(&video, pdu, &frame, iov, 4, &eof);
+	assert_int_equal(res, 3);
+	assert_int_equal(eof, 1);
+	assert_ptr_equal(iov[1].iov_base, data + 3 * VIDEO_STRIDE + 16);
+	assert_int_equal(iov[1].iov_len, 8);
+	assert_ptr_equal(iov[2].iov_base, data + 4 * VIDEO_STRIDE);
+	assert_int_equal(iov[2].iov_len, 24);
+
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, &val);
+	assert_int_equal(val, 11);
+
+	res = avtp_ieciidc_video_pack(&video, pdu, &frame, iov, 4, &eof);
+	assert_int_equal(res, 3);
+	avtp_ieciidc_pdu_get(pdu, AVTP_IECIIDC_FIELD_SY, &val);
+	assert_int_equal(val, 1);
+}
+
+static void ieciidc_video_unpack(void **state)
+{
+	int res, eof, i, n;
+	size_t len;
+	uint64_t lost;
+	struct iovec iov[4];
+	uint8_t src[VIDEO_STRIDE * VIDEO_HEIGHT];
+	uint8_t dst[VIDEO_LINE_LEN * VIDEO_HEIGHT];
+	struct avtp_ieciidc_video_frame src_frame = { src, VIDEO_STRIDE };
+	struct avtp_ieciidc_video_frame dst_frame = { dst, VIDEO_LINE_LEN };
+	struct avtp_ieciidc_video tx, rx;
+	struct avtp_stream_pdu *hdr = alloca(IECIIDC_PDU_HEADER_SIZE);
+	struct avtp_stream_pdu *pdu = alloca(VIDEO_PDU_SIZE);
+
+	for (i = 0; i < (int) sizeof(src); i++)
+		src[i] = i;
+
+	avtp_ieciidc_video_init(&tx, VIDEO_DBS, VIDEO_LINE_LEN, VIDEO_HEIGHT,
+							VIDEO_PDU_SIZE);
+	avtp_ieciidc_video_init(&rx, VIDEO_DBS, VIDEO_LINE_LEN, VIDEO_HEIGHT,
+							VIDEO_PDU_SIZE);
+	avtp_ieciidc_video_pdu_init(&tx, hdr);
+
+	/* The first frame is joined halfway, so it's dropped. */
+	n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 4, &eof);
+	n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 4, &eof);
+	len = gather_video_pdu(iov, n, pdu);
+	res = avtp_ieciidc_video_unpack(&rx, pdu, len, &dst_frame);
+	assert_int_equal(res, 0);
+	n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 4, &eof);
+	assert_int_equal(eof, 1);
+
+	memset(dst, 0, sizeof(dst));
+
+	for (i = 0; i < 3; i++) {
+		n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 4,
+									&eof);
+		len = gather_video_pdu(iov, n, pdu);
+
+		res = avtp_ieciidc_video_unpack(&rx, pdu, len, &dst_frame);
+		assert_int_equal(res, i == 2);
+	}
+
+	for (i = 0; i < VIDEO_HEIGHT; i++)
+		assert_memory_equal(dst + i * VIDEO_LINE_LEN,
+				src + i * VIDEO_STRIDE, VIDEO_LINE_LEN);
+
+	/* Lose the second packet: its blocks are skipped over. */
+	memset(dst, 0, sizeof(dst));
+
+	for (i = 0; i < 3; i++) {
+		n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 4,
+									&eof);
+		if (i == 1)
+			continue;
+
+		len = gather_video_pdu(iov, n, pdu);
+
+		res = avtp_ieciidc_video_unpack(&rx, pdu, len, &dst_frame);
+		assert_int_equal(res, i == 2);
+	}
+
+	avtp_ieciidc_video_get_lost(&rx, &lost);
+	assert_int_equal(lost, 5);
+
+	/* Blocks 0-4 and 10-14 made it, 5-9 (bytes 40-79) didn't. */
+	assert_memory_equal(dst, src, VIDEO_LINE_LEN);
+	assert_memory_equal(dst + 24, src + VIDEO_STRIDE, 16);
+	assert_int_equal(dst[40], 0);
+	assert_int_equal(dst[79], 0);
+	assert_memory_equal(dst + 80, src + 3 * VIDEO_STRIDE + 8, 16);
+	assert_memory_equal(dst + 96, src + 4 * VIDEO_STRIDE, 24);
+
+	res = avtp_ieciidc_video_unpack(&rx, pdu, len - 1, &dst_frame);
+	assert_int_equal(res, -EBADMSG);
+}
+
+/* With 1-quadlet data blocks a packet could hold more blocks than 'dbc'
+ * counts. Packets are capped, and a loss 'dbc' can't size makes the
+ * depacketizer wait for the next frame rather than guess.
+ */
+static void ieciidc_video_unpack_resync(void **state)
+{
+	int res, eof, i, n;
+	size_t len;
+	uint64_t val;
+	struct iovec iov[8];
+	uint8_t src[400 * 10];
+	uint8_t dst[400 * 10];
+	struct avtp_ieciidc_video_frame src_frame = { src, 400 };
+	struct avtp_ieciidc_video_frame dst_frame = { dst, 400 };
+	struct avtp_ieciidc_video tx, rx;
+	struct avtp_stream_pdu *hdr = alloca(IECIIDC_PDU_HEADER_SIZE);
+	struct avtp_stream_pdu *pdu = alloca(IECIIDC_PDU_HEADER_SIZE + 2000);
+
+	for (i = 0; i < (int) sizeof(src); i++)
+		src[i] = i % 251 + 1;
+
+	avtp_ieciidc_video_init(&tx, 1, 400, 10,
+					IECIIDC_PDU_HEADER_SIZE + 2000);
+	avtp_ieciidc_video_init(&rx, 1, 400, 10,
+					IECIIDC_PDU_HEADER_SIZE + 2000);
+	avtp_ieciidc_video_pdu_init(&tx, hdr);
+
+	memset(dst, 0, sizeof(dst));
+
+	/* 1000 blocks per frame: 255, 255, 255 and 235. The middle two are
+	 * lost.
+	 */
+	for (i = 0; i < 4; i++) {
+		n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 8,
+									&eof);
+		avtp_ieciidc_pdu_get(hdr, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN,
+									&val);
+		assert_int_equal(val, 8 + (i < 3 ? 255 : 235) * 4);
+		if (i == 1 || i == 2)
+			continue;
+
+		len = gather_video_pdu(iov, n, pdu);
+		res = avtp_ieciidc_video_unpack(&rx, pdu, len, &dst_frame);
+		assert_int_equal(res, 0);
+	}
+
+	assert_int_equal(eof, 1);
+	assert_memory_equal(dst, src, 255 * 4);
+	for (i = 255 * 4; i < (int) sizeof(dst); i++)
+		assert_int_equal(dst[i], 0);
+
+	for (i = 0; i < 4; i++) {
+		n = avtp_ieciidc_video_pack(&tx, hdr, &src_frame, iov, 8,
+									&eof);
+		len = gather_video_pdu(iov, n, pdu);
+		res = avtp_ieciidc_video_unpack(&rx, pdu, len, &dst_frame);
+		assert_int_equal(res, i == 3);
+	}
+
+	assert_memory_equal(dst, src, sizeof(src));
+}
+
+static void ieciidc_cip_init_null(void **state)
+{
+	int res;
+	struct avtp_ieciidc_cip cip;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	res = avtp_ieciidc_cip_init(NULL, &pdu);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_cip_init(&cip, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_cip_write(NULL, &pdu, 0, 0, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ieciidc_cip_write_batch(&cip, NULL, 1, 0, 8, 0, NULL);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_cip_init_no_cip(void **state)
+{
+	int res;
+	struct avtp_ieciidc_cip cip;
+	struct avtp_stream_pdu *pdu = alloca(IECIIDC_PDU_HEADER_SIZE);
+
+	res = avtp_ieciidc_pdu_init(pdu, AVTP_IECIIDC_TAG_NO_CIP);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_cip_init(&cip, pdu);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ieciidc_cip_write(void **state)
+{
+	int res;
+	struct avtp_ieciidc_cip cip;
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(IECIIDC_PDU_HEADER_SIZE);
+	struct avtp_ieciidc_cip_payload *pay =
+			(struct avtp_ieciidc_cip_payload *) pdu->avtp_payload;
+
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 0);
+	assert_int_equal(res, 0);
+	res = avtp_ieciidc_ts_pktzr_pdu_init(&pktzr, pdu);
+	assert_int_equal(res, 0);
+
+	/* Per-packet fields in the source PDU are not part of the template. */
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_DBC, 0x55);
+	assert_int_equal(res, 0);
+	res = avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_SYT, 0x1234);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_cip_init(&cip, pdu);
+	assert_int_equal(res, 0);
+
+	res = avtp_ieciidc_cip_write(&cip, pdu, 0xAA, 0x12, 0xBEEF);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pay->cip_1), 0x3F06C4AA);
+	assert_int_equal(ntohl(pay->cip_2), 0xA012BEEF);
+
+	res = avtp_ieciidc_cip_write(&cip, pdu, 0, 0, 0);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pay->cip_1), 0x3F06C400);
+	assert_int_equal(ntohl(pay->cip_2), 0xA0000000);
+}
+
+static void ieciidc_cip_write_batch(void **state)
+{
+	int res, i;
+	struct avtp_ieciidc_cip cip;
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	struct avtp_stream_pdu *pdus[3];
+	struct avtp_ieciidc_cip_payload *pay;
+	const uint16_t syt[3] = { 0x0100, 0x0200, 0x0300 };
+
+	for (i = 0; i < 3; i++)
+		pdus[i] = alloca(IECIIDC_PDU_HEADER_SIZE);
+
+	res = avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, 1500, 0);
+	assert_int_equal(res, 0);
+	res = avtp_ieciidc_ts_pktzr_pdu_init(&pktzr, pdus[0]);
+	assert_int_equal(res, 0);
+	res = avtp_ieciidc_cip_init(&cip, pdus[0]);
+	assert_int_equal(res, 0);
+
+	/* 'dbc' wraps around. */
+	res = avtp_ieciidc_cip_write_batch(&cip, pdus, 3, 0xF0, 8, 0x04, syt);
+	assert_int_equal(res, 0);
+	for (i = 0; i < 3; i++) {
+		pay = (struct avtp_ieciidc_cip_payload *) pdus[i]->avtp_payload;
+		assert_int_equal(ntohl(pay->cip_1),
+				0x3F06C400 | (uint8_t) (0xF0 + i * 8));
+		assert_int_equal(ntohl(pay->cip_2), 0xA0040000 | syt[i]);
+	}
+
+	res = avtp_ieciidc_cip_write_batch(&cip, pdus, 3, 0, 8, 0xFF, NULL);
+	assert_int_equal(res, 0);
+	for (i = 0; i < 3; i++) {
+		pay = (struct avtp_ieciidc_cip_payload *) pdus[i]->avtp_payload;
+		assert_int_equal(ntohl(pay->cip_1), 0x3F06C400 | (i * 8));
+		assert_int_equal(ntohl(pay->cip_2), 0xA0FFFFFF);
+	}
+}
+
 int main(void)
 {
 	const struct CMUnitTest tests[] = {
@@ -1261,6 +2393,37 @@ int main(void)
 		cmocka_unit_test(ieciidc_pdu_init_null_pdu),
 		cmocka_unit_test(ieciidc_pdu_init_invalid_tag),
 		cmocka_unit_test(ieciidc_pdu_init),
+		cmocka_unit_test(ieciidc_ts_pktzr_init_null_pktzr),
+		cmocka_unit_test(ieciidc_ts_pktzr_init_invalid_bitrate),
+		cmocka_unit_test(ieciidc_ts_pktzr_init_invalid_pdu_size),
+		cmocka_unit_test(ieciidc_ts_pktzr_pdu_init),
+		cmocka_unit_test(ieciidc_ts_pktzr_fill_invalid_len),
+		cmocka_unit_test(ieciidc_ts_pktzr_fill),
+		cmocka_unit_test(ieciidc_ts_pktzr_fill_bitrate),
+		cmocka_unit_test(ieciidc_ts_dpktzr_init_invalid_capacity),
+		cmocka_unit_test(ieciidc_ts_dpktzr_push_invalid_pdu),
+		cmocka_unit_test(ieciidc_ts_dpktzr_push),
+		cmocka_unit_test(ieciidc_ts_dpktzr_push_lost),
+		cmocka_unit_test(ieciidc_ts_dpktzr_push_burst_lost),
+		cmocka_unit_test(ieciidc_ts_dpktzr_push_reordered),
+		cmocka_unit_test(ieciidc_ts_dpktzr_push_full),
+		cmocka_unit_test(ieciidc_am824_init_invalid),
+		cmocka_unit_test(ieciidc_am824_pdu_init),
+		cmocka_unit_test(ieciidc_am824_pack_16bit),
+		cmocka_unit_test(ieciidc_am824_pack_24bit),
+		cmocka_unit_test(ieciidc_am824_pack_no_data),
+		cmocka_unit_test(ieciidc_am824_pack_non_blocking),
+		cmocka_unit_test(ieciidc_am824_unpack),
+		cmocka_unit_test(ieciidc_am824_unpack_dbs_mismatch),
+		cmocka_unit_test(ieciidc_am824_unpack_not_cip),
+		cmocka_unit_test(ieciidc_video_init_invalid),
+		cmocka_unit_test(ieciidc_video_pack),
+		cmocka_unit_test(ieciidc_video_unpack),
+		cmocka_unit_test(ieciidc_video_unpack_resync),
+		cmocka_unit_test(ieciidc_cip_init_null),
+		cmocka_unit_test(ieciidc_cip_init_no_cip),
+		cmocka_unit_test(ieciidc_cip_write),
+		cmocka_unit_test(ieciidc_cip_write_batch),
 	};
 
 	return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <alloca.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <arpa/inet.h>
+#include <endian.h>
+
+#include "avtp.h"
+#include "avtp_ntscf.h"
+
+/* Room for 4 ACF CAN Brief messages with 8-byte payloads. */
+#define MAX_PDU_SIZE		(sizeof(struct avtp_ntscf_pdu) + 4 * 16)
+#define LATENCY			50
+
+static void ntscf_get_field_null(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_ntscf_pdu pdu = { 0 };
+
+	res = avtp_ntscf_pdu_get(NULL, AVTP_NTSCF_FIELD_SV, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_pdu_get(&pdu, AVTP_NTSCF_FIELD_SV, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_pdu_get(&pdu, AVTP_NTSCF_FIELD_MAX, &val);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ntscf_get_fields(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_ntscf_pdu pdu;
+
+	/* 'sv' 1, 'ntscf_data_length' 1500, 'sequence_num' 0xAB. */
+	pdu.subtype_data = htonl(0x8285DCAB);
+	pdu.stream_id = htobe64(0xAABBCCDDEEFF0001);
+
+	res = avtp_ntscf_pdu_get(&pdu, AVTP_NTSCF_FIELD_SV, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_ntscf_pdu_get(&pdu, AVTP_NTSCF_FIELD_DATA_LEN, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1500);
+
+	res = avtp_ntscf_pdu_get(&pdu, AVTP_NTSCF_FIELD_SEQ_NUM, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0xAB);
+
+	res = avtp_ntscf_pdu_get(&pdu, AVTP_NTSCF_FIELD_STREAM_ID, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0xAABBCCDDEEFF0001);
+}
+
+static void ntscf_set_fields(void **state)
+{
+	int res;
+	struct avtp_ntscf_pdu pdu = { 0 };
+
+	res = avtp_ntscf_pdu_set(NULL, AVTP_NTSCF_FIELD_SV, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_pdu_set(&pdu, AVTP_NTSCF_FIELD_MAX, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_pdu_set(&pdu, AVTP_NTSCF_FIELD_SV, 1);
+	assert_int_equal(res, 0);
+	res = avtp_ntscf_pdu_set(&pdu, AVTP_NTSCF_FIELD_DATA_LEN, 1500);
+	assert_int_equal(res, 0);
+	res = avtp_ntscf_pdu_set(&pdu, AVTP_NTSCF_FIELD_SEQ_NUM, 0xAB);
+	assert_int_equal(res, 0);
+	res = avtp_ntscf_pdu_set(&pdu, AVTP_NTSCF_FIELD_STREAM_ID,
+							0xAABBCCDDEEFF0001);
+	assert_int_equal(res, 0);
+
+	assert_int_equal(ntohl(pdu.subtype_data), 0x0085DCAB);
+	assert_true(be64toh(pdu.stream_id) == 0xAABBCCDDEEFF0001);
+}
+
+static void ntscf_pdu_init(void **state)
+{
+	int res;
+	struct avtp_ntscf_pdu pdu;
+
+	memset(&pdu, 0xFF, sizeof(pdu));
+
+	res = avtp_ntscf_pdu_init(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_pdu_init(&pdu);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.subtype_data), 0x82800000);
+	assert_true(pdu.stream_id == 0);
+}
+
+static void ntscf_pktzr_init_invalid(void **state)
+{
+	int res;
+	struct avtp_ntscf_pktzr pktzr;
+
+	res = avtp_ntscf_pktzr_init(NULL, MAX_PDU_SIZE, LATENCY);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_pktzr_init(&pktzr, sizeof(struct avtp_ntscf_pdu),
+								LATENCY);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ntscf_pktzr_pack(void **state)
+{
+	int res, i;
+	uint64_t val;
+	size_t pdu_len;
+	uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	struct avtp_acf_can msgs[6];
+	struct avtp_ntscf_pktzr pktzr;
+	struct avtp_ntscf_pdu *pdu = alloca(MAX_PDU_SIZE);
+
+	for (i = 0; i < 6; i++) {
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].id = i;
+		msgs[i].data = data;
+		msgs[i].len = sizeof(data);
+	}
+
+	res = avtp_ntscf_pktzr_init(&pktzr, MAX_PDU_SIZE, LATENCY);
+	assert_int_equal(res, 0);
+	res = avtp_ntscf_pdu_init(pdu);
+	assert_int_equal(res, 0);
+
+	res = avtp_ntscf_pktzr_get_deadline(&pktzr, &val);
+	assert_int_equal(res, -ENODATA);
+	res = avtp_ntscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, -ENODATA);
+
+	/* The deadline is set by the first message in the PDU. */
+	res = avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN_BRIEF,
+							msgs, 1, 100);
+	assert_int_equal(res, 1);
+	res = avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN_BRIEF,
+							msgs + 1, 5, 120);
+	assert_int_equal(res, 3);
+
+	res = avtp_ntscf_pktzr_get_deadline(&pktzr, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 100 + LATENCY);
+
+	res = avtp_ntscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, 4);
+	assert_int_equal(pdu_len, MAX_PDU_SIZE);
+	avtp_ntscf_pdu_get(pdu, AVTP_NTSCF_FIELD_DATA_LEN, &val);
+	assert_true(val == 64);
+	avtp_ntscf_pdu_get(pdu, AVTP_NTSCF_FIELD_SEQ_NUM, &val);
+	assert_true(val == 0);
+
+	res = avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN_BRIEF,
+							msgs + 4, 2, 200);
+	assert_int_equal(res, 2);
+	res = avtp_ntscf_pktzr_get_deadline(&pktzr, &val);
+	assert_true(val == 200 + LATENCY);
+
+	res = avtp_ntscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, 2);
+	assert_int_equal(pdu_len, sizeof(struct avtp_ntscf_pdu) + 32);
+	avtp_ntscf_pdu_get(pdu, AVTP_NTSCF_FIELD_SEQ_NUM, &val);
+	assert_true(val == 1);
+}
+
+static void ntscf_pktzr_pack_invalid(void **state)
+{
+	int res;
+	uint8_t data[64] = { 0 };
+	struct avtp_acf_can msgs[2] = {
+		{ .data = data, .len = 8 },
+		{ .data = data, .len = 9 },
+	};
+	struct avtp_acf_can big = {
+		.data = data,
+		.len = 64,
+		.flags = AVTP_ACF_CAN_FLAG_FDF,
+	};
+	struct avtp_ntscf_pktzr pktzr;
+	struct avtp_ntscf_pdu *pdu = alloca(MAX_PDU_SIZE);
+
+	avtp_ntscf_pktzr_init(&pktzr, MAX_PDU_SIZE, LATENCY);
+	avtp_ntscf_pdu_init(pdu);
+
+	/* Stops before the invalid frame, then reports it. */
+	res = avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN,
+							msgs, 2, 0);
+	assert_int_equal(res, 1);
+	res = avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN,
+							msgs + 1, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	/* Never fits in an empty PDU. */
+	avtp_ntscf_pktzr_init(&pktzr, MAX_PDU_SIZE, LATENCY);
+	res = avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN,
+							&big, 1, 0);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void ntscf_iter(void **state)
+{
+	int res, i;
+	size_t pdu_len;
+	uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	struct avtp_acf_can msgs[3];
+	struct avtp_ntscf_pktzr pktzr;
+	struct avtp_ntscf_pdu *pdu = alloca(MAX_PDU_SIZE);
+	struct avtp_acf_iter iter;
+	struct avtp_acf_msg msg;
+
+	for (i = 0; i < 3; i++) {
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].id = 0x100 + i;
+		msgs[i].data = data;
+		msgs[i].len = i + 1;
+	}
+
+	avtp_ntscf_pktzr_init(&pktzr, MAX_PDU_SIZE, LATENCY);
+	avtp_ntscf_pdu_init(pdu);
+	avtp_ntscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN_BRIEF, msgs,
+								3, 0);
+	avtp_ntscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+
+	res = avtp_ntscf_iter_init(NULL, pdu, pdu_len);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_ntscf_iter_init(&iter, pdu, pdu_len - 1);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_ntscf_iter_init(&iter, pdu, pdu_len);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < 3; i++) {
+		struct avtp_acf_can can;
+
+		res = avtp_acf_iter_next(&iter, &msg);
+		assert_int_equal(res, 1);
+
+		res = avtp_acf_can_read(&msg, &can);
+		assert_int_equal(res, 0);
+		assert_int_equal(can.id, 0x100 + i);
+		assert_int_equal(can.len, i + 1);
+		assert_memory_equal(can.data, data, i + 1);
+
+		/* Zero-copy: payload points into the PDU. */
+		assert_true(can.data > (uint8_t *) pdu &&
+				can.data < (uint8_t *) pdu + pdu_len);
+	}
+
+	res = avtp_acf_iter_next(&iter, &msg);
+	assert_int_equal(res, 0);
+
+	avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_TSCF);
+	res = avtp_ntscf_iter_init(&iter, pdu, pdu_len);
+	assert_int_equal(res, -EBADMSG);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(ntscf_get_field_null),
+		cmocka_unit_test(ntscf_get_fields),
+		cmocka_unit_test(ntscf_set_fields),
+		cmocka_unit_test(ntscf_pdu_init),
+		cmocka_unit_test(ntscf_pktzr_init_invalid),
+		cmocka_unit_test(ntscf_pktzr_pack),
+		cmocka_unit_test(ntscf_pktzr_pack_invalid),
+		cmocka_unit_test(ntscf_iter),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include "avtp_policy.h"
+
+#define MAX_TRANSIT_TIME		2000000
+#define TOLERANCE			100000
+
+/* Right below a 32-bit wrap of the presentation time. */
+#define NOW				((5ULL << 32) - 1000)
+
+/* AVTP timestamp of presentation time 't'. */
+#define TS(t)				((uint32_t) (t))
+
+static void policy_invalid(void **state)
+{
+	struct avtp_policy *policy;
+	enum avtp_policy_action action;
+	uint64_t time;
+	int res;
+
+	res = avtp_policy_create(NULL, MAX_TRANSIT_TIME, TOLERANCE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_create(&policy, 1ULL << 31, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_create(&policy, 1ULL << 30, 1ULL << 29);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_create(&policy, MAX_TRANSIT_TIME, TOLERANCE);
+	assert_int_equal(res, 0);
+
+	res = avtp_policy_set_action(NULL, AVTP_POLICY_CLASS_LATE,
+						AVTP_POLICY_ACTION_DROP);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_set_action(policy, AVTP_POLICY_CLASS_MAX,
+						AVTP_POLICY_ACTION_DROP);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_set_action(policy, AVTP_POLICY_CLASS_LATE,
+						AVTP_POLICY_ACTION_MAX);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_classify(NULL, 0, NOW, &time, &action);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_classify(policy, 0, NOW, NULL, &action);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_classify(policy, 0, NOW, &time, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_policy_get_count(policy, AVTP_POLICY_CLASS_MAX, &time);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_policy_destroy(policy);
+}
+
+static void policy_classes(void **state)
+{
+	struct avtp_policy *policy;
+	enum avtp_policy_action action;
+	uint64_t time, count;
+	int res;
+
+	res = avtp_policy_create(&policy, MAX_TRANSIT_TIME, TOLERANCE);
+	assert_int_equal(res, 0);
+
+	/* On time, across the 32-bit wrap. */
+	res = avtp_policy_classify(policy, TS(NOW + MAX_TRANSIT_TIME), NOW,
+							&time, &action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_ON_TIME);
+	assert_int_equal(action, AVTP_POLICY_ACTION_SCHEDULE);
+	assert_int_equal(time, NOW + MAX_TRANSIT_TIME);
+
+	/* Late within tolerance is still on time. */
+	res = avtp_policy_classify(policy, TS(NOW - TOLERANCE), NOW, &time,
+								&action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_ON_TIME);
+	assert_int_equal(time, NOW - TOLERANCE);
+
+	res = avtp_policy_classify(policy, TS(NOW - TOLERANCE - 1), NOW, &time,
+								&action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_LATE);
+	assert_int_equal(action, AVTP_POLICY_ACTION_PRESENT_NOW);
+	assert_int_equal(time, NOW);
+
+	res = avtp_policy_classify(policy,
+				TS(NOW + MAX_TRANSIT_TIME + TOLERANCE + 1),
+				NOW, &time, &action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_EARLY);
+	assert_int_equal(action, AVTP_POLICY_ACTION_DROP);
+
+	/* Far in the past is late, not scheduled a wrap ahead. */
+	res = avtp_policy_classify(policy, TS(NOW - 1000000000), NOW, &time,
+								&action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_LATE);
+	assert_int_equal(action, AVTP_POLICY_ACTION_PRESENT_NOW);
+	assert_int_equal(time, NOW);
+
+	/* Half a wrap away, which wrap it belongs to is ambiguous. */
+	res = avtp_policy_classify(policy, TS(NOW - (1ULL << 31) + 1000), NOW,
+							&time, &action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_WRAPPED);
+	assert_int_equal(action, AVTP_POLICY_ACTION_DROP);
+	assert_int_equal(time, NOW - (1ULL << 31) + 1000);
+
+	avtp_policy_get_count(policy, AVTP_POLICY_CLASS_ON_TIME, &count);
+	assert_int_equal(count, 2);
+	avtp_policy_get_count(policy, AVTP_POLICY_CLASS_LATE, &count);
+	assert_int_equal(count, 2);
+	avtp_policy_get_count(policy, AVTP_POLICY_CLASS_EARLY, &count);
+	assert_int_equal(count, 1);
+	avtp_policy_get_count(policy, AVTP_POLICY_CLASS_WRAPPED, &count);
+	assert_int_equal(count, 1);
+
+	avtp_policy_destroy(policy);
+}
+
+static void policy_actions(void **state)
+{
+	struct avtp_policy *policy;
+	enum avtp_policy_action action;
+	uint64_t time;
+	int res;
+
+	res = avtp_policy_create(&policy, MAX_TRANSIT_TIME, TOLERANCE);
+	assert_int_equal(res, 0);
+
+	res = avtp_policy_set_action(policy, AVTP_POLICY_CLASS_LATE,
+						AVTP_POLICY_ACTION_CONCEAL);
+	assert_int_equal(res, 0);
+
+	res = avtp_policy_set_action(policy, AVTP_POLICY_CLASS_EARLY,
+						AVTP_POLICY_ACTION_PRESENT_NOW);
+	assert_int_equal(res, 0);
+
+	avtp_policy_classify(policy, TS(NOW - 2 * TOLERANCE), NOW, &time,
+								&action);
+	assert_int_equal(action, AVTP_POLICY_ACTION_CONCEAL);
+	assert_int_equal(time, NOW);
+
+	avtp_policy_classify(policy, TS(NOW + 2 * MAX_TRANSIT_TIME), NOW, &time,
+								&action);
+	assert_int_equal(action, AVTP_POLICY_ACTION_PRESENT_NOW);
+	assert_int_equal(time, NOW);
+
+	avtp_policy_destroy(policy);
+}
+
+static void policy_zero_transit_time(void **state)
+{
+	struct avtp_policy *policy;
+	enum avtp_policy_action action;
+	uint64_t time;
+	int res;
+
+	res = avtp_policy_create(&policy, 0, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_policy_classify(policy, TS(NOW), NOW, &time, &action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_ON_TIME);
+
+	/* Late by more than the (zero) transit time is still late. */
+	res = avtp_policy_classify(policy, TS(NOW - 500000000), NOW, &time,
+								&action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_LATE);
+	assert_int_equal(action, AVTP_POLICY_ACTION_PRESENT_NOW);
+
+	res = avtp_policy_classify(policy, TS(NOW + 1), NOW, &time, &action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_EARLY);
+
+	res = avtp_policy_classify(policy, TS(NOW + (1ULL << 31)), NOW, &time,
+								&action);
+	assert_int_equal(res, AVTP_POLICY_CLASS_WRAPPED);
+
+	avtp_policy_destroy(policy);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(policy_invalid),
+		cmocka_unit_test(policy_classes),
+		cmocka_unit_test(policy_actions),
+		cmocka_unit_test(policy_zero_transit_time),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
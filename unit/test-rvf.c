@@ -0,0 +1,545 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <alloca.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <arpa/inet.h>
+
+#include "avtp.h"
+#include "avtp_rvf.h"
+
+#define RVF_HEADER_LEN		(sizeof(struct avtp_stream_pdu) + \
+						AVTP_RVF_RAW_HEADER_LEN)
+#define WIDTH			48
+#define HEIGHT			4
+#define STRIDE			128
+
+/* RVF specific fields, the quadlet (from 'format_specific' on) holding
+ * them, and the quadlet value with the field set to 'val'.
+ */
+static const struct {
+	enum avtp_rvf_field field;
+	unsigned int quadlet;
+	uint32_t bitmap;
+	uint64_t val;
+} fields[] = {
+	{ AVTP_RVF_FIELD_ACTIVE_PIXELS, 0, 0x07800000, 1920 },
+	{ AVTP_RVF_FIELD_TOTAL_LINES, 0, 0x00000438, 1080 },
+	{ AVTP_RVF_FIELD_AP, 1, 0x00008000, 1 },
+	{ AVTP_RVF_FIELD_F, 1, 0x00002000, 1 },
+	{ AVTP_RVF_FIELD_EF, 1, 0x00001000, 1 },
+	{ AVTP_RVF_FIELD_EVT, 1, 0x00000A00, 0xA },
+	{ AVTP_RVF_FIELD_PD, 1, 0x00000080, 1 },
+	{ AVTP_RVF_FIELD_I, 1, 0x00000040, 1 },
+	{ AVTP_RVF_FIELD_PIXEL_DEPTH, 2, 0x20000000, 2 },
+	{ AVTP_RVF_FIELD_PIXEL_FORMAT, 2, 0x02000000, 2 },
+	{ AVTP_RVF_FIELD_FRAME_RATE, 2, 0x00AA0000, 0xAA },
+	{ AVTP_RVF_FIELD_COLORSPACE, 2, 0x00008000, 8 },
+	{ AVTP_RVF_FIELD_NUM_LINES, 2, 0x00000F00, 15 },
+	{ AVTP_RVF_FIELD_I_SEQ_NUM, 3, 0x00550000, 0x55 },
+	{ AVTP_RVF_FIELD_LINE_NUMBER, 3, 0x0000ABCD, 0xABCD },
+};
+
+static uint32_t *get_quadlet(struct avtp_stream_pdu *pdu, unsigned int n)
+{
+	return &pdu->format_specific + n;
+}
+
+static void rvf_get_field_null(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu *pdu = alloca(RVF_HEADER_LEN);
+
+	res = avtp_rvf_pdu_get(NULL, AVTP_RVF_FIELD_SV, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_SV, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_MAX, &val);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void rvf_set_field_null(void **state)
+{
+	int res;
+	struct avtp_stream_pdu *pdu = alloca(RVF_HEADER_LEN);
+
+	res = avtp_rvf_pdu_set(NULL, AVTP_RVF_FIELD_SV, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_rvf_pdu_set(pdu, AVTP_RVF_FIELD_MAX, 1);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void rvf_get_field_stream(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu *pdu = alloca(RVF_HEADER_LEN);
+
+	memset(pdu, 0, RVF_HEADER_LEN);
+	pdu->subtype_data = htonl(0x00815500);
+	pdu->packet_info = htonl(0x05DC0000);
+
+	res = avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_SV, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_TV, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_SEQ_NUM, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0x55);
+
+	res = avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_STREAM_DATA_LEN, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1500);
+}
+
+static void rvf_get_field_rvf(void **state)
+{
+	int res;
+	unsigned int i;
+	uint64_t val;
+	struct avtp_stream_pdu *pdu = alloca(RVF_HEADER_LEN);
+
+	for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+		memset(pdu, 0, RVF_HEADER_LEN);
+		*get_quadlet(pdu, fields[i].quadlet) = htonl(fields[i].bitmap);
+
+		res = avtp_rvf_pdu_get(pdu, fields[i].field, &val);
+		assert_int_equal(res, 0);
+		assert_true(val == fields[i].val);
+	}
+}
+
+static void rvf_set_field_rvf(void **state)
+{
+	int res;
+	unsigned int i, j;
+	struct avtp_stream_pdu *pdu = alloca(RVF_HEADER_LEN);
+
+	for (i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+		memset(pdu, 0, RVF_HEADER_LEN);
+
+		res = avtp_rvf_pdu_set(pdu, fields[i].field, fields[i].val);
+		assert_int_equal(res, 0);
+
+		for (j = 0; j < 4; j++) {
+			uint32_t expected = j == fields[i].quadlet ?
+						fields[i].bitmap : 0;
+
+			assert_int_equal(ntohl(*get_quadlet(pdu, j)),
+								expected);
+		}
+	}
+}
+
+static void rvf_pdu_init(void **state)
+{
+	int res;
+	struct avtp_stream_pdu *pdu = alloca(RVF_HEADER_LEN);
+	struct avtp_rvf_payload *pay =
+			(struct avtp_rvf_payload *) pdu->avtp_payload;
+
+	memset(pdu, 0xFF, RVF_HEADER_LEN);
+
+	res = avtp_rvf_pdu_init(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_rvf_pdu_init(pdu);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu->subtype_data), 0x07800000);
+	assert_int_equal(pdu->stream_id, 0);
+	assert_int_equal(pdu->avtp_time, 0);
+	assert_int_equal(pdu->format_specific, 0);
+	assert_int_equal(pdu->packet_info, 0);
+	assert_int_equal(pay->raw_header[0], 0);
+	assert_int_equal(pay->raw_header[1], 0);
+}
+
+static void rvf_video_init_invalid(void **state)
+{
+	int res;
+	struct avtp_rvf_video video;
+
+	res = avtp_rvf_video_init(NULL, WIDTH, HEIGHT,
+				AVTP_RVF_PIXEL_FORMAT_422,
+				AVTP_RVF_PIXEL_DEPTH_8BIT, 1500);
+	assert_int_equal(res, -EINVAL);
+
+	/* 4:2:2 pgroups are 2 pixels wide. */
+	res = avtp_rvf_video_init(&video, WIDTH + 1, HEIGHT,
+				AVTP_RVF_PIXEL_FORMAT_422,
+				AVTP_RVF_PIXEL_DEPTH_8BIT, 1500);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_rvf_video_init(&video, WIDTH, HEIGHT,
+				AVTP_RVF_PIXEL_FORMAT_420,
+				AVTP_RVF_PIXEL_DEPTH_8BIT, 1500);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_rvf_video_init(&video, WIDTH, HEIGHT,
+				AVTP_RVF_PIXEL_FORMAT_444,
+				AVTP_RVF_PIXEL_DEPTH_10BIT, 1500);
+	assert_int_equal(res, -EINVAL);
+
+	/* No room for a single pgroup. */
+	res = avtp_rvf_video_init(&video, WIDTH, HEIGHT,
+				AVTP_RVF_PIXEL_FORMAT_422,
+				AVTP_RVF_PIXEL_DEPTH_8BIT, RVF_HEADER_LEN + 3);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void init_frame(struct avtp_rvf_frame *frame, uint8_t *buf,
+					uint8_t depth, int fill)
+{
+	int i;
+
+	memset(buf, 0, 3 * STRIDE * HEIGHT);
+
+	for (i = 0; i < 3; i++) {
+		frame->planes[i] = buf + i * STRIDE * HEIGHT;
+		frame->strides[i] = STRIDE;
+	}
+
+	if (!fill)
+		return;
+
+	for (i = 0; i < 3 * STRIDE * HEIGHT / 2; i++) {
+		if (depth == AVTP_RVF_PIXEL_DEPTH_8BIT)
+			buf[i * 2] = rand(), buf[i * 2 + 1] = rand();
+		else
+			((uint16_t *) buf)[i] = rand() & 0x3FF;
+	}
+}
+
+static int frames_equal(const struct avtp_rvf_frame *a,
+			const struct avtp_rvf_frame *b, size_t *line_len)
+{
+	unsigned int p, line;
+
+	for (p = 0; p < 3; p++) {
+		for (line = 0; line < HEIGHT; line++) {
+			if (memcmp((uint8_t *) a->planes[p] + line * STRIDE,
+				(uint8_t *) b->planes[p] + line * STRIDE,
+				line_len[p]))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* Send a whole frame through the packetizer and depacketizer, and return
+ * the number of PDUs used.
+ */
+static int round_trip(uint8_t format, uint8_t depth, size_t max_pdu_size,
+							size_t *line_len)
+{
+	int res, eof, pdus = 0;
+	size_t len;
+	uint8_t *src_buf = malloc(3 * STRIDE * HEIGHT);
+	uint8_t *dst_buf = malloc(3 * STRIDE * HEIGHT);
+	struct avtp_rvf_frame src, dst;
+	struct avtp_rvf_video tx, rx;
+	struct avtp_stream_pdu *pdu = alloca(max_pdu_size);
+
+	assert_non_null(src_buf);
+	assert_non_null(dst_buf);
+	init_frame(&src, src_buf, depth, 1);
+	init_frame(&dst, dst_buf, depth, 0);
+
+	res = avtp_rvf_video_init(&tx, WIDTH, HEIGHT, format, depth,
+								max_pdu_size);
+	assert_int_equal(res, 0);
+	rx = tx;
+
+	res = avtp_rvf_video_pdu_init(&tx, pdu);
+	assert_int_equal(res, 0);
+
+	do {
+		res = avtp_rvf_video_pack(&tx, pdu, &src, &len, &eof);
+		assert_int_equal(res, 0);
+		assert_in_range(len, RVF_HEADER_LEN + 1, max_pdu_size);
+
+		res = avtp_rvf_video_unpack(&rx, pdu, len, &dst);
+		assert_int_equal(res, eof);
+		pdus++;
+	} while (!eof);
+
+	/* The first fragment of the frame can't be placed, as the
+	 * depacketizer hadn't seen the stream before. Send the frame again.
+	 */
+	do {
+		avtp_rvf_video_pack(&tx, pdu, &src, &len, &eof);
+		avtp_rvf_video_unpack(&rx, pdu, len, &dst);
+	} while (!eof);
+
+	assert_true(frames_equal(&src, &dst, line_len));
+
+	free(src_buf);
+	free(dst_buf);
+
+	return pdus;
+}
+
+static void rvf_video_422_8(void **state)
+{
+	size_t line_len[3] = { WIDTH, WIDTH / 2, WIDTH / 2 };
+	int pdus;
+
+	/* 96 bytes per line: all 4 lines fit in one PDU. */
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_422, AVTP_RVF_PIXEL_DEPTH_8BIT,
+						1500, line_len);
+	assert_int_equal(pdus, 1);
+
+	/* 2 lines per PDU. */
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_422, AVTP_RVF_PIXEL_DEPTH_8BIT,
+				RVF_HEADER_LEN + 2 * 96 + 95, line_len);
+	assert_int_equal(pdus, 2);
+
+	/* Lines split in 40 + 40 + 16 byte fragments. */
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_422, AVTP_RVF_PIXEL_DEPTH_8BIT,
+					RVF_HEADER_LEN + 43, line_len);
+	assert_int_equal(pdus, 3 * HEIGHT);
+}
+
+static void rvf_video_422_10(void **state)
+{
+	size_t line_len[3] = { WIDTH * 2, WIDTH, WIDTH };
+	int pdus;
+
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_422,
+			AVTP_RVF_PIXEL_DEPTH_10BIT, 1500, line_len);
+	assert_int_equal(pdus, 1);
+
+	/* 120 bytes per line, split in 45 + 45 + 30 byte fragments. */
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_422,
+			AVTP_RVF_PIXEL_DEPTH_10BIT, RVF_HEADER_LEN + 49,
+			line_len);
+	assert_int_equal(pdus, 3 * HEIGHT);
+}
+
+static void rvf_video_444_8(void **state)
+{
+	size_t line_len[3] = { WIDTH, WIDTH, WIDTH };
+	int pdus;
+
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_444, AVTP_RVF_PIXEL_DEPTH_8BIT,
+						1500, line_len);
+	assert_int_equal(pdus, 1);
+
+	/* 144 bytes per line, split in 2 fragments of 72 bytes. */
+	pdus = round_trip(AVTP_RVF_PIXEL_FORMAT_444, AVTP_RVF_PIXEL_DEPTH_8BIT,
+					RVF_HEADER_LEN + 72, line_len);
+	assert_int_equal(pdus, 2 * HEIGHT);
+}
+
+static void rvf_video_pack_wire(void **state)
+{
+	int res, eof;
+	size_t len;
+	uint64_t val;
+	uint8_t buf[3 * STRIDE * HEIGHT];
+	struct avtp_rvf_frame frame;
+	struct avtp_rvf_video video;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_rvf_payload *pay =
+			(struct avtp_rvf_payload *) pdu->avtp_payload;
+	uint16_t *y, *cb, *cr;
+
+	init_frame(&frame, buf, AVTP_RVF_PIXEL_DEPTH_10BIT, 0);
+	y = frame.planes[0];
+	cb = frame.planes[1];
+	cr = frame.planes[2];
+	y[0] = 0x3FF;
+	cb[0] = 0x001;
+	cr[0] = 0x2AA;
+	y[1] = 0x155;
+
+	res = avtp_rvf_video_init(&video, WIDTH, HEIGHT,
+					AVTP_RVF_PIXEL_FORMAT_422,
+					AVTP_RVF_PIXEL_DEPTH_10BIT, 1500);
+	assert_int_equal(res, 0);
+	res = avtp_rvf_video_pdu_init(&video, pdu);
+	assert_int_equal(res, 0);
+
+	res = avtp_rvf_video_pack(&video, pdu, &frame, &len, &eof);
+	assert_int_equal(res, 0);
+	assert_int_equal(eof, 1);
+	assert_int_equal(len, RVF_HEADER_LEN + HEIGHT * WIDTH / 2 * 5);
+
+	/* Cb 0x001, Y0 0x3FF, Cr 0x2AA, Y1 0x155. */
+	assert_int_equal(pay->raw_data[0], 0x00);
+	assert_int_equal(pay->raw_data[1], 0x7F);
+	assert_int_equal(pay->raw_data[2], 0xFA);
+	assert_int_equal(pay->raw_data[3], 0xA9);
+	assert_int_equal(pay->raw_data[4], 0x55);
+
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_ACTIVE_PIXELS, &val);
+	assert_true(val == WIDTH);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_TOTAL_LINES, &val);
+	assert_true(val == HEIGHT);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_NUM_LINES, &val);
+	assert_true(val == HEIGHT);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_LINE_NUMBER, &val);
+	assert_true(val == 0);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_EF, &val);
+	assert_true(val == 1);
+	avtp_rvf_pdu_get(pdu, AVTP_RVF_FIELD_STREAM_DATA_LEN, &val);
+	assert_true(val == len - sizeof(struct avtp_stream_pdu));
+}
+
+static void rvf_video_pack_wire_444(void **state)
+{
+	int res, eof;
+	size_t len;
+	unsigned int line, i, c;
+	uint8_t buf[3 * STRIDE * HEIGHT];
+	struct avtp_rvf_frame frame;
+	struct avtp_rvf_video video;
+	struct avtp_stream_pdu *pdu = alloca(1500);
+	struct avtp_rvf_payload *pay =
+			(struct avtp_rvf_payload *) pdu->avtp_payload;
+	const uint8_t *data;
+
+	init_frame(&frame, buf, AVTP_RVF_PIXEL_DEPTH_8BIT, 1);
+
+	res = avtp_rvf_video_init(&video, WIDTH, HEIGHT,
+					AVTP_RVF_PIXEL_FORMAT_444,
+					AVTP_RVF_PIXEL_DEPTH_8BIT, 1500);
+	assert_int_equal(res, 0);
+	res = avtp_rvf_video_pdu_init(&video, pdu);
+	assert_int_equal(res, 0);
+
+	res = avtp_rvf_video_pack(&video, pdu, &frame, &len, &eof);
+	assert_int_equal(res, 0);
+	assert_int_equal(eof, 1);
+	assert_int_equal(len, RVF_HEADER_LEN + HEIGHT * WIDTH * 3);
+
+	/* Components are interleaved one pixel at a time. */
+	data = pay->raw_data;
+	for (line = 0; line < HEIGHT; line++) {
+		for (i = 0; i < WIDTH; i++) {
+			for (c = 0; c < 3; c++) {
+				const uint8_t *row = (uint8_t *)
+						frame.planes[c] + line * STRIDE;
+
+				assert_int_equal(*data++, row[i]);
+			}
+		}
+	}
+}
+
+static void rvf_video_unpack_loss(void **state)
+{
+	int res, eof, i;
+	size_t len[3 * HEIGHT];
+	uint64_t lost;
+	uint8_t src_buf[3 * STRIDE * HEIGHT], dst_buf[3 * STRIDE * HEIGHT];
+	struct avtp_rvf_frame src, dst;
+	struct avtp_rvf_video tx, rx;
+	size_t max_pdu_size = RVF_HEADER_LEN + 40;
+	uint8_t *pdus = alloca(3 * HEIGHT * max_pdu_size);
+
+	init_frame(&src, src_buf, AVTP_RVF_PIXEL_DEPTH_8BIT, 1);
+	init_frame(&dst, dst_buf, AVTP_RVF_PIXEL_DEPTH_8BIT, 0);
+
+	res = avtp_rvf_video_init(&tx, WIDTH, HEIGHT,
+					AVTP_RVF_PIXEL_FORMAT_422,
+					AVTP_RVF_PIXEL_DEPTH_8BIT, max_pdu_size);
+	assert_int_equal(res, 0);
+	rx = tx;
+
+	/* 3 fragments per line. */
+	for (i = 0; i < 3 * HEIGHT; i++) {
+		struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *)
+						(pdus + i * max_pdu_size);
+
+		avtp_rvf_video_pdu_init(&tx, pdu);
+		avtp_rvf_video_pack(&tx, pdu, &src, &len[i], &eof);
+	}
+	assert_int_equal(eof, 1);
+
+	/* Drop the first fragment of line 1: the rest of line 1 can't be
+	 * placed, and the depacketizer resyncs on line 2.
+	 */
+	for (i = 0; i < 3 * HEIGHT; i++) {
+		if (i == 3)
+			continue;
+
+		res = avtp_rvf_video_unpack(&rx, (struct avtp_stream_pdu *)
+					(pdus + i * max_pdu_size), len[i], &dst);
+		assert_int_equal(res, i == 3 * HEIGHT - 1);
+	}
+
+	res = avtp_rvf_video_get_lost(&rx, &lost);
+	assert_int_equal(res, 0);
+	assert_int_equal(lost, 1);
+
+	assert_memory_equal(dst_buf + 2 * STRIDE, src_buf + 2 * STRIDE,
+								2 * WIDTH / 2);
+	assert_int_equal(((uint8_t *) dst.planes[0])[STRIDE + WIDTH - 1], 0);
+	assert_memory_equal((uint8_t *) dst.planes[0] + 3 * STRIDE,
+			(uint8_t *) src.planes[0] + 3 * STRIDE, WIDTH);
+
+	/* Truncated PDU. */
+	res = avtp_rvf_video_unpack(&rx, (struct avtp_stream_pdu *) pdus,
+							len[0] - 1, &dst);
+	assert_int_equal(res, -EBADMSG);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(rvf_get_field_null),
+		cmocka_unit_test(rvf_set_field_null),
+		cmocka_unit_test(rvf_get_field_stream),
+		cmocka_unit_test(rvf_get_field_rvf),
+		cmocka_unit_test(rvf_set_field_rvf),
+		cmocka_unit_test(rvf_pdu_init),
+		cmocka_unit_test(rvf_video_init_invalid),
+		cmocka_unit_test(rvf_video_422_8),
+		cmocka_unit_test(rvf_video_422_10),
+		cmocka_unit_test(rvf_video_444_8),
+		cmocka_unit_test(rvf_video_pack_wire),
+		cmocka_unit_test(rvf_video_pack_wire_444),
+		cmocka_unit_test(rvf_video_unpack_loss),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
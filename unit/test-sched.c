@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "avtp_sched.h"
+
+#define MAX_ENTRIES			1000
+
+static void sched_invalid(void **state)
+{
+	struct avtp_sched *sched;
+	uint64_t time;
+	void *data;
+	int res;
+
+	res = avtp_sched_create(NULL, MAX_ENTRIES);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_create(&sched, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_create(&sched, MAX_ENTRIES);
+	assert_int_equal(res, 0);
+
+	res = avtp_sched_push(NULL, 0, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_peek(sched, NULL, &data);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_pop(sched, 0, &time, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_get_count(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_arm_timer(sched, -1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_sched_peek(sched, &time, &data);
+	assert_int_equal(res, 0);
+
+	res = avtp_sched_pop(sched, UINT64_MAX, &time, &data);
+	assert_int_equal(res, 0);
+
+	avtp_sched_destroy(sched);
+}
+
+static void sched_head(void **state)
+{
+	struct avtp_sched *sched;
+	uint64_t time;
+	void *data;
+	int res;
+
+	res = avtp_sched_create(&sched, MAX_ENTRIES);
+	assert_int_equal(res, 0);
+
+	res = avtp_sched_push(sched, 2000, "b");
+	assert_int_equal(res, 1);
+
+	res = avtp_sched_push(sched, 3000, "c");
+	assert_int_equal(res, 0);
+
+	res = avtp_sched_push(sched, 1000, "a");
+	assert_int_equal(res, 1);
+
+	res = avtp_sched_peek(sched, &time, &data);
+	assert_int_equal(res, 1);
+	assert_int_equal(time, 1000);
+	assert_string_equal(data, "a");
+
+	res = avtp_sched_pop(sched, 999, &time, &data);
+	assert_int_equal(res, 0);
+
+	res = avtp_sched_pop(sched, 2000, &time, &data);
+	assert_int_equal(res, 1);
+	assert_string_equal(data, "a");
+
+	res = avtp_sched_pop(sched, 2000, &time, &data);
+	assert_int_equal(res, 1);
+	assert_int_equal(time, 2000);
+	assert_string_equal(data, "b");
+
+	res = avtp_sched_pop(sched, 2000, &time, &data);
+	assert_int_equal(res, 0);
+
+	assert_int_equal(avtp_sched_get_count(sched), 1);
+
+	avtp_sched_destroy(sched);
+}
+
+/* Payloads from interleaved, jittery streams come out in time order, and
+ * in push order for equal times.
+ */
+static void sched_order(void **state)
+{
+	struct avtp_sched *sched;
+	uint64_t time, last = 0;
+	uintptr_t data, last_data = 0;
+	unsigned int i;
+	int res;
+
+	res = avtp_sched_create(&sched, MAX_ENTRIES);
+	assert_int_equal(res, 0);
+
+	srand(1);
+
+	for (i = 0; i < MAX_ENTRIES; i++) {
+		time = (rand() % 100) * 1000;
+
+		res = avtp_sched_push(sched, time, (void *) (uintptr_t) i);
+		assert_true(res >= 0);
+	}
+
+	res = avtp_sched_push(sched, 0, NULL);
+	assert_int_equal(res, -ENOSPC);
+
+	for (i = 0; i < MAX_ENTRIES; i++) {
+		res = avtp_sched_pop(sched, UINT64_MAX, &time,
+							(void **) &data);
+		assert_int_equal(res, 1);
+		assert_true(time >= last);
+		if (i && time == last)
+			assert_true(data > last_data);
+
+		last = time;
+		last_data = data;
+
+		/* Refill half of the slots to reuse them. */
+		if (i % 2)
+			avtp_sched_push(sched, last + 500000,
+					(void *) (uintptr_t) (MAX_ENTRIES + i));
+	}
+
+	assert_int_equal(avtp_sched_get_count(sched), MAX_ENTRIES / 2);
+
+	avtp_sched_destroy(sched);
+}
+
+static void sched_arm_timer(void **state)
+{
+	struct avtp_sched *sched;
+	struct itimerspec spec;
+	struct timespec now;
+	int fd, res;
+
+	res = avtp_sched_create(&sched, MAX_ENTRIES);
+	assert_int_equal(res, 0);
+
+	fd = timerfd_create(CLOCK_MONOTONIC, 0);
+	assert_true(fd >= 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	avtp_sched_push(sched, (now.tv_sec + 10) * 1000000000ULL, NULL);
+
+	res = avtp_sched_arm_timer(sched, fd);
+	assert_int_equal(res, 0);
+
+	timerfd_gettime(fd, &spec);
+	assert_true(spec.it_value.tv_sec > 0);
+
+	avtp_sched_pop(sched, UINT64_MAX, NULL, &(void *){ NULL });
+
+	res = avtp_sched_arm_timer(sched, fd);
+	assert_int_equal(res, 0);
+
+	timerfd_gettime(fd, &spec);
+	assert_int_equal(spec.it_value.tv_sec, 0);
+	assert_int_equal(spec.it_value.tv_nsec, 0);
+
+	close(fd);
+
+	avtp_sched_destroy(sched);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(sched_invalid),
+		cmocka_unit_test(sched_head),
+		cmocka_unit_test(sched_order),
+		cmocka_unit_test(sched_arm_timer),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "avtp_shm.h"
+
+#define RING_SIZE			AVTP_SHM_MIN_SIZE
+#define REC_HEADER_SIZE			24
+
+/* Pass the sink file descriptors over a Unix socket, as between a listener
+ * and a consumer process, and create a reader from them.
+ */
+static struct avtp_shm_reader *connect_reader(struct avtp_shm_sink *sink)
+{
+	struct avtp_shm_reader *reader;
+	int sock[2], mem_fd, bell_fd;
+	int res;
+
+	res = socketpair(AF_UNIX, SOCK_STREAM, 0, sock);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_send_fds(sink, sock[0]);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_recv_fds(sock[1], &mem_fd, &bell_fd);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_reader_create(&reader, mem_fd, bell_fd);
+	assert_int_equal(res, 0);
+
+	close(mem_fd);
+	close(bell_fd);
+	close(sock[0]);
+	close(sock[1]);
+
+	return reader;
+}
+
+static void shm_write_invalid(void **state)
+{
+	struct avtp_shm_sink *sink;
+	uint8_t buf[RING_SIZE / 4 + 1] = { 0 };
+	int res;
+
+	res = avtp_shm_sink_create(NULL, "test", RING_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_sink_create(&sink, NULL, RING_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE / 2);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE + 8);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_sink_write(NULL, buf, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_sink_write(sink, NULL, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_sink_write(sink, buf, sizeof(buf), 0);
+	assert_int_equal(res, -EMSGSIZE);
+
+	res = avtp_shm_sink_write(sink, buf, sizeof(buf) - 1, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_sink_flush(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_shm_sink_destroy(sink);
+}
+
+static void shm_reader_create_invalid(void **state)
+{
+	struct avtp_shm_reader *reader;
+	int sock[2];
+	int res;
+
+	res = socketpair(AF_UNIX, SOCK_STREAM, 0, sock);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_reader_create(NULL, sock[0], sock[1]);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_shm_reader_create(&reader, -1, sock[1]);
+	assert_int_equal(res, -EINVAL);
+
+	/* A socket is not a ring. */
+	res = avtp_shm_reader_create(&reader, sock[0], sock[1]);
+	assert_int_equal(res, -EBADMSG);
+
+	close(sock[0]);
+	close(sock[1]);
+}
+
+static void shm_recv_fds_invalid(void **state)
+{
+	int sock[2];
+	int mem_fd, bell_fd;
+	int res;
+
+	res = socketpair(AF_UNIX, SOCK_STREAM, 0, sock);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_recv_fds(sock[1], NULL, &bell_fd);
+	assert_int_equal(res, -EINVAL);
+
+	/* No file descriptors attached. */
+	res = write(sock[0], "x", 1);
+	assert_int_equal(res, 1);
+
+	res = avtp_shm_recv_fds(sock[1], &mem_fd, &bell_fd);
+	assert_int_equal(res, -EBADMSG);
+
+	close(sock[0]);
+	close(sock[1]);
+}
+
+static void shm_roundtrip(void **state)
+{
+	struct avtp_shm_sink *sink;
+	struct avtp_shm_reader *reader;
+	struct avtp_shm_rec rec;
+	char data[32];
+	int i, res;
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE);
+	assert_int_equal(res, 0);
+
+	reader = connect_reader(sink);
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < 10; i++) {
+		snprintf(data, sizeof(data), "record %d", i);
+		res = avtp_shm_sink_write(sink, data, strlen(data) + 1,
+								1000 + i);
+		assert_int_equal(res, 0);
+	}
+
+	for (i = 0; i < 10; i++) {
+		snprintf(data, sizeof(data), "record %d", i);
+
+		res = avtp_shm_reader_next(reader, &rec);
+		assert_int_equal(res, 1);
+		assert_int_equal(rec.len, strlen(data) + 1);
+		assert_int_equal(rec.time, 1000 + i);
+		assert_int_equal(rec.seq, i);
+		assert_memory_equal(rec.data, data, rec.len);
+
+		res = avtp_shm_reader_release(reader);
+		assert_int_equal(res, 0);
+	}
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 0);
+
+	/* Nothing to release. */
+	res = avtp_shm_reader_release(reader);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_shm_reader_destroy(reader);
+	avtp_shm_sink_destroy(sink);
+}
+
+/* Records of odd sizes keep the reader in step with the sink across many
+ * wraps, padding records included.
+ */
+static void shm_wrap(void **state)
+{
+	struct avtp_shm_sink *sink;
+	struct avtp_shm_reader *reader;
+	struct avtp_shm_rec rec;
+	uint8_t data[RING_SIZE / 4];
+	uint64_t i;
+	int res;
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE);
+	assert_int_equal(res, 0);
+
+	reader = connect_reader(sink);
+
+	for (i = 0; i < 1000; i++) {
+		size_t len = (i * 37) % sizeof(data);
+
+		memset(data, i, len);
+		res = avtp_shm_sink_write(sink, data, len, i);
+		assert_int_equal(res, 0);
+
+		res = avtp_shm_reader_next(reader, &rec);
+		assert_int_equal(res, 1);
+		assert_int_equal(rec.len, len);
+		assert_int_equal(rec.seq, i);
+		assert_int_equal(rec.time, i);
+		assert_memory_equal(rec.data, data, len);
+
+		res = avtp_shm_reader_release(reader);
+		assert_int_equal(res, 0);
+	}
+
+	avtp_shm_reader_destroy(reader);
+	avtp_shm_sink_destroy(sink);
+}
+
+static void shm_overrun(void **state)
+{
+	struct avtp_shm_sink *sink;
+	struct avtp_shm_reader *reader;
+	struct avtp_shm_rec rec;
+	uint8_t data[64] = { 0 };
+	uint64_t i, n = 2 * RING_SIZE / (REC_HEADER_SIZE + sizeof(data));
+	int res;
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE);
+	assert_int_equal(res, 0);
+
+	reader = connect_reader(sink);
+
+	for (i = 0; i < n; i++) {
+		res = avtp_shm_sink_write(sink, data, sizeof(data), i);
+		assert_int_equal(res, 0);
+	}
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, -EOVERFLOW);
+
+	/* The reader resumes with the next record published. */
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_sink_write(sink, data, sizeof(data), n);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 1);
+	assert_int_equal(rec.seq, n);
+	assert_int_equal(avtp_shm_reader_release(reader), 0);
+
+	avtp_shm_reader_destroy(reader);
+	avtp_shm_sink_destroy(sink);
+}
+
+static void shm_release_overwritten(void **state)
+{
+	struct avtp_shm_sink *sink;
+	struct avtp_shm_reader *reader;
+	struct avtp_shm_rec rec;
+	uint8_t data[64] = { 0 };
+	int i, res;
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE);
+	assert_int_equal(res, 0);
+
+	reader = connect_reader(sink);
+
+	res = avtp_shm_sink_write(sink, data, sizeof(data), 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 1);
+
+	/* One ring worth of records overwrites the one in use. */
+	for (i = 0; i < RING_SIZE / (REC_HEADER_SIZE + 64); i++) {
+		res = avtp_shm_sink_write(sink, data, sizeof(data), 0);
+		assert_int_equal(res, 0);
+	}
+
+	res = avtp_shm_reader_release(reader);
+	assert_int_equal(res, -EOVERFLOW);
+
+	avtp_shm_reader_destroy(reader);
+	avtp_shm_sink_destroy(sink);
+}
+
+static void shm_wait(void **state)
+{
+	struct avtp_shm_sink *sink;
+	struct avtp_shm_reader *reader;
+	struct avtp_shm_rec rec;
+	pid_t pid;
+	int res;
+
+	res = avtp_shm_sink_create(&sink, "test", RING_SIZE);
+	assert_int_equal(res, 0);
+
+	reader = connect_reader(sink);
+
+	res = avtp_shm_reader_wait(reader, 10);
+	assert_int_equal(res, -ETIMEDOUT);
+
+	res = avtp_shm_sink_write(sink, "x", 1, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_sink_flush(sink);
+	assert_int_equal(res, 0);
+
+	/* A record is pending so there is no need to sleep. */
+	res = avtp_shm_reader_wait(reader, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 1);
+	assert_int_equal(avtp_shm_reader_release(reader), 0);
+
+	/* The doorbell wakes up a reader sleeping in another process. */
+	pid = fork();
+	assert_true(pid >= 0);
+	if (pid == 0) {
+		usleep(50000);
+		avtp_shm_sink_write(sink, "y", 1, 1);
+		avtp_shm_sink_flush(sink);
+		_exit(0);
+	}
+
+	res = avtp_shm_reader_wait(reader, 5000);
+	waitpid(pid, NULL, 0);
+	assert_int_equal(res, 0);
+
+	res = avtp_shm_reader_next(reader, &rec);
+	assert_int_equal(res, 1);
+	assert_int_equal(rec.seq, 1);
+	assert_memory_equal(rec.data, "y", 1);
+
+	avtp_shm_reader_destroy(reader);
+	avtp_shm_sink_destroy(sink);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(shm_write_invalid),
+		cmocka_unit_test(shm_reader_create_invalid),
+		cmocka_unit_test(shm_recv_fds_invalid),
+		cmocka_unit_test(shm_roundtrip),
+		cmocka_unit_test(shm_wrap),
+		cmocka_unit_test(shm_overrun),
+		cmocka_unit_test(shm_release_overwritten),
+		cmocka_unit_test(shm_wait),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
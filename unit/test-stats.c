@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "avtp_stats.h"
+
+#define STREAM_ID			0xAABBCCDDEEFF0001
+#define STATS_PATH			"/tmp/test-stats"
+
+static void stats_open_invalid(void **state)
+{
+	struct avtp_stats *stats;
+	char path[] = "/tmp/test-stats-XXXXXX";
+	int fd, res;
+
+	res = avtp_stats_open(NULL, path);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_open(&stats, "/nonexistent/stats");
+	assert_int_equal(res, -ENOENT);
+
+	fd = mkstemp(path);
+	assert_true(fd >= 0);
+
+	res = avtp_stats_open(&stats, path);
+	assert_int_equal(res, -EBADMSG);
+
+	res = ftruncate(fd, 4096);
+	assert_int_equal(res, 0);
+
+	res = avtp_stats_open(&stats, path);
+	assert_int_equal(res, -EBADMSG);
+
+	close(fd);
+	unlink(path);
+}
+
+static void stats_add_stream(void **state)
+{
+	struct avtp_stats *stats;
+	unsigned int index, count;
+	int i, res;
+
+	res = avtp_stats_create(NULL, STATS_PATH, 1, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_create(&stats, NULL, 1, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_create(&stats, STATS_PATH, 0, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_create(&stats, STATS_PATH, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_create(&stats, STATS_PATH, 4, 2);
+	assert_int_equal(res, 0);
+
+	res = avtp_stats_add_stream(NULL, STREAM_ID, "s", &index);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_add_stream(stats, STREAM_ID, NULL, &index);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_stats_add_stream(stats, STREAM_ID, "s", NULL);
+	assert_int_equal(res, -EINVAL);
+
+	for (i = 0; i < 4; i++) {
+		res = avtp_stats_add_stream(stats, STREAM_ID + i, "s",
+									&index);
+		assert_int_equal(res, 0);
+		assert_int_equal(index, i);
+	}
+
+	res = avtp_stats_add_stream(stats, STREAM_ID, "s", &index);
+	assert_int_equal(res, -ENOSPC);
+
+	res = avtp_stats_get_stream_count(stats, &count);
+	assert_int_equal(res, 0);
+	assert_int_equal(count, 4);
+
+	res = avtp_stats_get_stream_count(NULL, &count);
+	assert_int_equal(res, -EINVAL);
+
+	avtp_stats_destroy(stats);
+}
+
+static void stats_get_counters(void **state)
+{
+	struct avtp_stats *stats;
+	struct avtp_stats_counters *a, *b;
+	int res;
+
+	res = avtp_stats_create(&stats, STATS_PATH, 4, 2);
+	assert_int_equal(res, 0);
+
+	assert_null(avtp_stats_get_counters(NULL, 0, 0));
+	assert_null(avtp_stats_get_counters(stats, 2, 0));
+	assert_null(avtp_stats_get_counters(stats, 0, 4));
+
+	/* Every block has its own cache lines. */
+	a = avtp_stats_get_counters(stats, 0, 0);
+	b = avtp_stats_get_counters(stats, 0, 1);
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_int_equal((uintptr_t) a % 64, 0);
+	assert_true((uint8_t *) b - (uint8_t *) a >= (ptrdiff_t) sizeof(*a));
+
+	b = avtp_stats_get_counters(stats, 1, 0);
+	assert_non_null(b);
+	assert_true(a != b);
+
+	avtp_stats_destroy(stats);
+}
+
+static void stats_read(void **state)
+{
+	struct avtp_stats *stats;
+	struct avtp_stats_counters *c0, *c1, sum;
+	struct avtp_stats *reader;
+	char name[AVTP_STATS_NAME_LEN];
+	unsigned int index, other;
+	uint64_t stream_id;
+	int res;
+
+	res = avtp_stats_create(&stats, STATS_PATH, 4, 2);
+	assert_int_equal(res, 0);
+
+	res = avtp_stats_add_stream(stats, STREAM_ID,
+			"a name much longer than AVTP_STATS_NAME_LEN", &index);
+	assert_int_equal(res, 0);
+	res = avtp_stats_add_stream(stats, STREAM_ID + 1, "other", &other);
+	assert_int_equal(res, 0);
+
+	c0 = avtp_stats_get_counters(stats, 0, index);
+	c1 = avtp_stats_get_counters(stats, 1, index);
+
+	avtp_stats_packet(c0, 100);
+	avtp_stats_packet(c0, 100);
+	avtp_stats_packet(c1, 50);
+	c0->seq_gaps += 3;
+	c1->late_drops++;
+	c1->early_drops += 2;
+	c0->invalid[AVTP_STATS_INVALID_FORMAT]++;
+	c1->invalid[AVTP_STATS_INVALID_FORMAT]++;
+	avtp_stats_margin(c0, 1000);
+	avtp_stats_margin(c0, 3000);
+	avtp_stats_margin(c1, -500);
+
+	res = avtp_stats_open(&reader, STATS_PATH);
+	assert_int_equal(res, 0);
+
+	/* Readers can't update counters. */
+	assert_null(avtp_stats_get_counters(reader, 0, index));
+	res = avtp_stats_add_stream(reader, STREAM_ID, "s", &index);
+	assert_int_equal(res, -EPERM);
+
+	res = avtp_stats_read(reader, index, &stream_id, name, &sum);
+	assert_int_equal(res, 0);
+	assert_int_equal(stream_id, STREAM_ID);
+	assert_int_equal(strlen(name), AVTP_STATS_NAME_LEN - 1);
+	assert_int_equal(sum.packets, 3);
+	assert_int_equal(sum.bytes, 250);
+	assert_int_equal(sum.seq_gaps, 3);
+	assert_int_equal(sum.late_drops, 1);
+	assert_int_equal(sum.early_drops, 2);
+	assert_int_equal(sum.invalid[AVTP_STATS_INVALID_FORMAT], 2);
+	assert_int_equal(sum.invalid[AVTP_STATS_INVALID_SUBTYPE], 0);
+	assert_int_equal(sum.margin_min, -500);
+	assert_int_equal(sum.margin_max, 3000);
+	assert_int_equal(sum.margin_sum, 3500);
+	assert_int_equal(sum.margin_count, 3);
+
+	/* No margin recorded. */
+	res = avtp_stats_read(reader, other, &stream_id, name, &sum);
+	assert_int_equal(res, 0);
+	assert_int_equal(stream_id, STREAM_ID + 1);
+	assert_true(strcmp(name, "other") == 0);
+	assert_int_equal(sum.packets, 0);
+	assert_int_equal(sum.margin_min, 0);
+	assert_int_equal(sum.margin_max, 0);
+
+	res = avtp_stats_read(reader, other + 1, &stream_id, name, &sum);
+	assert_int_equal(res, -ENOENT);
+
+	res = avtp_stats_read(NULL, index, &stream_id, name, &sum);
+	assert_int_equal(res, -EINVAL);
+
+	/* Destroying a reader leaves the registry in place. */
+	avtp_stats_destroy(reader);
+	assert_int_equal(access(STATS_PATH, F_OK), 0);
+
+	avtp_stats_destroy(stats);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(stats_open_invalid),
+		cmocka_unit_test(stats_add_stream),
+		cmocka_unit_test(stats_get_counters),
+		cmocka_unit_test(stats_read),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <alloca.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <arpa/inet.h>
+
+#include "avtp.h"
+#include "avtp_svf.h"
+
+#define LINE_LEN		100
+#define HEIGHT			8
+#define STRIDE			128
+#define MAX_PDU_SIZE		(sizeof(struct avtp_stream_pdu) + 256)
+#define RING_SIZE		4
+
+static void svf_get_field_null(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	res = avtp_svf_pdu_get(NULL, AVTP_SVF_FIELD_SV, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_SV, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_MAX, &val);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void svf_get_field_line(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	/* 'line_number' 0x0438 and 'line_offset' 0x1234. */
+	pdu.format_specific = htonl(0x04381234);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_NUMBER, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0x0438);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_OFFSET, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0x1234);
+}
+
+static void svf_get_field_packet_info(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	/* 'stream_data_length' 1476, 'f' 1, 'ef' 1, 'evt' 0xA. */
+	pdu.packet_info = htonl(0x05C43A00);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1476);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_F, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_EF, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_EVT, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0xA);
+}
+
+static void svf_set_field_null(void **state)
+{
+	int res;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	res = avtp_svf_pdu_set(NULL, AVTP_SVF_FIELD_SV, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_MAX, 1);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void svf_set_fields(void **state)
+{
+	int res;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_LINE_NUMBER, 0x0438);
+	assert_int_equal(res, 0);
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_LINE_OFFSET, 0x1234);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.format_specific), 0x04381234);
+
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, 1476);
+	assert_int_equal(res, 0);
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_F, 1);
+	assert_int_equal(res, 0);
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_EF, 1);
+	assert_int_equal(res, 0);
+	res = avtp_svf_pdu_set(&pdu, AVTP_SVF_FIELD_EVT, 0xA);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.packet_info), 0x05C43A00);
+}
+
+static void svf_pdu_init(void **state)
+{
+	int res;
+	struct avtp_stream_pdu pdu;
+
+	memset(&pdu, 0xFF, sizeof(pdu));
+
+	res = avtp_svf_pdu_init(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_pdu_init(&pdu);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.subtype_data), 0x06800000);
+	assert_int_equal(pdu.stream_id, 0);
+	assert_int_equal(pdu.avtp_time, 0);
+	assert_int_equal(pdu.format_specific, 0);
+	assert_int_equal(pdu.packet_info, 0);
+}
+
+static void svf_video_init_invalid(void **state)
+{
+	int res;
+	struct avtp_svf_video video;
+
+	res = avtp_svf_video_init(NULL, LINE_LEN, HEIGHT, MAX_PDU_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_video_init(&video, 0, HEIGHT, MAX_PDU_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_video_init(&video, 65537, HEIGHT, MAX_PDU_SIZE);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_video_init(&video, LINE_LEN, HEIGHT,
+					sizeof(struct avtp_stream_pdu));
+	assert_int_equal(res, -EINVAL);
+}
+
+static void svf_video_pack(void **state)
+{
+	int res, eof;
+	uint64_t val;
+	uint8_t data[STRIDE * HEIGHT];
+	struct avtp_svf_frame frame = { data, STRIDE };
+	struct avtp_svf_video video;
+	struct avtp_stream_pdu pdu;
+	struct iovec iov[5];
+
+	res = avtp_svf_video_init(&video, LINE_LEN, HEIGHT, MAX_PDU_SIZE);
+	assert_int_equal(res, 0);
+	res = avtp_svf_video_pdu_init(&video, &pdu);
+	assert_int_equal(res, 0);
+
+	/* Lines 0 and 1, and 56 bytes of line 2. */
+	res = avtp_svf_video_pack(&video, &pdu, &frame, iov, 5, &eof);
+	assert_int_equal(res, 4);
+	assert_int_equal(eof, 0);
+	assert_ptr_equal(iov[0].iov_base, &pdu);
+	assert_int_equal(iov[0].iov_len, sizeof(pdu));
+	assert_ptr_equal(iov[1].iov_base, data);
+	assert_int_equal(iov[1].iov_len, LINE_LEN);
+	assert_ptr_equal(iov[2].iov_base, data + STRIDE);
+	assert_int_equal(iov[2].iov_len, LINE_LEN);
+	assert_ptr_equal(iov[3].iov_base, data + 2 * STRIDE);
+	assert_int_equal(iov[3].iov_len, 56);
+
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, &val);
+	assert_true(val == 256);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_NUMBER, &val);
+	assert_true(val == 0);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_OFFSET, &val);
+	assert_true(val == 0);
+
+	/* Out of entries: rest of line 2 and line 3 only. */
+	res = avtp_svf_video_pack(&video, &pdu, &frame, iov, 3, &eof);
+	assert_int_equal(res, 3);
+	assert_ptr_equal(iov[1].iov_base, data + 2 * STRIDE + 56);
+	assert_int_equal(iov[1].iov_len, 44);
+	assert_int_equal(iov[2].iov_len, LINE_LEN);
+
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, &val);
+	assert_true(val == 144);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_NUMBER, &val);
+	assert_true(val == 2);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_OFFSET, &val);
+	assert_true(val == 56);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_SEQ_NUM, &val);
+	assert_true(val == 1);
+
+	/* 400 bytes left: 256 + 144. */
+	res = avtp_svf_video_pack(&video, &pdu, &frame, iov, 5, &eof);
+	assert_int_equal(eof, 0);
+	res = avtp_svf_video_pack(&video, &pdu, &frame, iov, 5, &eof);
+	assert_int_equal(eof, 1);
+
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_EF, &val);
+	assert_true(val == 1);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_STREAM_DATA_LEN, &val);
+	assert_true(val == 144);
+
+	/* Next frame. */
+	res = avtp_svf_video_pack(&video, &pdu, &frame, iov, 5, &eof);
+	assert_int_equal(res, 4);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_LINE_NUMBER, &val);
+	assert_true(val == 0);
+	avtp_svf_pdu_get(&pdu, AVTP_SVF_FIELD_EF, &val);
+	assert_true(val == 0);
+}
+
+static void svf_ring(void **state)
+{
+	int res;
+	uint64_t dropped;
+	struct avtp_svf_frame frames[RING_SIZE] = { 0 };
+	const struct avtp_svf_frame *frame;
+	struct avtp_svf_ring ring;
+
+	res = avtp_svf_ring_init(&ring, frames, 3);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_svf_ring_init(&ring, frames, RING_SIZE);
+	assert_int_equal(res, 0);
+
+	res = avtp_svf_ring_peek(&ring, &frame);
+	assert_int_equal(res, -ENODATA);
+
+	res = avtp_svf_ring_pop(&ring);
+	assert_int_equal(res, -ENODATA);
+
+	res = avtp_svf_ring_get_dropped(&ring, &dropped);
+	assert_int_equal(res, 0);
+	assert_int_equal(dropped, 0);
+}
+
+/* Packetize 'count' frames from 'src' into 'pdus' (a flat array of
+ * MAX_PDU_SIZE slots), returning the number of PDUs.
+ */
+static int build_pdus(struct avtp_svf_video *video,
+			const struct avtp_svf_frame *src, int count,
+			uint8_t *pdus, size_t *lens)
+{
+	int n = 0, eof;
+
+	while (count--) {
+		do {
+			struct avtp_stream_pdu *pdu = (struct avtp_stream_pdu *)
+						(pdus + n * MAX_PDU_SIZE);
+			struct iovec iov[5];
+			int i, cnt;
+
+			avtp_svf_video_pdu_init(video, pdu);
+			cnt = avtp_svf_video_pack(video, pdu, src, iov, 5,
+									&eof);
+			assert_true(cnt > 0);
+
+			/* Gather in place: the header is already there. */
+			lens[n] = iov[0].iov_len;
+			for (i = 1; i < cnt; i++) {
+				memcpy((uint8_t *) pdu + lens[n],
+					iov[i].iov_base, iov[i].iov_len);
+				lens[n] += iov[i].iov_len;
+			}
+
+			n++;
+		} while (!eof);
+	}
+
+	return n;
+}
+
+static void svf_video_unpack(void **state)
+{
+	int res, i, n;
+	uint64_t val;
+	uint8_t src_data[STRIDE * HEIGHT];
+	uint8_t dst_data[RING_SIZE][STRIDE * HEIGHT];
+	uint8_t peeked[STRIDE * HEIGHT];
+	struct avtp_svf_frame src = { src_data, STRIDE };
+	struct avtp_svf_frame frames[RING_SIZE];
+	const struct avtp_svf_frame *frame;
+	struct avtp_svf_video tx, rx;
+	struct avtp_svf_ring ring;
+	uint8_t *pdus = alloca(16 * MAX_PDU_SIZE);
+	size_t lens[16];
+
+	for (i = 0; i < STRIDE * HEIGHT; i++)
+		src_data[i] = rand();
+
+	memset(dst_data, 0, sizeof(dst_data));
+	for (i = 0; i < RING_SIZE; i++) {
+		frames[i].data = dst_data[i];
+		frames[i].stride = STRIDE;
+	}
+
+	res = avtp_svf_ring_init(&ring, frames, RING_SIZE);
+	assert_int_equal(res, 0);
+	res = avtp_svf_video_init(&tx, LINE_LEN, HEIGHT, MAX_PDU_SIZE);
+	assert_int_equal(res, 0);
+	rx = tx;
+
+	/* 4 PDUs per frame. Start mid-frame: PDUs are dropped until the
+	 * next frame starts.
+	 */
+	n = build_pdus(&tx, &src, 2, pdus, lens);
+	assert_int_equal(n, 8);
+
+	for (i = 2; i < n; i++) {
+		res = avtp_svf_video_unpack(&rx, (struct avtp_stream_pdu *)
+					(pdus + i * MAX_PDU_SIZE), lens[i],
+					&ring);
+		assert_int_equal(res, i == 7);
+	}
+
+	res = avtp_svf_ring_peek(&ring, &frame);
+	assert_int_equal(res, 0);
+	assert_ptr_equal(frame, &frames[0]);
+	for (i = 0; i < HEIGHT; i++)
+		assert_memory_equal(frame->data + i * STRIDE,
+					src_data + i * STRIDE, LINE_LEN);
+
+	res = avtp_svf_ring_pop(&ring);
+	assert_int_equal(res, 0);
+	res = avtp_svf_ring_peek(&ring, &frame);
+	assert_int_equal(res, -ENODATA);
+
+	/* Lose the second PDU of a frame: its area is left untouched. */
+	n = build_pdus(&tx, &src, 1, pdus, lens);
+	for (i = 0; i < n; i++) {
+		if (i == 1)
+			continue;
+
+		res = avtp_svf_video_unpack(&rx, (struct avtp_stream_pdu *)
+					(pdus + i * MAX_PDU_SIZE), lens[i],
+					&ring);
+		assert_int_equal(res, i == n - 1);
+	}
+
+	res = avtp_svf_video_get_lost(&rx, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 1);
+
+	res = avtp_svf_ring_peek(&ring, &frame);
+	assert_int_equal(res, 0);
+	assert_ptr_equal(frame, &frames[1]);
+	assert_memory_equal(frame->data, src_data, LINE_LEN);
+	/* Second PDU covers the end of line 2 up to line 4. */
+	assert_int_equal(frame->data[3 * STRIDE], 0);
+	assert_memory_equal(frame->data + 5 * STRIDE + 12,
+				src_data + 5 * STRIDE + 12, LINE_LEN - 12);
+
+	/* Overflow the ring with different frames while holding the peeked
+	 * one: the new frames that don't fit are dropped and the peeked one
+	 * is left untouched.
+	 */
+	memcpy(peeked, frame->data, sizeof(peeked));
+	for (i = 0; i < STRIDE * HEIGHT; i++)
+		src_data[i] = ~src_data[i];
+
+	n = build_pdus(&tx, &src, RING_SIZE, pdus, lens);
+	for (i = 0; i < n; i++)
+		avtp_svf_video_unpack(&rx, (struct avtp_stream_pdu *)
+				(pdus + i * MAX_PDU_SIZE), lens[i], &ring);
+
+	res = avtp_svf_ring_get_dropped(&ring, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 2);
+
+	assert_memory_equal(frame->data, peeked, sizeof(peeked));
+	res = avtp_svf_ring_peek(&ring, &frame);
+	assert_int_equal(res, 0);
+	assert_ptr_equal(frame, &frames[1]);
+
+	for (i = 0; i < RING_SIZE - 1; i++) {
+		res = avtp_svf_ring_pop(&ring);
+		assert_int_equal(res, 0);
+	}
+	res = avtp_svf_ring_pop(&ring);
+	assert_int_equal(res, -ENODATA);
+
+	/* Truncated PDU. */
+	res = avtp_svf_video_unpack(&rx, (struct avtp_stream_pdu *) pdus,
+							lens[0] - 1, &ring);
+	assert_int_equal(res, -EBADMSG);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(svf_get_field_null),
+		cmocka_unit_test(svf_get_field_line),
+		cmocka_unit_test(svf_get_field_packet_info),
+		cmocka_unit_test(svf_set_field_null),
+		cmocka_unit_test(svf_set_fields),
+		cmocka_unit_test(svf_pdu_init),
+		cmocka_unit_test(svf_video_init_invalid),
+		cmocka_unit_test(svf_video_pack),
+		cmocka_unit_test(svf_ring),
+		cmocka_unit_test(svf_video_unpack),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <alloca.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <arpa/inet.h>
+
+#include "avtp.h"
+#include "avtp_tscf.h"
+
+/* Room for 4 ACF CAN messages with 8-byte payloads. */
+#define MAX_PDU_SIZE		(sizeof(struct avtp_stream_pdu) + 4 * 24)
+#define WINDOW			1000
+
+static const uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+static void init_msgs(struct avtp_acf_can *msgs, const uint64_t *times,
+							unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].timestamp = times[i];
+		msgs[i].id = i;
+		msgs[i].data = data;
+		msgs[i].len = sizeof(data);
+	}
+}
+
+static void tscf_get_set_fields(void **state)
+{
+	int res;
+	uint64_t val;
+	struct avtp_stream_pdu pdu = { 0 };
+
+	res = avtp_tscf_pdu_get(NULL, AVTP_TSCF_FIELD_SV, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_pdu_get(&pdu, AVTP_TSCF_FIELD_MAX, &val);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_pdu_set(&pdu, AVTP_TSCF_FIELD_MAX, 1);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_pdu_set(&pdu, AVTP_TSCF_FIELD_STREAM_DATA_LEN, 1476);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.packet_info), 1476 << 16);
+
+	res = avtp_tscf_pdu_set(&pdu, AVTP_TSCF_FIELD_TIMESTAMP, 0x80C0FFEE);
+	assert_int_equal(res, 0);
+	res = avtp_tscf_pdu_get(&pdu, AVTP_TSCF_FIELD_TIMESTAMP, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 0x80C0FFEE);
+}
+
+static void tscf_pdu_init(void **state)
+{
+	int res;
+	struct avtp_stream_pdu pdu;
+
+	memset(&pdu, 0xFF, sizeof(pdu));
+
+	res = avtp_tscf_pdu_init(NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_pdu_init(&pdu);
+	assert_int_equal(res, 0);
+	assert_int_equal(ntohl(pdu.subtype_data), 0x05800000);
+	assert_true(pdu.stream_id == 0);
+	assert_true(pdu.avtp_time == 0);
+	assert_true(pdu.format_specific == 0);
+	assert_true(pdu.packet_info == 0);
+}
+
+static void tscf_pktzr_init_invalid(void **state)
+{
+	int res;
+	struct avtp_tscf_pktzr pktzr;
+
+	res = avtp_tscf_pktzr_init(NULL, MAX_PDU_SIZE, WINDOW);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_pktzr_init(&pktzr, MAX_PDU_SIZE, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_pktzr_init(&pktzr, sizeof(struct avtp_stream_pdu),
+								WINDOW);
+	assert_int_equal(res, -EINVAL);
+}
+
+static void tscf_pktzr_pack_window(void **state)
+{
+	int res;
+	uint64_t val;
+	size_t pdu_len;
+	static const uint64_t times[] = { 100, 500, 1099, 1100, 1200 };
+	struct avtp_acf_can msgs[5];
+	struct avtp_tscf_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
+
+	init_msgs(msgs, times, 5);
+	avtp_tscf_pktzr_init(&pktzr, MAX_PDU_SIZE, WINDOW);
+	avtp_tscf_pdu_init(pdu);
+
+	res = avtp_tscf_pktzr_get_time(&pktzr, &val);
+	assert_int_equal(res, -ENODATA);
+
+	/* The fourth message starts the next window. */
+	res = avtp_tscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN, msgs, 5);
+	assert_int_equal(res, 3);
+
+	res = avtp_tscf_pktzr_get_time(&pktzr, &val);
+	assert_int_equal(res, 0);
+	assert_true(val == 100);
+
+	res = avtp_tscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, 3);
+	assert_int_equal(pdu_len, sizeof(struct avtp_stream_pdu) + 3 * 24);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_TV, &val);
+	assert_true(val == 1);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_TIMESTAMP, &val);
+	assert_true(val == 100);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_STREAM_DATA_LEN, &val);
+	assert_true(val == 3 * 24);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_SEQ_NUM, &val);
+	assert_true(val == 0);
+
+	res = avtp_tscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, -ENODATA);
+
+	res = avtp_tscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN,
+							msgs + 3, 2);
+	assert_int_equal(res, 2);
+
+	/* Messages earlier than the window belong to another PDU too. */
+	res = avtp_tscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN,
+							msgs, 1);
+	assert_int_equal(res, 0);
+
+	res = avtp_tscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, 2);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_TIMESTAMP, &val);
+	assert_true(val == 1100);
+	avtp_tscf_pdu_get(pdu, AVTP_TSCF_FIELD_SEQ_NUM, &val);
+	assert_true(val == 1);
+}
+
+static void tscf_pktzr_pack_full(void **state)
+{
+	int res;
+	size_t pdu_len;
+	static const uint64_t times[] = { 0, 1, 2, 3, 4, 5 };
+	struct avtp_acf_can msgs[6];
+	struct avtp_tscf_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
+
+	init_msgs(msgs, times, 6);
+	avtp_tscf_pktzr_init(&pktzr, MAX_PDU_SIZE, WINDOW);
+	avtp_tscf_pdu_init(pdu);
+
+	res = avtp_tscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN, msgs, 6);
+	assert_int_equal(res, 4);
+
+	res = avtp_tscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, 4);
+	assert_int_equal(pdu_len, MAX_PDU_SIZE);
+}
+
+static void tscf_pktzr_pack_msg(void **state)
+{
+	int res;
+	size_t pdu_len;
+	uint8_t buf[96] = { 0xF0, 0x02 };
+	struct avtp_acf_msg msg = { buf, 8, AVTP_ACF_TYPE_USER0 };
+	struct avtp_tscf_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
+
+	avtp_tscf_pktzr_init(&pktzr, MAX_PDU_SIZE, WINDOW);
+	avtp_tscf_pdu_init(pdu);
+
+	res = avtp_tscf_pktzr_pack_msg(&pktzr, pdu, &msg, 5000);
+	assert_int_equal(res, 1);
+
+	res = avtp_tscf_pktzr_pack_msg(&pktzr, pdu, &msg, 6000);
+	assert_int_equal(res, 0);
+
+	msg.len = 6;
+	res = avtp_tscf_pktzr_pack_msg(&pktzr, pdu, &msg, 5000);
+	assert_int_equal(res, -EINVAL);
+
+	/* Only 88 bytes left. */
+	msg.len = 92;
+	res = avtp_tscf_pktzr_pack_msg(&pktzr, pdu, &msg, 5000);
+	assert_int_equal(res, 0);
+
+	res = avtp_tscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+	assert_int_equal(res, 1);
+	assert_memory_equal(pdu->avtp_payload, buf, 8);
+}
+
+static void tscf_iter(void **state)
+{
+	int res;
+	uint64_t time;
+	size_t pdu_len;
+	/* Window starts right after the 32-bit timestamp wraps. */
+	const uint64_t start = 0x100000010ULL;
+	const uint64_t times[] = { start, start + 10, start + 20 };
+	struct avtp_acf_can msgs[3];
+	struct avtp_tscf_pktzr pktzr;
+	struct avtp_stream_pdu *pdu = alloca(MAX_PDU_SIZE);
+	struct avtp_tscf_iter iter;
+	struct avtp_acf_msg msg;
+
+	init_msgs(msgs, times, 3);
+	avtp_tscf_pktzr_init(&pktzr, MAX_PDU_SIZE, WINDOW);
+	avtp_tscf_pdu_init(pdu);
+
+	res = avtp_tscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN, msgs, 2);
+	assert_int_equal(res, 2);
+	res = avtp_tscf_pktzr_pack_can(&pktzr, pdu, AVTP_ACF_TYPE_CAN_BRIEF,
+							msgs + 2, 1);
+	assert_int_equal(res, 1);
+	avtp_tscf_pktzr_flush(&pktzr, pdu, &pdu_len);
+
+	res = avtp_tscf_iter_init(NULL, pdu, pdu_len, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_iter_init(&iter, pdu, pdu_len - 1, 0);
+	assert_int_equal(res, -EBADMSG);
+
+	res = avtp_tscf_iter_init(&iter, pdu, pdu_len, 0xFFFFFFF0);
+	assert_int_equal(res, 0);
+
+	res = avtp_tscf_iter_next(&iter, &msg, NULL);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tscf_iter_next(&iter, &msg, &time);
+	assert_int_equal(res, 1);
+	assert_int_equal(msg.type, AVTP_ACF_TYPE_CAN);
+	assert_true(time == start);
+
+	res = avtp_tscf_iter_next(&iter, &msg, &time);
+	assert_int_equal(res, 1);
+	assert_true(time == start + 10);
+
+	/* No timestamp of its own: presented with the PDU. */
+	res = avtp_tscf_iter_next(&iter, &msg, &time);
+	assert_int_equal(res, 1);
+	assert_int_equal(msg.type, AVTP_ACF_TYPE_CAN_BRIEF);
+	assert_true(time == start);
+
+	res = avtp_tscf_iter_next(&iter, &msg, &time);
+	assert_int_equal(res, 0);
+
+	avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+							AVTP_SUBTYPE_NTSCF);
+	res = avtp_tscf_iter_init(&iter, pdu, pdu_len, 0);
+	assert_int_equal(res, -EBADMSG);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(tscf_get_set_fields),
+		cmocka_unit_test(tscf_pdu_init),
+		cmocka_unit_test(tscf_pktzr_init_invalid),
+		cmocka_unit_test(tscf_pktzr_pack_window),
+		cmocka_unit_test(tscf_pktzr_pack_full),
+		cmocka_unit_test(tscf_pktzr_pack_msg),
+		cmocka_unit_test(tscf_iter),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
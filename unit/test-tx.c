@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "avtp_tx.h"
+
+#define PDUS				40
+
+/* Zero-copy is only supported on TCP and UDP sockets, so zero-copy tests
+ * use a UDP socket connected to another one on the loopback interface.
+ */
+static void connect_udp(int fds[2])
+{
+	struct sockaddr_in addr = { 0 };
+	socklen_t len = sizeof(addr);
+	int res;
+
+	fds[0] = socket(AF_INET, SOCK_DGRAM, 0);
+	assert_true(fds[0] >= 0);
+
+	fds[1] = socket(AF_INET, SOCK_DGRAM, 0);
+	assert_true(fds[1] >= 0);
+
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	res = bind(fds[1], (struct sockaddr *) &addr, sizeof(addr));
+	assert_int_equal(res, 0);
+
+	res = getsockname(fds[1], (struct sockaddr *) &addr, &len);
+	assert_int_equal(res, 0);
+
+	res = connect(fds[0], (struct sockaddr *) &addr, sizeof(addr));
+	assert_int_equal(res, 0);
+}
+
+/* Reap notifications until send 'id' is released or a second elapses. */
+static int wait_released(struct avtp_tx_zc *zc, int fd, uint32_t id)
+{
+	struct pollfd pfd = { .fd = fd, .events = 0 };
+	int i, res;
+
+	for (i = 0; i < 100; i++) {
+		res = avtp_tx_zc_reap(zc);
+		if (res < 0)
+			return res;
+
+		res = avtp_tx_zc_is_released(zc, id);
+		if (res != 0)
+			return res;
+
+		poll(&pfd, 1, 10);
+	}
+
+	return 0;
+}
+
+static void tx_send_invalid(void **state)
+{
+	int fds[2];
+	uint8_t header[4] = { 0 };
+	struct iovec iov[AVTP_TX_MAX_IOV + 1] = { 0 };
+	ssize_t res;
+
+	res = socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_tx_send(fds[0], NULL, NULL, 4, NULL, 0, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tx_send(fds[0], NULL, header, 4, NULL, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tx_send(fds[0], NULL, header, 4, iov,
+						AVTP_TX_MAX_IOV + 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tx_send(-1, NULL, header, 4, NULL, 0, 0);
+	assert_int_equal(res, -EBADF);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void tx_send(void **state)
+{
+	int fds[2];
+	uint8_t header[4] = { 0xA0, 0xA1, 0xA2, 0xA3 };
+	uint8_t payload[6] = { 0, 1, 2, 3, 4, 5 };
+	uint8_t expected[10] = { 0xA0, 0xA1, 0xA2, 0xA3, 3, 4, 5, 0, 1, 2 };
+	uint8_t buf[32];
+	struct iovec iov[2] = {
+		{ &payload[3], 3 },
+		{ &payload[0], 3 },
+	};
+	ssize_t res;
+
+	res = socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_tx_send(fds[0], NULL, header, sizeof(header), iov, 2, 0);
+	assert_int_equal(res, sizeof(expected));
+
+	res = recv(fds[1], buf, sizeof(buf), 0);
+	assert_int_equal(res, sizeof(expected));
+	assert_memory_equal(buf, expected, sizeof(expected));
+
+	/* Header only. */
+	res = avtp_tx_send(fds[0], NULL, header, sizeof(header), NULL, 0, 0);
+	assert_int_equal(res, sizeof(header));
+
+	res = recv(fds[1], buf, sizeof(buf), 0);
+	assert_int_equal(res, sizeof(header));
+	assert_memory_equal(buf, header, sizeof(header));
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void tx_send_batch_invalid(void **state)
+{
+	int fds[2];
+	uint8_t header[4] = { 0 };
+	struct avtp_tx_pdu pdus[2] = {
+		{ header, sizeof(header), NULL, 0 },
+		{ NULL, sizeof(header), NULL, 0 },
+	};
+	uint8_t buf[32];
+	int res;
+
+	res = socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_tx_send_batch(fds[0], NULL, NULL, 1, 0);
+	assert_int_equal(res, -EINVAL);
+
+	/* Nothing is sent if any PDU is invalid. */
+	res = avtp_tx_send_batch(fds[0], NULL, pdus, 2, 0);
+	assert_int_equal(res, -EINVAL);
+
+	res = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+	assert_int_equal(res, -1);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void tx_send_batch(void **state)
+{
+	int fds[2];
+	uint8_t headers[PDUS][2];
+	uint8_t payload[PDUS];
+	struct iovec iov[PDUS];
+	struct avtp_tx_pdu pdus[PDUS];
+	uint8_t buf[32];
+	int i, res;
+
+	res = socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < PDUS; i++) {
+		headers[i][0] = 0xAA;
+		headers[i][1] = i;
+		payload[i] = PDUS - i;
+		iov[i].iov_base = &payload[i];
+		iov[i].iov_len = 1;
+		pdus[i].header = headers[i];
+		pdus[i].header_len = sizeof(headers[i]);
+		pdus[i].iov = &iov[i];
+		pdus[i].iovcnt = 1;
+	}
+
+	/* More PDUs than a single sendmmsg() call takes. */
+	res = avtp_tx_send_batch(fds[0], NULL, pdus, PDUS, 0);
+	assert_int_equal(res, PDUS);
+
+	for (i = 0; i < PDUS; i++) {
+		res = recv(fds[1], buf, sizeof(buf), 0);
+		assert_int_equal(res, 3);
+		assert_int_equal(buf[0], 0xAA);
+		assert_int_equal(buf[1], i);
+		assert_int_equal(buf[2], PDUS - i);
+	}
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void tx_zc_init_invalid(void **state)
+{
+	int fds[2];
+	struct avtp_tx_zc zc;
+	int res;
+
+	res = socketpair(AF_UNIX, SOCK_DGRAM, 0, fds);
+	assert_int_equal(res, 0);
+
+	res = avtp_tx_zc_init(NULL, fds[0]);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tx_zc_init(&zc, -1);
+	assert_int_equal(res, -EINVAL);
+
+	/* Not supported on AF_UNIX (nor AF_PACKET) sockets. */
+	res = avtp_tx_zc_init(&zc, fds[0]);
+	assert_int_equal(res, -EOPNOTSUPP);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void tx_zc_send(void **state)
+{
+	int fds[2];
+	struct avtp_tx_zc zc;
+	struct avtp_tx_zc_stats stats;
+	uint8_t header[4] = { 0xA0, 0xA1, 0xA2, 0xA3 };
+	uint8_t payload[1024];
+	uint8_t buf[2048];
+	struct iovec iov = { payload, sizeof(payload) };
+	uint32_t id[2], pending;
+	ssize_t res;
+
+	connect_udp(fds);
+
+	memset(payload, 0x5A, sizeof(payload));
+
+	res = avtp_tx_zc_init(&zc, fds[0]);
+	assert_int_equal(res, 0);
+
+	res = avtp_tx_zc_send(&zc, NULL, 4, &iov, 1, 0, &id[0]);
+	assert_int_equal(res, -EINVAL);
+
+	res = avtp_tx_zc_send(&zc, header, sizeof(header), &iov, 1, 0, &id[0]);
+	assert_int_equal(res, sizeof(header) + sizeof(payload));
+	res = avtp_tx_zc_send(&zc, header, sizeof(header), &iov, 1, 0, &id[1]);
+	assert_int_equal(res, sizeof(header) + sizeof(payload));
+	assert_int_equal(id[0], 0);
+	assert_int_equal(id[1], 1);
+
+	res = recv(fds[1], buf, sizeof(buf), 0);
+	assert_int_equal(res, sizeof(header) + sizeof(payload));
+	assert_memory_equal(buf, header, sizeof(header));
+	assert_memory_equal(buf + sizeof(header), payload, sizeof(payload));
+	res = recv(fds[1], buf, sizeof(buf), 0);
+	assert_int_equal(res, sizeof(header) + sizeof(payload));
+
+	res = wait_released(&zc, fds[0], id[1]);
+	assert_int_equal(res, 1);
+	res = avtp_tx_zc_is_released(&zc, id[0]);
+	assert_int_equal(res, 1);
+
+	res = avtp_tx_zc_get_pending(&zc, &pending);
+	assert_int_equal(res, 0);
+	assert_int_equal(pending, 0);
+
+	res = avtp_tx_zc_get_stats(&zc, &stats);
+	assert_int_equal(res, 0);
+	assert_int_equal(stats.completions, 2);
+	/* Loopback always copies the payload on receive. */
+	assert_int_equal(stats.copied, 2);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void tx_zc_send_window(void **state)
+{
+	int fds[2];
+	struct avtp_tx_zc zc;
+	uint8_t header[4] = { 0 };
+	uint32_t id, pending;
+	int i, rcvbuf = 0;
+	ssize_t res;
+
+	connect_udp(fds);
+
+	/* Drop everything on the receiver so completions are not held back
+	 * by a full receive queue.
+	 */
+	setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	res = avtp_tx_zc_init(&zc, fds[0]);
+	assert_int_equal(res, 0);
+
+	for (i = 0; i < AVTP_TX_ZC_WINDOW; i++) {
+		res = avtp_tx_zc_send(&zc, header, sizeof(header), NULL, 0,
+								0, &id);
+		assert_int_equal(res, sizeof(header));
+	}
+
+	res = avtp_tx_zc_send(&zc, header, sizeof(header), NULL, 0, 0, &id);
+	assert_int_equal(res, -ENOBUFS);
+
+	res = avtp_tx_zc_get_pending(&zc, &pending);
+	assert_int_equal(res, 0);
+	assert_in_range(pending, 0, AVTP_TX_ZC_WINDOW);
+
+	res = wait_released(&zc, fds[0], AVTP_TX_ZC_WINDOW - 1);
+	assert_int_equal(res, 1);
+
+	res = avtp_tx_zc_send(&zc, header, sizeof(header), NULL, 0, 0, &id);
+	assert_int_equal(res, sizeof(header));
+	assert_int_equal(id, AVTP_TX_ZC_WINDOW);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(tx_send_invalid),
+		cmocka_unit_test(tx_send),
+		cmocka_unit_test(tx_send_batch_invalid),
+		cmocka_unit_test(tx_send_batch),
+		cmocka_unit_test(tx_zc_init_invalid),
+		cmocka_unit_test(tx_zc_send),
+		cmocka_unit_test(tx_zc_send_window),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2018, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    * Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of Intel Corporation nor the names of its contributors
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "avtp_view.hpp"
+
+#define BUF_SIZE		1500
+
+using buffer = std::array<std::byte, BUF_SIZE>;
+
+static struct avtp_stream_pdu *stream_pdu(buffer &buf)
+{
+	return (struct avtp_stream_pdu *) buf.data();
+}
+
+static void init_aaf(buffer &buf, uint8_t format, uint16_t channels,
+							uint16_t data_len)
+{
+	struct avtp_stream_pdu *pdu = stream_pdu(buf);
+
+	buf.fill(std::byte{0});
+	avtp_aaf_pdu_init(pdu);
+	avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_FORMAT, format);
+	avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_NSR, AVTP_AAF_PCM_NSR_48KHZ);
+	avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_CHAN_PER_FRAME, channels);
+	avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_BIT_DEPTH, 24);
+	avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_STREAM_DATA_LEN, data_len);
+	avtp_aaf_pdu_set(pdu, AVTP_AAF_FIELD_SEQ_NUM, 42);
+}
+
+static void view_aaf(void **state)
+{
+	buffer buf;
+	avtp::AafView view;
+	int res;
+
+	/* 6 frames of 2 channels, 24-bit samples. */
+	init_aaf(buf, AVTP_AAF_FORMAT_INT_24BIT, 2, 36);
+	buf[24 + 6] = std::byte{0xAB};
+
+	res = view.init(buf);
+
+	assert_int_equal(res, 0);
+	assert_int_equal(view.pdu().size(), 24 + 36);
+	assert_int_equal(view.payload().size(), 36);
+	assert_int_equal(view.sample_size(), 3);
+	assert_int_equal(view.frame_size(), 6);
+	assert_int_equal(view.frames(), 6);
+	assert_int_equal(view.frame(1).size(), 6);
+	assert_true(view.frame(1)[0] == std::byte{0xAB});
+	assert_int_equal(view.get<avtp::aaf::seq_num>(), 42);
+	assert_int_equal(view.get<avtp::aaf::nsr>(), AVTP_AAF_PCM_NSR_48KHZ);
+
+	view.set<avtp::aaf::seq_num>(43);
+	view.set<avtp::aaf::sp>(AVTP_AAF_PCM_SP_SPARSE);
+
+	assert_int_equal(view.get<avtp::aaf::seq_num>(), 43);
+	assert_int_equal(view.get<avtp::aaf::sp>(), AVTP_AAF_PCM_SP_SPARSE);
+	assert_int_equal(view.get<avtp::aaf::stream_data_len>(), 36);
+}
+
+static void view_aaf_const(void **state)
+{
+	buffer buf;
+	avtp::ConstAafView view;
+	int res;
+
+	init_aaf(buf, AVTP_AAF_FORMAT_FLOAT_32BIT, 8, 64);
+
+	res = view.init(std::span<const std::byte>(buf));
+
+	assert_int_equal(res, 0);
+	assert_int_equal(view.frames(), 2);
+	assert_int_equal(view.get<avtp::aaf::chan_per_frame>(), 8);
+}
+
+static void view_aaf_invalid(void **state)
+{
+	buffer buf;
+	avtp::AafView view;
+
+	/* Buffer shorter than the header. */
+	init_aaf(buf, AVTP_AAF_FORMAT_INT_16BIT, 2, 0);
+	assert_int_equal(view.init(std::span(buf).first(23)), -EBADMSG);
+
+	/* Data length beyond the buffer. */
+	init_aaf(buf, AVTP_AAF_FORMAT_INT_16BIT, 2, 16);
+	assert_int_equal(view.init(std::span(buf).first(24 + 15)), -EBADMSG);
+	assert_int_equal(view.init(std::span(buf).first(24 + 16)), 0);
+
+	/* Data length not a multiple of the frame size. */
+	init_aaf(buf, AVTP_AAF_FORMAT_INT_16BIT, 2, 18);
+	assert_int_equal(view.init(buf), -EBADMSG);
+
+	/* No channels. */
+	init_aaf(buf, AVTP_AAF_FORMAT_INT_16BIT, 0, 16);
+	assert_int_equal(view.init(buf), -EBADMSG);
+
+	/* Unsupported format. */
+	init_aaf(buf, AVTP_AAF_FORMAT_USER, 2, 16);
+	assert_int_equal(view.init(buf), -ENOTSUP);
+
+	/* Wrong subtype. */
+	init_aaf(buf, AVTP_AAF_FORMAT_INT_16BIT, 2, 16);
+	avtp::set<avtp::common::subtype>(buf, AVTP_SUBTYPE_CVF);
+	assert_int_equal(view.init(buf), -EBADMSG);
+}
+
+static void view_cvf(void **state)
+{
+	buffer buf{};
+	struct avtp_stream_pdu *pdu = stream_pdu(buf);
+	avtp::CvfView view;
+	int res;
+
+	avtp_cvf_pdu_init(pdu, AVTP_CVF_FORMAT_SUBTYPE_H264);
+	avtp_cvf_pdu_set(pdu, AVTP_CVF_FIELD_STREAM_DATA_LEN, 4 + 100);
+	avtp_cvf_pdu_set(pdu, AVTP_CVF_FIELD_H264_TIMESTAMP, 0x11223344);
+	buf[28] = std::byte{0x65};
+
+	res = view.init(buf);
+
+	assert_int_equal(res, 0);
+	assert_true(view.is_h264());
+	assert_int_equal(view.h264_timestamp(), 0x11223344);
+	assert_int_equal(view.h264_data().size(), 100);
+	assert_true(view.h264_data()[0] == std::byte{0x65});
+
+	view.set_h264_timestamp(0x55667788);
+	view.set<avtp::cvf::m>(1);
+
+	assert_int_equal(view.h264_timestamp(), 0x55667788);
+	assert_int_equal(view.get<avtp::cvf::m>(), 1);
+}
+
+static void view_cvf_invalid(void **state)
+{
+	buffer buf{};
+	struct avtp_stream_pdu *pdu = stream_pdu(buf);
+	avtp::CvfView view;
+
+	/* Too short for the H.264 header. */
+	avtp_cvf_pdu_init(pdu, AVTP_CVF_FORMAT_SUBTYPE_H264);
+	avtp_cvf_pdu_set(pdu, AVTP_CVF_FIELD_STREAM_DATA_LEN, 3);
+	assert_int_equal(view.init(buf), -EBADMSG);
+
+	/* Other formats have no header. */
+	avtp_cvf_pdu_set(pdu, AVTP_CVF_FIELD_FORMAT_SUBTYPE,
+					AVTP_CVF_FORMAT_SUBTYPE_MJPEG);
+	assert_int_equal(view.init(buf), 0);
+	assert_false(view.is_h264());
+	assert_int_equal(view.payload().size(), 3);
+
+	avtp_cvf_pdu_set(pdu, AVTP_CVF_FIELD_FORMAT, 0);
+	assert_int_equal(view.init(buf), -ENOTSUP);
+}
+
+static void view_crf(void **state)
+{
+	buffer buf{};
+	struct avtp_crf_pdu *pdu = (struct avtp_crf_pdu *) buf.data();
+	avtp::CrfView view;
+	uint64_t ts = htobe64(0x0102030405060708ULL);
+	int res;
+
+	avtp_crf_pdu_init(pdu);
+	avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN, 3 * 8);
+	avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_TIMESTAMP_INTERVAL, 160);
+	memcpy(&buf[20 + 8], &ts, sizeof(ts));
+
+	res = view.init(buf);
+
+	assert_int_equal(res, 0);
+	assert_int_equal(view.pdu().size(), 20 + 24);
+	assert_int_equal(view.timestamps(), 3);
+	assert_true(view.timestamp(1) == 0x0102030405060708ULL);
+	assert_int_equal(view.get<avtp::crf::timestamp_interval>(), 160);
+
+	view.set_timestamp(2, 0xAABBCCDDEEFF0011ULL);
+
+	memcpy(&ts, &buf[20 + 16], sizeof(ts));
+	assert_true(be64toh(ts) == 0xAABBCCDDEEFF0011ULL);
+
+	/* Data length not a multiple of the timestamp size. */
+	avtp_crf_pdu_set(pdu, AVTP_CRF_FIELD_CRF_DATA_LEN, 20);
+	assert_int_equal(view.init(buf), -EBADMSG);
+}
+
+static void view_ieciidc(void **state)
+{
+	buffer buf{};
+	struct avtp_stream_pdu *pdu = stream_pdu(buf);
+	struct avtp_ieciidc_ts_pktzr pktzr;
+	uint8_t ts[3 * AVTP_IECIIDC_TS_PACKET_LEN];
+	avtp::IeciidcView view;
+	size_t pdu_len;
+	int res;
+
+	memset(ts, 0x47, sizeof(ts));
+	avtp_ieciidc_ts_pktzr_init(&pktzr, 8000000, BUF_SIZE, 0);
+	avtp_ieciidc_ts_pktzr_pdu_init(&pktzr, pdu);
+	res = avtp_ieciidc_ts_pktzr_fill(&pktzr, pdu, ts, sizeof(ts),
+								&pdu_len);
+	assert_int_equal(res, 3);
+
+	res = view.init(std::span(buf).first(pdu_len));
+
+	assert_int_equal(res, 0);
+	assert_int_equal(view.get<avtp::ieciidc::cip_sph>(), 1);
+	assert_int_equal(view.data_block_size(), 24);
+	assert_int_equal(view.source_packet_size(), AVTP_IECIIDC_TS_SP_LEN);
+	assert_int_equal(view.source_packets(), 3);
+	assert_true(view.source_packet(2)[4] == std::byte{0x47});
+	assert_true(view.source_packet(2).data() + AVTP_IECIIDC_TS_SP_LEN ==
+				view.pdu().data() + view.pdu().size());
+}
+
+static void view_ieciidc_invalid(void **state)
+{
+	buffer buf{};
+	struct avtp_stream_pdu *pdu = stream_pdu(buf);
+	avtp::IeciidcView view;
+
+	avtp_pdu_set((struct avtp_common_pdu *) pdu, AVTP_FIELD_SUBTYPE,
+						AVTP_SUBTYPE_61883_IIDC);
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TAG, 1);
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_DBS, 6);
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_CIP_FN, 3);
+
+	/* Data length shorter than the CIP header. */
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, 4);
+	assert_int_equal(view.init(buf), -EBADMSG);
+
+	/* Partial source packet. */
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, 8 + 100);
+	assert_int_equal(view.init(buf), -EBADMSG);
+
+	/* Empty CIP payload. */
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_STREAM_DATA_LEN, 8);
+	assert_int_equal(view.init(buf), 0);
+	assert_int_equal(view.source_packets(), 0);
+
+	/* No CIP header. */
+	avtp_ieciidc_pdu_set(pdu, AVTP_IECIIDC_FIELD_TAG, 0);
+	assert_int_equal(view.init(buf), -ENOTSUP);
+}
+
+int main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(view_aaf),
+		cmocka_unit_test(view_aaf_const),
+		cmocka_unit_test(view_aaf_invalid),
+		cmocka_unit_test(view_cvf),
+		cmocka_unit_test(view_cvf_invalid),
+		cmocka_unit_test(view_crf),
+		cmocka_unit_test(view_ieciidc),
+		cmocka_unit_test(view_ieciidc_invalid),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}